@@ -0,0 +1,141 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2005-2006 Alexander Wemmer
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include <QApplication>
+#include <QStringList>
+
+#include "assert.h"
+#include "logger.h"
+
+#include "navdata_generator.h"
+#include "navdata_benchmark.h"
+#include "navcalc_benchmark.h"
+
+/////////////////////////////////////////////////////////////////////////////
+
+void usage()
+{
+    Logger::log("usage: vasbench [options]");
+    Logger::log("  --dir <path>          directory of the generated data set (default: bench)");
+    Logger::log("  --airports <n>        number of airports");
+    Logger::log("  --vors <n>            number of VORs");
+    Logger::log("  --ndbs <n>            number of NDBs");
+    Logger::log("  --fixes <n>           number of intersections");
+    Logger::log("  --airways <n>         number of airways");
+    Logger::log("  --airway-fixes <n>    number of fixes per airway");
+    Logger::log("  --procedures <n>      number of airports with SIDs and STARs");
+    Logger::log("  --duplicates <ratio>  ratio of duplicate navaid and fix idents");
+    Logger::log("  --seed <n>            seed of the data set");
+    Logger::log("  --queries <n>         number of queries per phase (default: 1000)");
+    Logger::log("  --image               repeat the lookups on the compiled navdata image");
+    Logger::log("  --report <file>       write the results as CSV");
+    Logger::log("  --navcalc             run the great circle benchmark instead of the navdata one");
+    Logger::log("  --points <n>          number of points of the great circle benchmark (default: 100000)");
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+int main(int argc, char **argv)
+{
+    // no GUI is needed, but the navdata may use message boxes on errors
+    QApplication app(argc, argv, false);
+
+    NavdataGeneratorConfig config;
+    QString directory = "bench";
+    QString report_filename;
+    uint query_count = 1000;
+    bool with_image = false;
+    bool navcalc = false;
+    int point_count = 100000;
+
+    QStringList arguments = app.arguments();
+    for(int index = 1; index < arguments.count(); ++index)
+    {
+        const QString& option = arguments[index];
+
+        if (option == "--image")
+        {
+            with_image = true;
+            continue;
+        }
+
+        if (option == "--navcalc")
+        {
+            navcalc = true;
+            continue;
+        }
+
+        if (index+1 >= arguments.count())
+        {
+            usage();
+            return 1;
+        }
+
+        const QString& value = arguments[++index];
+
+        if (option == "--dir") directory = value;
+        else if (option == "--report") report_filename = value;
+        else if (option == "--airports") config.airport_count = value.toUInt();
+        else if (option == "--vors") config.vor_count = value.toUInt();
+        else if (option == "--ndbs") config.ndb_count = value.toUInt();
+        else if (option == "--fixes") config.fix_count = value.toUInt();
+        else if (option == "--airways") config.airway_count = value.toUInt();
+        else if (option == "--airway-fixes") config.airway_fix_count = qMax(2U, value.toUInt());
+        else if (option == "--procedures") config.procedure_airport_count = value.toUInt();
+        else if (option == "--duplicates") config.duplicate_ratio = value.toDouble();
+        else if (option == "--seed") config.seed = value.toUInt();
+        else if (option == "--queries") query_count = qMax(1U, value.toUInt());
+        else if (option == "--points") point_count = qMax(1, value.toInt());
+        else
+        {
+            usage();
+            return 1;
+        }
+    }
+
+    if (navcalc)
+    {
+        NavcalcBenchmark benchmark(point_count, 20, config.seed);
+        bool accurate = benchmark.run();
+        benchmark.printReport();
+        if (!accurate) Logger::log("vasbench: batch great circle results exceed the tolerances");
+
+        Logger::finish();
+        return accurate ? 0 : 1;
+    }
+
+    if (config.airport_count == 0 || config.vor_count == 0 || config.ndb_count == 0 || config.fix_count == 0)
+    {
+        Logger::log("vasbench: airports, VORs, NDBs and fixes must not be empty");
+        return 1;
+    }
+
+    NavdataBenchmark benchmark(config, directory, query_count);
+    bool ok = benchmark.run(with_image);
+    benchmark.printReport();
+
+    if (ok && !report_filename.isEmpty()) ok = benchmark.writeReport(report_filename);
+
+    Logger::finish();
+    return ok ? 0 : 1;
+}
+
+// End of file
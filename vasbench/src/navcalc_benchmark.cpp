@@ -0,0 +1,173 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2005-2006 Alexander Wemmer
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#include <math.h>
+
+#include "assert.h"
+#include "logger.h"
+#include "navcalc.h"
+#include "waypoint.h"
+
+#include "navdata_benchmark.h"
+#include "navcalc_benchmark.h"
+
+/////////////////////////////////////////////////////////////////////////////
+
+//! The single point distance uses acos(), which loses about 1e-6nm for
+//! very short distances, so the batch results may differ that much.
+#define MAX_DIST_ERROR_NM 1.0e-4
+#define MAX_TRACK_ERROR_DEG 1.0e-6
+//! tracks are only compared above this distance
+#define MIN_TRACK_CHECK_DIST_NM 0.1
+
+/////////////////////////////////////////////////////////////////////////////
+
+NavcalcBenchmark::NavcalcBenchmark(int point_count, int iteration_count, uint seed) :
+    m_point_count(point_count), m_iteration_count(iteration_count), m_random_state(seed),
+    m_single_ns_per_point(0.0), m_batch_ns_per_point(0.0), m_batch_dist_only_ns_per_point(0.0),
+    m_max_dist_error_nm(0.0), m_max_track_error_deg(0.0), m_max_cross_track_error_nm(0.0)
+{
+    MYASSERT(m_point_count > 0);
+    MYASSERT(m_iteration_count > 0);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+double NavcalcBenchmark::random(double min, double max)
+{
+    m_random_state = m_random_state * 1664525 + 1013904223;
+    return min + (max - min) * ((m_random_state >> 8) / 16777216.0);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void NavcalcBenchmark::generatePoints(double ref_lat, double ref_lon)
+{
+    m_lat.resize(m_point_count);
+    m_lon.resize(m_point_count);
+
+    for(int index = 0; index < m_point_count; ++index)
+    {
+        double spread = 180.0;
+        switch(index % 3)
+        {
+            case(0): { spread = 0.01; break; }
+            case(1): { spread = 5.0; break; }
+        }
+
+        m_lat[index] = qMax(-89.9, qMin(89.9, ref_lat + random(-spread, spread)));
+        m_lon[index] = ref_lon + random(-2.0*spread, 2.0*spread);
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+bool NavcalcBenchmark::run()
+{
+    QVector<double> distance_nm(m_point_count);
+    QVector<double> track_deg(m_point_count);
+    QVector<double> cross_track_nm(m_point_count);
+
+    double single_us = 0.0;
+    double batch_us = 0.0;
+    double batch_dist_only_us = 0.0;
+
+    for(int iteration = 0; iteration < m_iteration_count; ++iteration)
+    {
+        Waypoint ref_wpt("REF", QString::null, random(-89.0, 89.0), random(-180.0, 180.0));
+        Waypoint to_wpt("TO", QString::null, random(-89.0, 89.0), random(-180.0, 180.0));
+        generatePoints(ref_wpt.lat(), ref_wpt.lon());
+
+        // the single point functions need waypoints, they are built
+        // before the timing starts
+        QVector<Waypoint> waypoints(m_point_count);
+        for(int index = 0; index < m_point_count; ++index)
+            waypoints[index] = Waypoint("P", QString::null, m_lat[index], m_lon[index]);
+
+        QVector<double> single_distance_nm(m_point_count);
+        QVector<double> single_track_deg(m_point_count);
+
+        double start_us = NavdataBenchmark::timeUs();
+        for(int index = 0; index < m_point_count; ++index)
+            Navcalc::getDistAndTrackBetweenWaypoints(ref_wpt, waypoints[index],
+                                                     single_distance_nm[index], single_track_deg[index]);
+        single_us += NavdataBenchmark::timeUs() - start_us;
+
+        start_us = NavdataBenchmark::timeUs();
+        Navcalc::getDistsAndTracksFromWaypoint(ref_wpt, m_lat.constData(), m_lon.constData(), m_point_count,
+                                               distance_nm.data(), track_deg.data());
+        batch_us += NavdataBenchmark::timeUs() - start_us;
+
+        start_us = NavdataBenchmark::timeUs();
+        Navcalc::getDistsFromWaypoint(ref_wpt, m_lat.constData(), m_lon.constData(), m_point_count,
+                                      distance_nm.data());
+        batch_dist_only_us += NavdataBenchmark::timeUs() - start_us;
+
+        Navcalc::getCrossTrackDistances(ref_wpt, to_wpt, m_lat.constData(), m_lon.constData(), m_point_count,
+                                        cross_track_nm.data());
+
+        // accuracy
+
+        for(int index = 0; index < m_point_count; ++index)
+        {
+            m_max_dist_error_nm = qMax(m_max_dist_error_nm, qAbs(distance_nm[index] - single_distance_nm[index]));
+
+            if (single_distance_nm[index] > MIN_TRACK_CHECK_DIST_NM)
+            {
+                double track_error = qAbs(track_deg[index] - single_track_deg[index]);
+                if (track_error > 180.0) track_error = 360.0 - track_error;
+                m_max_track_error_deg = qMax(m_max_track_error_deg, track_error);
+            }
+
+            double crs_from_to, crs_from_current, dist_from_current;
+            double single_cross_track_nm = Navcalc::getCrossTrackDistance(
+                ref_wpt, to_wpt, waypoints[index], crs_from_to, crs_from_current, dist_from_current);
+            m_max_cross_track_error_nm =
+                qMax(m_max_cross_track_error_nm, qAbs(cross_track_nm[index] - single_cross_track_nm));
+        }
+    }
+
+    double point_count = (double)m_point_count * m_iteration_count;
+    m_single_ns_per_point = single_us * 1000.0 / point_count;
+    m_batch_ns_per_point = batch_us * 1000.0 / point_count;
+    m_batch_dist_only_ns_per_point = batch_dist_only_us * 1000.0 / point_count;
+
+    return
+        m_max_dist_error_nm <= MAX_DIST_ERROR_NM &&
+        m_max_track_error_deg <= MAX_TRACK_ERROR_DEG &&
+        m_max_cross_track_error_nm <= MAX_DIST_ERROR_NM;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void NavcalcBenchmark::printReport() const
+{
+    Logger::log(QString("NavcalcBenchmark: %1 points x %2 iterations").arg(m_point_count).arg(m_iteration_count));
+    Logger::log(QString("  single dist+track:  %1 ns/point").arg(m_single_ns_per_point, 0, 'f', 1));
+    Logger::log(QString("  batch dist+track:   %1 ns/point (%2x)").arg(m_batch_ns_per_point, 0, 'f', 1).
+                arg(m_batch_ns_per_point > 0.0 ? m_single_ns_per_point / m_batch_ns_per_point : 0.0, 0, 'f', 2));
+    Logger::log(QString("  batch dist:         %1 ns/point").arg(m_batch_dist_only_ns_per_point, 0, 'f', 1));
+    Logger::log(QString("  max dist error:        %1 nm (limit %2)").arg(m_max_dist_error_nm).arg(MAX_DIST_ERROR_NM));
+    Logger::log(QString("  max track error:       %1 deg (limit %2)").arg(m_max_track_error_deg).arg(MAX_TRACK_ERROR_DEG));
+    Logger::log(QString("  max cross track error: %1 nm (limit %2)").arg(m_max_cross_track_error_nm).arg(MAX_DIST_ERROR_NM));
+}
+
+// End of file
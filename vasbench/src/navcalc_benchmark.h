@@ -0,0 +1,79 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2005-2006 Alexander Wemmer
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+///////////////////////////////////////////////////////////////////////////////
+
+
+#ifndef NAVCALC_BENCHMARK_H
+#define NAVCALC_BENCHMARK_H
+
+#include <QVector>
+
+/////////////////////////////////////////////////////////////////////////////
+
+//! Compares the batch great circle functions of Navcalc with the single
+//! point ones, both for speed and for accuracy.
+class NavcalcBenchmark
+{
+public:
+
+    NavcalcBenchmark(int point_count, int iteration_count, uint seed);
+    virtual ~NavcalcBenchmark() {};
+
+    //! Runs the benchmark and the accuracy check, returns false when the
+    //! batch results differ more than the tolerances from the single point
+    //! results.
+    bool run();
+
+    //! prints the results via the logger
+    void printReport() const;
+
+protected:
+
+    //! returns a pseudo random number in the range [min, max)
+    double random(double min, double max);
+
+    //! fills the point arrays around the given reference point, mixing
+    //! short, medium and long distances
+    void generatePoints(double ref_lat, double ref_lon);
+
+protected:
+
+    int m_point_count;
+    int m_iteration_count;
+    quint32 m_random_state;
+
+    QVector<double> m_lat;
+    QVector<double> m_lon;
+
+    double m_single_ns_per_point;
+    double m_batch_ns_per_point;
+    double m_batch_dist_only_ns_per_point;
+
+    double m_max_dist_error_nm;
+    double m_max_track_error_deg;
+    double m_max_cross_track_error_nm;
+
+private:
+    //! Hidden copy-constructor
+    NavcalcBenchmark(const NavcalcBenchmark&);
+    //! Hidden assignment operator
+    const NavcalcBenchmark& operator = (const NavcalcBenchmark&);
+};
+
+#endif
@@ -0,0 +1,465 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2005-2006 Alexander Wemmer
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <QDir>
+#include <QFile>
+#include <QRegExp>
+#include <QTextStream>
+#include <QTime>
+
+#if defined(Q_OS_UNIX)
+#include <time.h>
+#endif
+
+#include "assert.h"
+#include "logger.h"
+#include "vas_path.h"
+#include "navdata.h"
+
+#include "navdata_benchmark.h"
+
+/////////////////////////////////////////////////////////////////////////////
+
+#define BENCH_NAVDATA_CONFIG_FILENAME "cfg/navdata.cfg"
+#define BENCH_NAVDATA_INDEX_CONFIG_FILENAME "cfg/navdata_index.cfg"
+
+#define BENCH_LATLON_WAYPOINT_REGEXP "^(N|S)(\\d{2,2})\\.(\\d{1,2}\\.\\d{1,2})/(E|W)(\\d{2,3})\\.(\\d{1,2}\\.\\d{1,2})$"
+
+#define BENCH_SPATIAL_RADIUS_NM 100.0
+#define BENCH_NEAREST_COUNT 10
+#define BENCH_SEARCH_MATCH_COUNT 10
+
+/////////////////////////////////////////////////////////////////////////////
+
+double NavdataBenchmark::Phase::percentile(double fraction) const
+{
+    if (samples_us.isEmpty()) return 0.0;
+    QVector<double> sorted = samples_us;
+    qSort(sorted);
+    int index = qMin(sorted.count()-1, (int)(fraction * sorted.count()));
+    return sorted[index];
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+double NavdataBenchmark::Phase::mean() const
+{
+    if (samples_us.isEmpty()) return 0.0;
+    double sum = 0.0;
+    for(int index = 0; index < samples_us.count(); ++index) sum += samples_us[index];
+    return sum / samples_us.count();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+double NavdataBenchmark::Phase::max() const
+{
+    double max_value = 0.0;
+    for(int index = 0; index < samples_us.count(); ++index) max_value = qMax(max_value, samples_us[index]);
+    return max_value;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+NavdataBenchmark::NavdataBenchmark(const NavdataGeneratorConfig& generator_config,
+                                   const QString& directory,
+                                   uint query_count) :
+    m_generator(generator_config), m_directory(directory), m_query_count(query_count)
+{
+    MYASSERT(m_query_count > 0);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+double NavdataBenchmark::timeUs()
+{
+#if defined(Q_OS_UNIX)
+    struct timespec now;
+    clock_gettime(CLOCK_MONOTONIC, &now);
+    return now.tv_sec * 1000000.0 + now.tv_nsec / 1000.0;
+#else
+    static QTime start_time;
+    if (start_time.isNull()) start_time.start();
+    return start_time.elapsed() * 1000.0;
+#endif
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+uint NavdataBenchmark::residentSizeKb()
+{
+    QFile status_file("/proc/self/status");
+    if (!status_file.open(QIODevice::ReadOnly | QIODevice::Text)) return 0;
+
+    QTextStream in(&status_file);
+    while(!in.atEnd())
+    {
+        QString line = in.readLine();
+        if (!line.startsWith("VmRSS:")) continue;
+        return line.mid(6).trimmed().section(' ', 0, 0).toUInt();
+    }
+
+    return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+NavdataBenchmark::Phase& NavdataBenchmark::startPhase(const QString& name)
+{
+    Logger::log(QString("NavdataBenchmark: %1").arg(name));
+
+    Phase phase;
+    phase.name = name;
+    phase.result_count = 0;
+    phase.rss_kb = 0;
+    phase.samples_us.reserve(m_query_count);
+    m_phase_list.append(phase);
+    return m_phase_list.last();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void NavdataBenchmark::finishPhase(Phase& phase)
+{
+    phase.rss_kb = residentSizeKb();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+const NavdataGeneratedPoint& NavdataBenchmark::pick(const QList<NavdataGeneratedPoint>& list)
+{
+    MYASSERT(!list.isEmpty());
+    return list[m_generator.random(list.count())];
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+bool NavdataBenchmark::run(bool with_image)
+{
+    m_phase_list.clear();
+
+    Phase& generate_phase = startPhase("generate");
+    double start_us = timeUs();
+    if (!m_generator.generate(m_directory)) return false;
+    generate_phase.samples_us.append(timeUs() - start_us);
+    finishPhase(generate_phase);
+
+    VasPath::setPath(m_directory);
+    QDir(m_directory).mkpath("cfg");
+
+    // the generator removed the index file, so the first startup indexes
+    // all text files and the second one loads the written index file
+
+    Navdata* navdata = startup("startup cold");
+    if (navdata == 0) return false;
+    delete navdata;
+
+    navdata = startup("startup warm");
+    if (navdata == 0) return false;
+
+    runLookups(*navdata, QString::null);
+
+    if (with_image)
+    {
+        Phase& image_phase = startPhase("compile image");
+        start_us = timeUs();
+        bool compiled = navdata->compileImage();
+        image_phase.samples_us.append(timeUs() - start_us);
+        finishPhase(image_phase);
+
+        if (compiled) runLookups(*navdata, " (image)");
+        else Logger::log("NavdataBenchmark:run: could not compile the navdata image");
+    }
+
+    delete navdata;
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+Navdata* NavdataBenchmark::startup(const QString& phase_name)
+{
+    Phase& phase = startPhase(phase_name);
+
+    double start_us = timeUs();
+    Navdata* navdata = new Navdata(BENCH_NAVDATA_CONFIG_FILENAME, BENCH_NAVDATA_INDEX_CONFIG_FILENAME);
+    MYASSERT(navdata != 0);
+    phase.samples_us.append(timeUs() - start_us);
+    finishPhase(phase);
+
+    if (navdata->isValid()) return navdata;
+
+    Logger::log("NavdataBenchmark:startup: navdata is not valid");
+    delete navdata;
+    return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void NavdataBenchmark::runLookups(const Navdata& navdata, const QString& suffix)
+{
+    runExactLookups(navdata, suffix);
+    runIdentSearch(navdata, suffix);
+    runSpatialLookups(navdata, suffix);
+    runAirwayExpansion(navdata, suffix);
+    runProcedureLookups(navdata, suffix);
+    runRouteResolution(navdata, suffix);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void NavdataBenchmark::runExactLookups(const Navdata& navdata, const QString& suffix)
+{
+    Phase& airport_phase = startPhase("airport lookup" + suffix);
+    for(uint count = 0; count < m_query_count; ++count)
+    {
+        QString id = pick(m_generator.airports()).id;
+        WaypointPtrList result_list;
+        double start_us = timeUs();
+        airport_phase.result_count += navdata.getAirports(id, result_list);
+        airport_phase.samples_us.append(timeUs() - start_us);
+    }
+    finishPhase(airport_phase);
+
+    Phase& navaid_phase = startPhase("navaid lookup" + suffix);
+    for(uint count = 0; count < m_query_count; ++count)
+    {
+        QString id = pick(m_generator.random(2) ? m_generator.vors() : m_generator.ndbs()).id;
+        WaypointPtrList result_list;
+        double start_us = timeUs();
+        navaid_phase.result_count += navdata.getNavaids(id, result_list);
+        navaid_phase.samples_us.append(timeUs() - start_us);
+    }
+    finishPhase(navaid_phase);
+
+    Phase& fix_phase = startPhase("fix lookup" + suffix);
+    for(uint count = 0; count < m_query_count; ++count)
+    {
+        QString id = pick(m_generator.fixes()).id;
+        WaypointPtrList result_list;
+        double start_us = timeUs();
+        fix_phase.result_count += navdata.getIntersections(id, result_list);
+        fix_phase.samples_us.append(timeUs() - start_us);
+    }
+    finishPhase(fix_phase);
+
+    QRegExp lat_lon_regexp(BENCH_LATLON_WAYPOINT_REGEXP);
+
+    Phase& waypoint_phase = startPhase("waypoint lookup" + suffix);
+    for(uint count = 0; count < m_query_count; ++count)
+    {
+        QString id = pick(m_generator.fixes()).id;
+        WaypointPtrList result_list;
+        double start_us = timeUs();
+        waypoint_phase.result_count += navdata.getWaypoints(id, result_list, lat_lon_regexp);
+        waypoint_phase.samples_us.append(timeUs() - start_us);
+    }
+    finishPhase(waypoint_phase);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void NavdataBenchmark::runIdentSearch(const Navdata& navdata, const QString& suffix)
+{
+    Phase& prefix_phase = startPhase("prefix search" + suffix);
+    for(uint count = 0; count < m_query_count; ++count)
+    {
+        const NavdataGeneratedPoint& fix = pick(m_generator.fixes());
+        Waypoint position(fix.id, QString::null, fix.lat / 1000000.0, fix.lon / 1000000.0);
+        NavdataIdentSearch::MatchList matches;
+        double start_us = timeUs();
+        prefix_phase.result_count +=
+            navdata.searchIdents(fix.id.left(3), position, BENCH_SEARCH_MATCH_COUNT, matches, false);
+        prefix_phase.samples_us.append(timeUs() - start_us);
+    }
+    finishPhase(prefix_phase);
+
+    Phase& fuzzy_phase = startPhase("fuzzy search" + suffix);
+    for(uint count = 0; count < m_query_count; ++count)
+    {
+        const NavdataGeneratedPoint& fix = pick(m_generator.fixes());
+        Waypoint position(fix.id, QString::null, fix.lat / 1000000.0, fix.lon / 1000000.0);
+
+        // a typo in the last character
+        QString text = fix.id;
+        text[text.length()-1] = QChar('A' + m_generator.random(26));
+
+        NavdataIdentSearch::MatchList matches;
+        double start_us = timeUs();
+        fuzzy_phase.result_count += navdata.searchIdents(text, position, BENCH_SEARCH_MATCH_COUNT, matches, true);
+        fuzzy_phase.samples_us.append(timeUs() - start_us);
+    }
+    finishPhase(fuzzy_phase);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void NavdataBenchmark::runSpatialLookups(const Navdata& navdata, const QString& suffix)
+{
+    Phase& radius_phase = startPhase("airports within radius" + suffix);
+    for(uint count = 0; count < m_query_count; ++count)
+    {
+        const NavdataGeneratedPoint& fix = pick(m_generator.fixes());
+        Waypoint center(fix.id, QString::null, fix.lat / 1000000.0, fix.lon / 1000000.0);
+        NavdataSpatialIndex::HitList hits;
+        double start_us = timeUs();
+        radius_phase.result_count += navdata.getAirportsWithinRadius(center, BENCH_SPATIAL_RADIUS_NM, hits);
+        radius_phase.samples_us.append(timeUs() - start_us);
+    }
+    finishPhase(radius_phase);
+
+    Phase& nearest_phase = startPhase("nearest VORs" + suffix);
+    for(uint count = 0; count < m_query_count; ++count)
+    {
+        const NavdataGeneratedPoint& fix = pick(m_generator.fixes());
+        Waypoint center(fix.id, QString::null, fix.lat / 1000000.0, fix.lon / 1000000.0);
+        NavdataSpatialIndex::HitList hits;
+        double start_us = timeUs();
+        nearest_phase.result_count += navdata.getNearestVors(center, BENCH_NEAREST_COUNT, hits);
+        nearest_phase.samples_us.append(timeUs() - start_us);
+    }
+    finishPhase(nearest_phase);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void NavdataBenchmark::runAirwayExpansion(const Navdata& navdata, const QString& suffix)
+{
+    if (m_generator.airways().isEmpty()) return;
+
+    Phase& phase = startPhase("airway expansion" + suffix);
+    for(uint count = 0; count < m_query_count; ++count)
+    {
+        const NavdataGeneratedAirway& airway =
+            m_generator.airways()[m_generator.random(m_generator.airways().count())];
+
+        const NavdataGeneratedPoint& from_fix = airway.fixes.first();
+        Waypoint from_waypoint(from_fix.id, QString::null, from_fix.lat / 1000000.0, from_fix.lon / 1000000.0);
+        QString to_id = airway.fixes[1 + m_generator.random(airway.fixes.count()-1)].id;
+
+        WaypointPtrList result_list;
+        QString error_text;
+        double start_us = timeUs();
+        if (navdata.getWaypointsByAirway(from_waypoint, airway.id, to_id, result_list, error_text))
+            phase.result_count += result_list.count();
+        phase.samples_us.append(timeUs() - start_us);
+    }
+    finishPhase(phase);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void NavdataBenchmark::runProcedureLookups(const Navdata& navdata, const QString& suffix)
+{
+    const QStringList& airports = m_generator.procedureAirports();
+    if (airports.isEmpty()) return;
+
+    Phase& phase = startPhase("SID/STAR lookup" + suffix);
+    for(uint count = 0; count < m_query_count; ++count)
+    {
+        const QString& airport = airports[m_generator.random(airports.count())];
+        ProcedurePtrList sids;
+        ProcedurePtrList stars;
+        double start_us = timeUs();
+        phase.result_count += navdata.getSids(airport, sids);
+        phase.result_count += navdata.getStars(airport, stars);
+        phase.samples_us.append(timeUs() - start_us);
+    }
+    finishPhase(phase);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void NavdataBenchmark::runRouteResolution(const Navdata& navdata, const QString& suffix)
+{
+    if (m_generator.airways().isEmpty()) return;
+
+    QRegExp lat_lon_regexp(BENCH_LATLON_WAYPOINT_REGEXP);
+
+    Phase& phase = startPhase("ICAO route resolution" + suffix);
+    for(uint count = 0; count < m_query_count; ++count)
+    {
+        const NavdataGeneratedAirway& airway =
+            m_generator.airways()[m_generator.random(m_generator.airways().count())];
+
+        QString route = QString("%1 %2 %3 %4 %5").
+                        arg(pick(m_generator.airports()).id).
+                        arg(airway.fixes.first().id).
+                        arg(airway.id).
+                        arg(airway.fixes.last().id).
+                        arg(pick(m_generator.airports()).id);
+
+        NavdataResolvedRoute result;
+        double start_us = timeUs();
+        if (navdata.resolveICAORoute(route, lat_lon_regexp, result)) ++phase.result_count;
+        phase.samples_us.append(timeUs() - start_us);
+    }
+    finishPhase(phase);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void NavdataBenchmark::printReport() const
+{
+    Logger::log(QString("%1 %2 %3 %4 %5 %6 %7 %8 %9").
+                arg("phase", -36).arg("count", 7).arg("results", 8).
+                arg("mean_us", 11).arg("p50_us", 11).arg("p90_us", 11).
+                arg("p99_us", 11).arg("max_us", 11).arg("rss_kb", 9));
+
+    QList<Phase>::const_iterator iter = m_phase_list.begin();
+    for(; iter != m_phase_list.end(); ++iter)
+    {
+        const Phase& phase = *iter;
+        Logger::log(QString("%1 %2 %3 %4 %5 %6 %7 %8 %9").
+                    arg(phase.name, -36).arg(phase.samples_us.count(), 7).arg(phase.result_count, 8).
+                    arg(phase.mean(), 11, 'f', 1).arg(phase.percentile(0.5), 11, 'f', 1).
+                    arg(phase.percentile(0.9), 11, 'f', 1).arg(phase.percentile(0.99), 11, 'f', 1).
+                    arg(phase.max(), 11, 'f', 1).arg(phase.rss_kb, 9));
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+bool NavdataBenchmark::writeReport(const QString& filename) const
+{
+    QFile file(filename);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+    {
+        Logger::log(QString("NavdataBenchmark:writeReport: could not open %1").arg(filename));
+        return false;
+    }
+
+    QTextStream out(&file);
+    out << "phase,count,results,mean_us,p50_us,p90_us,p99_us,max_us,rss_kb\n";
+
+    QList<Phase>::const_iterator iter = m_phase_list.begin();
+    for(; iter != m_phase_list.end(); ++iter)
+    {
+        const Phase& phase = *iter;
+        out << phase.name << "," << phase.samples_us.count() << "," << phase.result_count << ","
+            << phase.mean() << "," << phase.percentile(0.5) << "," << phase.percentile(0.9) << ","
+            << phase.percentile(0.99) << "," << phase.max() << "," << phase.rss_kb << "\n";
+    }
+
+    out.flush();
+    return file.error() == QFile::NoError;
+}
+
+// End of file
@@ -0,0 +1,112 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2005-2006 Alexander Wemmer
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef NAVDATA_BENCHMARK_H
+#define NAVDATA_BENCHMARK_H
+
+#include <QList>
+#include <QString>
+#include <QVector>
+
+#include "navdata_generator.h"
+
+class Navdata;
+
+/////////////////////////////////////////////////////////////////////////////
+
+//! Measures the startup and lookup times of Navdata on a generated AIRAC
+//! data set. Every phase records the time of each single operation, the
+//! report shows the percentiles and the resident memory after the phase.
+class NavdataBenchmark
+{
+public:
+
+    NavdataBenchmark(const NavdataGeneratorConfig& generator_config,
+                     const QString& directory,
+                     uint query_count);
+
+    virtual ~NavdataBenchmark() {};
+
+    //! Generates the data set and runs all phases, when "with_image" is set
+    //! the lookups are repeated on the compiled navdata image.
+    //! Returns true on success.
+    bool run(bool with_image);
+
+    //! prints the results via the logger
+    void printReport() const;
+
+    //! writes the results as CSV, returns true on success
+    bool writeReport(const QString& filename) const;
+
+    //! returns the current time in microseconds from a monotonic clock
+    static double timeUs();
+
+    //! returns the resident set size of the process in KB, 0 if unknown
+    static uint residentSizeKb();
+
+protected:
+
+    struct Phase
+    {
+        QString name;
+        //! duration of every single operation
+        QVector<double> samples_us;
+        //! number of found items over all operations
+        uint result_count;
+        uint rss_kb;
+
+        double percentile(double fraction) const;
+        double mean() const;
+        double max() const;
+    };
+
+    Phase& startPhase(const QString& name);
+    void finishPhase(Phase& phase);
+
+    //! times the constructor of the navdata, returns 0 on error
+    Navdata* startup(const QString& phase_name);
+
+    void runLookups(const Navdata& navdata, const QString& suffix);
+    void runExactLookups(const Navdata& navdata, const QString& suffix);
+    void runIdentSearch(const Navdata& navdata, const QString& suffix);
+    void runSpatialLookups(const Navdata& navdata, const QString& suffix);
+    void runAirwayExpansion(const Navdata& navdata, const QString& suffix);
+    void runProcedureLookups(const Navdata& navdata, const QString& suffix);
+    void runRouteResolution(const Navdata& navdata, const QString& suffix);
+
+    //! returns a random generated point of the given list
+    const NavdataGeneratedPoint& pick(const QList<NavdataGeneratedPoint>& list);
+
+protected:
+
+    NavdataGenerator m_generator;
+    QString m_directory;
+    uint m_query_count;
+
+    QList<Phase> m_phase_list;
+
+private:
+    //! Hidden copy-constructor
+    NavdataBenchmark(const NavdataBenchmark&);
+    //! Hidden assignment operator
+    const NavdataBenchmark& operator = (const NavdataBenchmark&);
+};
+
+#endif
@@ -0,0 +1,377 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2005-2006 Alexander Wemmer
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <QDir>
+#include <QFile>
+
+#include "assert.h"
+#include "logger.h"
+
+#include "navdata_generator.h"
+
+/////////////////////////////////////////////////////////////////////////////
+
+#define NDSEP "|"
+
+//! number of random fixes checked for the next fix of an airway
+#define AIRWAY_NEXT_FIX_CANDIDATES 16
+
+static const char* AIRWAY_PREFIXES[] = { "A", "B", "G", "J", "L", "M", "N", "Q", "R", "T", "UL", "UM", "UN", "V", 0 };
+
+/////////////////////////////////////////////////////////////////////////////
+
+NavdataGenerator::NavdataGenerator(const NavdataGeneratorConfig& config) :
+    m_config(config), m_random_state(config.seed)
+{
+    MYASSERT(m_config.airway_fix_count >= 2);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+uint NavdataGenerator::random(uint range)
+{
+    MYASSERT(range > 0);
+
+    // 32 bit LCG, the high bits are the random ones
+    m_random_state = m_random_state * 1664525 + 1013904223;
+    return (uint)(((quint64)(m_random_state >> 8) * range) >> 24);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+QString NavdataGenerator::ident(uint length, QSet<QString>& used_idents, QList<QString>& ident_list,
+                                double duplicate_ratio)
+{
+    if (!ident_list.isEmpty() && random(1000000) < (uint)(duplicate_ratio * 1000000))
+        return ident_list[random(ident_list.count())];
+
+    QString id;
+    do
+    {
+        id.clear();
+        for(uint index = 0; index < length; ++index) id += QChar('A' + random(26));
+    }
+    while(used_idents.contains(id));
+
+    used_idents.insert(id);
+    ident_list.append(id);
+    return id;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+NavdataGeneratedPoint NavdataGenerator::position(const QString& id)
+{
+    NavdataGeneratedPoint point;
+    point.id = id;
+    point.lat = (int)random(130000000) - 60000000;
+    point.lon = (int)random(360000000) - 180000000;
+    return point;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void NavdataGenerator::generatePoints()
+{
+    m_airports.clear();
+    m_vors.clear();
+    m_ndbs.clear();
+    m_fixes.clear();
+
+    QSet<QString> used_idents;
+    QList<QString> ident_list;
+
+    // airport idents are unique worldwide
+    for(uint index = 0; index < m_config.airport_count; ++index)
+        m_airports.append(position(ident(4, used_idents, ident_list, 0.0)));
+
+    used_idents.clear();
+    ident_list.clear();
+
+    for(uint index = 0; index < m_config.vor_count; ++index)
+        m_vors.append(position(ident(3, used_idents, ident_list, m_config.duplicate_ratio)));
+
+    for(uint index = 0; index < m_config.ndb_count; ++index)
+        m_ndbs.append(position(ident(2 + random(2), used_idents, ident_list, m_config.duplicate_ratio)));
+
+    used_idents.clear();
+    ident_list.clear();
+
+    for(uint index = 0; index < m_config.fix_count; ++index)
+        m_fixes.append(position(ident(5, used_idents, ident_list, m_config.duplicate_ratio)));
+
+    m_procedure_airports.clear();
+    for(uint index = 0; index < m_config.procedure_airport_count && index < (uint)m_airports.count(); ++index)
+        m_procedure_airports.append(m_airports[index].id);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void NavdataGenerator::generateAirways()
+{
+    m_airways.clear();
+    if ((uint)m_fixes.count() < m_config.airway_fix_count) return;
+
+    QSet<QString> used_airway_ids;
+
+    for(uint airway_index = 0; airway_index < m_config.airway_count; ++airway_index)
+    {
+        NavdataGeneratedAirway airway;
+
+        uint prefix_count = 0;
+        while(AIRWAY_PREFIXES[prefix_count] != 0) ++prefix_count;
+
+        do
+        {
+            airway.id = QString("%1%2").arg(AIRWAY_PREFIXES[random(prefix_count)]).arg(1 + random(999));
+        }
+        while(used_airway_ids.contains(airway.id));
+        used_airway_ids.insert(airway.id);
+
+        // walk from a random fix to one of the nearest of some random fixes
+
+        QSet<int> used_fixes;
+        int fix_index = random(m_fixes.count());
+        airway.fixes.append(m_fixes[fix_index]);
+        used_fixes.insert(fix_index);
+
+        while((uint)airway.fixes.count() < m_config.airway_fix_count)
+        {
+            const NavdataGeneratedPoint& last_fix = airway.fixes.last();
+
+            int next_fix_index = -1;
+            double next_fix_distance = 0.0;
+
+            for(int count = 0; count < AIRWAY_NEXT_FIX_CANDIDATES; ++count)
+            {
+                int candidate_index = random(m_fixes.count());
+                if (used_fixes.contains(candidate_index)) continue;
+
+                const NavdataGeneratedPoint& candidate = m_fixes[candidate_index];
+                double lat_diff = (candidate.lat - last_fix.lat) / 1000000.0;
+                double lon_diff = (candidate.lon - last_fix.lon) / 1000000.0;
+                double distance = lat_diff*lat_diff + lon_diff*lon_diff;
+
+                if (next_fix_index >= 0 && distance >= next_fix_distance) continue;
+                next_fix_index = candidate_index;
+                next_fix_distance = distance;
+            }
+
+            if (next_fix_index < 0) continue;
+            airway.fixes.append(m_fixes[next_fix_index]);
+            used_fixes.insert(next_fix_index);
+        }
+
+        m_airways.append(airway);
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+bool NavdataGenerator::generate(const QString& directory)
+{
+    QDir dir(directory);
+    if (!dir.mkpath("navdata/sid") || !dir.mkpath("navdata/star"))
+    {
+        Logger::log(QString("NavdataGenerator:generate: could not create %1/navdata").arg(directory));
+        return false;
+    }
+
+    // the index and image files belong to the previous data set
+    dir.remove("navdata/navdata.idx");
+    dir.remove("navdata/navdata.img");
+
+    m_random_state = m_config.seed;
+    generatePoints();
+    generateAirways();
+
+    QString navdata_path = dir.absoluteFilePath("navdata");
+
+    return
+        writeAirports(navdata_path + "/airports.txt") &&
+        writeNavaids(navdata_path + "/navaids.txt") &&
+        writeFixes(navdata_path + "/waypoints.txt") &&
+        writeAirways(navdata_path + "/ats.txt") &&
+        writeProcedures(navdata_path + "/sid", "SID") &&
+        writeProcedures(navdata_path + "/star", "STAR");
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+bool NavdataGenerator::openFile(const QString& filename, QFile& file)
+{
+    file.setFileName(filename);
+    if (file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) return true;
+
+    Logger::log(QString("NavdataGenerator:openFile: could not open %1").arg(filename));
+    return false;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+bool NavdataGenerator::writeAirports(const QString& filename)
+{
+    QFile file;
+    if (!openFile(filename, file)) return false;
+    QTextStream out(&file);
+
+    // the AIRAC cycle record comes first
+    out << "X" << NDSEP << "BENCH" << NDSEP << "01JAN28JAN" << NDSEP << m_config.seed << NDSEP << "SYNTHETIC\n";
+
+    QList<NavdataGeneratedPoint>::const_iterator iter = m_airports.begin();
+    for(; iter != m_airports.end(); ++iter)
+    {
+        const NavdataGeneratedPoint& airport = *iter;
+
+        out << "A" << NDSEP << airport.id << NDSEP << "BENCH " << airport.id.left(2) << "AIRPORT " << airport.id
+            << NDSEP << airport.lat << NDSEP << airport.lon << NDSEP << random(5000) << "\n";
+
+        // two runway directions, long enough for the spatial airport list
+        int heading = random(18) * 10;
+        for(int direction = 0; direction < 2; ++direction)
+        {
+            int runway_heading = (heading + direction * 180) % 360;
+            out << "R" << NDSEP << QString("%1").arg(qMax(1, runway_heading / 10), 2, 10, QChar('0'))
+                << NDSEP << runway_heading << NDSEP << 9000 << NDSEP << 1 << NDSEP << 110100 + random(20) * 100
+                << NDSEP << runway_heading << NDSEP << airport.lat + direction * 10000 << NDSEP << airport.lon
+                << NDSEP << random(5000) << NDSEP << 300 << NDSEP << 50 << "\n";
+        }
+
+        out << "\n";
+    }
+
+    out.flush();
+    return file.error() == QFile::NoError;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+bool NavdataGenerator::writeNavaids(const QString& filename)
+{
+    QFile file;
+    if (!openFile(filename, file)) return false;
+    QTextStream out(&file);
+
+    QList<NavdataGeneratedPoint>::const_iterator iter = m_vors.begin();
+    for(; iter != m_vors.end(); ++iter)
+    {
+        out << iter->id << NDSEP << "BENCH VOR " << iter->id << NDSEP << 108000 + random(100) * 100
+            << NDSEP << 1 << NDSEP << 1 << NDSEP << 130 << NDSEP << iter->lat << NDSEP << iter->lon
+            << NDSEP << random(5000) << NDSEP << "XX\n";
+    }
+
+    for(iter = m_ndbs.begin(); iter != m_ndbs.end(); ++iter)
+    {
+        out << iter->id << NDSEP << "BENCH NDB " << iter->id << NDSEP << 200000 + random(300) * 1000
+            << NDSEP << 0 << NDSEP << 0 << NDSEP << 50 << NDSEP << iter->lat << NDSEP << iter->lon
+            << NDSEP << random(5000) << NDSEP << "XX\n";
+    }
+
+    out.flush();
+    return file.error() == QFile::NoError;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+bool NavdataGenerator::writeFixes(const QString& filename)
+{
+    QFile file;
+    if (!openFile(filename, file)) return false;
+    QTextStream out(&file);
+
+    QList<NavdataGeneratedPoint>::const_iterator iter = m_fixes.begin();
+    for(; iter != m_fixes.end(); ++iter)
+        out << iter->id << NDSEP << iter->lat << NDSEP << iter->lon << NDSEP << "XX\n";
+
+    out.flush();
+    return file.error() == QFile::NoError;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+bool NavdataGenerator::writeAirways(const QString& filename)
+{
+    QFile file;
+    if (!openFile(filename, file)) return false;
+    QTextStream out(&file);
+
+    QList<NavdataGeneratedAirway>::const_iterator iter = m_airways.begin();
+    for(; iter != m_airways.end(); ++iter)
+    {
+        const NavdataGeneratedAirway& airway = *iter;
+        out << "A" << NDSEP << airway.id << NDSEP << airway.fixes.count()-1 << "\n";
+
+        for(int index = 1; index < airway.fixes.count(); ++index)
+        {
+            const NavdataGeneratedPoint& fix1 = airway.fixes[index-1];
+            const NavdataGeneratedPoint& fix2 = airway.fixes[index];
+
+            out << "S" << NDSEP << fix1.id << NDSEP << fix1.lat << NDSEP << fix1.lon
+                << NDSEP << fix2.id << NDSEP << fix2.lat << NDSEP << fix2.lon
+                << NDSEP << random(360) << NDSEP << random(360) << NDSEP << random(50000) << "\n";
+        }
+
+        out << "\n";
+    }
+
+    out.flush();
+    return file.error() == QFile::NoError;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+bool NavdataGenerator::writeProcedures(const QString& directory, const QString& type)
+{
+    QStringList::const_iterator iter = m_procedure_airports.begin();
+    for(; iter != m_procedure_airports.end(); ++iter)
+    {
+        QFile file;
+        if (!openFile(directory + "/" + iter->toLower() + ".txt", file)) return false;
+        QTextStream out(&file);
+
+        for(uint proc_index = 0; proc_index < m_config.procedures_per_airport; ++proc_index)
+        {
+            const NavdataGeneratedPoint& first_fix = m_fixes[random(m_fixes.count())];
+            uint leg_count = 3 + random(5);
+
+            out << "P" << NDSEP << first_fix.id << proc_index+1 << type.left(1) << NDSEP << "RW09"
+                << NDSEP << "ALL" << NDSEP << 0 << NDSEP << leg_count << "\n";
+
+            for(uint leg_index = 0; leg_index < leg_count; ++leg_index)
+            {
+                const NavdataGeneratedPoint& fix = (leg_index == 0) ? first_fix : m_fixes[random(m_fixes.count())];
+
+                out << "S" << NDSEP << fix.id << NDSEP << fix.lat << NDSEP << fix.lon << NDSEP << fix.id
+                    << NDSEP << "TF";
+                for(int field = 0; field < 13; ++field) out << NDSEP << 0;
+                out << "\n";
+            }
+
+            out << "\n";
+        }
+
+        out.flush();
+        if (file.error() != QFile::NoError) return false;
+    }
+
+    return true;
+}
+
+// End of file
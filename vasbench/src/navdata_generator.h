@@ -0,0 +1,142 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2005-2006 Alexander Wemmer
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef NAVDATA_GENERATOR_H
+#define NAVDATA_GENERATOR_H
+
+#include <QFile>
+#include <QList>
+#include <QSet>
+#include <QString>
+#include <QStringList>
+#include <QTextStream>
+
+/////////////////////////////////////////////////////////////////////////////
+
+//! size and ident distribution of a generated AIRAC data set
+struct NavdataGeneratorConfig
+{
+    NavdataGeneratorConfig() :
+        airport_count(4000), vor_count(3000), ndb_count(3000), fix_count(100000),
+        airway_count(3000), airway_fix_count(12), procedure_airport_count(200),
+        procedures_per_airport(8), duplicate_ratio(0.05), seed(1)
+    {};
+
+    uint airport_count;
+    uint vor_count;
+    uint ndb_count;
+    uint fix_count;
+    uint airway_count;
+    //! number of fixes per airway
+    uint airway_fix_count;
+    //! number of airports with SID and STAR files
+    uint procedure_airport_count;
+    uint procedures_per_airport;
+    //! Probability that a navaid or fix reuses an already used ident, like
+    //! the worldwide duplicate idents of real AIRAC data.
+    double duplicate_ratio;
+    uint seed;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+
+//! a generated record, used to build the benchmark queries
+struct NavdataGeneratedPoint
+{
+    QString id;
+    //! micro-degrees like in the AIRAC text files
+    int lat;
+    int lon;
+};
+
+//! a generated airway, used to build the benchmark queries
+struct NavdataGeneratedAirway
+{
+    QString id;
+    QList<NavdataGeneratedPoint> fixes;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+
+//! Writes a synthetic AIRAC data set in the text formats parsed by
+//! Navdata (airports.txt, navaids.txt, waypoints.txt, ats.txt and the
+//! SID/STAR files) below the given directory. The output only depends on
+//! the config, so the same seed always gives the same data set.
+class NavdataGenerator
+{
+public:
+
+    NavdataGenerator(const NavdataGeneratorConfig& config);
+    virtual ~NavdataGenerator() {};
+
+    //! Writes the data set to "<directory>/navdata", old index and image
+    //! files are removed. Returns true on success.
+    bool generate(const QString& directory);
+
+    inline const QList<NavdataGeneratedPoint>& airports() const { return m_airports; }
+    inline const QList<NavdataGeneratedPoint>& vors() const { return m_vors; }
+    inline const QList<NavdataGeneratedPoint>& ndbs() const { return m_ndbs; }
+    inline const QList<NavdataGeneratedPoint>& fixes() const { return m_fixes; }
+    inline const QList<NavdataGeneratedAirway>& airways() const { return m_airways; }
+    inline const QStringList& procedureAirports() const { return m_procedure_airports; }
+
+    //! returns the next pseudo random number in the range [0, range)
+    uint random(uint range);
+
+protected:
+
+    //! returns a new ident with the given length, an already used one with
+    //! the given probability
+    QString ident(uint length, QSet<QString>& used_idents, QList<QString>& ident_list, double duplicate_ratio);
+
+    //! returns a random position between 60S and 70N in micro-degrees
+    NavdataGeneratedPoint position(const QString& id);
+
+    void generatePoints();
+    void generateAirways();
+
+    bool writeAirports(const QString& filename);
+    bool writeNavaids(const QString& filename);
+    bool writeFixes(const QString& filename);
+    bool writeAirways(const QString& filename);
+    bool writeProcedures(const QString& directory, const QString& type);
+
+    static bool openFile(const QString& filename, QFile& file);
+
+protected:
+
+    NavdataGeneratorConfig m_config;
+    quint32 m_random_state;
+
+    QList<NavdataGeneratedPoint> m_airports;
+    QList<NavdataGeneratedPoint> m_vors;
+    QList<NavdataGeneratedPoint> m_ndbs;
+    QList<NavdataGeneratedPoint> m_fixes;
+    QList<NavdataGeneratedAirway> m_airways;
+    QStringList m_procedure_airports;
+
+private:
+    //! Hidden copy-constructor
+    NavdataGenerator(const NavdataGenerator&);
+    //! Hidden assignment operator
+    const NavdataGenerator& operator = (const NavdataGenerator&);
+};
+
+#endif
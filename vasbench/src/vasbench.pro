@@ -0,0 +1,43 @@
+# vasbench measures the startup and lookup times of the navdata on a
+# generated AIRAC data set:
+#
+# vasbench --dir /tmp/bench --queries 2000 --image --report bench.csv
+#
+# The data set size can be changed with --airports, --fixes, --airways etc.
+#
+# vasbench --navcalc --points 100000
+#
+# compares the batch great circle functions of Navcalc with the single
+# point ones and fails when the results differ more than the tolerances.
+
+QT += network xml
+
+CONFIG += console warn_on release thread
+CONFIG -= rtti exceptions stl app_bundle
+
+TEMPLATE = app
+TARGET = vasbench
+DESTDIR = ..
+
+# Where to find interesting files...
+INCLUDEPATH += ../../vaslib/src
+DEPENDPATH += ../../vaslib/src
+LIBS += -L../../vaslib/lib
+
+PRE_TARGETDEPS += ../../vaslib/lib/libvaslib.a
+DEFINES += VASFMC_GAUGE=0
+LIBS += -lvaslib
+
+unix:!macx {
+    LIBS += -lrt
+}
+
+# Input
+HEADERS += navdata_generator.h \
+           navdata_benchmark.h \
+           navcalc_benchmark.h
+
+SOURCES += main.cpp \
+           navdata_generator.cpp \
+           navdata_benchmark.cpp \
+           navcalc_benchmark.cpp
@@ -57,6 +57,7 @@
 #define CFG_MSFS_FILENAME CFG_DIR"/fsaccess_msfs.cfg"
 #define CFG_FGFS_FILENAME CFG_DIR"/fsaccess_fgfs.cfg"
 #define CFG_XPLANE_FILENAME CFG_DIR"/fsaccess_xplane.cfg"
+#define CFG_REPLAY_FILENAME CFG_DIR"/fsaccess_replay.cfg"
 #define CFG_NAVDATA_FILENAME CFG_DIR"/navdata.cfg"
 #define CFG_NAVDATA_INDEX_FILENAME CFG_DIR"/navdata_index.cfg"
 #define CFG_AUTOPILOT_FILENAME CFG_DIR"/autopilot.cfg"
@@ -123,6 +124,7 @@
 #define FS_ACCESS_TYPE_MSFS "msfs"
 #define FS_ACCESS_TYPE_XPLANE "xplane"
 #define FS_ACCESS_TYPE_FGFS "fgfs"
+#define FS_ACCESS_TYPE_REPLAY "replay"
 
 #define FS_TIME_SYNC_MAX_DIFF_SEC 60
 
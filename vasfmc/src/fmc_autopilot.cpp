@@ -74,11 +74,11 @@ FMCAutopilot::FMCAutopilot(ConfigWidgetProvider* config_widget_provider,
 
     // mode stuff
 
-    m_lateral_mode_calc_timer = QTime::currentTime().addSecs(-60);
-    m_lateral_mode_active_changed_time = QTime::currentTime().addSecs(-60);
+    m_lateral_mode_calc_timer.startMsAgo(60000);
+    m_lateral_mode_active_changed_time.startMsAgo(60000);
 
-    m_vertical_mode_calc_timer = QTime::currentTime().addSecs(-60);
-    m_vertical_mode_active_changed_time = QTime::currentTime().addSecs(-60);
+    m_vertical_mode_calc_timer.startMsAgo(60000);
+    m_vertical_mode_active_changed_time.startMsAgo(60000);
 
     // takeoff stuff
 
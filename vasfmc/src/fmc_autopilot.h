@@ -33,6 +33,7 @@
 #include "serialization_iface.h"
 
 #include "fmc_autopilot_defines.h"
+#include "sim_clock.h"
 
 class FMCControl;
 class FMCData;
@@ -218,17 +219,17 @@ protected:
 
     ILS_MODE m_ils_mode;
 
-    QTime m_refresh_detector;
+    SimTimer m_refresh_detector;
 
-    QTime m_lateral_mode_calc_timer;
+    SimTimer m_lateral_mode_calc_timer;
     LATERAL_MODE m_lateral_mode_active;
     LATERAL_MODE m_lateral_mode_armed;
-    QTime m_lateral_mode_active_changed_time;
+    SimTimer m_lateral_mode_active_changed_time;
 
-    QTime m_vertical_mode_calc_timer;
+    SimTimer m_vertical_mode_calc_timer;
     VERTICAL_MODE m_vertical_mode_active;
     VERTICAL_MODE m_vertical_mode_armed;
-    QTime m_vertical_mode_active_changed_time;
+    SimTimer m_vertical_mode_active_changed_time;
 
     double m_flightpath_angle;
     int m_vertical_speed;
@@ -250,7 +251,7 @@ protected:
     double m_takeoff_lateral_target_track;
 
     double m_takeoff_vertical_speed_hold_kts;
-    QTime m_takeoff_vertical_speed_hold_engaged_dt;
+    SimTimer m_takeoff_vertical_speed_hold_engaged_dt;
 
     QTimer m_lateral_fd_source_reset_timer;
     QTimer m_vertical_fd_source_reset_timer;
@@ -90,8 +90,8 @@ FMCAutothrottle::FMCAutothrottle(ConfigWidgetProvider* config_widget_provider,
 
     // mode stuff
 
-    m_speed_mode_calc_timer = QTime::currentTime().addSecs(-60);
-    m_speed_mode_active_changed_time = QTime::currentTime().addSecs(-60);
+    m_speed_mode_calc_timer.startMsAgo(60000);
+    m_speed_mode_active_changed_time.startMsAgo(60000);
     m_idle_thrust_timer_triggered = false;
 
     // climb thrust
@@ -35,6 +35,7 @@
 #include "controller_speed.h"
 
 #include "fmc_autothrottle_defines.h"
+#include "sim_clock.h"
 
 class FMCControl;
 class FMCData;
@@ -181,25 +182,25 @@ protected:
 
     bool m_was_acceleration_set;
 
-    QTime m_speed_mode_calc_timer;
+    SimTimer m_speed_mode_calc_timer;
     SPEED_MODE m_speed_mode_active;
     SPEED_MODE m_speed_mode_armed;
-    QTime m_speed_mode_active_changed_time;
+    SimTimer m_speed_mode_active_changed_time;
 
     bool m_idle_thrust_timer_triggered;
-    QTime m_idle_thrust_timer;
+    SimTimer m_idle_thrust_timer;
 
     double m_current_takeoff_thrust;
     double m_current_flex_thrust;
     double m_current_max_continous_thrust;
-    QTime m_climb_thrust_calculate_timer;
+    SimTimer m_climb_thrust_calculate_timer;
     double m_current_climb_thrust;
 
     bool m_more_drag_necessary;
     bool m_more_drag_necessary_timer_started;
-    QTime m_more_drag_necessary_timer;
+    SimTimer m_more_drag_necessary_timer;
     bool m_more_drag_necessary_end_timer_started;
-    QTime m_more_drag_necessary_end_timer;
+    SimTimer m_more_drag_necessary_end_timer;
 
     bool m_use_airbus_throttle_mode;
     AIRBUS_THROTTLE_MODE m_current_airbus_throttle_mode;
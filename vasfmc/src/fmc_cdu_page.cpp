@@ -82,6 +82,10 @@ void FMCCDUPageStyleATest::paintPage(QPainter& painter) const
 /////////////////////////////////////////////////////////////////////////////
 /////////////////////////////////////////////////////////////////////////////
 
+#define SCRATCHPAD_SUGGESTION_COUNT 3
+#define SCRATCHPAD_SUGGESTION_MAX_TEXT_LENGTH 9
+const static QRegExp SCRATCHPAD_SUGGESTION_REGEXP = QRegExp("^[A-Z0-9]{2,}$");
+
 void FMCCDUPageStyleAScratchpad::paintPage(QPainter& painter) const
 {
     setFont(painter, NORM_FONT);
@@ -100,11 +104,38 @@ void FMCCDUPageStyleAScratchpad::paintPage(QPainter& painter) const
     else
     {                            
         drawTextLeft(painter,  1, 14, m_text);
+
+        if (m_text != m_suggestion_text) updateSuggestions();
+        if (!m_suggestions.isEmpty())
+        {
+            setFont(painter, SMALL_FONT);
+            drawTextRight(painter, 1, 14, m_suggestions.join(" "), CYAN);
+        }
     }
 }
 
 /////////////////////////////////////////////////////////////////////////////
 
+void FMCCDUPageStyleAScratchpad::updateSuggestions() const
+{
+    m_suggestion_text = m_text;
+    m_suggestions.clear();
+
+    if (m_text.length() > SCRATCHPAD_SUGGESTION_MAX_TEXT_LENGTH ||
+        !SCRATCHPAD_SUGGESTION_REGEXP.exactMatch(m_text)) return;
+
+    // ask for some more matches, the same ident may be found several times
+    NavdataIdentSearch::MatchList matches;
+    fmcControl().navdata().searchIdents(m_text, m_flightstatus->current_position_raw,
+                                        SCRATCHPAD_SUGGESTION_COUNT * 3, matches);
+
+    NavdataIdentSearch::MatchList::const_iterator iter = matches.begin();
+    for(; iter != matches.end() && m_suggestions.count() < SCRATCHPAD_SUGGESTION_COUNT; ++iter)
+        if (iter->ident != m_text && !m_suggestions.contains(iter->ident)) m_suggestions.append(iter->ident);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
 void FMCCDUPageStyleAScratchpad::processAction(const QString& action)
 {
     // if we have an override text, the user must clear the text at first
@@ -744,6 +775,10 @@ void FMCCDUPageStyleAFlightplan::paintPage(QPainter& painter) const
     const Airport *ades = fmcControl().normalRoute().destinationAirport();
     int prev_wpt_index = fmcControl().normalRoute().previousWaypointIndex();
 
+    // the leg tracks are shown relative to the magnetic north at their waypoint
+    QVector<double> declination_list;
+    fmcControl().normalRoute().calcDeclinations(declination_list);
+
     for(; index < fmcControl().normalRoute().count() ; ++index)
     {
         if (m_display_line_counter > 12) break;
@@ -811,7 +846,7 @@ void FMCCDUPageStyleAFlightplan::paintPage(QPainter& painter) const
                 if (m_display_line_counter <= 7)
                     drawTextLeft(painter, 9,m_display_line_counter-1, QString("TRK%1").
                                  arg(Navcalc::trimHeading(route_data.m_true_track_from_prev_wpt -
-                                                          m_flightstatus->magvar), 3, 'f', 0, QChar('0')), color);
+                                                          declination_list[index]), 3, 'f', 0, QChar('0')), color);
                 
                 drawTextRight(painter, 6, m_display_line_counter-1, 
                               QString("%1").arg(route_data.m_dist_from_prev_wpt_nm, 0, 'f', 0), color);
@@ -91,11 +91,21 @@ public:
     }
     inline void setAction(const QString& action) { m_action = action; }
 
+protected:
+
+    //! looks up the idents starting with or resembling the current text,
+    //! the nearest ones are shown as suggestions
+    void updateSuggestions() const;
+
 protected:
 
     QString m_text;    
     QString m_override_text;
     QString m_action;
+
+    //! the text the suggestions were looked up for
+    mutable QString m_suggestion_text;
+    mutable QStringList m_suggestions;
 };
 
 /////////////////////////////////////////////////////////////////////////////
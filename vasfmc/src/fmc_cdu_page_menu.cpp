@@ -29,6 +29,7 @@
 #include "fly_by_wire.h"
 #include "flight_mode_tracker.h"
 #include "checklist.h"
+#include "navdata_query_service.h"
 
 #include "fmc_data.h"
 #include "fmc_control.h"
@@ -60,7 +61,7 @@ const QString FMCCDUPageStyleAMenu::SYSTEM_DISPLAY2 = "DISPLAY2";
 
 FMCCDUPageStyleAMenu::FMCCDUPageStyleAMenu(const QString& page_name, FMCCDUPageManager* page_manager) :
     FMCCDUPageBase(page_name, page_manager), m_weather(CFG_WEATHER_FILENAME),
-    m_selected_compact_route_index(0), m_icao_route(0),
+    m_selected_compact_route_index(0), m_icao_route(0), m_icao_route_query(0),
     m_pushback_dist_before_turn_m(30), m_pushback_turn_direction_clockwise(true),
     m_pushback_turn_degrees(90), m_pushback_dist_after_turn_m(5), m_aircraft_data_load_page(false)
 {
@@ -86,6 +87,7 @@ FMCCDUPageStyleAMenu::FMCCDUPageStyleAMenu(const QString& page_name, FMCCDUPageM
 
 FMCCDUPageStyleAMenu::~FMCCDUPageStyleAMenu()
 {
+    // a pending ICAO route query is deleted by the query service
     delete m_icao_route;
 }
 
@@ -1011,29 +1013,17 @@ void FMCCDUPageStyleAMenu::processAction(const QString& action)
             }
 
             clearICAORoute();
-            m_icao_route = new FlightRoute(m_flightstatus);
-            MYASSERT(m_icao_route != 0);
 
-            QString error;
-            if (!m_icao_route->extractICAORoute(m_fp_adep + " " + text + " " + m_fp_ades, 
-                                                fmcControl().navdata(), LATLON_WAYPOINT_REGEXP, error))
-            {
-                clearICAORoute();
-                m_page_manager->scratchpad().setOverrideText(error);
-                return;
-            }
+            // the route is resolved in the background, see slotGotICAORoute()
+            m_icao_route_query = 
+                fmcControl().navdataQueryService().queryICAORoute(m_fp_adep + " " + text + " " + m_fp_ades);
+            MYASSERT(m_icao_route_query != 0);
+            MYASSERT(connect(m_icao_route_query, SIGNAL(signalFinished(NavdataQuery*)),
+                             this, SLOT(slotGotICAORoute(NavdataQuery*))));
 
-            if (m_icao_route->departureAirport() == 0 || m_icao_route->destinationAirport() == 0)
-            {
-                clearICAORoute();
-                m_page_manager->scratchpad().setOverrideText("No ADEP/ADES found");
-                return;
-            }
-
-            MYASSERT(m_icao_route != 0);
-            fmcControl().temporaryRoute() = *m_icao_route;
-
-            m_page_manager->scratchpad().processAction(FMCCDUPageBase::ACTION_CLRALL);
+            // the query may have been finished already by a coalesced query
+            if (m_icao_route_query->isFinished()) slotGotICAORoute(m_icao_route_query);
+            else m_page_manager->scratchpad().setOverrideText("PROCESSING ROUTE...");
         }
         else if (rlsk_index == 1)
         {
@@ -1713,6 +1703,13 @@ void FMCCDUPageStyleAMenu::setActive(bool active)
 
 void FMCCDUPageStyleAMenu::clearICAORoute()
 {
+    if (m_icao_route_query != 0)
+    {
+        m_icao_route_query->disconnect(this);
+        fmcControl().navdataQueryService().release(m_icao_route_query);
+        m_icao_route_query = 0;
+    }
+
     delete m_icao_route;
     m_icao_route = 0;
     fmcControl().temporaryRoute().clear();
@@ -1720,6 +1717,47 @@ void FMCCDUPageStyleAMenu::clearICAORoute()
 
 /////////////////////////////////////////////////////////////////////////////
 
+void FMCCDUPageStyleAMenu::slotGotICAORoute(NavdataQuery* query)
+{
+    // the query may have been released before the queued signal arrived
+    if (query == 0 || query != m_icao_route_query) return;
+
+    const NavdataResolvedRoute& resolved_route = query->route();
+    QString error;
+
+    if (!resolved_route.isValid())
+        error = resolved_route.error_text;
+    else if (resolved_route.departure_airport == 0 || resolved_route.destination_airport == 0)
+        error = "No ADEP/ADES found";
+
+    if (error.isEmpty())
+    {
+        delete m_icao_route;
+        m_icao_route = new FlightRoute(m_flightstatus);
+        MYASSERT(m_icao_route != 0);
+        m_icao_route->setICAORoute(resolved_route);
+    }
+
+    m_icao_route_query->disconnect(this);
+    fmcControl().navdataQueryService().release(m_icao_route_query);
+    m_icao_route_query = 0;
+
+    if (!error.isEmpty())
+    {
+        clearICAORoute();
+        m_page_manager->scratchpad().setOverrideText(error);
+        return;
+    }
+
+    MYASSERT(m_icao_route != 0);
+    fmcControl().temporaryRoute() = *m_icao_route;
+
+    m_page_manager->scratchpad().setOverrideText(QString::null);
+    m_page_manager->scratchpad().processAction(FMCCDUPageBase::ACTION_CLRALL);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
 void FMCCDUPageStyleAMenu::slotGotWeather(const QString& airport, const QString& date_string, const QString& weather_string)
 {
     m_vertical_scroll_offset = 0;
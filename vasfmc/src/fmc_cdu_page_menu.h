@@ -34,6 +34,7 @@
 #include "fmc_cdu_page_base.h"
 
 class FlightRoute;
+class NavdataQuery;
 
 /////////////////////////////////////////////////////////////////////////////
 
@@ -76,6 +77,8 @@ protected slots:
 
     void slotSetVerticalScrollOffsetForChecklist();
 
+    void slotGotICAORoute(NavdataQuery* query);
+
 protected:
 
     virtual void setActive(bool active);
@@ -104,6 +107,8 @@ protected:
     QStringList m_route_text_list;
 
     FlightRoute *m_icao_route;
+    //! the pending resolution of the entered ICAO route, 0 if none
+    NavdataQuery* m_icao_route_query;
 
     uint m_pushback_dist_before_turn_m;
     bool m_pushback_turn_direction_clockwise;
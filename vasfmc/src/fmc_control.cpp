@@ -40,8 +40,11 @@
 #ifdef HAVE_PLIB
 #include "fsaccess_fgfs.h"
 #endif /* HAVE_PLIB */
+#include "fsaccess_replay.h"
+#include "flight_recorder.h"
 #include "projection.h"
 #include "geodata.h"
+#include "navdata_query_service.h"
 #include "aircraft_data.h"
 #include "checklist.h"
 #include "fly_by_wire.h"
@@ -55,6 +58,7 @@
 #include "fmc_gps.h"
 #include "fmc_fcu.h"
 #include "fmc_cdu.h"
+#include "fmc_cdu_defines.h"
 #include "fmc_pfd.h"
 #include "fmc_navdisplay.h"
 #include "fmc_ecam.h"
@@ -75,6 +79,13 @@ const static QChar AIRWAY_WAYPOINT_SEPARATOR = '.';
 
 #define DO_TIMER_LOGGING 0
 
+// periods of the scheduled tasks, see setupTasks()
+#define TASK_FLIGHTSTATUS_PERIOD_MS 5
+#define TASK_POLL_PERIOD_MS 10
+#define TASK_FLIGHT_MODE_PERIOD_MS 50
+#define TASK_FSCTRL_INPUT_PERIOD_MS 50
+#define TASK_CONTROL_PERIOD_MS 250
+
 /////////////////////////////////////////////////////////////////////////////
 
 FMCControl::FMCControl(ConfigWidgetProvider* config_widget_provider,
@@ -83,8 +94,9 @@ FMCControl::FMCControl(ConfigWidgetProvider* config_widget_provider,
     m_gl_font(0), m_config_widget_provider(config_widget_provider), m_main_config(cfg),
     m_fmc_data(0), m_flight_mode_tracker(0), m_fmc_sounds_handler(0),
     m_flightstatus(new FlightStatus(cfg->getIntValue(CFG_FLIGHTSTATUS_SMOOTHING_DELAY_MS))),
-    m_fs_access(0), m_flight_status_checker(0), m_last_flight_status_checker_style(-1),
-    m_navdata(0), m_pbd_counter(0), m_declination_calc(cfg->getValue(CFG_DECLINATION_DATAFILE)),
+    m_flightstatus_publisher(new FlightStatusPublisher(cfg->getIntValue(CFG_FLIGHTSTATUS_SMOOTHING_DELAY_MS))),
+    m_flight_recorder(0), m_fs_access(0), m_flight_status_checker(0), m_last_flight_status_checker_style(-1),
+    m_task_scheduler(0), m_navdata(0), m_navdata_query_service(0), m_pbd_counter(0), m_declination_calc(cfg->getValue(CFG_DECLINATION_DATAFILE)),
     m_aircraft_data(new AircraftData(m_flightstatus)), m_aircraft_data_confirmed(false),
     m_checklist_manager(0), m_pfd_left_handler(0), m_pfd_right_handler(0), m_nd_left_handler(0), m_nd_right_handler(0), 
     m_gps_handler(0), m_fcu_handler(0), m_cdu_left_handler(0), m_cdu_right_handler(0), m_upper_ecam_handler(0),
@@ -98,6 +110,7 @@ FMCControl::FMCControl(ConfigWidgetProvider* config_widget_provider,
     MYASSERT(m_config_widget_provider != 0);
     MYASSERT(m_main_config != 0);
     MYASSERT(m_flightstatus != 0);
+    MYASSERT(m_flightstatus_publisher != 0);
     m_sbox_transponder_timer.start();
     m_date_time_sync_timer.start();
     MYASSERT(Declination::globalDeclination() != 0);
@@ -166,6 +179,8 @@ FMCControl::FMCControl(ConfigWidgetProvider* config_widget_provider,
     Logger::log("setup navdata");
     m_navdata = new Navdata(CFG_NAVDATA_FILENAME, CFG_NAVDATA_INDEX_FILENAME);
     MYASSERT(m_navdata);
+    m_navdata_query_service = new NavdataQueryService(*m_navdata, LATLON_WAYPOINT_REGEXP);
+    MYASSERT(m_navdata_query_service != 0);
 
     // init flight status checker
 
@@ -181,6 +196,20 @@ FMCControl::FMCControl(ConfigWidgetProvider* config_widget_provider,
     // init flightsim access
     setupFsAccess();
 
+    // init flight recorder, a replayed flight is not recorded again
+    if (!m_control_cfg->getValue(CFG_FLIGHT_RECORDER_FILE).isEmpty() &&
+        m_main_config->getValue(CFG_FS_ACCESS_TYPE) != FS_ACCESS_TYPE_REPLAY)
+    {
+        m_flight_recorder = new FlightRecorder;
+        MYASSERT(m_flight_recorder != 0);
+        if (!m_flight_recorder->open(m_control_cfg->getValue(CFG_FLIGHT_RECORDER_FILE),
+                                     m_control_cfg->getIntValue(CFG_FLIGHT_RECORDER_SIZE_MB)))
+        {
+            delete m_flight_recorder;
+            m_flight_recorder = 0;
+        }
+    }
+
     // init autopilot control
     m_fmc_autopilot = new FMCAutopilot(m_config_widget_provider, m_main_config, CFG_AUTOPILOT_FILENAME, this);
     MYASSERT(m_fmc_autopilot != 0);
@@ -201,35 +230,19 @@ FMCControl::FMCControl(ConfigWidgetProvider* config_widget_provider,
     MYASSERT(connect(m_fmc_data, SIGNAL(signalApproachPhaseActivated()),
                      this, SLOT(slotApproachPhaseActivated())));
 
+    MYASSERT(connect(&m_fmc_data->normalRoute(), SIGNAL(signalDestinationAirportChanged()),
+                     this, SLOT(slotDestinationAirportChanged())));
+
     MYASSERT(projection() != 0);
     m_fmc_data->normalRoute().setProjection(projection());
     m_fmc_data->alternateRoute().setProjection(projection());
     m_fmc_data->secondaryRoute().setProjection(projection());
     m_fmc_data->temporaryRoute().setProjection(projection());
 
-    // setup central timer and refresh timers
+    // setup the periodic processing
 
-    MYASSERT(connect(&m_central_timer, SIGNAL(timeout()), this, SLOT(slotCentralTimer())));
-    m_central_timer.start(2);
-
-    m_pfdnd_refresh_timer.start();
-    m_ecam_refresh_timer.start();
-    m_ap_athr_refresh_timer.start();
-    m_cdufcu_refresh_timer.start();
-    m_fsctrl_poll_timer.start();
-
-    m_pfdnd_refresh_ms = 1000;
-    m_ecam_refresh_ms = 1000;
-    m_ap_athr_refresh_ms = 1000;
-    m_cdufcu_refresh_ms = 1000;
-
-    m_pfdnd_refresh_index = 0;
-    m_ap_athr_refresh_index = 0;
-    m_cdufcu_refresh_index = 0;
     m_fsctrl_poll_index = 0;
-
-    // setup control timer
-    m_control_timer.start();
+    setupTasks();
 
     MYASSERT(connect(&m_pushback_timer, SIGNAL(timeout()), this, SLOT(slotPushBackTimer())));
 
@@ -297,7 +310,9 @@ FMCControl::FMCControl(ConfigWidgetProvider* config_widget_provider,
 
 FMCControl::~FMCControl()
 {
-    m_central_timer.stop();
+    // no task may run while the modules are deleted
+    delete m_task_scheduler;
+    m_task_scheduler = 0;
 
     if (!m_fmc_data->normalRoute().saveFP(m_persistance_filename))
         Logger::log(QString("~FMCControl: could not save persistant route to (%1)").
@@ -331,9 +346,12 @@ FMCControl::~FMCControl()
     delete m_fmc_autopilot;
     delete m_fmc_autothrottle;
     delete m_fs_access;
+    delete m_flight_recorder;
     delete m_flight_mode_tracker;
+    delete m_flightstatus_publisher;
     delete m_flightstatus;
     delete m_fmc_data;
+    delete m_navdata_query_service;
     delete m_navdata;
     delete m_geodata;
     delete m_gl_font;
@@ -420,6 +438,10 @@ void FMCControl::setupDefaultConfig()
     m_control_cfg->setValue(CFG_SYNC_CLOCK_DATE, 0);
     m_control_cfg->setValue(CFG_TCAS, CFG_TCAS_ON);
 
+    m_control_cfg->setValue(CFG_FLIGHT_RECORDER_FILE, "");
+    m_control_cfg->setValue(CFG_FLIGHT_RECORDER_SIZE_MB, 64);
+    m_control_cfg->setValue(CFG_TASK_SCHEDULER_REPORT_INTERVAL_S, 60);
+
     m_control_cfg->setValue(CFG_NOISE_GENERATION_INTERVAL_MS, 200);
     m_control_cfg->setValue(CFG_ADF_NOISE_LIMIT_DEG, 45.0);
     m_control_cfg->setValue(CFG_ADF_NOISE_INC_LIMIT_DEG, 15.0);
@@ -525,7 +547,12 @@ void FMCControl::setupFsAccess()
     delete m_fs_access;
     m_fs_access = 0;
 
-    if (m_main_config->getValue(CFG_FS_ACCESS_TYPE) == FS_ACCESS_TYPE_XPLANE)
+    if (m_main_config->getValue(CFG_FS_ACCESS_TYPE) == FS_ACCESS_TYPE_REPLAY)
+    {
+        Logger::log("Switching to replay access");
+        m_fs_access = new FSAccessReplay(m_config_widget_provider, CFG_REPLAY_FILENAME, m_flightstatus);
+    }
+    else if (m_main_config->getValue(CFG_FS_ACCESS_TYPE) == FS_ACCESS_TYPE_XPLANE)
     {
         Logger::log("Switching to XPLANE access");
 #if VASFMC_GAUGE
@@ -602,155 +629,188 @@ void FMCControl::recalcFlightstatus()
 
 /////////////////////////////////////////////////////////////////////////////
 
-void FMCControl::slotCentralTimer()
+void FMCControl::setupTasks()
 {
-    QTime overall_timer;
-    overall_timer.start();
+    m_task_scheduler = new TaskScheduler(this);
+    MYASSERT(m_task_scheduler != 0);
+    MYASSERT(connect(m_task_scheduler, SIGNAL(signalTimeUsed(const QString&, uint)),
+                     this, SIGNAL(signalTimeUsed(const QString&, uint))));
 
-    //TODO implement load balancing
-    slotControlTimer();
+    // The periods are set by updateTaskPeriods(). ND and FCU are shifted
+    // against PFD and CDU to spread the drawing, AP and ATHR run back to
+    // back. The processor, sounds and flight mode tracker keep their own
+    // refresh periods, their tasks only poll them.
 
-    if (m_fmc_processor != 0) m_fmc_processor->slotRefresh(false);
-    if (m_cpflight_serial != 0) m_cpflight_serial->slotWriteValues(false);
-    if (m_fmc_sounds_handler->fmcSounds() != 0) m_fmc_sounds_handler->fmcSounds()->slotCheckSoundsTimer();
+    m_task_scheduler->addTask(TASK_FLIGHTSTATUS, "FS", TaskScheduler::LANE_GUIDANCE, TASK_FLIGHTSTATUS_PERIOD_MS);
+    m_task_scheduler->addTask(TASK_AUTOPILOT, "AP", TaskScheduler::LANE_GUIDANCE, 1000);
+    m_task_scheduler->addTask(TASK_AUTOTHROTTLE, "ATHR", TaskScheduler::LANE_GUIDANCE, 1000);
 
-    m_flight_mode_tracker->slotCheckAndSetFlightMode();
+    m_task_scheduler->addTask(TASK_FMC_PROCESSOR, "PROC", TaskScheduler::LANE_PROCESSING, TASK_POLL_PERIOD_MS);
+    m_task_scheduler->addTask(TASK_CONTROL, "FC", TaskScheduler::LANE_PROCESSING, TASK_CONTROL_PERIOD_MS);
+    m_task_scheduler->addTask(TASK_FLIGHT_MODE, "FM", TaskScheduler::LANE_PROCESSING, TASK_FLIGHT_MODE_PERIOD_MS);
+    m_task_scheduler->addTask(TASK_SOUNDS, "SND", TaskScheduler::LANE_PROCESSING, TASK_POLL_PERIOD_MS);
+    m_task_scheduler->addTask(TASK_CPFLIGHT, "CPF", TaskScheduler::LANE_PROCESSING, TASK_POLL_PERIOD_MS);
+    m_task_scheduler->addTask(TASK_FSCTRL_INPUT, "FSCTRL", TaskScheduler::LANE_PROCESSING, TASK_FSCTRL_INPUT_PERIOD_MS);
 
-    //----- process FS CTRL input
+    m_task_scheduler->addTask(TASK_PFD, "PFD", TaskScheduler::LANE_DISPLAY, 1000);
+    m_task_scheduler->addTask(TASK_ND, "ND", TaskScheduler::LANE_DISPLAY, 1000, 0, 500);
+    m_task_scheduler->addTask(TASK_ECAM, "ECAM", TaskScheduler::LANE_DISPLAY, 1000);
+    m_task_scheduler->addTask(TASK_CDU, "CDU", TaskScheduler::LANE_DISPLAY, 1000);
+    m_task_scheduler->addTask(TASK_FCU, "FCU", TaskScheduler::LANE_DISPLAY, 1000, 0, 500);
 
-    if (m_fsctrl_poll_timer.elapsed() > 50)
-    {
-        switch(m_fsctrl_poll_index)
-        {
-            case(0): {
-                if (m_pfd_left_handler != 0 && m_pfd_left_handler->fmcPFD() != 0) 
-                    m_pfd_left_handler->fmcPFD()->processFSControls();
-                if (m_pfd_right_handler != 0 && m_pfd_right_handler->fmcPFD() != 0) 
-                    m_pfd_right_handler->fmcPFD()->processFSControls();
-                break;
-            }
-            case(1): {
-                if (m_nd_left_handler != 0 && m_nd_left_handler->fmcNavdisplay() != 0) 
-                    m_nd_left_handler->fmcNavdisplay()->processFSControls();
-                if (m_nd_right_handler != 0 && m_nd_right_handler->fmcNavdisplay() != 0) 
-                    m_nd_right_handler->fmcNavdisplay()->processFSControls();
-                break;
-            }
-            case(2): {
-                if (m_upper_ecam_handler != 0 && m_upper_ecam_handler->fmcECAM() != 0)
-                    m_upper_ecam_handler->fmcECAM()->processFSControls();
-                break;
-            }
-            case(3): {
-                if (m_cdu_left_handler != 0 && m_cdu_left_handler->fmcCduBase() != 0) 
-                    m_cdu_left_handler->fmcCduBase()->slotProcessInput();
-                if (m_cdu_right_handler != 0 && m_cdu_right_handler->fmcCduBase() != 0) 
-                    m_cdu_right_handler->fmcCduBase()->slotProcessInput();
-                break;
-            }
-            case(4): {
-                if (m_fcu_handler->fmcFcuBase() != 0) 
-                    m_fcu_handler->fmcFcuBase()->slotProcessInput();
-                break;
-            }
-        }
+    // the recorder encodes the published snapshots, so it does not touch
+    // the flightstatus written in this thread
+    m_task_scheduler->addTask(TASK_FLIGHT_RECORDER, "REC", TaskScheduler::LANE_WORKER, TASK_FLIGHTSTATUS_PERIOD_MS);
 
-        m_fsctrl_poll_timer.start();
-        m_fsctrl_poll_index = ++m_fsctrl_poll_index % 5;
-    }
+    m_task_scheduler->setTaskEnabled(TASK_FLIGHT_RECORDER, m_flight_recorder != 0);
 
-    //----- either call the CDU or FCU in one run
+    updateTaskPeriods();
+    m_task_scheduler->start();
+}
 
-    if (m_cdufcu_refresh_timer.elapsed() >= m_cdufcu_refresh_ms)
-    {
-        switch(m_cdufcu_refresh_index)
-        {
-            case(0): {
-                if (m_cdu_left_handler != 0 && m_cdu_left_handler->fmcCduBase() != 0) 
-                    m_cdu_left_handler->fmcCduBase()->slotRefresh();
-                if (m_cdu_right_handler != 0 && m_cdu_right_handler->fmcCduBase() != 0) 
-                    m_cdu_right_handler->fmcCduBase()->slotRefresh();
-                break;
-            }
-            case(1): {
-                if (m_fcu_handler->fmcFcuBase() != 0) 
-                    m_fcu_handler->fmcFcuBase()->slotRefresh();
-                break;
-            }
-        }
+/////////////////////////////////////////////////////////////////////////////
 
-        m_cdufcu_refresh_index = 1 - m_cdufcu_refresh_index;
-        m_cdufcu_refresh_timer.start();
-    }
+void FMCControl::updateTaskPeriods()
+{
+    m_task_scheduler->setReportInterval(m_control_cfg->getIntValue(CFG_TASK_SCHEDULER_REPORT_INTERVAL_S) * 1000);
 
-    //----- either call the AP or ATHR in one run
+    int ap_athr_period_ms = qMax(1, Navcalc::round(m_main_config->getIntValue(CFG_FLIGHTSTATUS_SMOOTHING_DELAY_MS)/4.0));
+    m_task_scheduler->setTaskPeriod(TASK_AUTOPILOT, ap_athr_period_ms);
+    m_task_scheduler->setTaskPeriod(TASK_AUTOTHROTTLE, ap_athr_period_ms);
 
-    if (m_ap_athr_refresh_timer.elapsed() >= m_ap_athr_refresh_ms)
-    {
-        switch(m_ap_athr_refresh_index)
-        {
-            case(0): {
-                m_fmc_autopilot->slotRefresh();
-                break;
-            }
-            case(1): {
-                m_fmc_autothrottle->slotRefresh();
-                break;
-            }
-        }
+    int pfdnd_period_ms = qMax(1, m_control_cfg->getIntValue(CFG_PFDND_REFRESH_PERIOD_MS));
+    m_task_scheduler->setTaskPeriod(TASK_PFD, pfdnd_period_ms);
+    m_task_scheduler->setTaskPeriod(TASK_ND, pfdnd_period_ms);
 
-        m_ap_athr_refresh_index = 1 - m_ap_athr_refresh_index;
-        m_ap_athr_refresh_timer.start();
-    }
+    m_task_scheduler->setTaskPeriod(TASK_ECAM, qMax(1, m_control_cfg->getIntValue(CFG_ECAM_REFRESH_PERIOD_MS)));
 
-    //----- either draw the PFD, ND 
+    int cdufcu_period_ms = qMax(1, m_control_cfg->getIntValue(CFG_CDUFCU_REFRESH_PERIOD_MS));
+    m_task_scheduler->setTaskPeriod(TASK_CDU, cdufcu_period_ms);
+    m_task_scheduler->setTaskPeriod(TASK_FCU, cdufcu_period_ms);
+}
+
+/////////////////////////////////////////////////////////////////////////////
 
-    if (m_pfdnd_refresh_timer.elapsed() >= m_pfdnd_refresh_ms)
+void FMCControl::runScheduledTask(int task_id)
+{
+    switch(task_id)
     {
-        switch(m_pfdnd_refresh_index)
-        {
-            case(0): {
-                if (m_pfd_left_handler != 0 && m_pfd_left_handler->fmcPFD() != 0) 
-                    m_pfd_left_handler->fmcPFD()->slotRefresh();
-                if (m_pfd_right_handler != 0 &&m_pfd_right_handler->fmcPFD() != 0) 
-                    m_pfd_right_handler->fmcPFD()->slotRefresh();
-                break;
-            }
-            case(1): {
-                if (m_nd_left_handler != 0 && m_nd_left_handler->fmcNavdisplay() != 0)
-                    m_nd_left_handler->fmcNavdisplay()->slotRefresh();
-                if (m_nd_right_handler != 0 && m_nd_right_handler->fmcNavdisplay() != 0) 
-                    m_nd_right_handler->fmcNavdisplay()->slotRefresh();
-                break;
-            }
+        case(TASK_FLIGHTSTATUS): {
+            // publish the flightstatus when updated by the FSAccess backend
+            m_flightstatus_publisher->publish(*m_flightstatus);
+            break;
         }
+        case(TASK_AUTOPILOT): {
+            m_fmc_autopilot->slotRefresh();
+            break;
+        }
+        case(TASK_AUTOTHROTTLE): {
+            m_fmc_autothrottle->slotRefresh();
+            break;
+        }
+        case(TASK_FMC_PROCESSOR): {
+            if (m_fmc_processor != 0) m_fmc_processor->slotRefresh(false);
+            break;
+        }
+        case(TASK_CONTROL): {
+            slotControlTimer();
+            break;
+        }
+        case(TASK_FLIGHT_MODE): {
+            m_flight_mode_tracker->slotCheckAndSetFlightMode();
+            break;
+        }
+        case(TASK_SOUNDS): {
+            if (m_fmc_sounds_handler->fmcSounds() != 0) m_fmc_sounds_handler->fmcSounds()->slotCheckSoundsTimer();
+            break;
+        }
+        case(TASK_CPFLIGHT): {
+            if (m_cpflight_serial != 0) m_cpflight_serial->slotWriteValues(false);
+            break;
+        }
+        case(TASK_FSCTRL_INPUT): {
+            switch(m_fsctrl_poll_index)
+            {
+                case(0): {
+                    if (m_pfd_left_handler != 0 && m_pfd_left_handler->fmcPFD() != 0) 
+                        m_pfd_left_handler->fmcPFD()->processFSControls();
+                    if (m_pfd_right_handler != 0 && m_pfd_right_handler->fmcPFD() != 0) 
+                        m_pfd_right_handler->fmcPFD()->processFSControls();
+                    break;
+                }
+                case(1): {
+                    if (m_nd_left_handler != 0 && m_nd_left_handler->fmcNavdisplay() != 0) 
+                        m_nd_left_handler->fmcNavdisplay()->processFSControls();
+                    if (m_nd_right_handler != 0 && m_nd_right_handler->fmcNavdisplay() != 0) 
+                        m_nd_right_handler->fmcNavdisplay()->processFSControls();
+                    break;
+                }
+                case(2): {
+                    if (m_upper_ecam_handler != 0 && m_upper_ecam_handler->fmcECAM() != 0)
+                        m_upper_ecam_handler->fmcECAM()->processFSControls();
+                    break;
+                }
+                case(3): {
+                    if (m_cdu_left_handler != 0 && m_cdu_left_handler->fmcCduBase() != 0) 
+                        m_cdu_left_handler->fmcCduBase()->slotProcessInput();
+                    if (m_cdu_right_handler != 0 && m_cdu_right_handler->fmcCduBase() != 0) 
+                        m_cdu_right_handler->fmcCduBase()->slotProcessInput();
+                    break;
+                }
+                case(4): {
+                    if (m_fcu_handler->fmcFcuBase() != 0) 
+                        m_fcu_handler->fmcFcuBase()->slotProcessInput();
+                    break;
+                }
+            }
 
-        m_pfdnd_refresh_index = 1 - m_pfdnd_refresh_index;
-        m_pfdnd_refresh_timer.start();
-    }
-
-    //----- either draw the UPPER or LOWER ECAM
-
-    if (m_ecam_refresh_timer.elapsed() >= m_ecam_refresh_ms)
-    {
-        if (m_upper_ecam_handler != 0 && m_upper_ecam_handler->fmcECAM() != 0) m_upper_ecam_handler->fmcECAM()->slotRefresh();
-        
-        m_ecam_refresh_timer.start();
+            m_fsctrl_poll_index = ++m_fsctrl_poll_index % 5;
+            break;
+        }
+        case(TASK_PFD): {
+            if (m_pfd_left_handler != 0 && m_pfd_left_handler->fmcPFD() != 0) 
+                m_pfd_left_handler->fmcPFD()->slotRefresh();
+            if (m_pfd_right_handler != 0 && m_pfd_right_handler->fmcPFD() != 0) 
+                m_pfd_right_handler->fmcPFD()->slotRefresh();
+            break;
+        }
+        case(TASK_ND): {
+            if (m_nd_left_handler != 0 && m_nd_left_handler->fmcNavdisplay() != 0)
+                m_nd_left_handler->fmcNavdisplay()->slotRefresh();
+            if (m_nd_right_handler != 0 && m_nd_right_handler->fmcNavdisplay() != 0) 
+                m_nd_right_handler->fmcNavdisplay()->slotRefresh();
+            break;
+        }
+        case(TASK_ECAM): {
+            if (m_upper_ecam_handler != 0 && m_upper_ecam_handler->fmcECAM() != 0) 
+                m_upper_ecam_handler->fmcECAM()->slotRefresh();
+            break;
+        }
+        case(TASK_CDU): {
+            if (m_cdu_left_handler != 0 && m_cdu_left_handler->fmcCduBase() != 0) 
+                m_cdu_left_handler->fmcCduBase()->slotRefresh();
+            if (m_cdu_right_handler != 0 && m_cdu_right_handler->fmcCduBase() != 0) 
+                m_cdu_right_handler->fmcCduBase()->slotRefresh();
+            break;
+        }
+        case(TASK_FCU): {
+            if (m_fcu_handler->fmcFcuBase() != 0) 
+                m_fcu_handler->fmcFcuBase()->slotRefresh();
+            break;
+        }
+        case(TASK_FLIGHT_RECORDER): {
+            // runs in a worker thread
+            FlightStatusSnapshot snapshot(*m_flightstatus_publisher);
+            if (snapshot.isValid()) m_flight_recorder->record(*snapshot, SimClock::nowMs());
+            break;
+        }
     }
-    
-    if (overall_timer.elapsed() > 100) 
-        Logger::log(QString("FMCControl:slotCentralTimer: elapsed = %1ms").arg(overall_timer.elapsed()));
-
-    emit signalTimeUsed("CT", overall_timer.elapsed());
 }
 
 /////////////////////////////////////////////////////////////////////////////
 
 void FMCControl::slotControlTimer()
 {
-    if (m_control_timer.elapsed() < 250) return;
-    m_control_timer.start();
-
 #if DO_TIMER_LOGGING
     QTime overall_timer;
     overall_timer.start();
@@ -760,10 +820,7 @@ void FMCControl::slotControlTimer()
 
     // recalc refresh times
 
-    m_ap_athr_refresh_ms = Navcalc::round(m_main_config->getIntValue(CFG_FLIGHTSTATUS_SMOOTHING_DELAY_MS)/8.0);
-    m_pfdnd_refresh_ms = Navcalc::round(m_control_cfg->getIntValue(CFG_PFDND_REFRESH_PERIOD_MS) / 2.0);
-    m_ecam_refresh_ms = Navcalc::round(m_control_cfg->getIntValue(CFG_ECAM_REFRESH_PERIOD_MS) / 1.0);
-    m_cdufcu_refresh_ms = Navcalc::round(m_control_cfg->getIntValue(CFG_CDUFCU_REFRESH_PERIOD_MS) / 2.0);
+    updateTaskPeriods();
 
     // check FMC connection mode
 
@@ -1029,6 +1086,15 @@ void FMCControl::slotApproachPhaseActivated()
 
 /////////////////////////////////////////////////////////////////////////////
 
+void FMCControl::slotDestinationAirportChanged()
+{
+    // load the procedures of the destination and the airports around it
+    if (normalRoute().destinationAirport() != 0)
+        m_navdata->prefetchProcedures(*normalRoute().destinationAirport());
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
 void FMCControl::syncDateTime()
 {
     if (isFMCConnectModeSlave() || m_date_time_sync_timer.elapsed() < 3000) return;
@@ -2051,7 +2117,7 @@ void FMCControl::calcNoiseLimits()
             // ADF1
             if (!m_flightstatus->adf1.id().isEmpty())
             {
-                m_navdata->getNdbListByCoordinates(m_flightstatus->current_position_raw, 2, 100, wpt_selection_list);
+                m_navdata->getNdbListByCoordinates(m_flightstatus->current_position_raw, 100, wpt_selection_list);
 
                 Waypoint* ndb_wpt = 0;
                 WaypointPtrListIterator iter(wpt_selection_list);
@@ -2101,7 +2167,7 @@ void FMCControl::calcNoiseLimits()
             // ADF2
             if (!m_flightstatus->adf2.id().isEmpty())
             {
-                m_navdata->getNdbListByCoordinates(m_flightstatus->current_position_raw, 2, 100, wpt_selection_list);
+                m_navdata->getNdbListByCoordinates(m_flightstatus->current_position_raw, 100, wpt_selection_list);
 
                 Waypoint* ndb_wpt = 0;
                 WaypointPtrListIterator iter(wpt_selection_list);
@@ -33,12 +33,15 @@
 #include "sid.h"
 #include "star.h"
 #include "flightstatus.h"
+#include "flightstatus_publisher.h"
 #include "fsaccess.h"
 #include "declination.h"
 
 #include "fmc_control_defines.h"
 #include "fmc_data.h"
 #include "fmc_processor.h"
+#include "sim_clock.h"
+#include "task_scheduler.h"
 
 class Config;
 class FMCData;
@@ -46,6 +49,7 @@ class FMCAutopilot;
 class FMCAutothrottle;
 class ProjectionBase;
 class GeoData;
+class NavdataQueryService;
 class ConfigWidgetProvider;
 class OpenGLText;
 class FlightStatusCheckerBase;
@@ -66,11 +70,12 @@ class TransportLayerTCPServer;
 class FlightModeTracker;
 class ChecklistManager;
 class NoiseGenerator;
+class FlightRecorder;
 
 /////////////////////////////////////////////////////////////////////////////
 
 //! FMC Control
-class FMCControl : public QObject, FlightStatusProvider, FSAccessProvider
+class FMCControl : public QObject, FlightStatusProvider, FSAccessProvider, TaskRunner
 {
     Q_OBJECT
 
@@ -159,6 +164,13 @@ public:
     virtual const FlightStatus* flightStatus() const { return m_flightstatus; }
     inline FlightStatus* flightStatus() { return m_flightstatus; }
 
+    //! Gives access to the published flight status snapshots, which may be
+    //! read from other threads (see FlightStatusSnapshot).
+    inline const FlightStatusPublisher& flightStatusPublisher() const { return *m_flightstatus_publisher; }
+
+    //! returns the scheduler of the periodic processing, e.g. for its statistics
+    inline const TaskScheduler& taskScheduler() const { return *m_task_scheduler; }
+
     //! give access to the flightsim. all modules should use this method
     //! because the access module may change during runtime.
     virtual FSAccess& fsAccess() { return *m_fs_access; }
@@ -182,6 +194,9 @@ public:
     //! const access to the navigation database
     inline const Navdata& navdata() const { return *m_navdata; }
 
+    //! runs navdata queries in the background
+    inline NavdataQueryService& navdataQueryService() { return *m_navdata_query_service; }
+
     //! access to the geometrical database
     inline GeoData& geoData() { return *m_geodata; }
     //! const access to the geometrical database
@@ -655,8 +670,6 @@ public slots:
 
 protected slots:
 
-    void slotCentralTimer();
-
     void slotControlTimer();
     void slotDataChanged(const QString& routeflag, bool direct_change, const QString& comment);
 
@@ -666,11 +679,38 @@ protected slots:
     void slotReceivedRemoteFMCData(qint16 data_type, QByteArray& data);
 
     void slotApproachPhaseActivated();
+    void slotDestinationAirportChanged();
 
 protected:
 
+    //! IDs of the tasks of m_task_scheduler
+    enum TASK { TASK_FLIGHTSTATUS = 0,
+                TASK_AUTOPILOT,
+                TASK_AUTOTHROTTLE,
+                TASK_FMC_PROCESSOR,
+                TASK_CONTROL,
+                TASK_FLIGHT_MODE,
+                TASK_SOUNDS,
+                TASK_CPFLIGHT,
+                TASK_FSCTRL_INPUT,
+                TASK_PFD,
+                TASK_ND,
+                TASK_ECAM,
+                TASK_CDU,
+                TASK_FCU,
+                TASK_FLIGHT_RECORDER
+    };
+
     void setupDefaultConfig();
 
+    //! adds the periodic processing to m_task_scheduler and starts it
+    void setupTasks();
+
+    //! sets the task periods from the configured refresh periods
+    void updateTaskPeriods();
+
+    virtual void runScheduledTask(int task_id);
+
     //! Checks if the given waypoint ID specifies an overfly waypoint.
     //! If so, the waypoint_id will be altered and true will be returned, false otherwise.
     bool checkForOverflyWaypoint(QString& waypoint_id);
@@ -709,6 +749,12 @@ protected:
 
     //! flight status data fed by the flightsim access module
     FlightStatus* m_flightstatus;
+
+    //! snapshots of m_flightstatus for readers in other threads
+    FlightStatusPublisher* m_flightstatus_publisher;
+
+    //! records m_flightstatus to a file when configured, 0 otherwise
+    FlightRecorder* m_flight_recorder;
     
     //! access to the flight simulator
     FSAccess* m_fs_access;
@@ -718,13 +764,11 @@ protected:
     int m_last_flight_status_checker_style;
 
     //! triggers processing for all submodules
-    QTimer m_central_timer;
-    
-    //! triggers control processing
-    QTime m_control_timer;
+    TaskScheduler* m_task_scheduler;
 
     //! navdata access
     Navdata* m_navdata;    
+    NavdataQueryService* m_navdata_query_service;
 
     //! geo database
     GeoData* m_geodata;
@@ -740,7 +784,7 @@ protected:
 
     uint m_pbd_counter;
 
-    QTime m_sbox_transponder_timer;
+    SimTimer m_sbox_transponder_timer;
 
     QTime m_date_time_sync_timer;
 
@@ -795,27 +839,9 @@ protected:
     QString m_last_fmc_connect_mode;
     TransportLayerTCPClient* m_fmc_connect_slave_tcp_client;
     TransportLayerTCPServer* m_fmc_connect_master_tcp_server;
-    QTime m_fmc_connect_master_mode_sync_timer;
-
-    //----- refresh timer
-
-    QTime m_pfdnd_refresh_timer;
-    int m_pfdnd_refresh_ms;
-    int m_pfdnd_refresh_index;
-
-    QTime m_ecam_refresh_timer;
-    int m_ecam_refresh_ms;
-    //TODOint m_ecam_refresh_index;
-
-    QTime m_ap_athr_refresh_timer;
-    int m_ap_athr_refresh_ms;
-    int m_ap_athr_refresh_index;
-
-    QTime m_cdufcu_refresh_timer;
-    int m_cdufcu_refresh_ms;
-    int m_cdufcu_refresh_index;
+    SimTimer m_fmc_connect_master_mode_sync_timer;
 
-    QTime m_fsctrl_poll_timer;
+    //! the FS control inputs of the displays are processed round robin
     int m_fsctrl_poll_index;
 
     // used to gather 
@@ -827,7 +853,7 @@ protected:
     NoiseGenerator* m_vor2_noise_generator;
     NoiseGenerator* m_ils1_noise_generator;
     NoiseGenerator* m_ils2_noise_generator;
-    QTime m_noise_limit_update_timer;
+    SimTimer m_noise_limit_update_timer;
     Damping m_noise_damping;
     uint m_noise_calc_index;
 
@@ -72,6 +72,10 @@
 #define CFG_CDU_DISPLAY_ONLY_MODE "cdu_display_only_mode"
 #define CFG_TCAS "tcas"
 
+#define CFG_FLIGHT_RECORDER_FILE "flight_recorder_file"
+#define CFG_FLIGHT_RECORDER_SIZE_MB "flight_recorder_size_mb"
+#define CFG_TASK_SCHEDULER_REPORT_INTERVAL_S "task_scheduler_report_interval_s"
+
 #define CFG_NOISE_GENERATION_INTERVAL_MS "noise_generation_intervall_ms"
 #define CFG_ADF_NOISE_LIMIT_DEG "adf_noise_limit_degrees"
 #define CFG_ADF_NOISE_INC_LIMIT_DEG "adf_noise_increase_limit_degrees"
@@ -30,6 +30,7 @@
 #include "fmc_data_provider.h"
 #include "flightroute.h"
 #include "airport.h"
+#include "navdata_spatial_index.h"
 
 class Config;
 class Airport;
@@ -37,6 +38,37 @@ class FlightStatus;
 
 /////////////////////////////////////////////////////////////////////////////
 
+//! Navaids around the aircraft. The hits reference the spatial lists of
+//! the navdata (see Navdata::spatialVor() etc.), so nothing is copied.
+struct SurroundingNavaidList
+{
+    SurroundingNavaidList() : projection_epoch(0) {}
+
+    inline int count() const { return hits.count(); }
+
+    inline void clear()
+    {
+        hits.clear();
+        lat.clear();
+        lon.clear();
+        x.clear();
+        y.clear();
+        projection_epoch = 0;
+    }
+
+    NavdataSpatialIndex::HitList hits;
+    //! positions of the hits
+    QVector<double> lat;
+    QVector<double> lon;
+    //! projected positions of the hits
+    QVector<double> x;
+    QVector<double> y;
+    //! epoch of the projection of x/y, see ProjectionBase::epoch()
+    uint projection_epoch;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+
 class FMCData : public QObject, public SerializationIface, public FMCDataProvider
 {
     Q_OBJECT
@@ -95,14 +127,14 @@ public:
 
     //-----  surrounding stuff
 
-    inline const WaypointPtrList& surroundingAirportList() const { return m_surrounding_airport_list; }
-    inline WaypointPtrList& surroundingAirportList() { return m_surrounding_airport_list; }
+    inline const SurroundingNavaidList& surroundingAirports() const { return m_surrounding_airports; }
+    inline SurroundingNavaidList& surroundingAirports() { return m_surrounding_airports; }
 
-    inline const WaypointPtrList& surroundingVorList() const { return m_surrounding_vor_list; }
-    inline WaypointPtrList& surroundingVorList() { return m_surrounding_vor_list; }
+    inline const SurroundingNavaidList& surroundingVors() const { return m_surrounding_vors; }
+    inline SurroundingNavaidList& surroundingVors() { return m_surrounding_vors; }
 
-    inline const WaypointPtrList& surroundingNdbList() const { return m_surrounding_ndb_list; }
-    inline WaypointPtrList& surroundingNdbList() { return m_surrounding_ndb_list; }
+    inline const SurroundingNavaidList& surroundingNdbs() const { return m_surrounding_ndbs; }
+    inline SurroundingNavaidList& surroundingNdbs() { return m_surrounding_ndbs; }
 
     //----- speeds, performance stuff, etc.
 
@@ -313,9 +345,9 @@ protected:
 
     //----- surrounding stuff
 
-    WaypointPtrList m_surrounding_airport_list;
-    WaypointPtrList m_surrounding_vor_list;
-    WaypointPtrList m_surrounding_ndb_list;
+    SurroundingNavaidList m_surrounding_airports;
+    SurroundingNavaidList m_surrounding_vors;
+    SurroundingNavaidList m_surrounding_ndbs;
 
     //----- speeds, performance stuff, etc.
 
@@ -28,6 +28,7 @@
 #include "navcalc.h"
 #include "waypoint.h"
 #include "flightstatus.h"
+#include "flightstatus_publisher.h"
 #include "vas_path.h"
 
 #include "opengltext.h"
@@ -157,6 +158,22 @@ void GLNavdisplayWidget::paintGL()
 {
     if (!isVisible()) return;
 
+    // draw from the latest published flightstatus, the live one is written
+    // by the FSAccess backends while the display is drawn
+    FlightStatusSnapshot snapshot(m_fmc_control->flightStatusPublisher());
+    if (snapshot.isValid()) m_flightstatus = &(*snapshot);
+
+    paintDisplay();
+
+    m_flightstatus = m_fmc_control->flightStatus();
+    if (m_style != 0) m_style->setFlightStatus(m_flightstatus);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void GLNavdisplayWidget::paintDisplay()
+{
+
     //TODO disabled PLAN mode for right ND - we have to split the
     //projection (see fmc processor) in order to make this work
     if (!m_left_side && (m_current_mode == CFG_ND_DISPLAY_MODE_NAV_PLAN || 
@@ -234,6 +251,7 @@ void GLNavdisplayWidget::paintGL()
     
     if (m_style == 0 || (m_flightstatus->isValid() && !m_flightstatus->battery_on)) return;
 
+    m_style->setFlightStatus(m_flightstatus);
     drawDisplay();
    
     glFlush();
@@ -63,6 +63,9 @@ protected:
     void paintGL();
     void resizeGL(int width, int height);
 
+    //! draws the display from m_flightstatus
+    void paintDisplay();
+
 	void setupStateBeforeDraw();
 	void drawDisplay();
 
@@ -80,7 +83,8 @@ protected:
     Config* m_tcas_config;
 
     FMCControl* m_fmc_control;
-    FlightStatus* m_flightstatus;
+    //! the published flightstatus snapshot while painting
+    const FlightStatus* m_flightstatus;
     const ProjectionBase* m_projection;
 
     QSize m_size;
@@ -28,6 +28,7 @@
 #include "airport.h"
 #include "runway.h"
 #include "navcalc.h"
+#include "navdata.h"
 #include "fmc_control.h"
 #include "projection_mercator.h"
 #include "geodata.h"
@@ -177,29 +178,41 @@ void FMCNavdisplayStyle::drawSurroundingItems(const double& north_track_rotation
     // rotate for heading
     glRotated(-north_track_rotation, 0, 0, 1.0);
     
-    if (m_fmc_control->showSurroundingAirports(m_left_side))
+    const Navdata& navdata = m_fmc_control->navdata();
+
+    // lists projected with an older epoch are skipped until the FMC
+    // processor projected them again
+
+    if (m_fmc_control->showSurroundingAirports(m_left_side) &&
+        m_fmc_data.surroundingAirports().projection_epoch == m_projection->epoch())
     {
-        WaypointPtrListIterator airport_iter(m_fmc_data.surroundingAirportList());
-        while(airport_iter.hasNext()) 
-            drawAirport(*((*airport_iter.next()).asAirport()), north_track_rotation, item_color, true, false);
+        const SurroundingNavaidList& airports = m_fmc_data.surroundingAirports();
+        for(int index = 0; index < airports.count(); ++index)
+            drawItemSymbol(airports.x[index], airports.y[index], navdata.spatialAirport(airports.hits[index]).id(),
+                           m_airport_item_gllist, north_track_rotation, item_color);
     }
 
-    if (m_fmc_control->showSurroundingVORs(m_left_side))
+    if (m_fmc_control->showSurroundingVORs(m_left_side) &&
+        m_fmc_data.surroundingVors().projection_epoch == m_projection->epoch())
     {
-        WaypointPtrListIterator vor_iter(m_fmc_data.surroundingVorList());
-        while(vor_iter.hasNext()) 
+        const SurroundingNavaidList& vors = m_fmc_data.surroundingVors();
+        for(int index = 0; index < vors.count(); ++index)
         {
-            const Waypoint* vor = vor_iter.next();
-            if (vor->id() == m_flightstatus->nav1.id() || vor->id() == m_flightstatus->nav2.id()) continue;
-            drawVor(*vor, vor->asVor()->hasDME(), north_track_rotation, item_color);
+            const Vor& vor = navdata.spatialVor(vors.hits[index]);
+            if (vor.id() == m_flightstatus->nav1.id() || vor.id() == m_flightstatus->nav2.id()) continue;
+            drawItemSymbol(vors.x[index], vors.y[index], vor.id(),
+                           vor.hasDME() ? m_vor_dme_item_gllist : m_vor_wo_dme_item_gllist,
+                           north_track_rotation, item_color);
         }
     }
 
-    if (m_fmc_control->showSurroundingNDBs(m_left_side))
+    if (m_fmc_control->showSurroundingNDBs(m_left_side) &&
+        m_fmc_data.surroundingNdbs().projection_epoch == m_projection->epoch())
     {
-        WaypointPtrListIterator ndb_iter(m_fmc_data.surroundingNdbList());
-        while(ndb_iter.hasNext()) 
-            drawNdb(*((*ndb_iter.next()).asNdb()), north_track_rotation, item_color);
+        const SurroundingNavaidList& ndbs = m_fmc_data.surroundingNdbs();
+        for(int index = 0; index < ndbs.count(); ++index)
+            drawItemSymbol(ndbs.x[index], ndbs.y[index], navdata.spatialNdb(ndbs.hits[index]).id(),
+                           m_ndb_item_gllist, north_track_rotation, item_color);
     }
 
     #ifdef DO_PERF
@@ -221,20 +234,9 @@ void FMCNavdisplayStyle::drawAirport(const Airport& airport,
 
     if (draw_airport)
     {
-        glPushMatrix();
-        glTranslated(scaleXY(airport.x()), scaleXY(airport.y()), 0.0);
-        glRotated(+north_track_rotation, 0, 0, 1.0);
-
-        m_parent->qglColor(airport_symbol_color);
-
-        if (m_main_config->getIntValue(CFG_STYLE) == CFG_STYLE_A)
-            drawText(7.0, -1.0, airport.id());
-        else 
-            drawText(7.0, +m_font_height, airport.id());
-
-        glCallList(m_airport_item_gllist);
-
-        glPopMatrix();
+        QPointF airport_xy = m_projection->pointXY(airport);
+        drawItemSymbol(airport_xy.x(), airport_xy.y(), airport.id(), m_airport_item_gllist,
+                       north_track_rotation, airport_symbol_color);
     }
 
     // draw runways
@@ -284,21 +286,9 @@ void FMCNavdisplayStyle::drawVor(const Waypoint& vor,
                                  const double& north_track_rotation,
                                  const QColor& vor_symbol_color)
 {
-    glPushMatrix();
-
-    glTranslated(scaleXY(vor.x()), scaleXY(vor.y()), 0.0);
-    glRotated(+north_track_rotation, 0, 0, 1.0);
-
-    m_parent->qglColor(vor_symbol_color);
-    if (m_main_config->getIntValue(CFG_STYLE) == CFG_STYLE_A)
-        drawText(7.0, -1.0, vor.id());
-    else
-        drawText(7.0, m_font_height, vor.id());
-
-    if (has_dme) glCallList(m_vor_dme_item_gllist);
-    else         glCallList(m_vor_wo_dme_item_gllist);
-    
-    glPopMatrix();
+    QPointF vor_xy = m_projection->pointXY(vor);
+    drawItemSymbol(vor_xy.x(), vor_xy.y(), vor.id(), has_dme ? m_vor_dme_item_gllist : m_vor_wo_dme_item_gllist,
+                   north_track_rotation, vor_symbol_color);
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -306,19 +296,32 @@ void FMCNavdisplayStyle::drawVor(const Waypoint& vor,
 void FMCNavdisplayStyle::drawNdb(const Ndb& ndb, 
                                  const double& north_track_rotation,
                                  const QColor& ndb_symbol_color)
+{
+    QPointF ndb_xy = m_projection->pointXY(ndb);
+    drawItemSymbol(ndb_xy.x(), ndb_xy.y(), ndb.id(), m_ndb_item_gllist, north_track_rotation, ndb_symbol_color);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void FMCNavdisplayStyle::drawItemSymbol(const double& x,
+                                        const double& y,
+                                        const QString& id,
+                                        GLuint symbol_gllist,
+                                        const double& north_track_rotation,
+                                        const QColor& symbol_color)
 {
     glPushMatrix();
 
-    glTranslated(scaleXY(ndb.x()), scaleXY(ndb.y()), 0.0);
+    glTranslated(scaleXY(x), scaleXY(y), 0.0);
     glRotated(+north_track_rotation, 0, 0, 1.0);
 
-    m_parent->qglColor(ndb_symbol_color);
+    m_parent->qglColor(symbol_color);
     if (m_main_config->getIntValue(CFG_STYLE) == CFG_STYLE_A)
-        drawText(7.0, -1.0, ndb.id());
+        drawText(7.0, -1.0, id);
     else
-        drawText(7.0, m_font_height, ndb.id());
+        drawText(7.0, m_font_height, id);
 
-    glCallList(m_ndb_item_gllist);
+    glCallList(symbol_gllist);
     
     glPopMatrix();
 }
@@ -562,19 +565,35 @@ void FMCNavdisplayStyle::drawGeoData(const double& north_track_rotation, const Q
     glLineWidth(1.0);
     glRotated(-north_track_rotation, 0, 0, 1.0);
 
-    RoutePtrListIterator route_iter(m_fmc_control->geoData().activeRouteList());
-    while(route_iter.hasNext())
+    // the level of detail whose error stays below one pixel at the current range
+    int level = (m_dist_scale_factor > 0.0) ? GeoData::levelForResolution(1.0 / m_dist_scale_factor) : 0;
+    m_fmc_control->geoData().setLevelDrawn(level);
+
+    // polygons projected with an older epoch are skipped until the FMC
+    // processor projected them again
+    const GeoPolygonStore& polygons = m_fmc_control->geoData().activePolygons(level);
+    if (polygons.isProjected() && polygons.projectionEpoch() == m_projection->epoch())
     {
-        filled ? glBegin(GL_POLYGON) : glBegin(GL_LINE_STRIP);
+        // the tile parts of an outline can only be drawn as lines, they
+        // are replaced by whole polygons with the next geo data update
+        filled = filled && m_fmc_control->geoData().activePolygonsFilled();
+
+        const float* x = polygons.xArray();
+        const float* y = polygons.yArray();
 
-        WaypointPtrListIterator wpt_iter(route_iter.next()->waypointList());
-        while(wpt_iter.hasNext())
+        int max = polygons.count();
+        for(int index = 0; index < max; ++index)
         {
-            const Waypoint* wpt = wpt_iter.next();
-            glVertex2d(scaleXY(wpt->x()), scaleXY(wpt->y()));
-        }
+            const GeoPolygon& polygon = polygons.polygon(index);
+
+            filled ? glBegin(GL_POLYGON) : glBegin(GL_LINE_STRIP);
 
-        glEnd();
+            int point_end = polygon.first_point + polygon.point_count;
+            for(int point = polygon.first_point; point < point_end; ++point)
+                glVertex2d(scaleXY(x[point]), scaleXY(y[point]));
+
+            glEnd();
+        }
     }
 
     #ifdef DO_PERF
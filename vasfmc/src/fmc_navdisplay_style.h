@@ -71,6 +71,10 @@ public:
 
     inline Config* config() { return m_navdisplay_style_config; }
 
+    //! sets the flightstatus to draw from, e.g. a published snapshot
+    inline void setFlightStatus(const FlightStatus* flightstatus)
+    { MYASSERT(flightstatus != 0); m_flightstatus = flightstatus; }
+
     virtual void reset(const QSize& size,
                        const double& display_top_offset,
                        const int& max_drawable_y,
@@ -119,6 +123,14 @@ public:
                          const double& north_track_rotation,
                          const QColor& ndb_symbol_color);
 
+    //! draws the given symbol list with the ID at the given x/y position
+    void drawItemSymbol(const double& x,
+                        const double& y,
+                        const QString& id,
+                        GLuint symbol_gllist,
+                        const double& north_track_rotation,
+                        const QColor& symbol_color);
+
     inline void drawText(const double& x,const double& y, const QString& text) { m_font->drawText(x, y, text); }
     inline double getTextWidth(const QString& text) const { return m_font->getWidth(text); }
 
@@ -133,11 +145,26 @@ protected:
 
     inline double scaleXY(const double& coord) { return coord * m_dist_scale_factor; }
 
+    //! Moves to the aircraft position, the center correction of the
+    //! projection is applied relative to it, see
+    //! ProjectionBase::centerCorrection().
     inline void moveToCorrectedProjectionPosition(const double& north_track_rotation)
     {
         glRotated(-north_track_rotation, 0, 0, 1.0);
-        glTranslated(-scaleXY(m_flightstatus->current_position_smoothed.x()),
-                     -scaleXY(m_flightstatus->current_position_smoothed.y()), 0.0);
+
+        const QMatrix& correction = m_projection->centerCorrection();
+        if (!correction.isIdentity())
+        {
+            GLdouble linear_part[16] = { correction.m11(), correction.m12(), 0.0, 0.0,
+                                         correction.m21(), correction.m22(), 0.0, 0.0,
+                                         0.0, 0.0, 1.0, 0.0,
+                                         0.0, 0.0, 0.0, 1.0 };
+            glMultMatrixd(linear_part);
+        }
+
+        // the flightstatus snapshot may be older than the projection
+        QPointF position_xy = m_projection->pointXY(m_flightstatus->current_position_smoothed);
+        glTranslated(-scaleXY(position_xy.x()), -scaleXY(position_xy.y()), 0.0);
         glRotated(north_track_rotation, 0, 0, 1.0);
     }
 
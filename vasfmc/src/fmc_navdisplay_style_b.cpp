@@ -608,7 +608,10 @@ void FMCNavdisplayStyleB::drawRouteNormalMode(const FlightRoute& route, const do
 
         // test every third waypoint for distance
         if (reached_active_wpt && wpt_index % 3 == 0)
-            stop_drawing = (wpt->x() * wpt->x()) + (wpt->y() * wpt->y()) > max_display_range_quad;
+        {
+            QPointF wpt_xy = m_projection->pointXY(*wpt);
+            stop_drawing = (wpt_xy.x() * wpt_xy.x()) + (wpt_xy.y() * wpt_xy.y()) > max_display_range_quad;
+        }
 
         if(!stop_drawing && iter.hasNext()) drawLeg(wpt, iter.peekNext(), north_track_rotation, leg_color, do_stiple_legs);
 
@@ -1111,7 +1114,8 @@ void FMCNavdisplayStyleB::drawSpecialWaypoint(const Waypoint* wpt,
 
     // rotate for heading
 
-    glTranslated(scaleXY(wpt->x()), scaleXY(wpt->y()), 0.0);
+    QPointF wpt_xy = m_projection->pointXY(*wpt);
+    glTranslated(scaleXY(wpt_xy.x()), scaleXY(wpt_xy.y()), 0.0);
     glRotated(north_track_rotation, 0, 0, 1.0);
     m_parent->qglColor(color);
 
@@ -1136,7 +1140,8 @@ void FMCNavdisplayStyleB::drawWaypoint(const Waypoint* wpt,
 
     // rotate for heading
 
-    glTranslated(scaleXY(wpt->x()), scaleXY(wpt->y()), 0.0);
+    QPointF wpt_xy = m_projection->pointXY(*wpt);
+    glTranslated(scaleXY(wpt_xy.x()), scaleXY(wpt_xy.y()), 0.0);
     glRotated(north_track_rotation, 0, 0, 1.0);
 
     // draw waypoint
@@ -1206,7 +1211,10 @@ void FMCNavdisplayStyleB::drawLeg(const Waypoint* from_wpt,
 
     // rotate for heading
 
-    glTranslated(scaleXY(from_wpt->x()), scaleXY(from_wpt->y()), 0.0);
+    QPointF from_xy = m_projection->pointXY(*from_wpt);
+    QPointF to_xy = m_projection->pointXY(*to_wpt);
+
+    glTranslated(scaleXY(from_xy.x()), scaleXY(from_xy.y()), 0.0);
 
     // draw leg
 
@@ -1221,8 +1229,8 @@ void FMCNavdisplayStyleB::drawLeg(const Waypoint* from_wpt,
 
     glBegin(GL_LINES);
     glVertex2d(0, 0);
-    glVertex2d(scaleXY(to_wpt->x()) - scaleXY(from_wpt->x()),
-               scaleXY(to_wpt->y()) - scaleXY(from_wpt->y()));
+    glVertex2d(scaleXY(to_xy.x()) - scaleXY(from_xy.x()),
+               scaleXY(to_xy.y()) - scaleXY(from_xy.y()));
     glEnd();
 
     if (do_stiple) glDisable(GL_LINE_STIPPLE);
@@ -1247,7 +1255,8 @@ void FMCNavdisplayStyleB::drawRouteMapMode(const FlightRoute& route)
     const Waypoint* view_wpt = m_fmc_control->normalRoute().viewWpt();
     if (view_wpt == 0) return;
 
-    glTranslated(-scaleXY(view_wpt->x()), -scaleXY(view_wpt->y()), 0);
+    QPointF view_wpt_xy = m_projection->pointXY(*view_wpt);
+    glTranslated(-scaleXY(view_wpt_xy.x()), -scaleXY(view_wpt_xy.y()), 0);
 
     // loop through the route waypoints
 
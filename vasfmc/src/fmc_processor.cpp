@@ -23,6 +23,7 @@
 */
 
 #include <QDateTime>
+#include <QMatrix>
 
 #include "assert.h"
 #include "logger.h"
@@ -55,6 +56,8 @@
 #define CFG_WPT_TIMES_RECALC_PERIOD_MS "waypoint_times_recalc_period_milliseconds"
 #define CFG_ALT_REACH_RECALC_PERIOD_MS "altitude_reach_recalc_period_milliseconds"
 #define CFG_PROJECTION_RECALC_DISTANCE_NM "projection_recalc_distance_nm"
+#define CFG_PROJECTION_CORRECTION_RANGE_NM "projection_correction_range_nm"
+#define CFG_PROJECTION_MAX_CORRECTION_ERROR_NM "projection_max_correction_error_nm"
 #define CFG_MAX_ONGROUND_WPT_SKIP_DIST_NM "max_onground_wpt_skip_dist_nm"
 #define CFG_MAX_SURROUNDING_AIRPORT_DIST_NM "max_surrounding_airport_dist_nm"
 #define CFG_MAX_SURROUNDING_VOR_DIST_NM "max_surrounding_vor_dist_nm"
@@ -134,6 +137,8 @@ void FMCProcessor::setupDefaultConfig()
     m_processor_cfg->setValue(CFG_WPT_TIMES_RECALC_PERIOD_MS, 5000);
     m_processor_cfg->setValue(CFG_ALT_REACH_RECALC_PERIOD_MS, 500);
     m_processor_cfg->setValue(CFG_PROJECTION_RECALC_DISTANCE_NM, 20.0);
+    m_processor_cfg->setValue(CFG_PROJECTION_CORRECTION_RANGE_NM, 160.0);
+    m_processor_cfg->setValue(CFG_PROJECTION_MAX_CORRECTION_ERROR_NM, 0.02);
     m_processor_cfg->setValue(CFG_MAX_ONGROUND_WPT_SKIP_DIST_NM, 5.0);
 
     m_processor_cfg->setValue(CFG_MAX_SURROUNDING_AIRPORT_DIST_NM, 80);
@@ -198,13 +203,18 @@ void FMCProcessor::slotRefresh(bool force)
 
         //----- set active stuff
         
+        // the unit vectors of the route waypoints are cached, the one of
+        // the current position is only calculated once per refresh
+        const GeoVector& current_pos = m_flightstatus->current_position_raw.unitVector();
+
         if (active_wpt != 0)
         {
-            m_fmc_data.setDistanceToActiveWptNm(
-                Navcalc::getDistBetweenWaypoints(m_flightstatus->current_position_raw, *active_wpt));
-            
-            m_fmc_data.setTrueTrackToActiveWpt(
-                Navcalc::getTrackBetweenWaypoints(m_flightstatus->current_position_raw, *active_wpt));
+            double distance_nm = 0.0;
+            double track = 0.0;
+            Navcalc::getDistAndTrackBetweenWaypoints(current_pos, active_wpt->unitVector(), distance_nm, track);
+
+            m_fmc_data.setDistanceToActiveWptNm(distance_nm);
+            m_fmc_data.setTrueTrackToActiveWpt(track);
             
             if (m_flightstatus->ground_speed_kts < 30.0)
                 m_fmc_data.setHoursToActiveWpt(0.0);
@@ -217,16 +227,11 @@ void FMCProcessor::slotRefresh(bool force)
         if (prev_wpt != 0)
         {
             m_fmc_data.setDistanceFromPreviousWptNm(
-                Navcalc::getDistBetweenWaypoints(m_flightstatus->current_position_raw, *prev_wpt));
+                Navcalc::getDistBetweenWaypoints(current_pos, prev_wpt->unitVector()));
             
-            double dummy1 = 0.0;
-            double dummy2 = 0.0;
-            double dummy3 = 0.0;
-
             if (active_wpt != 0)
                 m_fmc_data.setCrossTrackDistanceNm(
-                    Navcalc::getCrossTrackDistance(*prev_wpt, *active_wpt, m_flightstatus->current_position_raw, 
-                                                   dummy1, dummy2, dummy3));
+                    Navcalc::getCrossTrackDistance(prev_wpt->unitVector(), active_wpt->unitVector(), current_pos));
         }
 
         //----- check if to switch to the next waypoint and update last removed waypoint
@@ -684,8 +689,30 @@ void FMCProcessor::slotRefresh(bool force)
 
     dist_to_projection_center = 
         Navcalc::getDistBetweenWaypoints(m_projection->getCenter(), view_center);
+
+    // when the center moved only slightly, the existing x/y values are
+    // corrected by an affine transformation instead of a full
+    // recalculation, which is only done when the correction gets too
+    // inaccurate. Projections not supporting this fall back to the
+    // recalc distance.
+
+    QMatrix center_correction;
+    double correction_error_nm = -1.0;
+    if (!m_data_changed && dist_to_projection_center > 0.0)
+        correction_error_nm = m_projection->calcCenterCorrection(
+            view_center, m_processor_cfg->getDoubleValue(CFG_PROJECTION_CORRECTION_RANGE_NM), center_correction);
+
+    bool recalc_projection = m_data_changed;
+    if (correction_error_nm < 0.0)
+        recalc_projection |= 
+            dist_to_projection_center >= m_processor_cfg->getDoubleValue(CFG_PROJECTION_RECALC_DISTANCE_NM);
+    else
+        recalc_projection |= 
+            correction_error_nm > m_processor_cfg->getDoubleValue(CFG_PROJECTION_MAX_CORRECTION_ERROR_NM);
+
+    if (!recalc_projection && correction_error_nm >= 0.0) m_projection->setCenterCorrection(center_correction);
     
-    if (m_data_changed || dist_to_projection_center >= m_processor_cfg->getDoubleValue(CFG_PROJECTION_RECALC_DISTANCE_NM))
+    if (recalc_projection)
     {
         //Logger::log(QString("FMCProcessor:refresh: projection recalc, dist=%1nm").arg(dist_to_projection_center));
 
@@ -783,40 +810,57 @@ void FMCProcessor::slotRefresh(bool force)
     {
         // process surrounding airports
 
-        m_fmc_data.surroundingAirportList().clear();
-        m_navdata->getAirportListByCoordinates(
-            view_center, 2, 
-            m_processor_cfg->getIntValue(CFG_MAX_SURROUNDING_AIRPORT_DIST_NM),
-            m_fmc_data.surroundingAirportList());
-        
-        WaypointPtrListIterator airport_iter(m_fmc_data.surroundingAirportList());
-        while(airport_iter.hasNext()) m_projection->convertLatLonToXY(*airport_iter.next());
+        SurroundingNavaidList& airports = m_fmc_data.surroundingAirports();
+        airports.clear();
+        m_navdata->getAirportsWithinRadius(
+            view_center, m_processor_cfg->getIntValue(CFG_MAX_SURROUNDING_AIRPORT_DIST_NM), airports.hits);
+
+        for(int index = 0; index < airports.count(); ++index)
+        {
+            const Airport& airport = m_navdata->spatialAirport(airports.hits[index]);
+            airports.lat.append(airport.lat());
+            airports.lon.append(airport.lon());
+        }
+
+        calcProjection(airports);
     }
 
     if (m_project_recalc_vors == 0)
     {
         // process surrounding vors
         
-        m_fmc_data.surroundingVorList().clear();        
-        m_navdata->getVorListByCoordinates(view_center, 2, 
-                                           m_processor_cfg->getIntValue(CFG_MAX_SURROUNDING_VOR_DIST_NM),
-                                           m_fmc_data.surroundingVorList());
-        
-        WaypointPtrListIterator vor_iter(m_fmc_data.surroundingVorList());
-        while(vor_iter.hasNext()) m_projection->convertLatLonToXY(*vor_iter.next());
+        SurroundingNavaidList& vors = m_fmc_data.surroundingVors();
+        vors.clear();
+        m_navdata->getVorsWithinRadius(
+            view_center, m_processor_cfg->getIntValue(CFG_MAX_SURROUNDING_VOR_DIST_NM), vors.hits);
+
+        for(int index = 0; index < vors.count(); ++index)
+        {
+            const Vor& vor = m_navdata->spatialVor(vors.hits[index]);
+            vors.lat.append(vor.lat());
+            vors.lon.append(vor.lon());
+        }
+
+        calcProjection(vors);
     }
 
     if (m_project_recalc_ndbs == 0)
     {
         // process surrounding ndbs
 
-        m_fmc_data.surroundingNdbList().clear();
-        m_navdata->getNdbListByCoordinates(view_center, 2, 
-                                           m_processor_cfg->getIntValue(CFG_MAX_SURROUNDING_NDB_DIST_NM),
-                                           m_fmc_data.surroundingNdbList());
-        
-        WaypointPtrListIterator ndb_iter(m_fmc_data.surroundingNdbList());
-        while(ndb_iter.hasNext()) m_projection->convertLatLonToXY(*ndb_iter.next());
+        SurroundingNavaidList& ndbs = m_fmc_data.surroundingNdbs();
+        ndbs.clear();
+        m_navdata->getNdbsWithinRadius(
+            view_center, m_processor_cfg->getIntValue(CFG_MAX_SURROUNDING_NDB_DIST_NM), ndbs.hits);
+
+        for(int index = 0; index < ndbs.count(); ++index)
+        {
+            const Ndb& ndb = m_navdata->spatialNdb(ndbs.hits[index]);
+            ndbs.lat.append(ndb.lat());
+            ndbs.lon.append(ndb.lon());
+        }
+
+        calcProjection(ndbs);
     }
 
     if (m_project_recalc_geo == 0)
@@ -824,10 +868,21 @@ void FMCProcessor::slotRefresh(bool force)
         // recalc GEO data
 
         m_fmc_control->geoData().updateActiveRouteList(
-            view_center, m_processor_cfg->getIntValue(CFG_MAX_SURROUNDING_GEO_DIST_NM));
-        m_fmc_control->geoData().calcProjectionActiveRoute(*m_projection);
+            view_center, m_processor_cfg->getIntValue(CFG_MAX_SURROUNDING_GEO_DIST_NM),
+            m_fmc_control->showGeoDataFilled());
     }
 
+    // the lists are only refilled in steps, project the ones still
+    // holding x/y values of an older projection epoch now
+
+    if (m_fmc_data.surroundingAirports().projection_epoch != m_projection->epoch())
+        calcProjection(m_fmc_data.surroundingAirports());
+    if (m_fmc_data.surroundingVors().projection_epoch != m_projection->epoch())
+        calcProjection(m_fmc_data.surroundingVors());
+    if (m_fmc_data.surroundingNdbs().projection_epoch != m_projection->epoch())
+        calcProjection(m_fmc_data.surroundingNdbs());
+    m_fmc_control->geoData().calcProjectionActiveRoute(*m_projection);
+
     if (m_project_recalc_airports >= 0) --m_project_recalc_airports;
     if (m_project_recalc_vors >= 0) --m_project_recalc_vors;
     if (m_project_recalc_ndbs >= 0) --m_project_recalc_ndbs;
@@ -858,4 +913,15 @@ void FMCProcessor::slotRefresh(bool force)
 
 /////////////////////////////////////////////////////////////////////////////
 
+void FMCProcessor::calcProjection(SurroundingNavaidList& navaids)
+{
+    navaids.x.resize(navaids.count());
+    navaids.y.resize(navaids.count());
+    m_projection->convertLatLonArraysToXY(navaids.lat.constData(), navaids.lon.constData(), navaids.count(),
+                                          navaids.x.data(), navaids.y.data());
+    navaids.projection_epoch = m_projection->epoch();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
 // End of file
@@ -26,7 +26,8 @@
 #define __FMC_PROCESSOR_H__
 
 #include <QObject>
-#include <QTime>
+
+#include "sim_clock.h"
 
 class FMCData;
 class FlightStatus;
@@ -70,6 +71,9 @@ protected:
 
     void setupDefaultConfig();
 
+    //! projects the positions of the given navaids
+    void calcProjection(SurroundingNavaidList& navaids);
+
 protected:
 
     ConfigWidgetProvider* m_config_widget_provider;
@@ -82,14 +86,14 @@ protected:
 
     bool m_flightstatus_was_valid_once;
 
-    QTime  m_refresh_timer;
+    SimTimer m_refresh_timer;
 
-    QTime  m_descent_estimate_recalc_timer;
+    SimTimer m_descent_estimate_recalc_timer;
 
-    QTime  m_wpt_times_recalc_timer;
+    SimTimer m_wpt_times_recalc_timer;
     int    m_wpt_times_recalc_wpt_index;
 
-    QTime  m_alt_reach_recalc_timer;
+    SimTimer m_alt_reach_recalc_timer;
     bool   m_data_changed;
 
     double m_last_toc_eod_ground_speed_kts;
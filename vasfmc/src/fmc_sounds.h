@@ -48,6 +48,7 @@
 
 #include "fmc_sounds_defines.h"
 #include "assert.h"
+#include "sim_clock.h"
 
 class Config;
 class FMCControl;
@@ -254,9 +255,9 @@ protected:
     FMCControl* m_fmc_control;
     const FlightStatus* m_flightstatus;
 
-    QTime m_refresh_timer;
+    SimTimer m_refresh_timer;
 
-    QTime m_startup_timer;
+    SimTimer m_startup_timer;
 
     //! map of sound files to play indexed by the sound source.
     //! sounds of different sources may be player simultaneously.
@@ -276,27 +277,27 @@ protected:
     bool m_do_positive_rate_callout;
     bool m_do_gear_up_callout;
     bool m_do_gear_down_callout;
-    QTime m_loc_alive_callout_timer;
+    SimTimer m_loc_alive_callout_timer;
     bool m_do_loc_alive_callout;
-    QTime m_gs_alive_callout_timer;
+    SimTimer m_gs_alive_callout_timer;
     bool m_do_gs_alive_callout;
     bool m_do_reaching_tod_callout;
     bool m_do_reverser_callout;
     bool m_do_gnd_spoiler_callout;
 
-    QTime m_outermarker_inhibit_timer;
+    SimTimer m_outermarker_inhibit_timer;
 
     uint m_prev_flaps_notch;
-    QTime m_flaps_callout_delay_timer;
+    SimTimer m_flaps_callout_delay_timer;
     QString m_flaps_next_callout;
 
     double m_prev_alt_ft;
-    QTime m_10000ft_inhibit_timer;
+    SimTimer m_10000ft_inhibit_timer;
 
     bool m_was_above_mda;
 
-    QTime m_last_reverser_callout_timer;
-    QTime m_last_gnd_spoiler_callout_timer;
+    SimTimer m_last_reverser_callout_timer;
+    SimTimer m_last_gnd_spoiler_callout_timer;
     
     uint m_direct_play_sound_id;
 
@@ -25,12 +25,12 @@
 #ifndef __FMC_SOUNDS_STYLE_A_H__
 #define __FMC_SOUNDS_STYLE_A_H__
 
-#include <QTime>
 
 #include "fmc_autopilot.h"
 #include "fmc_autothrottle.h"
 
 #include "fmc_sounds.h"
+#include "sim_clock.h"
 
 class QSound;
 
@@ -55,15 +55,15 @@ protected:
 
 protected:
 
-    QTime m_radar_height_inhibit_timer;
+    SimTimer m_radar_height_inhibit_timer;
     int m_radar_height_inhibit_time_ms;
     FMCAutopilot::ILS_MODE m_last_ils_mode;
-    QTime m_ils_mode_inhibit_timer;
+    SimTimer m_ils_mode_inhibit_timer;
 
     FMCAutothrottle::AIRBUS_THROTTLE_MODE m_last_airbus_throttle_mode;
     bool m_thr_lvr_clb_request_active;
-    QTime m_thr_lvr_clb_request_timer;
-    QTime m_airbus_thrust_change_timer;
+    SimTimer m_thr_lvr_clb_request_timer;
+    SimTimer m_airbus_thrust_change_timer;
     QString m_airbus_thrust_next_callout;
 
 private:
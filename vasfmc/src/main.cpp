@@ -26,6 +26,7 @@
 #include "assert.h"
 #include "config.h"
 #include "logger.h"
+#include "navdata.h"
 
 #include "fmc_console.h"
 
@@ -70,6 +71,17 @@ int main(int argc, char **argv)
     qInstallMsgHandler(myMessageOutput);
     QApplication app(argc, argv);
 
+    // compile the binary navdata image from the AIRAC text files and exit
+    if (app.arguments().contains("--compile-navdata"))
+    {
+        Logger::log("     ----- Compiling navdata image -----");
+        Navdata navdata(CFG_NAVDATA_FILENAME, CFG_NAVDATA_INDEX_FILENAME);
+        bool compiled = navdata.isValid() && navdata.compileImage();
+        Logger::log(QString("     ----- Compiling navdata image %1 -----").arg(compiled ? "finished" : "failed"));
+        Logger::finish();
+        return compiled ? 0 : 1;
+    }
+
     // setup console
     FMCConsole* console = new FMCConsole(0, 0);
     MYASSERT(console != 0);
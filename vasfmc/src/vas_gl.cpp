@@ -6,7 +6,9 @@
 #include "vas_gl_backend_qt.h"
 
 #include <QBitmap>
+#include <QMutex>
 #include <QPainter>
+#include <QThreadStorage>
 #include <QTransform>
 #include <QVector>
 
@@ -197,6 +199,9 @@ namespace
         {
             for(int i=0; i<m_commands.size(); i++)
                 delete m_commands[i];
+
+            for(int i=0; i<m_retainedLists.size(); i++)
+                delete m_retainedLists[i];
         }
 
         void addCommand(ListCommand *pCommand)
@@ -204,6 +209,13 @@ namespace
             m_commands.push_back(pCommand);
         }
 
+        // Takes over a list which was replaced while this list still
+        // refers to it (see glEndList())
+        void retainList(DisplayList *pList)
+        {
+            m_retainedLists.push_back(pList);
+        }
+
         void execute()
         {
             for(int i=0; i<m_commands.size(); i++)
@@ -216,12 +228,38 @@ namespace
         DisplayList &operator=(const DisplayList &);
 
         QVector<ListCommand *> m_commands;
+        QVector<DisplayList *> m_retainedLists;
+    };
+
+    // Calls a list which was resolved when the command was recorded
+    class ListCallCmd : public ListCommand
+    {
+    public:
+        ListCallCmd(DisplayList *pList)
+            : m_pList(pList)
+        {
+        }
+
+        virtual void execute()
+        {
+            m_pList->execute();
+        }
+
+    private:
+        DisplayList *m_pList;
+    };
+
+    struct ListRange
+    {
+        GLuint  begin;
+        GLsizei size;
     };
 
     struct RenderContext
     {
         RenderContext()
-            : m_pList(0), m_matrixMode(GL_MODELVIEW), m_color(Qt::white),
+            : m_pList(0), m_pFrame(0), m_boundTexture(0),
+              m_matrixMode(GL_MODELVIEW), m_color(Qt::white),
               m_clearColor(Qt::black)
         {
             Logger::log("Creating RenderContext");
@@ -232,6 +270,12 @@ namespace
         ~RenderContext()
         {
             Logger::log("Destroying RenderContext");
+
+            for(int i=0; i<m_lists.size(); i++)
+                delete m_lists[i];
+
+            delete m_pList;
+            delete m_pFrame;
         }
 
         void TransformChanged()
@@ -239,6 +283,13 @@ namespace
             m_backend.setTransform(m_modelview.back());
         }
 
+        // Returns the list the calls are recorded to, NULL if they are
+        // executed immediately
+        DisplayList *recording()
+        {
+            return m_pList ? m_pList : m_pFrame;
+        }
+
         VasGLBackendAGG        m_backend;
 
         // Lists
@@ -246,6 +297,16 @@ namespace
         GLuint                 m_listIndex;
         GLenum                 m_listMode;
 
+        QVector<DisplayList *> m_lists;
+        QVector<bool>          m_listAllocated;
+        QList<ListRange>       m_availableLists;
+
+        // Frame being recorded (see vasglBeginFrame()) and the state which
+        // can be queried while recording
+        DisplayList            *m_pFrame;
+        QColor                 m_frameColor;
+        GLuint                 m_boundTexture;
+
         QVector<QPointF>       m_vertices;
         QVector<QColor>        m_vertexColors;
         QVector<QPointF>       m_texCoords;
@@ -259,28 +320,38 @@ namespace
         RenderContext &operator=(const RenderContext &);
     };
 
-    struct ListRange
+    struct CurrentContext
     {
-        GLuint  begin;
-        GLsizei size;
+        CurrentContext()
+            : m_pCtx(0)
+        {
+        }
+
+        RenderContext *m_pCtx;
     };
 
-    static RenderContext *s_pCtx=0;
+    // Every thread has its own current context, so the contexts of
+    // different widgets can be used in parallel
+    QThreadStorage<CurrentContext *> s_current;
 
-    QVector<DisplayList *> s_lists;
-    QVector<bool>          s_listAllocated;
-    QList<ListRange>       s_availableLists;
-    QVector<GLuint>        s_availableTextures;
+    RenderContext *currentContext()
+    {
+        CurrentContext *pCurrent=s_current.localData();
 
+        return pCurrent ? pCurrent->m_pCtx : 0;
+    }
 
-    struct StaticInitExit
+    void setCurrentContext(RenderContext *pCtx)
     {
-        ~StaticInitExit()
-        {
-            for(int i=0; i<s_lists.size(); i++)
-                delete s_lists[i];
-        }
-    } s_staticInitExit;
+        if(!s_current.hasLocalData())
+            s_current.setLocalData(new CurrentContext());
+
+        s_current.localData()->m_pCtx=pCtx;
+    }
+
+    // Textures are shared by all contexts
+    QMutex          s_textureMutex;
+    QVector<GLuint> s_availableTextures;
 }
 
 VasGLRenderContext vasglCreateContext(int width, int height)
@@ -296,8 +367,8 @@ void vasglFreeContext(VasGLRenderContext ctx)
 {
     RenderContext *pCtx=(RenderContext *)ctx;
 
-    if(s_pCtx==pCtx)
-        s_pCtx=0;
+    if(currentContext()==pCtx)
+        setCurrentContext(0);
 
     pCtx->m_backend.end();
 
@@ -306,81 +377,160 @@ void vasglFreeContext(VasGLRenderContext ctx)
 
 void vasglMakeCurrent(VasGLRenderContext ctx, QImage *pimg)
 {
+    RenderContext *pCtx=currentContext();
+
     // Detach departing context from its rendering surface
-    if(s_pCtx)
-        s_pCtx->m_backend.detach();
+    if(pCtx)
+        pCtx->m_backend.detach();
 
-    s_pCtx=(RenderContext *)ctx;
+    pCtx=(RenderContext *)ctx;
+    setCurrentContext(pCtx);
 
-    // Attach new context to its rendering surface
-    if(s_pCtx)
-        s_pCtx->m_backend.attach(pimg);
+    // Attach new context to its rendering surface. Without a surface, the
+    // context can only be used to record a frame.
+    if(pCtx && pimg)
+        pCtx->m_backend.attach(pimg);
 }
 
-void vasglBeginClipRegion(const QSize &size)
+void vasglBeginFrame()
 {
-    if(!s_pCtx)
+    RenderContext *pCtx=currentContext();
+
+    if(!pCtx || pCtx->m_pFrame)
         return;
 
+    pCtx->m_pFrame=new DisplayList();
+    pCtx->m_frameColor=pCtx->m_color;
+}
+
+VasGLFrame vasglEndFrame()
+{
+    RenderContext *pCtx=currentContext();
+    DisplayList   *pFrame;
+
+    if(!pCtx)
+        return NULL;
+
+    pFrame=pCtx->m_pFrame;
+    pCtx->m_pFrame=0;
+
+    return pFrame;
+}
+
+void vasglRenderFrame(VasGLRenderContext ctx, VasGLFrame frame, QImage *pimg)
+{
+    vasglMakeCurrent(ctx, pimg);
+
+    if(frame)
+        ((DisplayList *)frame)->execute();
+
+    vasglMakeCurrent(NULL, NULL);
+}
+
+void vasglFreeFrame(VasGLFrame frame)
+{
+    delete (DisplayList *)frame;
+}
+
+// The size is only needed by native OpenGL, so the clip region can be
+// recorded without it
+static void beginClipRegion()
+{
+    RenderContext *pCtx=currentContext();
+
+    if(!pCtx)
+        return;
+
+    if(pCtx->recording())
+    {
+        pCtx->recording()->addCommand(new ListCmd0(beginClipRegion));
+        return;
+    }
+
     glPushMatrix();
     glLoadIdentity();
 
-    s_pCtx->m_backend.beginClipRegion();
+    pCtx->m_backend.beginClipRegion();
+}
+
+void vasglBeginClipRegion(const QSize &size)
+{
+    beginClipRegion();
 }
 
 void vasglEndClipRegion()
 {
-    if(!s_pCtx)
+    RenderContext *pCtx=currentContext();
+
+    if(!pCtx)
+        return;
+
+    if(pCtx->recording())
+    {
+        pCtx->recording()->addCommand(new ListCmd0(vasglEndClipRegion));
         return;
+    }
 
     glPopMatrix();
 
-    s_pCtx->m_backend.endClipRegion();
+    pCtx->m_backend.endClipRegion();
 }
 
 void vasglDisableClipping()
 {
-    if(!s_pCtx)
+    RenderContext *pCtx=currentContext();
+
+    if(!pCtx)
         return;
 
-    s_pCtx->m_backend.disableClipping();
+    if(pCtx->recording())
+    {
+        pCtx->recording()->addCommand(new ListCmd0(vasglDisableClipping));
+        return;
+    }
+
+    pCtx->m_backend.disableClipping();
 }
 
 void vasglCircle(double cx, double cy, double radius, double start_angle,
     double stop_angle, double angle_inc)
 {
-    if(!s_pCtx)
+    RenderContext *pCtx=currentContext();
+
+    if(!pCtx)
         return;
 
-    if(s_pCtx->m_pList)
+    if(pCtx->recording())
     {
-        s_pCtx->m_pList->addCommand(
+        pCtx->recording()->addCommand(
             new ListCmd6<double, double, double, double, double, double>
             (vasglCircle, cx, cy, radius, start_angle, stop_angle, angle_inc));
         return;
     }
 
-    s_pCtx->m_backend.drawCircle(cx, cy, radius, start_angle, stop_angle,
-        s_pCtx->m_color);
+    pCtx->m_backend.drawCircle(cx, cy, radius, start_angle, stop_angle,
+        pCtx->m_color);
 }
 
 void vasglFilledCircle(double cx, double cy, double radius, double start_angle,
     double stop_angle, double angle_inc)
 {
-    if(!s_pCtx)
+    RenderContext *pCtx=currentContext();
+
+    if(!pCtx)
         return;
 
-    if(s_pCtx->m_pList)
+    if(pCtx->recording())
     {
-        s_pCtx->m_pList->addCommand(
+        pCtx->recording()->addCommand(
             new ListCmd6<double, double, double, double, double, double>
             (vasglFilledCircle, cx, cy, radius, start_angle, stop_angle,
             angle_inc));
         return;
     }
 
-    s_pCtx->m_backend.drawFilledCircle(cx, cy, radius, start_angle,
-        stop_angle, s_pCtx->m_color);
+    pCtx->m_backend.drawFilledCircle(cx, cy, radius, start_angle,
+        stop_angle, pCtx->m_color);
 }
 
 static int GLColorToInt(GLclampf col)
@@ -397,52 +547,58 @@ static int GLColorToInt(GLclampf col)
 
 void glBegin(GLenum mode)
 {
-    if(!s_pCtx)
+    RenderContext *pCtx=currentContext();
+
+    if(!pCtx)
         return;
 
-    if(s_pCtx->m_pList)
+    if(pCtx->recording())
     {
-        s_pCtx->m_pList->addCommand(new ListCmd1e(glBegin, mode));
+        pCtx->recording()->addCommand(new ListCmd1e(glBegin, mode));
         return;
     }
 
-    s_pCtx->m_vertices.clear();
-    s_pCtx->m_vertexColors.clear();
-    s_pCtx->m_texCoords.clear();
-    s_pCtx->m_mode=mode;
+    pCtx->m_vertices.clear();
+    pCtx->m_vertexColors.clear();
+    pCtx->m_texCoords.clear();
+    pCtx->m_mode=mode;
 }
 
 void glEnd()
 {
-    if(!s_pCtx)
+    RenderContext *pCtx=currentContext();
+
+    if(!pCtx)
         return;
 
-    if(s_pCtx->m_pList)
+    if(pCtx->recording())
     {
-        s_pCtx->m_pList->addCommand(new ListCmd0(glEnd));
+        pCtx->recording()->addCommand(new ListCmd0(glEnd));
         return;
     }
 
-    if(s_pCtx->m_vertices.size()==0)
+    if(pCtx->m_vertices.size()==0)
         return;
 
-    s_pCtx->m_backend.drawPrimitives(s_pCtx->m_mode, s_pCtx->m_vertices,
-        s_pCtx->m_vertexColors, s_pCtx->m_texCoords);
+    pCtx->m_backend.drawPrimitives(pCtx->m_mode, pCtx->m_vertices,
+        pCtx->m_vertexColors, pCtx->m_texCoords);
 }
 
 void glVertex2d(GLdouble x, GLdouble y)
 {
-    if(!s_pCtx)
+    RenderContext *pCtx=currentContext();
+
+    if(!pCtx)
         return;
 
-    if(s_pCtx->m_pList)
+    if(pCtx->recording())
     {
-        s_pCtx->m_pList->addCommand(new ListCmd2d(glVertex2d, x, y));
+        pCtx->recording()->addCommand(new ListCmd2d(glVertex2d, x, y));
         return;
     }
 
-    s_pCtx->m_vertices.push_back(QPointF(x, y));
-    s_pCtx->m_vertexColors.push_back(s_pCtx->m_color);
+    pCtx->m_vertices.push_back(QPointF(x, y));
+    pCtx->m_vertexColors.push_back(pCtx->m_color);
 }
 
 void glVertex2i(GLint x, GLint y)
@@ -457,60 +613,66 @@ void glVertex2f(GLfloat x, GLfloat y)
 
 void glTexCoord2f(GLfloat s, GLfloat t)
 {
-    if(!s_pCtx)
+    RenderContext *pCtx=currentContext();
+
+    if(!pCtx)
         return;
 
-    if(s_pCtx->m_pList)
+    if(pCtx->recording())
     {
-        s_pCtx->m_pList->addCommand(new ListCmd2<GLfloat, GLfloat>
+        pCtx->recording()->addCommand(new ListCmd2<GLfloat, GLfloat>
             (glTexCoord2f, s, t));
         return;
     }
 
-    s_pCtx->m_texCoords.push_back(QPointF(s, t));
+    pCtx->m_texCoords.push_back(QPointF(s, t));
 }
 
 void glRotated(GLdouble angle, GLdouble x, GLdouble y, GLdouble z)
 {
-    if(!s_pCtx)
+    RenderContext *pCtx=currentContext();
+
+    if(!pCtx)
         return;
 
-    if(s_pCtx->m_pList)
+    if(pCtx->recording())
     {
-        s_pCtx->m_pList->addCommand(new ListCmd4d(glRotated, angle, x, y, z));
+        pCtx->recording()->addCommand(new ListCmd4d(glRotated, angle, x, y, z));
         return;
     }
 
-    if(s_pCtx->m_matrixMode==GL_MODELVIEW)
+    if(pCtx->m_matrixMode==GL_MODELVIEW)
     {
         // TODO: Not general...
         if(x!=0)
-            s_pCtx->m_modelview.back().rotate(angle, Qt::XAxis);
+            pCtx->m_modelview.back().rotate(angle, Qt::XAxis);
         else if(y!=0)
-            s_pCtx->m_modelview.back().rotate(angle, Qt::YAxis);
+            pCtx->m_modelview.back().rotate(angle, Qt::YAxis);
         else
-            s_pCtx->m_modelview.back().rotate(angle, Qt::ZAxis);
+            pCtx->m_modelview.back().rotate(angle, Qt::ZAxis);
 
-        s_pCtx->TransformChanged();
+        pCtx->TransformChanged();
     }
 }
 
 void glTranslated(GLdouble x, GLdouble y, GLdouble z)
 {
-    if(!s_pCtx)
+    RenderContext *pCtx=currentContext();
+
+    if(!pCtx)
         return;
 
-    if(s_pCtx->m_pList)
+    if(pCtx->recording())
     {
-        s_pCtx->m_pList->addCommand(new ListCmd3d(glTranslated, x, y, z));
+        pCtx->recording()->addCommand(new ListCmd3d(glTranslated, x, y, z));
         return;
     }
 
-    if(s_pCtx->m_matrixMode==GL_MODELVIEW)
+    if(pCtx->m_matrixMode==GL_MODELVIEW)
     {
-        s_pCtx->m_modelview.back().translate(x, y);
+        pCtx->m_modelview.back().translate(x, y);
 
-        s_pCtx->TransformChanged();
+        pCtx->TransformChanged();
     }
 }
 
@@ -520,32 +682,36 @@ void glShadeModel(GLenum mode)
 
 void glEnable(GLenum cap)
 {
-    if(!s_pCtx)
+    RenderContext *pCtx=currentContext();
+
+    if(!pCtx)
         return;
 
-    if(s_pCtx->m_pList)
+    if(pCtx->recording())
     {
-        s_pCtx->m_pList->addCommand(new ListCmd1e(glEnable, cap));
+        pCtx->recording()->addCommand(new ListCmd1e(glEnable, cap));
         return;
     }
 
     if(cap == GL_LINE_STIPPLE)
-        s_pCtx->m_backend.enableLineStipple(true);
+        pCtx->m_backend.enableLineStipple(true);
 }
 
 void glDisable(GLenum cap)
 {
-    if(!s_pCtx)
+    RenderContext *pCtx=currentContext();
+
+    if(!pCtx)
         return;
 
-    if(s_pCtx->m_pList)
+    if(pCtx->recording())
     {
-        s_pCtx->m_pList->addCommand(new ListCmd1e(glEnable, cap));
+        pCtx->recording()->addCommand(new ListCmd1e(glDisable, cap));
         return;
     }
 
     if(cap == GL_LINE_STIPPLE)
-        s_pCtx->m_backend.enableLineStipple(false);
+        pCtx->m_backend.enableLineStipple(false);
 }
 
 void glBlendFunc(GLenum sfactor, GLenum dfactor)
@@ -563,34 +729,38 @@ void glViewport(GLint x, GLint y, GLsizei width, GLsizei height)
 
 void glMatrixMode(GLenum mode)
 {
-    if(!s_pCtx)
+    RenderContext *pCtx=currentContext();
+
+    if(!pCtx)
         return;
 
-    if(s_pCtx->m_pList)
+    if(pCtx->recording())
     {
-        s_pCtx->m_pList->addCommand(new ListCmd1e(glMatrixMode, mode));
+        pCtx->recording()->addCommand(new ListCmd1e(glMatrixMode, mode));
         return;
     }
 
-    s_pCtx->m_matrixMode=mode;
+    pCtx->m_matrixMode=mode;
 }
 
 void glLoadIdentity()
 {
-    if(!s_pCtx)
+    RenderContext *pCtx=currentContext();
+
+    if(!pCtx)
         return;
 
-    if(s_pCtx->m_pList)
+    if(pCtx->recording())
     {
-        s_pCtx->m_pList->addCommand(new ListCmd0(glLoadIdentity));
+        pCtx->recording()->addCommand(new ListCmd0(glLoadIdentity));
         return;
     }
 
-    if(s_pCtx->m_matrixMode==GL_MODELVIEW)
+    if(pCtx->m_matrixMode==GL_MODELVIEW)
     {
-        s_pCtx->m_modelview.back()=QTransform();
+        pCtx->m_modelview.back()=QTransform();
 
-        s_pCtx->TransformChanged();
+        pCtx->TransformChanged();
     }
 }
 
@@ -601,60 +771,68 @@ void glOrtho(GLdouble left, GLdouble right, GLdouble bottom,
 
 void glPushMatrix()
 {
-    if(!s_pCtx)
+    RenderContext *pCtx=currentContext();
+
+    if(!pCtx)
         return;
 
-    if(s_pCtx->m_pList)
+    if(pCtx->recording())
     {
-        s_pCtx->m_pList->addCommand(new ListCmd0(glPushMatrix));
+        pCtx->recording()->addCommand(new ListCmd0(glPushMatrix));
         return;
     }
 
-    if(s_pCtx->m_matrixMode==GL_MODELVIEW)
+    if(pCtx->m_matrixMode==GL_MODELVIEW)
     {
-        s_pCtx->m_modelview.push_back(s_pCtx->m_modelview.back());
+        pCtx->m_modelview.push_back(pCtx->m_modelview.back());
 
-        s_pCtx->TransformChanged();
+        pCtx->TransformChanged();
     }
 }
 
 void glPopMatrix()
 {
-    if(!s_pCtx)
+    RenderContext *pCtx=currentContext();
+
+    if(!pCtx)
         return;
 
-    if(s_pCtx->m_pList)
+    if(pCtx->recording())
     {
-        s_pCtx->m_pList->addCommand(new ListCmd0(glPopMatrix));
+        pCtx->recording()->addCommand(new ListCmd0(glPopMatrix));
         return;
     }
 
-    if(s_pCtx->m_matrixMode==GL_MODELVIEW)
-        if(s_pCtx->m_modelview.size()>1)
+    if(pCtx->m_matrixMode==GL_MODELVIEW)
+        if(pCtx->m_modelview.size()>1)
         {
-            s_pCtx->m_modelview.pop_back();
+            pCtx->m_modelview.pop_back();
 
-            s_pCtx->TransformChanged();
+            pCtx->TransformChanged();
         }
 }
 
 void glClear(GLbitfield mask)
 {
-    if(!s_pCtx)
+    RenderContext *pCtx=currentContext();
+
+    if(!pCtx)
         return;
 
-    if(s_pCtx->m_pList)
+    if(pCtx->recording())
     {
-        s_pCtx->m_pList->addCommand(new ListCmd1<GLbitfield>(glClear, mask));
+        pCtx->recording()->addCommand(new ListCmd1<GLbitfield>(glClear, mask));
         return;
     }
 
-    s_pCtx->m_backend.clear(s_pCtx->m_clearColor);
+    pCtx->m_backend.clear(pCtx->m_clearColor);
 }
 
 void glFlush()
 {
-    if(!s_pCtx)
+    RenderContext *pCtx=currentContext();
+
+    if(!pCtx)
         return;
 }
 
@@ -666,48 +844,55 @@ GLenum glGetError()
 void glClearColor(GLclampf red, GLclampf green, GLclampf blue,
     GLclampf alpha)
 {
-    if(!s_pCtx)
+    RenderContext *pCtx=currentContext();
+
+    if(!pCtx)
         return;
 
-    if(s_pCtx->m_pList)
+    if(pCtx->recording())
     {
-        s_pCtx->m_pList->addCommand(
+        pCtx->recording()->addCommand(
             new ListCmd4<GLclampf, GLclampf, GLclampf, GLclampf>
             (glClearColor, red, green, blue, alpha));
         return;
     }
 
-    s_pCtx->m_clearColor=QColor(GLColorToInt(red), GLColorToInt(green),
+    pCtx->m_clearColor=QColor(GLColorToInt(red), GLColorToInt(green),
         GLColorToInt(blue), GLColorToInt(alpha));
 }
 
 void glGetFloatv(GLenum pname, GLfloat *params)
 {
-    if(!s_pCtx)
+    RenderContext *pCtx=currentContext();
+
+    if(!pCtx)
         return;
 
     if(pname==GL_CURRENT_COLOR)
     {
-        params[0]=double(s_pCtx->m_color.red())/255.0;
-        params[1]=double(s_pCtx->m_color.green())/255.0;
-        params[2]=double(s_pCtx->m_color.blue())/255.0;
-        params[3]=double(s_pCtx->m_color.alpha())/255.0;
+        const QColor &color=pCtx->m_pFrame ? pCtx->m_frameColor : pCtx->m_color;
+
+        params[0]=double(color.red())/255.0;
+        params[1]=double(color.green())/255.0;
+        params[2]=double(color.blue())/255.0;
+        params[3]=double(color.alpha())/255.0;
     }
 }
 
 // Lists
 void glDeleteLists(GLuint list,  GLsizei range)
 {
+    RenderContext *pCtx=currentContext();
     ListRange listRange;
     int       i;
 
-    if(!s_pCtx)
+    if(!pCtx)
         return;
 
     if(list==0)
         return;
 
-    MYASSERT(list>=1 && int(list+range)<=s_lists.size());
+    MYASSERT(list>=1 && int(list+range)<=pCtx->m_lists.size());
 
     // All of the lists that are being freed should be currently allocated,
     // and we're going to mark them as not allocated
@@ -715,53 +900,57 @@ void glDeleteLists(GLuint list,  GLsizei range)
     {
         // To protect ourselves against double frees in a release build,
         // don't free the list if one of the list elements isn't allocated
-        if(!s_listAllocated[list+i])
+        if(!pCtx->m_listAllocated[list+i])
         {
             *((int *)0)=0;
             return;
         }
 
-        MYASSERT(s_listAllocated[list+i]);
+        MYASSERT(pCtx->m_listAllocated[list+i]);
 
-        s_listAllocated[list+i]=false;
+        pCtx->m_listAllocated[list+i]=false;
     }
 
     listRange.begin=list;
     listRange.size=range;
 
-    s_availableLists.push_back(listRange);
+    pCtx->m_availableLists.push_back(listRange);
 }
 
 GLuint glGenLists(GLsizei range)
 {
+    RenderContext *pCtx=currentContext();
     int i, j, rval;
 
+    if(!pCtx)
+        return 0;
+
     // First of all, check if a list range of sufficient size is available
-    for(i=0; i<s_availableLists.size(); i++)
-        if(s_availableLists[i].size >= range)
+    for(i=0; i<pCtx->m_availableLists.size(); i++)
+        if(pCtx->m_availableLists[i].size >= range)
         {
             // Remember beginning of list range
-            rval=s_availableLists[i].begin;
+            rval=pCtx->m_availableLists[i].begin;
 
             // If the size of this list range is exactly equal to the
             // requested size, delete it from the available list. Otherwise, 
             // reduce its size accordingly
-            if(s_availableLists[i].size == range)
+            if(pCtx->m_availableLists[i].size == range)
             {
-                s_availableLists.erase(
-                    s_availableLists.begin()+i);
+                pCtx->m_availableLists.erase(
+                    pCtx->m_availableLists.begin()+i);
             }
             else
             {
-                s_availableLists[i].begin+=range;
-                s_availableLists[i].size=-range;
+                pCtx->m_availableLists[i].begin+=range;
+                pCtx->m_availableLists[i].size-=range;
             }
 
             // Remeber that these lists have been allocated
             for(j=0; j<range; j++)
             {
-                MYASSERT(!s_listAllocated[rval+j]);
-                s_listAllocated[rval+j]=true;
+                MYASSERT(!pCtx->m_listAllocated[rval+j]);
+                pCtx->m_listAllocated[rval+j]=true;
             }
 
             return rval;
@@ -769,18 +958,18 @@ GLuint glGenLists(GLsizei range)
 
     // Since a list index of 0 is not permissible, create a dummy list with a
     // list index of 0 if necessary
-    if(s_lists.size()==0)
+    if(pCtx->m_lists.size()==0)
     {
-        s_lists.push_back(NULL);
-        s_listAllocated.push_back(false);
+        pCtx->m_lists.push_back(NULL);
+        pCtx->m_listAllocated.push_back(false);
     }
 
-    rval=s_lists.size();
+    rval=pCtx->m_lists.size();
     
     for(int i=0; i<range; i++)
     {
-        s_lists.push_back(NULL);
-        s_listAllocated.push_back(true);
+        pCtx->m_lists.push_back(NULL);
+        pCtx->m_listAllocated.push_back(true);
     }
 
     return rval;
@@ -788,44 +977,63 @@ GLuint glGenLists(GLsizei range)
 
 void glNewList(GLuint list, GLenum mode)
 {
-    if(!s_pCtx)
+    RenderContext *pCtx=currentContext();
+
+    if(!pCtx)
         return;
 
     // If we're already compiling a list, return
-    if(s_pCtx->m_pList)
+    if(pCtx->m_pList)
         return;
 
     // Spec says we should replace any potential existing list only when
     // glEndList is called -- so for the moment, we allocate the new list but
-    // do not place it in s_lists yet.
+    // do not place it in m_lists yet.
 
-    s_pCtx->m_listIndex=list;
-    s_pCtx->m_listMode=mode;
-    s_pCtx->m_pList=new DisplayList();
+    pCtx->m_listIndex=list;
+    pCtx->m_listMode=mode;
+    pCtx->m_pList=new DisplayList();
 }
 
 void glEndList()
 {
-    if(!s_pCtx)
+    RenderContext *pCtx=currentContext();
+
+    if(!pCtx || !pCtx->m_pList)
         return;
 
-    // Delete old list if one exists and replace it with the new list
-    delete s_lists[s_pCtx->m_listIndex];
-    s_lists[s_pCtx->m_listIndex]=s_pCtx->m_pList;
+    // Delete old list if one exists and replace it with the new list. A
+    // frame being recorded may already call the old list, so it keeps it
+    // until it is freed.
+    if(pCtx->m_pFrame && pCtx->m_lists[pCtx->m_listIndex])
+        pCtx->m_pFrame->retainList(pCtx->m_lists[pCtx->m_listIndex]);
+    else
+        delete pCtx->m_lists[pCtx->m_listIndex];
+
+    pCtx->m_lists[pCtx->m_listIndex]=pCtx->m_pList;
 
     // Remember that we're no longer compiling a list
-    s_pCtx->m_pList=0;
+    pCtx->m_pList=0;
 }
 
 void glCallList(GLuint list)
 {
-    if(!s_pCtx)
+    RenderContext *pCtx=currentContext();
+
+    if(!pCtx)
         return;
 
-    if(s_pCtx->m_pList)
-        s_pCtx->m_pList->addCommand(new ListCmd1u(glCallList, list));
+    if(pCtx->m_pList)
+        pCtx->m_pList->addCommand(new ListCmd1u(glCallList, list));
+    else if(pCtx->m_pFrame)
+    {
+        // Resolve the list now, it may be replaced before the frame is
+        // rendered
+        if(pCtx->m_lists[list])
+            pCtx->m_pFrame->addCommand(new ListCallCmd(pCtx->m_lists[list]));
+    }
     else
-        s_lists[list]->execute();
+        pCtx->m_lists[list]->execute();
 }
 
 // Depth buffer
@@ -840,47 +1048,58 @@ void glDepthMask(GLboolean flag)
 void glColor4f(GLfloat red, GLfloat green, GLfloat blue,
     GLfloat alpha)
 {
-    if(!s_pCtx)
+    RenderContext *pCtx=currentContext();
+
+    if(!pCtx)
         return;
 
-    if(s_pCtx->m_pList)
+    if(pCtx->recording())
     {
-        s_pCtx->m_pList->addCommand(new ListCmd4f(glColor4f, red, green, blue,
+        // Keep track of the color for glGetFloatv() while recording a frame
+        if(!pCtx->m_pList)
+            pCtx->m_frameColor=QColor(GLColorToInt(red), GLColorToInt(green),
+                GLColorToInt(blue), GLColorToInt(alpha));
+
+        pCtx->recording()->addCommand(new ListCmd4f(glColor4f, red, green, blue,
             alpha));
         return;
     }
 
-    s_pCtx->m_color=QColor(GLColorToInt(red), GLColorToInt(green),
+    pCtx->m_color=QColor(GLColorToInt(red), GLColorToInt(green),
         GLColorToInt(blue), GLColorToInt(alpha));
 }
 
 void glLineStipple(GLint factor, GLushort pattern)
 {
-    if(!s_pCtx)
+    RenderContext *pCtx=currentContext();
+
+    if(!pCtx)
         return;
 
-    if(s_pCtx->m_pList)
+    if(pCtx->recording())
     {
-        s_pCtx->m_pList->addCommand(
+        pCtx->recording()->addCommand(
             new ListCmd2<GLint, GLushort>(glLineStipple, factor, pattern));
         return;
     }
 
-    s_pCtx->m_backend.setLineStipple(factor, pattern);
+    pCtx->m_backend.setLineStipple(factor, pattern);
 }
 
 void glLineWidth(GLfloat width)
 {
-    if(!s_pCtx)
+    RenderContext *pCtx=currentContext();
+
+    if(!pCtx)
         return;
 
-    if(s_pCtx->m_pList)
+    if(pCtx->recording())
     {
-        s_pCtx->m_pList->addCommand(new ListCmd1f(glLineWidth, width));
+        pCtx->recording()->addCommand(new ListCmd1f(glLineWidth, width));
         return;
     }
 
-    s_pCtx->m_backend.setLineWidth(width);
+    pCtx->m_backend.setLineWidth(width);
 }
 
 void glPolygonMode(GLenum face, GLenum mode)
@@ -899,9 +1118,13 @@ void glRectd(GLdouble x1, GLdouble y1, GLdouble x2, GLdouble y2)
 
 void glGenTextures(GLsizei n, GLuint *textures)
 {
-    if(!s_pCtx)
+    RenderContext *pCtx=currentContext();
+
+    if(!pCtx)
         return;
 
+    QMutexLocker locker(&s_textureMutex);
+
     // First, try to fill request from the available deleted textures
     while(n>0 && s_availableTextures.size()>0)
     {
@@ -913,45 +1136,63 @@ void glGenTextures(GLsizei n, GLuint *textures)
 
     // If we still need additional textures, get them from the backend
     if(n>0)
-        s_pCtx->m_backend.reserveTexIndexes(n, textures);
+        VasGLBackendAGG::reserveTexIndexes(n, textures);
 }
 
 void glDeleteTextures(GLsizei n, GLuint *textures)
 {
+    RenderContext *pCtx=currentContext();
     int i;
 
-    if(!s_pCtx)
+    if(!pCtx)
         return;
 
+    QMutexLocker locker(&s_textureMutex);
+
     for(i=0; i<n; i++)
         s_availableTextures.push_back(textures[i]);
 }
 
 void glBindTexture(GLenum target, GLuint texture)
 {
-    if(!s_pCtx)
+    RenderContext *pCtx=currentContext();
+
+    if(!pCtx)
         return;
 
-    if(s_pCtx->m_pList)
+    if(pCtx->m_pList)
+    {
+        pCtx->m_pList->addCommand(new ListCmd2<GLenum, GLuint>
+            (glBindTexture, target, texture));
+        return;
+    }
+
+    // glTexImage2D() loads the texture bound when it is called, also while
+    // recording a frame
+    if(target==GL_TEXTURE_2D)
+        pCtx->m_boundTexture=texture;
+
+    if(pCtx->m_pFrame)
     {
-        s_pCtx->m_pList->addCommand(new ListCmd2<GLenum, GLuint>
+        pCtx->m_pFrame->addCommand(new ListCmd2<GLenum, GLuint>
             (glBindTexture, target, texture));
         return;
     }
 
     if(target==GL_TEXTURE_2D)
-        s_pCtx->m_backend.selectTexture(texture);
+        pCtx->m_backend.selectTexture(texture);
 }
 
 void glTexImage2D(GLenum target, GLint level, GLint internalFormat,
     GLsizei width, GLsizei height, GLint border, GLenum format, GLenum type,
     const GLvoid *pixels)
 {
+    RenderContext *pCtx=currentContext();
     int x, y;
     const uint8_t *buf=(const uint8_t *)pixels;
     uint8_t lum, alpha;
 
-    if(!s_pCtx)
+    if(!pCtx)
         return;
 
     if(target==GL_TEXTURE_2D && level==0 &&
@@ -970,7 +1211,7 @@ void glTexImage2D(GLenum target, GLint level, GLint internalFormat,
                 img.setPixel(x, y, qRgba(lum, lum, lum, alpha));
             }
 
-        s_pCtx->m_backend.setTexture(img);
+        VasGLBackendAGG::setTexture(pCtx->m_boundTexture, img);
     }
 }
 
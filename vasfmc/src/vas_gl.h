@@ -57,6 +57,26 @@ extern VasGLRenderContext vasglCreateContext(int width, int height);
 extern void vasglFreeContext(VasGLRenderContext ctx);
 
 extern void vasglMakeCurrent(VasGLRenderContext ctx, QImage *pimg);
+    // Makes 'ctx' the current context of the calling thread. 'pimg' may be
+    // NULL if the context is only used to record frames.
+
+typedef void *VasGLFrame;
+
+extern void vasglBeginFrame();
+    // Starts recording all following calls on the current context into a
+    // frame instead of drawing them. Display lists are still compiled
+    // immediately.
+
+extern VasGLFrame vasglEndFrame();
+    // Stops recording and returns the frame, which has to be freed with
+    // vasglFreeFrame().
+
+extern void vasglRenderFrame(VasGLRenderContext ctx, VasGLFrame frame,
+    QImage *pimg);
+    // Draws a recorded frame of 'ctx' to 'pimg' in the calling thread. The
+    // context must not be used by another thread meanwhile.
+
+extern void vasglFreeFrame(VasGLFrame frame);
 
 // Types
 typedef unsigned int GLuint;
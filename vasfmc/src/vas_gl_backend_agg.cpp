@@ -4,12 +4,17 @@
 
 #include "logger.h"
 
+#include <QReadWriteLock>
+
 #include <agg_conv_stroke.h>
 
 #include <cstdlib>
 #include <cstring>
 
+// Textures are shared by the backends of all threads, they are read while
+// drawing and written only when a texture is loaded
 static QVector<agg::rendering_buffer *> s_textures;
+static QReadWriteLock                   s_texturesLock;
 
 static void agg_error_callback(const char *msg)
 {
@@ -235,6 +240,8 @@ void VasGLBackendAGG::drawPrimitives(GLenum mode,
                vertices.size()==4 &&
                m_textureIdx!=0)
             {
+                QReadLocker locker(&s_texturesLock);
+
                 agg::pixfmt_gray8 pixfmt_img(*s_textures[m_textureIdx]);
 
                 m_path_storage.remove_all();
@@ -454,6 +461,8 @@ void VasGLBackendAGG::disableClipping()
 
 /* static */ void VasGLBackendAGG::reserveTexIndexes(int num, GLuint *indexes)
 {
+    QWriteLocker locker(&s_texturesLock);
+
     // Since a texture index of 0 is not permissible, create a dummy texture
     // with an index of 0 if necessary
     if(s_textures.size()==0)
@@ -469,7 +478,7 @@ void VasGLBackendAGG::disableClipping()
     }
 }
 
-void VasGLBackendAGG::setTexture(QImage img)
+/* static */ void VasGLBackendAGG::setTexture(int idx, QImage img)
 {
     uint8_t *buffer;
     QRgb    *pScanline;
@@ -479,16 +488,18 @@ void VasGLBackendAGG::setTexture(QImage img)
     if(img.format()!=QImage::Format_ARGB32)
         return;
 
-    if(m_textureIdx!=0)
+    QWriteLocker locker(&s_texturesLock);
+
+    if(idx>0 && idx<s_textures.size())
     {
         // Allocate buffer
         buffer=new uint8_t[img.width()*img.height()];
 
         // Delete old buffer
-        delete [] s_textures[m_textureIdx]->buf();
+        delete [] s_textures[idx]->buf();
 
         // Attach buffer to rendering buffer
-        s_textures[m_textureIdx]->attach(buffer, img.width(), img.height(),
+        s_textures[idx]->attach(buffer, img.width(), img.height(),
             img.width());
 
         // Copy in image data
@@ -496,13 +507,15 @@ void VasGLBackendAGG::setTexture(QImage img)
         {
             pScanline=(QRgb *)img.scanLine(y);
             for(x=0; x<img.width(); x++)
-                s_textures[m_textureIdx]->row_ptr(y)[x]=qRed(pScanline[x]);
+                s_textures[idx]->row_ptr(y)[x]=qRed(pScanline[x]);
         }
     }
 }
 
 void VasGLBackendAGG::selectTexture(int idx)
 {
+    QReadLocker locker(&s_texturesLock);
+
     if(idx<0 || idx>=s_textures.size())
     {
         Logger::log("VasGLBackendAGG::selectTexture(): Warning, invalid "
@@ -223,9 +223,10 @@ public:
     void endClipRegion();
     void disableClipping();
 
-    // Textures
+    // Textures, shared by all backends. Loading a texture waits until no
+    // backend draws textures anymore.
     static void reserveTexIndexes(int num, GLuint *indexes);
-    void setTexture(QImage img);
+    static void setTexture(int idx, QImage img);
     void selectTexture(int idx);
 
 private:
@@ -57,6 +57,11 @@ public:
         return true;
     }
 
+    VasGLRenderContext context() const
+    {
+        return m_ctx;
+    }
+
 private:
     VasGLRenderContext m_ctx;
     QImage             *m_pimg;
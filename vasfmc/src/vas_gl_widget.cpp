@@ -26,12 +26,108 @@
 #include "code_timer.h"
 #endif
 
+#include "assert.h"
+
 #if !VASFMC_GAUGE
+#include <QCoreApplication>
 #include <QPainter>
 #endif
 
 #define CODETIMER 0
 
+#if VAS_GL_RENDER_THREAD
+VasGLRenderThread::VasGLRenderThread(QObject *pReceiver)
+    : m_pReceiver(pReceiver), m_ctx(NULL), m_frame(NULL), m_pimg(NULL),
+      m_rendering(false), m_stop(false)
+{
+}
+
+/* virtual */ VasGLRenderThread::~VasGLRenderThread()
+{
+    m_mutex.lock();
+    m_stop=true;
+    m_condFrame.wakeAll();
+    m_mutex.unlock();
+
+    wait();
+
+    // Free a frame which was not picked up anymore
+    vasglFreeFrame(m_frame);
+}
+
+void VasGLRenderThread::render(VasGLRenderContext ctx, VasGLFrame frame,
+    QImage *pimg)
+{
+    QMutexLocker locker(&m_mutex);
+
+    MYASSERT(!m_rendering);
+
+    m_ctx=ctx;
+    m_frame=frame;
+    m_pimg=pimg;
+    m_rendering=true;
+    m_condFrame.wakeAll();
+
+    if(!isRunning())
+        start();
+}
+
+bool VasGLRenderThread::isRendering()
+{
+    QMutexLocker locker(&m_mutex);
+
+    return m_rendering;
+}
+
+void VasGLRenderThread::waitForFrame()
+{
+    QMutexLocker locker(&m_mutex);
+
+    while(m_rendering)
+        m_condFinished.wait(&m_mutex);
+}
+
+// protected:
+
+/* virtual */ void VasGLRenderThread::run()
+{
+    VasGLRenderContext ctx;
+    VasGLFrame         frame;
+    QImage             *pimg;
+
+    m_mutex.lock();
+
+    while(true)
+    {
+        while(!m_stop && !m_rendering)
+            m_condFrame.wait(&m_mutex);
+
+        if(m_stop)
+            break;
+
+        ctx=m_ctx;
+        frame=m_frame;
+        pimg=m_pimg;
+        m_frame=NULL;
+
+        m_mutex.unlock();
+
+        vasglRenderFrame(ctx, frame, pimg);
+        vasglFreeFrame(frame);
+
+        m_mutex.lock();
+
+        m_rendering=false;
+        m_condFinished.wakeAll();
+
+        QCoreApplication::postEvent(m_pReceiver,
+            new QEvent(FrameRenderedEvent));
+    }
+
+    m_mutex.unlock();
+}
+#endif // VAS_GL_RENDER_THREAD
+
 VasGLWidget::VasGLWidget(const QGLFormat &format, VasWidget *parent /* =0 */)
 #if VASFMC_GAUGE
     : m_pBuffer(NULL), m_size(0, 0)
@@ -39,10 +135,19 @@ VasGLWidget::VasGLWidget(const QGLFormat &format, VasWidget *parent /* =0 */)
     : VasWidget(parent), m_pBuffer(NULL), m_size(0, 0)
 #endif
 {
+#if VAS_GL_RENDER_THREAD
+    m_pRenderThread=NULL;
+    m_framePending=false;
+#endif
 }
 
 /* virtual */ VasGLWidget::~VasGLWidget()
 {
+#if VAS_GL_RENDER_THREAD
+    // Stop the render thread before its context goes away
+    delete m_pRenderThread;
+#endif
+
     if(m_pBuffer!=NULL)
         m_pBuffer->doneCurrent();
 
@@ -53,6 +158,11 @@ void VasGLWidget::makeCurrent()
 {
     int dxDesired, dyDesired;
 
+#if VAS_GL_RENDER_THREAD
+    if(m_framePending)
+        finishFrame();
+#endif
+
     getDesiredSize(&dxDesired, &dyDesired);
     createPixelBuffer(QSize(dxDesired, dyDesired));
     m_pBuffer->makeCurrent(pimgCur());
@@ -82,6 +192,18 @@ void VasGLWidget::updateGL()
 #endif
     QString strPaintGL, strConvert;
 
+#if VAS_GL_RENDER_THREAD
+    // Only one frame is drawn at a time, if the previous one is not finished
+    // yet this refresh is dropped
+    if(m_framePending)
+    {
+        if(m_pRenderThread->isRendering())
+            return;
+
+        finishFrame();
+    }
+#endif
+
     // Get the desired size for the bitmap (i.e. the size of the window).
     getDesiredSize(&dxDesired, &dyDesired);
     if(dxDesired==0 || dyDesired==0)
@@ -97,6 +219,24 @@ void VasGLWidget::updateGL()
 
     // Create an OpenGL pixel buffer and make the GL context current
     createPixelBuffer(QSize(dxDesired, dyDesired));
+
+#if VAS_GL_RENDER_THREAD
+    // Painting reads the state of vasFMC, so the frame is recorded here and
+    // only drawn in the render thread
+    m_pBuffer->makeCurrent(NULL);
+
+    vasglBeginFrame();
+    paintGL();
+    VasGLFrame frame=vasglEndFrame();
+
+    m_pBuffer->doneCurrent();
+
+    if(m_pRenderThread==NULL)
+        m_pRenderThread=new VasGLRenderThread(this);
+
+    m_pRenderThread->render(m_pBuffer->context(), frame, pimgCur());
+    m_framePending=true;
+#else
     m_pBuffer->makeCurrent(pimgCur());
 
     // Paint the gauge using OpenGL
@@ -126,6 +266,7 @@ void VasGLWidget::updateGL()
 
     // Flip buffers
     flip();
+#endif // VAS_GL_RENDER_THREAD
 }
 
 // protected:
@@ -142,8 +283,34 @@ void VasGLWidget::updateGL()
 }
 #endif
 
+#if VAS_GL_RENDER_THREAD
+/* virtual */ bool VasGLWidget::event(QEvent *event)
+{
+    if(event->type()==VasGLRenderThread::FrameRenderedEvent)
+    {
+        // The frame may have been shown by updateGL() already
+        if(m_framePending)
+            finishFrame();
+
+        return true;
+    }
+
+    return VasWidget::event(event);
+}
+#endif
+
 // private:
 
+#if VAS_GL_RENDER_THREAD
+void VasGLWidget::finishFrame()
+{
+    m_pRenderThread->waitForFrame();
+    m_framePending=false;
+
+    flip();
+}
+#endif
+
 void VasGLWidget::createPixelBuffer(QSize size)
 {
     QImage imgDummy;
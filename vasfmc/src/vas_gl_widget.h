@@ -32,9 +32,61 @@
 #include "vas_gl_pixelbuffer.h"
 
 #include <QColor>
+#include <QEvent>
 #include <QImage>
+#include <QMutex>
 #include <QObject>
 #include <QPixmap>
+#include <QThread>
+#include <QWaitCondition>
+
+#if VAS_GL_EMUL && !VASFMC_GAUGE
+// The standalone version records the frames in the GUI thread and draws them
+// in a render thread per widget
+#define VAS_GL_RENDER_THREAD 1
+#else
+#define VAS_GL_RENDER_THREAD 0
+#endif
+
+#if VAS_GL_RENDER_THREAD
+class VasGLRenderThread : public QThread
+// Draws the recorded frames of one VasGLWidget. A FrameRenderedEvent is
+// posted to the widget when a frame is finished.
+{
+public:
+    static const QEvent::Type FrameRenderedEvent=QEvent::Type(QEvent::User+1);
+
+    VasGLRenderThread(QObject *pReceiver);
+
+    virtual ~VasGLRenderThread();
+
+    void render(VasGLRenderContext ctx, VasGLFrame frame, QImage *pimg);
+        // Draws 'frame' to 'pimg' and frees it. The context and the image
+        // must not be used until the frame is finished.
+
+    bool isRendering();
+        // Returns true while a frame is being drawn
+
+    void waitForFrame();
+        // Blocks until the current frame is finished
+
+protected:
+    virtual void run();
+
+private:
+    QObject            *m_pReceiver;
+
+    QMutex             m_mutex;
+    QWaitCondition     m_condFrame;
+    QWaitCondition     m_condFinished;
+
+    VasGLRenderContext m_ctx;
+    VasGLFrame         m_frame;
+    QImage             *m_pimg;
+    bool               m_rendering;
+    bool               m_stop;
+};
+#endif // VAS_GL_RENDER_THREAD
 
 class VasGLWidget : public VasWidget
 // Base class for widgets that are drawn using OpenGL. VasGLWidget can be used
@@ -80,6 +132,10 @@ protected:
     virtual void paintEvent(QPaintEvent *event);
 #endif
 
+#if VAS_GL_RENDER_THREAD
+    virtual bool event(QEvent *event);
+#endif
+
 private:
     void createPixelBuffer(QSize size);
 
@@ -92,6 +148,14 @@ private:
     QPixmap        m_pixmap;
 #endif
 
+#if VAS_GL_RENDER_THREAD
+    void finishFrame();
+        // Waits for the frame being drawn and shows it
+
+    VasGLRenderThread *m_pRenderThread;
+    bool              m_framePending;
+#endif
+
     VasGLPixelBuffer *m_pBuffer;
     QSize            m_size;
 };
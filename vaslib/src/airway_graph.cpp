@@ -0,0 +1,546 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2005-2006 Alexander Wemmer
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <QtAlgorithms>
+
+#include "logger.h"
+#include "navcalc.h"
+
+#include "airway_graph.h"
+
+//! waypoints outside the graph are connected to this many nearest fixes
+#define ENDPOINT_CONNECTION_COUNT 8
+//! waypoints outside the graph are connected to fixes within this distance
+#define ENDPOINT_CONNECTION_MAX_NM 250.0
+
+#define NO_NODE 0xffffffff
+
+/////////////////////////////////////////////////////////////////////////////
+
+//! binary min heap for the A* open list
+class AirwayGraphOpenList
+{
+public:
+
+    struct Entry
+    {
+        double cost;
+        uint node;
+    };
+
+    inline bool isEmpty() const { return m_entries.isEmpty(); }
+
+    void push(double cost, uint node)
+    {
+        Entry entry;
+        entry.cost = cost;
+        entry.node = node;
+        m_entries.append(entry);
+
+        int index = m_entries.count() - 1;
+        while(index > 0)
+        {
+            int parent = (index - 1) / 2;
+            if (m_entries[parent].cost <= m_entries[index].cost) break;
+            qSwap(m_entries[parent], m_entries[index]);
+            index = parent;
+        }
+    }
+
+    Entry pop()
+    {
+        Entry top = m_entries[0];
+        m_entries[0] = m_entries.last();
+        m_entries.remove(m_entries.count() - 1);
+
+        int index = 0;
+        int count = m_entries.count();
+        while(true)
+        {
+            int smallest = index;
+            int left = index * 2 + 1;
+            int right = left + 1;
+            if (left < count && m_entries[left].cost < m_entries[smallest].cost) smallest = left;
+            if (right < count && m_entries[right].cost < m_entries[smallest].cost) smallest = right;
+            if (smallest == index) break;
+            qSwap(m_entries[smallest], m_entries[index]);
+            index = smallest;
+        }
+
+        return top;
+    }
+
+protected:
+
+    QVector<Entry> m_entries;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+
+AirwayGraph::AirwayGraph()
+{
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void AirwayGraph::clear()
+{
+    m_nodes.clear();
+    m_edges.clear();
+    m_pending_edges.clear();
+    m_id_node_map.clear();
+    m_airway_names.clear();
+    m_airway_name_map.clear();
+    m_node_spatial_index.clear();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+uint AirwayGraph::addNode(const Waypoint& waypoint)
+{
+    QByteArray id = waypoint.id().toLatin1();
+
+    QList<uint>& node_list = m_id_node_map[id];
+    QList<uint>::const_iterator iter = node_list.begin();
+    for(; iter != node_list.end(); ++iter)
+    {
+        const Node& node = m_nodes[*iter];
+        if (qAbs(node.lat - waypoint.lat()) <= Waypoint::LAT_LON_COMPARE_EPSILON &&
+            qAbs(node.lon - waypoint.lon()) <= Waypoint::LAT_LON_COMPARE_EPSILON) return *iter;
+    }
+
+    Node node;
+    node.id = id;
+    node.lat = waypoint.lat();
+    node.lon = waypoint.lon();
+    node.first_edge = 0;
+    node.edge_count = 0;
+    m_nodes.append(node);
+
+    node_list.append(m_nodes.count() - 1);
+    return m_nodes.count() - 1;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void AirwayGraph::addAirway(const Airway& airway)
+{
+    QByteArray name = airway.id().toLatin1();
+    if (!m_airway_name_map.contains(name))
+    {
+        m_airway_name_map.insert(name, m_airway_names.count());
+        m_airway_names.append(name);
+    }
+    uint airway_index = m_airway_name_map.value(name);
+
+    const WaypointPtrList& waypoint_list = airway.waypointList();
+    for(int index = 1; index < waypoint_list.count(); ++index)
+    {
+        const Waypoint& waypoint1 = *waypoint_list[index-1];
+        const Waypoint& waypoint2 = *waypoint_list[index];
+
+        uint node1 = addNode(waypoint1);
+        uint node2 = addNode(waypoint2);
+        if (node1 == node2) continue;
+
+        double distance_nm = 0.0;
+        double course = 0.0;
+
+        PendingEdge pending_edge;
+        pending_edge.edge.airway = airway_index;
+
+        Navcalc::getDistAndTrackBetweenWaypoints(waypoint1, waypoint2, distance_nm, course);
+        pending_edge.from_node = node1;
+        pending_edge.edge.to_node = node2;
+        pending_edge.edge.distance_nm = distance_nm;
+        pending_edge.edge.course = course;
+        m_pending_edges.append(pending_edge);
+
+        Navcalc::getDistAndTrackBetweenWaypoints(waypoint2, waypoint1, distance_nm, course);
+        pending_edge.from_node = node2;
+        pending_edge.edge.to_node = node1;
+        pending_edge.edge.distance_nm = distance_nm;
+        pending_edge.edge.course = course;
+        m_pending_edges.append(pending_edge);
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void AirwayGraph::finalize()
+{
+    qStableSort(m_pending_edges);
+
+    m_edges.clear();
+    m_edges.reserve(m_pending_edges.count());
+
+    QList<PendingEdge>::const_iterator iter = m_pending_edges.begin();
+    for(; iter != m_pending_edges.end(); ++iter)
+    {
+        Node& node = m_nodes[iter->from_node];
+        if (node.edge_count == 0) node.first_edge = m_edges.count();
+        ++node.edge_count;
+        m_edges.append(iter->edge);
+    }
+
+    m_pending_edges.clear();
+
+    buildNodeLookup();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void AirwayGraph::buildNodeLookup()
+{
+    m_id_node_map.clear();
+    m_node_spatial_index.clear();
+    for(int index = 0; index < m_nodes.count(); ++index)
+    {
+        m_id_node_map[m_nodes[index].id].append(index);
+        m_node_spatial_index.insert(m_nodes[index].lat, m_nodes[index].lon, index);
+    }
+    m_node_spatial_index.finalize();
+
+    m_airway_name_map.clear();
+    for(int index = 0; index < m_airway_names.count(); ++index)
+        m_airway_name_map.insert(m_airway_names[index], index);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void AirwayGraph::operator<<(QDataStream& in)
+{
+    clear();
+
+    quint32 node_count = 0, edge_count = 0;
+    in >> m_airway_names >> node_count >> edge_count;
+    if (in.status() != QDataStream::Ok) { clear(); return; }
+
+    // the counts are not trusted for allocations, a truncated stream ends
+    // the loops
+
+    for(uint index = 0; index < node_count && in.status() == QDataStream::Ok; ++index)
+    {
+        Node node;
+        in >> node.id >> node.lat >> node.lon >> node.first_edge >> node.edge_count;
+        m_nodes.append(node);
+    }
+
+    for(uint index = 0; index < edge_count && in.status() == QDataStream::Ok; ++index)
+    {
+        Edge edge;
+        in >> edge.to_node >> edge.airway >> edge.distance_nm >> edge.course;
+        m_edges.append(edge);
+    }
+
+    if (in.status() != QDataStream::Ok) { clear(); return; }
+
+    // the edges are followed without further checks
+
+    bool consistent = true;
+    for(uint index = 0; index < node_count && consistent; ++index)
+    {
+        const Node& node = m_nodes[index];
+        consistent = node.first_edge <= edge_count && node.edge_count <= edge_count - node.first_edge;
+    }
+
+    for(uint index = 0; index < edge_count && consistent; ++index)
+    {
+        const Edge& edge = m_edges[index];
+        consistent = edge.to_node < node_count && edge.airway < (uint)m_airway_names.count();
+    }
+
+    if (!consistent)
+    {
+        Logger::log("AirwayGraph:operator<<: inconsistent graph data");
+        in.setStatus(QDataStream::ReadCorruptData);
+        clear();
+        return;
+    }
+
+    buildNodeLookup();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void AirwayGraph::operator>>(QDataStream& out) const
+{
+    MYASSERT(m_pending_edges.isEmpty());
+
+    out << m_airway_names << (quint32)m_nodes.count() << (quint32)m_edges.count();
+
+    for(int index = 0; index < m_nodes.count(); ++index)
+    {
+        const Node& node = m_nodes[index];
+        out << node.id << node.lat << node.lon << node.first_edge << node.edge_count;
+    }
+
+    for(int index = 0; index < m_edges.count(); ++index)
+    {
+        const Edge& edge = m_edges[index];
+        out << edge.to_node << edge.airway << edge.distance_nm << edge.course;
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+int AirwayGraph::findNode(const Waypoint& waypoint) const
+{
+    QHash<QByteArray, QList<uint> >::const_iterator map_iter = m_id_node_map.find(waypoint.id().toLatin1());
+    if (map_iter == m_id_node_map.end()) return -1;
+
+    QList<uint>::const_iterator iter = map_iter->begin();
+    for(; iter != map_iter->end(); ++iter)
+    {
+        const Node& node = m_nodes[*iter];
+        if (qAbs(node.lat - waypoint.lat()) <= Waypoint::LAT_LON_COMPARE_EPSILON &&
+            qAbs(node.lon - waypoint.lon()) <= Waypoint::LAT_LON_COMPARE_EPSILON) return *iter;
+    }
+
+    return -1;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+Waypoint* AirwayGraph::createWaypoint(uint node_index, const QString& parent) const
+{
+    const Node& node = m_nodes[node_index];
+    Waypoint* waypoint = new Waypoint(QString::fromLatin1(node.id), QString::null, node.lat, node.lon);
+    MYASSERT(waypoint != 0);
+    waypoint->setParent(parent);
+    return waypoint;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+double AirwayGraph::distanceToNode(const Waypoint& waypoint, uint node_index) const
+{
+    const Node& node = m_nodes[node_index];
+
+    double rad_lat1 = Navcalc::toRad(waypoint.lat());
+    double rad_lat2 = Navcalc::toRad(node.lat);
+    double cos_angle = sin(rad_lat1)*sin(rad_lat2) +
+                       cos(rad_lat1)*cos(rad_lat2)*cos(Navcalc::toRad(waypoint.lon() - node.lon));
+
+    if (cos_angle >= 1.0) return 0.0;
+    if (cos_angle <= -1.0) return 180.0 * 60.0;
+    return Navcalc::toDeg(acos(cos_angle)) * 60.0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+bool AirwayGraph::getWaypointsByAirway(const Waypoint& from_waypoint,
+                                       const QString& airway,
+                                       const QString& to_waypoint,
+                                       WaypointPtrList& result_wpt_list) const
+{
+    int start_node = findNode(from_waypoint);
+    if (start_node < 0) return false;
+
+    QHash<QByteArray, uint>::const_iterator airway_iter = m_airway_name_map.find(airway.toLatin1());
+    if (airway_iter == m_airway_name_map.end()) return false;
+    uint airway_index = *airway_iter;
+
+    QByteArray to_id = to_waypoint.toLatin1();
+
+    // breadth first walk along the edges of the airway, the airway may be
+    // walked in both directions
+
+    QHash<uint, uint> previous_node_map;
+    previous_node_map.insert(start_node, NO_NODE);
+
+    QList<uint> open_list;
+    open_list.append(start_node);
+
+    uint found_node = NO_NODE;
+    while(!open_list.isEmpty() && found_node == NO_NODE)
+    {
+        uint node_index = open_list.takeFirst();
+        const Node& node = m_nodes[node_index];
+
+        for(uint edge_index = node.first_edge; edge_index < node.first_edge + node.edge_count; ++edge_index)
+        {
+            const Edge& edge = m_edges[edge_index];
+            if (edge.airway != airway_index || previous_node_map.contains(edge.to_node)) continue;
+
+            previous_node_map.insert(edge.to_node, node_index);
+            if (m_nodes[edge.to_node].id == to_id)
+            {
+                found_node = edge.to_node;
+                break;
+            }
+
+            open_list.append(edge.to_node);
+        }
+    }
+
+    if (found_node == NO_NODE) return false;
+
+    QList<uint> path;
+    for(uint node_index = found_node; node_index != (uint)start_node; node_index = previous_node_map.value(node_index))
+        path.prepend(node_index);
+
+    QList<uint>::const_iterator iter = path.begin();
+    for(; iter != path.end(); ++iter) result_wpt_list.append(createWaypoint(*iter, airway));
+
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void AirwayGraph::getEndpointNodes(const Waypoint& waypoint, QList<uint>& nodes, QList<double>& distances) const
+{
+    int node_index = findNode(waypoint);
+    if (node_index >= 0)
+    {
+        nodes.append(node_index);
+        distances.append(0.0);
+        return;
+    }
+
+    NavdataSpatialIndex::HitList hits;
+    m_node_spatial_index.getNearest(waypoint.lat(), waypoint.lon(), ENDPOINT_CONNECTION_COUNT, hits);
+
+    NavdataSpatialIndex::HitList::const_iterator iter = hits.begin();
+    for(; iter != hits.end(); ++iter)
+    {
+        if (iter->distance_nm > ENDPOINT_CONNECTION_MAX_NM) break;
+        nodes.append(iter->index);
+        distances.append(iter->distance_nm);
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+bool AirwayGraph::findRoute(const Waypoint& from,
+                            const Waypoint& to,
+                            WaypointPtrList& result_wpt_list,
+                            double& distance_nm,
+                            const QStringList& allowed_airways) const
+{
+    distance_nm = 0.0;
+    if (m_nodes.isEmpty()) return false;
+
+    // airway restriction
+
+    QVector<bool> airway_allowed(m_airway_names.count(), allowed_airways.isEmpty());
+    QStringList::const_iterator allowed_iter = allowed_airways.begin();
+    for(; allowed_iter != allowed_airways.end(); ++allowed_iter)
+    {
+        QHash<QByteArray, uint>::const_iterator iter = m_airway_name_map.find(allowed_iter->toUpper().toLatin1());
+        if (iter != m_airway_name_map.end()) airway_allowed[*iter] = true;
+    }
+
+    // connect the endpoints, the goal is a virtual node behind all nodes
+
+    QList<uint> start_nodes;
+    QList<double> start_distances;
+    getEndpointNodes(from, start_nodes, start_distances);
+
+    QList<uint> goal_nodes;
+    QList<double> goal_distances;
+    getEndpointNodes(to, goal_nodes, goal_distances);
+
+    if (start_nodes.isEmpty() || goal_nodes.isEmpty()) return false;
+
+    uint goal = m_nodes.count();
+    QHash<uint, double> goal_link_map;
+    for(int index = 0; index < goal_nodes.count(); ++index) goal_link_map.insert(goal_nodes[index], goal_distances[index]);
+
+    // A* with the great circle distance to the goal as heuristic
+
+    QVector<double> cost(m_nodes.count() + 1, -1.0);
+    QVector<uint> previous_node(m_nodes.count() + 1, NO_NODE);
+    QVector<uint> previous_airway(m_nodes.count() + 1, NO_NODE);
+    QVector<bool> closed(m_nodes.count() + 1, false);
+
+    AirwayGraphOpenList open_list;
+
+    for(int index = 0; index < start_nodes.count(); ++index)
+    {
+        uint node_index = start_nodes[index];
+        cost[node_index] = start_distances[index];
+        open_list.push(cost[node_index] + distanceToNode(to, node_index), node_index);
+    }
+
+    while(!open_list.isEmpty())
+    {
+        uint node_index = open_list.pop().node;
+        if (closed[node_index]) continue;
+        closed[node_index] = true;
+
+        if (node_index == goal) break;
+
+        QHash<uint, double>::const_iterator goal_iter = goal_link_map.find(node_index);
+        if (goal_iter != goal_link_map.end())
+        {
+            double goal_cost = cost[node_index] + *goal_iter;
+            if (cost[goal] < 0.0 || goal_cost < cost[goal])
+            {
+                cost[goal] = goal_cost;
+                previous_node[goal] = node_index;
+                open_list.push(goal_cost, goal);
+            }
+        }
+
+        const Node& node = m_nodes[node_index];
+        for(uint edge_index = node.first_edge; edge_index < node.first_edge + node.edge_count; ++edge_index)
+        {
+            const Edge& edge = m_edges[edge_index];
+            if (!airway_allowed[edge.airway] || closed[edge.to_node]) continue;
+
+            double new_cost = cost[node_index] + edge.distance_nm;
+            if (cost[edge.to_node] >= 0.0 && cost[edge.to_node] <= new_cost) continue;
+
+            cost[edge.to_node] = new_cost;
+            previous_node[edge.to_node] = node_index;
+            previous_airway[edge.to_node] = edge.airway;
+            open_list.push(new_cost + distanceToNode(to, edge.to_node), edge.to_node);
+        }
+    }
+
+    if (!closed[goal]) return false;
+
+    distance_nm = cost[goal];
+
+    // the last graph node is "to" itself when it is part of the graph
+
+    uint last_node = previous_node[goal];
+    if (findNode(to) == (int)last_node) last_node = previous_node[last_node];
+
+    QList<uint> path;
+    for(uint node_index = last_node; node_index != NO_NODE; node_index = previous_node[node_index])
+        path.prepend(node_index);
+
+    // the first graph node is "from" itself when it is part of the graph
+    if (!path.isEmpty() && findNode(from) == (int)path.first()) path.removeFirst();
+
+    QList<uint>::const_iterator iter = path.begin();
+    for(; iter != path.end(); ++iter)
+    {
+        uint airway = previous_airway[*iter];
+        result_wpt_list.append(createWaypoint(*iter, (airway == NO_NODE) ?
+                                              QString::null : QString::fromLatin1(m_airway_names[airway])));
+    }
+
+    return true;
+}
+
+// End of file
@@ -0,0 +1,153 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2005-2006 Alexander Wemmer
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef AIRWAY_GRAPH_H
+#define AIRWAY_GRAPH_H
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QHash>
+#include <QList>
+#include <QString>
+#include <QStringList>
+#include <QVector>
+
+#include "assert.h"
+#include "airway.h"
+#include "navdata_spatial_index.h"
+
+/////////////////////////////////////////////////////////////////////////////
+
+//! In-memory graph of all airways. The fixes of the airways are the nodes,
+//! every airway segment is stored as two directed edges with distance and
+//! course. The edges are stored packed per node.
+//! Airways are collected with addAirway() and the graph is built by finalize().
+class AirwayGraph
+{
+public:
+
+    struct Node
+    {
+        QByteArray id;
+        double lat;
+        double lon;
+        uint first_edge;
+        uint edge_count;
+    };
+
+    struct Edge
+    {
+        uint to_node;
+        uint airway;
+        float distance_nm;
+        float course;
+    };
+
+    AirwayGraph();
+    virtual ~AirwayGraph() {};
+
+    void clear();
+
+    //! adds all segments of the given airway, call finalize() when all
+    //! airways have been added
+    void addAirway(const Airway& airway);
+
+    //! builds the packed edge lists
+    void finalize();
+
+    //! Reads a finalized graph, the graph is empty and the stream status
+    //! is set when the data is inconsistent.
+    void operator<<(QDataStream& in);
+    //! writes a finalized graph
+    void operator>>(QDataStream& out) const;
+
+    inline bool isEmpty() const { return m_nodes.isEmpty(); }
+    inline uint nodeCount() const { return m_nodes.count(); }
+    inline uint edgeCount() const { return m_edges.count(); }
+    inline uint airwayCount() const { return m_airway_names.count(); }
+
+    inline const Node& node(uint index) const { return m_nodes[index]; }
+    inline const Edge& edge(uint index) const { return m_edges[index]; }
+    inline const QByteArray& airwayName(uint index) const { return m_airway_names[index]; }
+
+    //! returns the index of the node with the ID and position of the given
+    //! waypoint, -1 if there is no such node
+    int findNode(const Waypoint& waypoint) const;
+
+    //! Walks along the given airway from "from_waypoint" to the fix with the
+    //! ID "to_waypoint" in either direction and appends the fixes after
+    //! "from_waypoint" up to and including "to_waypoint" to the given list.
+    //! The parent of the fixes is set to the airway. Returns true on success.
+    bool getWaypointsByAirway(const Waypoint& from_waypoint,
+                              const QString& airway,
+                              const QString& to_waypoint,
+                              WaypointPtrList& result_wpt_list) const;
+
+    //! Searches the shortest route via airways (A*) from "from" to "to" and
+    //! appends the fixes in between to the given list, the parent of the
+    //! fixes is set to the airway they are reached by. Waypoints which are
+    //! not fixes of the graph (e.g. airports) are connected directly to
+    //! their nearest fixes. When "allowed_airways" is not empty, only those
+    //! airways are used. Returns true if a route was found.
+    bool findRoute(const Waypoint& from,
+                   const Waypoint& to,
+                   WaypointPtrList& result_wpt_list,
+                   double& distance_nm,
+                   const QStringList& allowed_airways = QStringList()) const;
+
+    //! ATTENTION: the caller is responsible to delete the returned waypoint
+    Waypoint* createWaypoint(uint node_index, const QString& parent = QString::null) const;
+
+protected:
+
+    struct PendingEdge
+    {
+        uint from_node;
+        Edge edge;
+        bool operator<(const PendingEdge& other) const { return from_node < other.from_node; }
+    };
+
+    uint addNode(const Waypoint& waypoint);
+
+    //! builds the lookup maps and the spatial index of the nodes
+    void buildNodeLookup();
+
+    //! appends the nodes a waypoint is connected to together with the
+    //! direct distance to the given lists
+    void getEndpointNodes(const Waypoint& waypoint, QList<uint>& nodes, QList<double>& distances) const;
+
+    double distanceToNode(const Waypoint& waypoint, uint node_index) const;
+
+protected:
+
+    QVector<Node> m_nodes;
+    QVector<Edge> m_edges;
+    QList<PendingEdge> m_pending_edges;
+
+    QHash<QByteArray, QList<uint> > m_id_node_map;
+
+    QVector<QByteArray> m_airway_names;
+    QHash<QByteArray, uint> m_airway_name_map;
+
+    //! used to connect waypoints outside the graph
+    NavdataSpatialIndex m_node_spatial_index;
+};
+
+#endif
@@ -25,9 +25,9 @@
 #ifndef __CONTROLLER_BASE_H__
 #define __CONTROLLER_BASE_H__
 
-#include <QTime>
 
 #include "flightstatus.h"
+#include "sim_clock.h"
 
 /////////////////////////////////////////////////////////////////////////////
 
@@ -66,7 +66,7 @@ protected:
     double m_max_output;
     double m_output;
 
-    QTime m_last_call_dt;
+    SimTimer m_last_call_dt;
 
 private:
     //! Hidden copy-constructor
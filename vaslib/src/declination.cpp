@@ -22,22 +22,45 @@
     \author  Alexander Wemmer, alex@wemmer.at
 */
 
-#include "declination_geomag.h"
+#include <QDate>
+
+#include "navcalc.h"
 #include "vas_path.h"
 
 #include "declination.h"
 
 /////////////////////////////////////////////////////////////////////////////
 
+//! returns the given angle normalized to [-180,180]
+static inline double normalizeDeclination(double value)
+{
+    while (value > 180.0) value -= 360.0;
+    while (value < -180.0) value += 360.0;
+    return value;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
 const Declination* Declination::m_global_declination = 0;
 
 /////////////////////////////////////////////////////////////////////////////
 
 Declination::Declination(const QString& declination_datafile) : 
-    m_declination_datafile(declination_datafile) 
+    m_declination_datafile(declination_datafile), m_decimal_year(currentDecimalYear())
 {
     Logger::log(QString("Declination: %1").arg(declination_datafile));
     m_global_declination = this;
+
+    if (!m_model.load(VasPath::prependPath(m_declination_datafile)))
+    {
+        Logger::log("Declination: could not load the model, all declinations will be zero");
+        return;
+    }
+
+    if (m_decimal_year - m_model.epoch() > 5.0)
+        Logger::log(QString("Declination: the model epoch %1 is outdated").arg(m_model.epoch()));
+
+    calcGrid(m_decimal_year);
 };
 
 /////////////////////////////////////////////////////////////////////////////
@@ -49,9 +72,96 @@ Declination::~Declination()
 
 /////////////////////////////////////////////////////////////////////////////
 
-double Declination::declination(const Waypoint& location) const
+double Declination::currentDecimalYear()
+{
+    QDate date = QDate::currentDate();
+    return date.year() + (date.dayOfYear() - 1) / (double)date.daysInYear();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void Declination::calcGrid(double decimal_year)
+{
+    m_grid.resize(DECLINATION_GRID_ROWS * DECLINATION_GRID_COLUMNS);
+    float* value = m_grid.data();
+
+    for(int row = 0; row < DECLINATION_GRID_ROWS; ++row)
+    {
+        double lat = row * DECLINATION_GRID_STEP - DECLINATION_GRID_MAX_LAT;
+
+        for(int column = 0; column < DECLINATION_GRID_COLUMNS; ++column, ++value)
+            *value = m_model.declination(lat, column * DECLINATION_GRID_STEP - 180.0, 0.0, decimal_year);
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+double Declination::declination(double lat, double lon) const
+{
+    if (m_grid.isEmpty()) return 0.0;
+
+    // the declination changes too fast near the magnetic poles for the grid
+    if (lat > DECLINATION_GRID_MAX_LAT || lat < -DECLINATION_GRID_MAX_LAT)
+        return m_model.declination(lat, lon, 0.0, m_decimal_year);
+
+    while (lon < -180.0) lon += 360.0;
+    while (lon > 180.0) lon -= 360.0;
+
+    double row_pos = (lat + DECLINATION_GRID_MAX_LAT) / DECLINATION_GRID_STEP;
+    double column_pos = (lon + 180.0) / DECLINATION_GRID_STEP;
+    int row = qMin((int)row_pos, DECLINATION_GRID_ROWS-2);
+    int column = qMin((int)column_pos, DECLINATION_GRID_COLUMNS-2);
+    double row_frac = row_pos - row;
+    double column_frac = column_pos - column;
+
+    // bilinear interpolation, the corners are taken relative to the
+    // first one to not interpolate across the 180 degree wrap
+
+    const float* cell = m_grid.constData() + row * DECLINATION_GRID_COLUMNS + column;
+    double d00 = cell[0];
+    double d01 = normalizeDeclination(cell[1] - d00);
+    double d10 = normalizeDeclination(cell[DECLINATION_GRID_COLUMNS] - d00);
+    double d11 = normalizeDeclination(cell[DECLINATION_GRID_COLUMNS+1] - d00);
+
+    return normalizeDeclination(
+        d00 + column_frac * d01 + row_frac * d10 + column_frac * row_frac * (d11 - d01 - d10));
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void Declination::declinations(const double* lat, const double* lon, int count, double* declination) const
+{
+    for(int index = 0; index < count; ++index)
+        declination[index] = this->declination(lat[index], lon[index]);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void Declination::declinations(const WaypointPtrList& wpt_list, QVector<double>& declination_list) const
+{
+    QVector<double> lat_list(wpt_list.count());
+    QVector<double> lon_list(wpt_list.count());
+    double* lat = lat_list.data();
+    double* lon = lon_list.data();
+
+    WaypointPtrListIterator iter(wpt_list);
+    while(iter.hasNext())
+    {
+        const Waypoint* wpt = iter.next();
+        MYASSERT(wpt != 0);
+        *lat++ = wpt->lat();
+        *lon++ = wpt->lon();
+    }
+
+    declination_list.resize(wpt_list.count());
+    declinations(lat_list.constData(), lon_list.constData(), wpt_list.count(), declination_list.data());
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+double Declination::exactDeclination(const Waypoint& location) const
 {
-    return getDeclination(location, VasPath::prependPath(m_declination_datafile));
+    return m_model.declination(location.lat(), location.lon(), 0.0, m_decimal_year);
 }
 
 // End of file
@@ -13,28 +13,69 @@
 #ifndef DECLINATION_H
 #define DECLINATION_H
 
+#include <QVector>
+
 #include "logger.h"
 #include "waypoint.h"
+#include "declination_model.h"
+
+/////////////////////////////////////////////////////////////////////////////
+
+//! resolution of the declination grid in degrees
+#define DECLINATION_GRID_STEP 1
+//! the grid covers the latitudes up to this value, the model is evaluated beyond
+#define DECLINATION_GRID_MAX_LAT 80
+#define DECLINATION_GRID_ROWS (2*DECLINATION_GRID_MAX_LAT/DECLINATION_GRID_STEP+1)
+#define DECLINATION_GRID_COLUMNS (360/DECLINATION_GRID_STEP+1)
 
 /////////////////////////////////////////////////////////////////////////////
 
-//! declination calculator
+//! Declination calculator. The magnetic model is read once at startup and
+//! evaluated for the current date on a grid, the queries interpolate the
+//! grid and never touch the file system.
 class Declination 
 {
 public:
 
+    //! Filename shall be specified as a relative path (relative to the vasFMC directory)
     Declination(const QString& declination_datafile);
     virtual ~Declination();
 
-    //! Filename shall be specified as a relative path (relative to the vasFMC directory)
-    double declination(const Waypoint& location) const;
+    //! returns the declination in degrees (east positive) at the given location
+    inline double declination(const Waypoint& location) const { return declination(location.lat(), location.lon()); }
+    double declination(double lat, double lon) const;
+
+    //! Calculates the declinations of all given points, the points are
+    //! given as separate lat/lon arrays in degrees.
+    void declinations(const double* lat, const double* lon, int count, double* declination) const;
+
+    //! calculates the declinations of all waypoints of the given list
+    void declinations(const WaypointPtrList& wpt_list, QVector<double>& declination_list) const;
+
+    //! returns the declination evaluated by the model without the grid
+    double exactDeclination(const Waypoint& location) const;
 
     static const Declination* globalDeclination() { return m_global_declination; }
 
+protected:
+
+    //! returns the current date as decimal year
+    static double currentDecimalYear();
+
+    //! evaluates the model on the grid for the given date
+    void calcGrid(double decimal_year);
+
 protected:
 
     QString m_declination_datafile;
 
+    DeclinationModel m_model;
+    double m_decimal_year;
+
+    //! declination values in degrees, row wise from south to north and
+    //! from 180W to 180E
+    QVector<float> m_grid;
+
     static const Declination* m_global_declination;
 
 private:
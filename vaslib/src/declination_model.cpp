@@ -0,0 +1,290 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2005-2007 Alexander Wemmer
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+///////////////////////////////////////////////////////////////////////////////
+
+/*! \file    declination_model.cpp
+    \author  Alexander Wemmer, alex@wemmer.at
+*/
+
+#include <math.h>
+#include <string.h>
+
+#include <QFile>
+#include <QRegExp>
+#include <QStringList>
+#include <QTextStream>
+
+#include "logger.h"
+#include "navcalc.h"
+
+#include "declination_model.h"
+
+/////////////////////////////////////////////////////////////////////////////
+
+#define SIZE DECLINATION_MODEL_SIZE
+
+// WGS84 ellipsoid and mean earth radius in km
+#define WGS84_A 6378.137
+#define WGS84_B 6356.7523142
+#define EARTH_RADIUS_KM 6371.2
+
+/////////////////////////////////////////////////////////////////////////////
+
+DeclinationModel::DeclinationModel() : m_epoch(0.0), m_max_degree(0)
+{
+    memset(m_c, 0, sizeof(m_c));
+    memset(m_cd, 0, sizeof(m_cd));
+    memset(m_k, 0, sizeof(m_k));
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+bool DeclinationModel::load(const QString& filename)
+{
+    m_epoch = 0.0;
+    m_max_degree = 0;
+    memset(m_c, 0, sizeof(m_c));
+    memset(m_cd, 0, sizeof(m_cd));
+    memset(m_k, 0, sizeof(m_k));
+
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly))
+    {
+        Logger::log(QString("DeclinationModel:load: could not open file (%1)").arg(filename));
+        return false;
+    }
+
+    QTextStream stream(&file);
+
+    // header: epoch, model name, release date
+    QStringList item_list = stream.readLine().split(QRegExp("\\s+"), QString::SkipEmptyParts);
+    bool convok = false;
+    double epoch = item_list.isEmpty() ? 0.0 : item_list[0].toDouble(&convok);
+    if (!convok)
+    {
+        Logger::log(QString("DeclinationModel:load: invalid header (%1)").arg(filename));
+        return false;
+    }
+
+    // coefficient lines: n, m, g, h, g_dot, h_dot - the end is marked by a line of 9s
+
+    int max_degree = 0;
+
+    while(!stream.atEnd())
+    {
+        QString line = stream.readLine().trimmed();
+        if (line.isEmpty()) continue;
+        if (line.startsWith("9999")) break;
+
+        item_list = line.split(QRegExp("\\s+"), QString::SkipEmptyParts);
+        if (item_list.count() < 6)
+        {
+            Logger::log(QString("DeclinationModel:load: invalid line (%1)").arg(line));
+            return false;
+        }
+
+        int n = item_list[0].toInt();
+        int m = item_list[1].toInt();
+        if (n < 1 || n > DECLINATION_MODEL_MAX_DEGREE || m < 0 || m > n) continue;
+
+        m_c[m][n] = item_list[2].toDouble();
+        m_cd[m][n] = item_list[4].toDouble();
+        if (m != 0)
+        {
+            m_c[n][m-1] = item_list[3].toDouble();
+            m_cd[n][m-1] = item_list[5].toDouble();
+        }
+
+        max_degree = qMax(max_degree, n);
+    }
+
+    if (max_degree == 0)
+    {
+        Logger::log(QString("DeclinationModel:load: no coefficients (%1)").arg(filename));
+        return false;
+    }
+
+    // convert the schmidt normalized gauss coefficients to unnormalized ones
+
+    double snorm[SIZE*SIZE];
+    snorm[0] = 1.0;
+
+    for(int n=1; n <= max_degree; ++n)
+    {
+        snorm[n] = snorm[n-1] * (2*n-1) / n;
+        int j = 2;
+
+        for(int m=0; m <= n; ++m)
+        {
+            m_k[m][n] = (double)((n-1)*(n-1) - m*m) / (double)((2*n-1)*(2*n-3));
+
+            if (m > 0)
+            {
+                double flnmj = (double)((n-m+1)*j) / (double)(n+m);
+                snorm[n+m*SIZE] = snorm[n+(m-1)*SIZE] * sqrt(flnmj);
+                j = 1;
+                m_c[n][m-1] *= snorm[n+m*SIZE];
+                m_cd[n][m-1] *= snorm[n+m*SIZE];
+            }
+
+            m_c[m][n] *= snorm[n+m*SIZE];
+            m_cd[m][n] *= snorm[n+m*SIZE];
+        }
+    }
+
+    m_k[1][1] = 0.0;
+
+    m_epoch = epoch;
+    m_max_degree = max_degree;
+
+    Logger::log(QString("DeclinationModel:load: epoch %1, degree %2 (%3)").
+                arg(m_epoch).arg(m_max_degree).arg(filename));
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+double DeclinationModel::declination(double lat, double lon, double altitude_km, double decimal_year) const
+{
+    if (!isValid()) return 0.0;
+
+    const double a2 = WGS84_A*WGS84_A;
+    const double b2 = WGS84_B*WGS84_B;
+    const double c2 = a2-b2;
+    const double a4 = a2*a2;
+    const double c4 = a4-b2*b2;
+
+    double dt = decimal_year - m_epoch;
+
+    double rlat = Navcalc::toRad(lat);
+    double rlon = Navcalc::toRad(lon);
+    double srlat = sin(rlat);
+    double crlat = cos(rlat);
+    double srlat2 = srlat*srlat;
+    double crlat2 = crlat*crlat;
+
+    // convert from geodetic to spherical coordinates
+
+    double q = sqrt(a2-c2*srlat2);
+    double q1 = altitude_km*q;
+    double q2 = ((q1+a2)/(q1+b2))*((q1+a2)/(q1+b2));
+    double ct = srlat/sqrt(q2*crlat2+srlat2);
+    double st = sqrt(1.0-(ct*ct));
+    double r = sqrt((altitude_km*altitude_km) + 2.0*q1 + (a4-c4*srlat2)/(q*q));
+    double d = sqrt(a2*crlat2+b2*srlat2);
+    double ca = (altitude_km+d)/r;
+    double sa = c2*crlat*srlat/(r*d);
+
+    double sp[SIZE];
+    double cp[SIZE];
+    sp[0] = 0.0;
+    cp[0] = 1.0;
+    sp[1] = sin(rlon);
+    cp[1] = cos(rlon);
+
+    for(int m=2; m <= m_max_degree; ++m)
+    {
+        sp[m] = sp[1]*cp[m-1] + cp[1]*sp[m-1];
+        cp[m] = cp[1]*cp[m-1] - sp[1]*sp[m-1];
+    }
+
+    // legendre functions and their derivatives, the entries below the
+    // diagonal stay zero
+
+    double p[SIZE*SIZE];
+    double dp[SIZE][SIZE];
+    double pp[SIZE];
+    memset(p, 0, sizeof(p));
+    memset(dp, 0, sizeof(dp));
+    p[0] = 1.0;
+    pp[0] = 1.0;
+
+    double aor = EARTH_RADIUS_KM/r;
+    double ar = aor*aor;
+    double br = 0.0;
+    double bt = 0.0;
+    double bp = 0.0;
+    double bpp = 0.0;
+
+    for(int n=1; n <= m_max_degree; ++n)
+    {
+        ar *= aor;
+
+        for(int m=0; m <= n; ++m)
+        {
+            if (n == m)
+            {
+                p[n+m*SIZE] = st*p[n-1+(m-1)*SIZE];
+                dp[m][n] = st*dp[m-1][n-1] + ct*p[n-1+(m-1)*SIZE];
+            }
+            else if (n == 1 && m == 0)
+            {
+                p[n] = ct*p[n-1];
+                dp[m][n] = ct*dp[m][n-1] - st*p[n-1];
+            }
+            else
+            {
+                if (m > n-2)
+                {
+                    p[n-2+m*SIZE] = 0.0;
+                    dp[m][n-2] = 0.0;
+                }
+
+                p[n+m*SIZE] = ct*p[n-1+m*SIZE] - m_k[m][n]*p[n-2+m*SIZE];
+                dp[m][n] = ct*dp[m][n-1] - st*p[n-1+m*SIZE] - m_k[m][n]*dp[m][n-2];
+            }
+
+            // time adjust the gauss coefficients
+
+            double g = m_c[m][n] + dt*m_cd[m][n];
+            double h = (m == 0) ? 0.0 : m_c[n][m-1] + dt*m_cd[n][m-1];
+
+            // accumulate the terms of the spherical harmonic expansion
+
+            double par = ar*p[n+m*SIZE];
+            double temp1 = g*cp[m] + h*sp[m];
+            double temp2 = g*sp[m] - h*cp[m];
+
+            bt -= ar*temp1*dp[m][n];
+            bp += m*temp2*par;
+            br += (n+1)*temp1*par;
+
+            // special case at the geographic poles
+
+            if (st == 0.0 && m == 1)
+            {
+                if (n == 1) pp[n] = pp[n-1];
+                else        pp[n] = ct*pp[n-1] - m_k[m][n]*pp[n-2];
+                bpp += m*temp2*ar*pp[n];
+            }
+        }
+    }
+
+    if (st == 0.0) bp = bpp;
+    else           bp /= st;
+
+    // rotate the field vector from spherical to geodetic coordinates
+
+    double bx = -bt*ca - br*sa;
+    double by = bp;
+
+    return Navcalc::toDeg(atan2(by, bx));
+}
+
+// End of file
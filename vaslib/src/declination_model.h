@@ -0,0 +1,84 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2005-2007 Alexander Wemmer
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+///////////////////////////////////////////////////////////////////////////////
+
+/*! \file    declination_model.h
+    \author  Alexander Wemmer, alex@wemmer.at
+*/
+
+#ifndef DECLINATION_MODEL_H
+#define DECLINATION_MODEL_H
+
+#include <QString>
+
+/////////////////////////////////////////////////////////////////////////////
+
+#define DECLINATION_MODEL_MAX_DEGREE 12
+#define DECLINATION_MODEL_SIZE (DECLINATION_MODEL_MAX_DEGREE+1)
+
+/////////////////////////////////////////////////////////////////////////////
+
+//! Spherical harmonic geomagnetic model (WMM coefficient file format).
+//! The coefficients are read once and converted to the unnormalized form,
+//! so a query only evaluates the series. Based on the geomag program of
+//! the NOAA National Geophysical Data Center.
+class DeclinationModel
+{
+public:
+
+    DeclinationModel();
+    virtual ~DeclinationModel() {};
+
+    //! Reads the given coefficient file (e.g. WMM2005.cof), returns true
+    //! on success.
+    bool load(const QString& filename);
+
+    inline bool isValid() const { return m_max_degree > 0; }
+
+    //! returns the epoch of the model as decimal year
+    inline double epoch() const { return m_epoch; }
+
+    //! Returns the declination in degrees (east positive) at the given
+    //! geodetic position in degrees, the altitude in km above the
+    //! ellipsoid and the time as decimal year.
+    double declination(double lat, double lon, double altitude_km, double decimal_year) const;
+
+protected:
+
+    double m_epoch;
+    int m_max_degree;
+
+    //! Gauss coefficients and their secular variation, the g values are
+    //! stored at [m][n], the h values at [n][m-1].
+    double m_c[DECLINATION_MODEL_SIZE][DECLINATION_MODEL_SIZE];
+    double m_cd[DECLINATION_MODEL_SIZE][DECLINATION_MODEL_SIZE];
+
+    //! recursion factors of the legendre functions
+    double m_k[DECLINATION_MODEL_SIZE][DECLINATION_MODEL_SIZE];
+
+private:
+    //! Hidden copy-constructor
+    DeclinationModel(const DeclinationModel&);
+    //! Hidden assignment operator
+    const DeclinationModel& operator = (const DeclinationModel&);
+};
+
+#endif /* DECLINATION_MODEL_H */
+
+// End of file
@@ -0,0 +1,1008 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2005-2007 Alexander Wemmer 
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+///////////////////////////////////////////////////////////////////////////////
+
+/*! \file    flight_recorder.cpp
+    \author  Alexander Wemmer, alex@wemmer.at
+*/
+
+#include <string.h>
+
+#include <QDataStream>
+#include <QtAlgorithms>
+#include <QTime>
+#include <QDate>
+
+#include "assert.h"
+#include "logger.h"
+
+#include "flight_recorder.h"
+
+/////////////////////////////////////////////////////////////////////////////
+
+#define BLOCK_MAGIC "VBLK"
+
+// offsets within the file header
+#define HEADER_VERSION 8
+#define HEADER_BLOCK_SIZE 12
+#define HEADER_BLOCK_COUNT 16
+#define HEADER_CHANNEL_COUNT 20
+
+// offsets within the block header
+#define BLOCK_SEQUENCE 4
+#define BLOCK_USED 8
+#define BLOCK_FRAME_COUNT 12
+#define BLOCK_START_MS 16
+
+// values beyond this would overflow the fixed point representation
+#define MAX_FIXED_POINT_VALUE 9.0e18
+
+/////////////////////////////////////////////////////////////////////////////
+
+static inline void writeUInt32(uchar* data, quint32 value)
+{
+    for(int index = 0; index < 4; ++index) data[index] = (uchar)(value >> (8*index));
+}
+
+static inline quint32 readUInt32(const uchar* data)
+{
+    quint32 value = 0;
+    for(int index = 0; index < 4; ++index) value |= ((quint32)data[index]) << (8*index);
+    return value;
+}
+
+static inline void writeInt64(uchar* data, qint64 value)
+{
+    for(int index = 0; index < 8; ++index) data[index] = (uchar)(((quint64)value) >> (8*index));
+}
+
+static inline qint64 readInt64(const uchar* data)
+{
+    quint64 value = 0;
+    for(int index = 0; index < 8; ++index) value |= ((quint64)data[index]) << (8*index);
+    return (qint64)value;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+static inline void appendVarint(QByteArray& buffer, quint64 value)
+{
+    while(value >= 0x80)
+    {
+        buffer.append((char)((value & 0x7f) | 0x80));
+        value >>= 7;
+    }
+    buffer.append((char)value);
+}
+
+static inline void appendSignedVarint(QByteArray& buffer, qint64 value)
+{
+    // zigzag encoding, small negative values stay small
+    appendVarint(buffer, (((quint64)value) << 1) ^ (quint64)(value >> 63));
+}
+
+//! reads a varint at "position", returns false if the data ends before it
+static inline bool readVarint(const uchar* data, uint size, uint& position, quint64& value)
+{
+    value = 0;
+    for(uint shift = 0; shift < 64; shift += 7)
+    {
+        if (position >= size) return false;
+        uchar byte = data[position++];
+        value |= ((quint64)(byte & 0x7f)) << shift;
+        if ((byte & 0x80) == 0) return true;
+    }
+    return false;
+}
+
+static inline bool readSignedVarint(const uchar* data, uint size, uint& position, qint64& value)
+{
+    quint64 zigzag = 0;
+    if (!readVarint(data, size, position, zigzag)) return false;
+    value = (qint64)(zigzag >> 1) ^ -(qint64)(zigzag & 1);
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+static inline qint64 toFixedPoint(double value, double scale)
+{
+    double scaled = value * scale;
+    if (scaled != scaled || qAbs(scaled) > MAX_FIXED_POINT_VALUE) return 0;
+    return (qint64)(scaled < 0.0 ? scaled - 0.5 : scaled + 0.5);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+FlightRecorderChannels::FlightRecorderChannels()
+{
+    // position and attitude
+
+    addDouble("lat", &FlightStatus::lat, 1.0e8);
+    addDouble("lon", &FlightStatus::lon, 1.0e8);
+    addDouble("tas", &FlightStatus::tas);
+    addSmoothed("smoothed_ias", &FlightStatus::smoothed_ias);
+    addDouble("barber_pole_speed", &FlightStatus::barber_pole_speed);
+    addSmoothed("smoothed_altimeter_readout", &FlightStatus::smoothed_altimeter_readout);
+    addDouble("alt_ft", &FlightStatus::alt_ft);
+    addDouble("ground_alt_ft", &FlightStatus::ground_alt_ft);
+    addSmoothed("smoothed_vs", &FlightStatus::smoothed_vs);
+    addSmoothed("pitch", &FlightStatus::pitch);
+    addSmoothed("bank", &FlightStatus::bank);
+    addSmoothed("true_heading", &FlightStatus::m_true_heading);
+    addSmoothed("magnetic_track", &FlightStatus::m_magnetic_track);
+    addBool("magnetic_track_set", &FlightStatus::m_magnetic_track_set);
+    addBool("fd_active", &FlightStatus::fd_active);
+    addSmoothed("fd_pitch", &FlightStatus::m_fd_pitch);
+    addBool("fd_pitch_input_from_external", &FlightStatus::m_fd_pitch_input_from_external);
+    addSmoothed("fd_bank", &FlightStatus::m_fd_bank);
+    addBool("fd_bank_input_from_external", &FlightStatus::m_fd_bank_input_from_external);
+    addDouble("mach", &FlightStatus::mach, 1.0e6);
+
+    addDouble("velocity_pitch_deg_s", &FlightStatus::velocity_pitch_deg_s);
+    addDouble("velocity_roll_deg_s", &FlightStatus::velocity_roll_deg_s);
+    addDouble("velocity_yaw_deg_s", &FlightStatus::velocity_yaw_deg_s);
+    addDouble("acceleration_pitch_deg_s2", &FlightStatus::acceleration_pitch_deg_s2);
+    addDouble("acceleration_roll_deg_s2", &FlightStatus::acceleration_roll_deg_s2);
+    addDouble("acceleration_yaw_deg_s2", &FlightStatus::acceleration_yaw_deg_s2);
+
+    // environment
+
+    addDouble("magvar", &FlightStatus::magvar);
+    addDouble("wind_speed_kts", &FlightStatus::wind_speed_kts);
+    addDouble("wind_dir_deg_true", &FlightStatus::wind_dir_deg_true);
+    addChannel("fs_utc_time", KIND_UTC_TIME);
+    addChannel("fs_utc_date", KIND_UTC_DATE);
+    addDouble("tat", &FlightStatus::tat);
+    addDouble("sat", &FlightStatus::sat);
+    addDouble("oat", &FlightStatus::oat);
+    addDouble("dew", &FlightStatus::dew);
+    addDouble("qnh", &FlightStatus::qnh);
+    addDouble("delta", &FlightStatus::delta, 1.0e6);
+    addDouble("theta", &FlightStatus::theta, 1.0e6);
+
+    // engines
+
+    addChannel("nr_of_engines", KIND_ENGINE_COUNT);
+    addChannel("engine_type", KIND_ENGINE_TYPE);
+    addBool("engine_ignition_on", &FlightStatus::engine_ignition_on);
+
+    for(uint engine = 1; engine <= FLIGHT_RECORDER_ENGINES; ++engine)
+    {
+        addChannel("engine_smoothed_n1", KIND_ENGINE_SMOOTHED, 1.0e4, engine);
+        addChannel("engine_n2_percent", KIND_ENGINE_DOUBLE, 1.0e4, engine).engine_double_member = &EngineData::n2_percent;
+        addChannel("engine_egt_degrees", KIND_ENGINE_DOUBLE, 1.0e4, engine).engine_double_member = &EngineData::egt_degrees;
+        addChannel("engine_ff_kg_per_hour", KIND_ENGINE_DOUBLE, 1.0e4, engine).engine_double_member = &EngineData::ff_kg_per_hour;
+        addChannel("engine_anti_ice_on", KIND_ENGINE_BOOL, 1.0, engine).engine_bool_member = &EngineData::anti_ice_on;
+        addChannel("engine_throttle_lever_percent", KIND_ENGINE_DOUBLE, 1.0e4, engine).engine_double_member =
+            &EngineData::throttle_lever_percent;
+        addChannel("engine_reverser_percent", KIND_ENGINE_DOUBLE, 1.0e4, engine).engine_double_member =
+            &EngineData::reverser_percent;
+        addChannel("engine_throttle_input_percent", KIND_ENGINE_DOUBLE, 1.0e4, engine).engine_double_member =
+            &EngineData::throttle_input_percent;
+    }
+
+    // controls
+
+    addDouble("rudder_percent", &FlightStatus::rudder_percent);
+    addDouble("aileron_percent", &FlightStatus::aileron_percent);
+    addDouble("elevator_percent", &FlightStatus::elevator_percent);
+    addDouble("elevator_trim_percent", &FlightStatus::elevator_trim_percent);
+    addDouble("elevator_trim_degrees", &FlightStatus::elevator_trim_degrees);
+    addDouble("rudder_input_percent", &FlightStatus::rudder_input_percent);
+    addDouble("aileron_input_percent", &FlightStatus::aileron_input_percent);
+    addDouble("elevator_input_percent", &FlightStatus::elevator_input_percent);
+
+    // misc
+
+    addInt("view_dir_deg", &FlightStatus::view_dir_deg);
+    addBool("paused", &FlightStatus::paused);
+    addBool("onground", &FlightStatus::onground);
+    addBool("slew", &FlightStatus::slew);
+    addBool("stall", &FlightStatus::stall);
+
+    addUInt("speed_vs0_kts", &FlightStatus::speed_vs0_kts);
+    addUInt("speed_vs1_kts", &FlightStatus::speed_vs1_kts);
+    addUInt("speed_vc_kts", &FlightStatus::speed_vc_kts);
+    addUInt("speed_min_drag_kts", &FlightStatus::speed_min_drag_kts);
+    addDouble("aoa_degrees", &FlightStatus::aoa_degrees);
+    addDouble("slip_percent", &FlightStatus::slip_percent);
+
+    addDouble("total_fuel_capacity_kg", &FlightStatus::total_fuel_capacity_kg);
+    addUInt("zero_fuel_weight_kg", &FlightStatus::zero_fuel_weight_kg);
+    addUInt("total_weight_kg", &FlightStatus::total_weight_kg);
+
+    addDouble("brake_left_percent", &FlightStatus::brake_left_percent);
+    addDouble("brake_right_percent", &FlightStatus::brake_right_percent);
+    addBool("parking_brake_set", &FlightStatus::parking_brake_set);
+
+    addBool("spoilers_armed", &FlightStatus::spoilers_armed);
+    addDouble("spoiler_lever_percent", &FlightStatus::spoiler_lever_percent);
+    addDouble("spoiler_left_percent", &FlightStatus::spoiler_left_percent);
+    addDouble("spoiler_right_percent", &FlightStatus::spoiler_right_percent);
+
+    addBool("lights_landing", &FlightStatus::lights_landing);
+    addBool("lights_strobe", &FlightStatus::lights_strobe);
+    addBool("lights_beacon", &FlightStatus::lights_beacon);
+    addBool("lights_taxi", &FlightStatus::lights_taxi);
+    addBool("lights_navigation", &FlightStatus::lights_navigation);
+    addBool("lights_instruments", &FlightStatus::lights_instruments);
+
+    addDouble("gear_nose_position_percent", &FlightStatus::gear_nose_position_percent);
+    addDouble("gear_left_position_percent", &FlightStatus::gear_left_position_percent);
+    addDouble("gear_right_position_percent", &FlightStatus::gear_right_position_percent);
+
+    addUInt("current_flap_lever_notch", &FlightStatus::current_flap_lever_notch);
+    addUInt("flaps_lever_notch_count", &FlightStatus::flaps_lever_notch_count);
+    addDouble("slats_degrees", &FlightStatus::slats_degrees);
+    addDouble("flaps_degrees", &FlightStatus::flaps_degrees);
+    addDouble("flaps_percent_left", &FlightStatus::flaps_percent_left);
+    addDouble("flaps_percent_right", &FlightStatus::flaps_percent_right);
+
+    addBool("battery_on", &FlightStatus::battery_on);
+    addBool("avionics_on", &FlightStatus::avionics_on);
+
+    // autopilot
+
+    addBool("ap_available", &FlightStatus::ap_available);
+    addBool("ap_enabled", &FlightStatus::ap_enabled);
+    addBool("ap_hdg_lock", &FlightStatus::ap_hdg_lock);
+    addBool("ap_alt_lock", &FlightStatus::ap_alt_lock);
+    addBool("ap_vs_lock", &FlightStatus::ap_vs_lock);
+    addBool("ap_speed_lock", &FlightStatus::ap_speed_lock);
+    addBool("ap_mach_lock", &FlightStatus::ap_mach_lock);
+    addBool("ap_nav1_lock", &FlightStatus::ap_nav1_lock);
+    addBool("ap_gs_lock", &FlightStatus::ap_gs_lock);
+    addBool("ap_app_lock", &FlightStatus::ap_app_lock);
+    addBool("ap_app_bc_lock", &FlightStatus::ap_app_bc_lock);
+    addBool("at_toga", &FlightStatus::at_toga);
+    addBool("at_arm", &FlightStatus::at_arm);
+    addBool("gps_enabled", &FlightStatus::gps_enabled);
+
+    addInt("ap_hdg", &FlightStatus::m_ap_hdg);
+    addInt("ap_alt", &FlightStatus::m_ap_alt);
+    addInt("ap_vs", &FlightStatus::m_ap_vs);
+    addInt("ap_spd", &FlightStatus::m_ap_spd);
+    addDouble("ap_mach", &FlightStatus::m_ap_mach, 1.0e6);
+    addDouble("altimeter_pressure_setting_hpa", &FlightStatus::m_altimeter_pressure_setting_hpa);
+
+    // radios
+
+    addWaypoint("nav1", &FlightStatus::nav1);
+    addInt("nav1_freq", &FlightStatus::nav1_freq);
+    addBool("nav1_has_loc", &FlightStatus::nav1_has_loc);
+    addUInt("nav1_loc_mag_heading", &FlightStatus::nav1_loc_mag_heading);
+    addSmoothed("nav1_bearing", &FlightStatus::nav1_bearing);
+    addString("nav1_distance_nm", &FlightStatus::nav1_distance_nm);
+    addInt("obs1", &FlightStatus::obs1);
+    addInt("obs1_to_from", &FlightStatus::obs1_to_from);
+    addInt("obs1_loc_needle", &FlightStatus::obs1_loc_needle);
+    addInt("obs1_gs_needle", &FlightStatus::obs1_gs_needle);
+
+    addWaypoint("nav2", &FlightStatus::nav2);
+    addInt("nav2_freq", &FlightStatus::nav2_freq);
+    addBool("nav2_has_loc", &FlightStatus::nav2_has_loc);
+    addSmoothed("nav2_bearing", &FlightStatus::nav2_bearing);
+    addString("nav2_distance_nm", &FlightStatus::nav2_distance_nm);
+    addInt("obs2", &FlightStatus::obs2);
+    addInt("obs2_to_from", &FlightStatus::obs2_to_from);
+    addInt("obs2_loc_needle", &FlightStatus::obs2_loc_needle);
+    addInt("obs2_gs_needle", &FlightStatus::obs2_gs_needle);
+
+    addNdb("adf1", &FlightStatus::adf1);
+    addSmoothed("adf1_bearing", &FlightStatus::adf1_bearing);
+    addNdb("adf2", &FlightStatus::adf2);
+    addSmoothed("adf2_bearing", &FlightStatus::adf2_bearing);
+
+    addBool("outer_marker", &FlightStatus::outer_marker);
+    addBool("middle_marker", &FlightStatus::middle_marker);
+    addBool("inner_marker", &FlightStatus::inner_marker);
+
+    addDouble("ground_speed_kts", &FlightStatus::ground_speed_kts);
+    addInt("avionics_status", &FlightStatus::avionics_status);
+    addString("aircraft_type", &FlightStatus::aircraft_type);
+
+    // FS control inputs
+
+    addCharList("fsctrl_nd_left_list", &FlightStatus::fsctrl_nd_left_list);
+    addCharList("fsctrl_pfd_left_list", &FlightStatus::fsctrl_pfd_left_list);
+    addCharList("fsctrl_cdu_left_list", &FlightStatus::fsctrl_cdu_left_list);
+    addCharList("fsctrl_cdu_right_list", &FlightStatus::fsctrl_cdu_right_list);
+    addCharList("fsctrl_fmc_list", &FlightStatus::fsctrl_fmc_list);
+    addCharList("fsctrl_ecam_list", &FlightStatus::fsctrl_ecam_list);
+    addCharList("fsctrl_fcu_list", &FlightStatus::fsctrl_fcu_list);
+    addCharList("fsctrl_nd_right_list", &FlightStatus::fsctrl_nd_right_list);
+    addCharList("fsctrl_pfd_right_list", &FlightStatus::fsctrl_pfd_right_list);
+
+    addBool("doors_open", &FlightStatus::doors_open);
+    addBool("pitot_heat_on", &FlightStatus::pitot_heat_on);
+    addInt("pushback_status", &FlightStatus::pushback_status);
+    addBool("no_smoking_sign", &FlightStatus::no_smoking_sign);
+    addBool("seat_belt_sign", &FlightStatus::seat_belt_sign);
+
+    addChannel("tcas", KIND_TCAS);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+FlightRecorderChannels::Channel& FlightRecorderChannels::addChannel(const char* name, Kind kind, double scale, uint engine)
+{
+    Channel channel;
+    channel.name = name;
+    channel.kind = kind;
+    channel.scale = scale;
+    channel.engine = engine;
+    channel.double_member = 0;
+    channel.int_member = 0;
+    channel.uint_member = 0;
+    channel.bool_member = 0;
+    channel.smoothed_member = 0;
+    channel.string_member = 0;
+    channel.waypoint_member = 0;
+    channel.ndb_member = 0;
+    channel.char_list_member = 0;
+    channel.engine_double_member = 0;
+    channel.engine_bool_member = 0;
+    m_channel_list.append(channel);
+    return m_channel_list.last();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+qint64 FlightRecorderChannels::numericValue(const FlightStatus& flightstatus, int index) const
+{
+    const Channel& channel = m_channel_list[index];
+
+    // the const operator[] of the map would return a copy of the engine data
+    const EngineData* engine_data = 0;
+    if (channel.engine > 0)
+    {
+        QMap<uint, EngineData>::const_iterator iter = flightstatus.engine_data.find(channel.engine);
+        if (iter == flightstatus.engine_data.end()) return 0;
+        engine_data = &iter.value();
+    }
+
+    switch(channel.kind)
+    {
+        case(KIND_DOUBLE):
+            return toFixedPoint(flightstatus.*channel.double_member, channel.scale);
+        case(KIND_INT):
+            return flightstatus.*channel.int_member;
+        case(KIND_UINT):
+            return flightstatus.*channel.uint_member;
+        case(KIND_BOOL):
+            return (flightstatus.*channel.bool_member) ? 1 : 0;
+        case(KIND_SMOOTHED):
+            return toFixedPoint((flightstatus.*channel.smoothed_member).lastValue(), channel.scale);
+        case(KIND_ENGINE_COUNT):
+            return flightstatus.nr_of_engines;
+        case(KIND_ENGINE_TYPE):
+            return flightstatus.engine_type;
+        case(KIND_UTC_TIME):
+            return flightstatus.fs_utc_time.isValid() ? QTime(0, 0).msecsTo(flightstatus.fs_utc_time) : -1;
+        case(KIND_UTC_DATE):
+            return flightstatus.fs_utc_date.isValid() ? flightstatus.fs_utc_date.toJulianDay() : 0;
+        case(KIND_ENGINE_DOUBLE):
+            return toFixedPoint(engine_data->*channel.engine_double_member, channel.scale);
+        case(KIND_ENGINE_BOOL):
+            return (engine_data->*channel.engine_bool_member) ? 1 : 0;
+        case(KIND_ENGINE_SMOOTHED):
+            return toFixedPoint(engine_data->smoothed_n1.lastValue(), channel.scale);
+        default:
+            break;
+    }
+
+    MYASSERT(false);
+    return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void FlightRecorderChannels::setNumericValue(FlightStatus& flightstatus, int index, qint64 value) const
+{
+    const Channel& channel = m_channel_list[index];
+
+    switch(channel.kind)
+    {
+        case(KIND_DOUBLE): {
+            flightstatus.*channel.double_member = value / channel.scale;
+            break;
+        }
+        case(KIND_INT): {
+            flightstatus.*channel.int_member = (int)value;
+            break;
+        }
+        case(KIND_UINT): {
+            flightstatus.*channel.uint_member = (uint)value;
+            break;
+        }
+        case(KIND_BOOL): {
+            flightstatus.*channel.bool_member = (value != 0);
+            break;
+        }
+        case(KIND_SMOOTHED): {
+            flightstatus.*channel.smoothed_member = value / channel.scale;
+            break;
+        }
+        case(KIND_ENGINE_COUNT): {
+            flightstatus.nr_of_engines = (unsigned char)qMin(value, (qint64)FLIGHT_RECORDER_ENGINES);
+            break;
+        }
+        case(KIND_ENGINE_TYPE): {
+            flightstatus.engine_type = (FlightStatus::ENGINE_TYPE)value;
+            break;
+        }
+        case(KIND_UTC_TIME): {
+            flightstatus.fs_utc_time = (value < 0) ? QTime() : QTime(0, 0).addMSecs((int)value);
+            break;
+        }
+        case(KIND_UTC_DATE): {
+            flightstatus.fs_utc_date = (value == 0) ? QDate() : QDate::fromJulianDay((int)value);
+            break;
+        }
+        case(KIND_ENGINE_DOUBLE): {
+            flightstatus.engine_data[channel.engine].*channel.engine_double_member = value / channel.scale;
+            break;
+        }
+        case(KIND_ENGINE_BOOL): {
+            flightstatus.engine_data[channel.engine].*channel.engine_bool_member = (value != 0);
+            break;
+        }
+        case(KIND_ENGINE_SMOOTHED): {
+            flightstatus.engine_data[channel.engine].smoothed_n1 = value / channel.scale;
+            break;
+        }
+        default: {
+            MYASSERT(false);
+            break;
+        }
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+QByteArray FlightRecorderChannels::byteValue(const FlightStatus& flightstatus, int index) const
+{
+    const Channel& channel = m_channel_list[index];
+
+    QByteArray value;
+
+    switch(channel.kind)
+    {
+        case(KIND_STRING): {
+            value = (flightstatus.*channel.string_member).toUtf8();
+            break;
+        }
+        case(KIND_WAYPOINT): {
+            QDataStream stream(&value, QIODevice::WriteOnly);
+            (flightstatus.*channel.waypoint_member) >> stream;
+            break;
+        }
+        case(KIND_NDB): {
+            QDataStream stream(&value, QIODevice::WriteOnly);
+            (flightstatus.*channel.ndb_member) >> stream;
+            break;
+        }
+        case(KIND_CHAR_LIST): {
+            const QList<char>& char_list = flightstatus.*channel.char_list_member;
+            value.reserve(char_list.count());
+            for(int char_index = 0; char_index < char_list.count(); ++char_index) value.append(char_list[char_index]);
+            break;
+        }
+        case(KIND_TCAS): {
+            const TcasEntryValueList& entry_list = flightstatus.tcasEntryList();
+            if (entry_list.isEmpty()) break;
+
+            QDataStream stream(&value, QIODevice::WriteOnly);
+            stream << (qint32)entry_list.count();
+
+            TcasEntryValueListIterator iter(entry_list);
+            while(iter.hasNext())
+            {
+                const TcasEntry& entry = iter.next();
+                stream << entry.m_valid << (qint32)entry.m_id;
+                entry.m_position >> stream;
+                stream << (qint32)entry.m_altitude_ft << (qint32)entry.m_true_heading
+                       << (qint32)entry.m_groundspeed_kts << (qint32)entry.m_vs_fpm;
+            }
+            break;
+        }
+        default: {
+            MYASSERT(false);
+            break;
+        }
+    }
+
+    return value;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void FlightRecorderChannels::setByteValue(FlightStatus& flightstatus, int index, const QByteArray& value) const
+{
+    const Channel& channel = m_channel_list[index];
+
+    switch(channel.kind)
+    {
+        case(KIND_STRING): {
+            flightstatus.*channel.string_member = QString::fromUtf8(value.constData(), value.size());
+            break;
+        }
+        case(KIND_WAYPOINT): {
+            Waypoint waypoint;
+            if (!value.isEmpty())
+            {
+                QDataStream stream(value);
+                waypoint << stream;
+            }
+            flightstatus.*channel.waypoint_member = waypoint;
+            break;
+        }
+        case(KIND_NDB): {
+            Ndb ndb;
+            if (!value.isEmpty())
+            {
+                QDataStream stream(value);
+                ndb << stream;
+            }
+            flightstatus.*channel.ndb_member = ndb;
+            break;
+        }
+        case(KIND_CHAR_LIST): {
+            QList<char>& char_list = flightstatus.*channel.char_list_member;
+            char_list.clear();
+            for(int char_index = 0; char_index < value.size(); ++char_index) char_list.append(value[char_index]);
+            break;
+        }
+        case(KIND_TCAS): {
+            flightstatus.clearTcasEntryList();
+            if (value.isEmpty()) break;
+
+            QDataStream stream(value);
+            qint32 count = 0;
+            stream >> count;
+
+            for(qint32 entry_index = 0; entry_index < count && stream.status() == QDataStream::Ok; ++entry_index)
+            {
+                TcasEntry entry;
+                qint32 id, altitude_ft, true_heading, groundspeed_kts, vs_fpm;
+                stream >> entry.m_valid >> id;
+                entry.m_position << stream;
+                stream >> altitude_ft >> true_heading >> groundspeed_kts >> vs_fpm;
+                if (stream.status() != QDataStream::Ok) break;
+
+                entry.m_id = id;
+                entry.m_altitude_ft = altitude_ft;
+                entry.m_true_heading = true_heading;
+                entry.m_groundspeed_kts = groundspeed_kts;
+                entry.m_vs_fpm = vs_fpm;
+                flightstatus.addTcasEntry(entry);
+            }
+            break;
+        }
+        default: {
+            MYASSERT(false);
+            break;
+        }
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+FlightRecorder::FlightRecorder() :
+    m_map(0), m_block_count(0), m_block_sequence(0), m_block(0), m_block_used(0), m_block_frame_count(0),
+    m_last_time_ms(0), m_recorded_once(false), m_recorded_update_count(0), m_frame_count(0)
+{
+    m_last_numeric_values.resize(m_channels.count());
+    m_last_byte_values.resize(m_channels.count());
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+FlightRecorder::~FlightRecorder()
+{
+    close();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+bool FlightRecorder::open(const QString& filename, uint size_mb)
+{
+    close();
+
+    m_block_count = (uint)((((qint64)size_mb) * 1024 * 1024) / FLIGHT_RECORDER_BLOCK_SIZE);
+    if (m_block_count < 2)
+    {
+        Logger::log(QString("FlightRecorder:open: size too small (%1 MB)").arg(size_mb));
+        return false;
+    }
+
+    m_file.setFileName(filename);
+    if (!m_file.open(QIODevice::ReadWrite | QIODevice::Truncate))
+    {
+        Logger::log(QString("FlightRecorder:open: could not open file (%1)").arg(filename));
+        return false;
+    }
+
+    qint64 file_size = FLIGHT_RECORDER_HEADER_SIZE + ((qint64)m_block_count) * FLIGHT_RECORDER_BLOCK_SIZE;
+    if (!m_file.resize(file_size) || (m_map = m_file.map(0, file_size)) == 0)
+    {
+        Logger::log(QString("FlightRecorder:open: could not map file (%1)").arg(filename));
+        m_file.close();
+        return false;
+    }
+
+    // a fresh file is zero filled, so all blocks are unused (sequence 0)
+    memset(m_map, 0, FLIGHT_RECORDER_HEADER_SIZE);
+    memcpy(m_map, FLIGHT_RECORDER_MAGIC, 8);
+    writeUInt32(m_map + HEADER_VERSION, FLIGHT_RECORDER_VERSION);
+    writeUInt32(m_map + HEADER_BLOCK_SIZE, FLIGHT_RECORDER_BLOCK_SIZE);
+    writeUInt32(m_map + HEADER_BLOCK_COUNT, m_block_count);
+    writeUInt32(m_map + HEADER_CHANNEL_COUNT, m_channels.count());
+
+    Logger::log(QString("FlightRecorder:open: recording to %1 (%2 blocks)").arg(filename).arg(m_block_count));
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void FlightRecorder::close()
+{
+    if (m_map != 0) m_file.unmap(m_map);
+    m_map = 0;
+    m_file.close();
+
+    m_block_count = 0;
+    m_block_sequence = 0;
+    m_block = 0;
+    m_recorded_once = false;
+    m_frame_count = 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void FlightRecorder::startBlock(qint64 time_ms)
+{
+    m_block = m_map + FLIGHT_RECORDER_HEADER_SIZE +
+              (m_block_sequence % m_block_count) * FLIGHT_RECORDER_BLOCK_SIZE;
+    ++m_block_sequence;
+
+    // the block is marked unused while it is rewritten
+    writeUInt32(m_block + BLOCK_SEQUENCE, 0);
+    memcpy(m_block, BLOCK_MAGIC, 4);
+    writeUInt32(m_block + BLOCK_USED, FLIGHT_RECORDER_BLOCK_HEADER_SIZE);
+    writeUInt32(m_block + BLOCK_FRAME_COUNT, 0);
+    writeInt64(m_block + BLOCK_START_MS, time_ms);
+    writeUInt32(m_block + BLOCK_SEQUENCE, m_block_sequence);
+
+    m_block_used = FLIGHT_RECORDER_BLOCK_HEADER_SIZE;
+    m_block_frame_count = 0;
+    m_last_time_ms = time_ms;
+
+    // the first frame of a block is relative to zero values
+    for(int index = 0; index < m_channels.count(); ++index)
+    {
+        m_last_numeric_values[index] = 0;
+        m_last_byte_values[index] = QByteArray();
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void FlightRecorder::encodeFrame(const FlightStatus& flightstatus, qint64 time_ms)
+{
+    m_change_buffer.resize(0);
+
+    int change_count = 0;
+    int last_changed_index = -1;
+
+    for(int index = 0; index < m_channels.count(); ++index)
+    {
+        if (m_channels.isNumeric(index))
+        {
+            qint64 value = m_channels.numericValue(flightstatus, index);
+            if (value == m_last_numeric_values[index]) continue;
+
+            appendVarint(m_change_buffer, index - last_changed_index - 1);
+            appendSignedVarint(m_change_buffer, value - m_last_numeric_values[index]);
+            m_last_numeric_values[index] = value;
+        }
+        else
+        {
+            QByteArray value = m_channels.byteValue(flightstatus, index);
+            if (value == m_last_byte_values[index]) continue;
+
+            appendVarint(m_change_buffer, index - last_changed_index - 1);
+            appendVarint(m_change_buffer, value.size());
+            m_change_buffer.append(value);
+            m_last_byte_values[index] = value;
+        }
+
+        last_changed_index = index;
+        ++change_count;
+    }
+
+    m_frame_buffer.resize(0);
+    appendSignedVarint(m_frame_buffer, time_ms - m_last_time_ms);
+    appendVarint(m_frame_buffer, change_count);
+    m_frame_buffer.append(m_change_buffer);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+bool FlightRecorder::record(const FlightStatus& flightstatus, qint64 time_ms)
+{
+    if (!isOpen() || !flightstatus.isValid()) return false;
+    if (m_recorded_once && flightstatus.updateCount() == m_recorded_update_count) return false;
+
+    m_recorded_once = true;
+    m_recorded_update_count = flightstatus.updateCount();
+
+    if (m_block == 0) startBlock(time_ms);
+
+    // the last values are changed by the encoding, so a frame not fitting
+    // into the current block is encoded again as full frame of a new block
+    encodeFrame(flightstatus, time_ms);
+
+    if (m_block_used + m_frame_buffer.size() > FLIGHT_RECORDER_BLOCK_SIZE)
+    {
+        startBlock(time_ms);
+        encodeFrame(flightstatus, time_ms);
+
+        if (m_block_used + m_frame_buffer.size() > FLIGHT_RECORDER_BLOCK_SIZE)
+        {
+            Logger::log(QString("FlightRecorder:record: frame too large (%1 bytes)").arg(m_frame_buffer.size()));
+            m_block = 0;
+            return false;
+        }
+    }
+
+    memcpy(m_block + m_block_used, m_frame_buffer.constData(), m_frame_buffer.size());
+    m_block_used += m_frame_buffer.size();
+    ++m_block_frame_count;
+    m_last_time_ms = time_ms;
+
+    // the frame counts once the used bytes include it
+    writeUInt32(m_block + BLOCK_FRAME_COUNT, m_block_frame_count);
+    writeUInt32(m_block + BLOCK_USED, m_block_used);
+
+    ++m_frame_count;
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+FlightRecording::FlightRecording() :
+    m_map(0), m_block_index(-1), m_block(0), m_block_used(0), m_block_position(0), m_last_time_ms(0)
+{
+    m_numeric_values.resize(m_channels.count());
+    m_byte_values.resize(m_channels.count());
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+FlightRecording::~FlightRecording()
+{
+    close();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+static bool blockSequenceLessThan(const uchar* block1, const uchar* block2)
+{
+    return readUInt32(block1 + BLOCK_SEQUENCE) < readUInt32(block2 + BLOCK_SEQUENCE);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+bool FlightRecording::open(const QString& filename)
+{
+    close();
+
+    m_file.setFileName(filename);
+    if (!m_file.open(QIODevice::ReadOnly))
+    {
+        Logger::log(QString("FlightRecording:open: could not open file (%1)").arg(filename));
+        return false;
+    }
+
+    qint64 file_size = m_file.size();
+    uchar* map = (file_size >= FLIGHT_RECORDER_HEADER_SIZE) ? m_file.map(0, file_size) : 0;
+    if (map == 0)
+    {
+        Logger::log(QString("FlightRecording:open: could not map file (%1)").arg(filename));
+        m_file.close();
+        return false;
+    }
+    m_map = map;
+
+    quint32 block_count = readUInt32(m_map + HEADER_BLOCK_COUNT);
+
+    if (memcmp(m_map, FLIGHT_RECORDER_MAGIC, 8) != 0 ||
+        readUInt32(m_map + HEADER_VERSION) != FLIGHT_RECORDER_VERSION ||
+        readUInt32(m_map + HEADER_BLOCK_SIZE) != FLIGHT_RECORDER_BLOCK_SIZE ||
+        readUInt32(m_map + HEADER_CHANNEL_COUNT) != (quint32)m_channels.count() ||
+        file_size < FLIGHT_RECORDER_HEADER_SIZE + ((qint64)block_count) * FLIGHT_RECORDER_BLOCK_SIZE)
+    {
+        Logger::log(QString("FlightRecording:open: invalid or incompatible file (%1)").arg(filename));
+        close();
+        return false;
+    }
+
+    for(quint32 index = 0; index < block_count; ++index)
+    {
+        const uchar* block = m_map + FLIGHT_RECORDER_HEADER_SIZE + index * FLIGHT_RECORDER_BLOCK_SIZE;
+        quint32 used = readUInt32(block + BLOCK_USED);
+
+        if (memcmp(block, BLOCK_MAGIC, 4) != 0 || readUInt32(block + BLOCK_SEQUENCE) == 0 ||
+            used <= FLIGHT_RECORDER_BLOCK_HEADER_SIZE || used > FLIGHT_RECORDER_BLOCK_SIZE) continue;
+
+        m_block_list.append(block);
+    }
+
+    qSort(m_block_list.begin(), m_block_list.end(), blockSequenceLessThan);
+
+    Logger::log(QString("FlightRecording:open: %1 blocks (%2)").arg(m_block_list.count()).arg(filename));
+    rewind();
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void FlightRecording::close()
+{
+    if (m_map != 0) m_file.unmap((uchar*)m_map);
+    m_map = 0;
+    m_file.close();
+    m_block_list.clear();
+    rewind();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void FlightRecording::rewind()
+{
+    m_block_index = -1;
+    m_block = 0;
+    m_block_used = 0;
+    m_block_position = 0;
+    m_last_time_ms = 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+bool FlightRecording::ensureFrame()
+{
+    while(m_block == 0 || m_block_position >= m_block_used)
+    {
+        if (m_block_index + 1 >= m_block_list.count()) return false;
+
+        m_block = m_block_list[++m_block_index];
+        m_block_used = readUInt32(m_block + BLOCK_USED);
+        m_block_position = FLIGHT_RECORDER_BLOCK_HEADER_SIZE;
+        m_last_time_ms = readInt64(m_block + BLOCK_START_MS);
+
+        for(int index = 0; index < m_channels.count(); ++index)
+        {
+            m_numeric_values[index] = 0;
+            m_byte_values[index] = QByteArray();
+        }
+    }
+
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+bool FlightRecording::peekFrameTime(qint64& time_ms)
+{
+    while(ensureFrame())
+    {
+        uint position = m_block_position;
+        qint64 dt_ms = 0;
+        if (readSignedVarint(m_block, m_block_used, position, dt_ms))
+        {
+            time_ms = m_last_time_ms + dt_ms;
+            return true;
+        }
+
+        Logger::log("FlightRecording:peekFrameTime: corrupt frame, skipping block");
+        m_block_position = m_block_used;
+    }
+
+    return false;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+bool FlightRecording::readFrame(FlightStatus& flightstatus, qint64& time_ms)
+{
+    while(ensureFrame())
+    {
+        bool is_keyframe = (m_block_position == FLIGHT_RECORDER_BLOCK_HEADER_SIZE);
+        uint position = m_block_position;
+        qint64 dt_ms = 0;
+        quint64 change_count = 0;
+        bool ok = readSignedVarint(m_block, m_block_used, position, dt_ms) &&
+                  readVarint(m_block, m_block_used, position, change_count);
+
+        int index = -1;
+
+        for(quint64 change = 0; ok && change < change_count; ++change)
+        {
+            quint64 gap = 0;
+            ok = readVarint(m_block, m_block_used, position, gap) && gap < (quint64)m_channels.count();
+            index += (int)gap + 1;
+            if (!ok || index >= m_channels.count()) { ok = false; break; }
+
+            if (m_channels.isNumeric(index))
+            {
+                qint64 delta = 0;
+                ok = readSignedVarint(m_block, m_block_used, position, delta);
+                m_numeric_values[index] += delta;
+                if (ok && !is_keyframe && !m_channels.isSmoothed(index))
+                    m_channels.setNumericValue(flightstatus, index, m_numeric_values[index]);
+            }
+            else
+            {
+                quint64 size = 0;
+                ok = readVarint(m_block, m_block_used, position, size) && size <= m_block_used - position;
+                if (!ok) break;
+
+                m_byte_values[index] = QByteArray((const char*)m_block + position, (int)size);
+                position += (uint)size;
+                if (!is_keyframe) m_channels.setByteValue(flightstatus, index, m_byte_values[index]);
+            }
+        }
+
+        if (!ok)
+        {
+            Logger::log("FlightRecording:readFrame: corrupt frame, skipping block");
+            m_block_position = m_block_used;
+            continue;
+        }
+
+        m_block_position = position;
+        m_last_time_ms += dt_ms;
+        time_ms = m_last_time_ms;
+
+        // A full frame sets all values, channels at zero are not contained.
+        // Smoothed values are set with every frame to feed their smoothing.
+        for(int channel_index = 0; channel_index < m_channels.count(); ++channel_index)
+        {
+            if (m_channels.isNumeric(channel_index))
+            {
+                if (is_keyframe || m_channels.isSmoothed(channel_index))
+                    m_channels.setNumericValue(flightstatus, channel_index, m_numeric_values[channel_index]);
+            }
+            else if (is_keyframe)
+            {
+                m_channels.setByteValue(flightstatus, channel_index, m_byte_values[channel_index]);
+            }
+        }
+
+        return true;
+    }
+
+    return false;
+}
+
+// End of file
@@ -0,0 +1,269 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2005-2007 Alexander Wemmer 
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+///////////////////////////////////////////////////////////////////////////////
+
+/*! \file    flight_recorder.h
+    \author  Alexander Wemmer, alex@wemmer.at
+*/
+
+#ifndef FLIGHT_RECORDER_H
+#define FLIGHT_RECORDER_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QList>
+#include <QString>
+#include <QVector>
+
+#include "flightstatus.h"
+
+/////////////////////////////////////////////////////////////////////////////
+
+#define FLIGHT_RECORDER_MAGIC "VASFREC1"
+#define FLIGHT_RECORDER_VERSION 1
+#define FLIGHT_RECORDER_HEADER_SIZE 32
+#define FLIGHT_RECORDER_BLOCK_SIZE 65536
+#define FLIGHT_RECORDER_BLOCK_HEADER_SIZE 24
+#define FLIGHT_RECORDER_ENGINES 4
+
+/////////////////////////////////////////////////////////////////////////////
+
+//! The recorded values of the flightstatus. Numeric values are stored as
+//! fixed point integers, all others as byte arrays (strings, waypoints,
+//! TCAS entries, FS control inputs). Values derived by
+//! FlightStatus::recalc() are not recorded.
+class FlightRecorderChannels
+{
+public:
+
+    enum Kind { KIND_DOUBLE = 0,
+                KIND_INT,
+                KIND_UINT,
+                KIND_BOOL,
+                KIND_SMOOTHED,
+                KIND_ENGINE_COUNT,
+                KIND_ENGINE_TYPE,
+                KIND_UTC_TIME,
+                KIND_UTC_DATE,
+                KIND_ENGINE_DOUBLE,
+                KIND_ENGINE_BOOL,
+                KIND_ENGINE_SMOOTHED,
+                KIND_STRING,
+                KIND_WAYPOINT,
+                KIND_NDB,
+                KIND_CHAR_LIST,
+                KIND_TCAS
+    };
+
+    struct Channel
+    {
+        const char* name;
+        Kind kind;
+        //! fixed point factor of numeric values
+        double scale;
+        //! engine index for the engine kinds
+        uint engine;
+
+        double FlightStatus::* double_member;
+        int FlightStatus::* int_member;
+        uint FlightStatus::* uint_member;
+        bool FlightStatus::* bool_member;
+        SmoothedValueWithDelay<double> FlightStatus::* smoothed_member;
+        QString FlightStatus::* string_member;
+        Waypoint FlightStatus::* waypoint_member;
+        Ndb FlightStatus::* ndb_member;
+        QList<char> FlightStatus::* char_list_member;
+        double EngineData::* engine_double_member;
+        bool EngineData::* engine_bool_member;
+    };
+
+    FlightRecorderChannels();
+    virtual ~FlightRecorderChannels() {};
+
+    inline int count() const { return m_channel_list.count(); }
+    inline const Channel& channel(int index) const { return m_channel_list[index]; }
+
+    inline bool isNumeric(int index) const { return m_channel_list[index].kind < KIND_STRING; }
+    //! returns true if the value has to be set with every frame
+    inline bool isSmoothed(int index) const 
+    { 
+        return m_channel_list[index].kind == KIND_SMOOTHED || m_channel_list[index].kind == KIND_ENGINE_SMOOTHED;
+    }
+
+    qint64 numericValue(const FlightStatus& flightstatus, int index) const;
+    void setNumericValue(FlightStatus& flightstatus, int index, qint64 value) const;
+
+    QByteArray byteValue(const FlightStatus& flightstatus, int index) const;
+    void setByteValue(FlightStatus& flightstatus, int index, const QByteArray& value) const;
+
+protected:
+
+    Channel& addChannel(const char* name, Kind kind, double scale = 1.0, uint engine = 0);
+
+    void addDouble(const char* name, double FlightStatus::* member, double scale = 1.0e4)
+    { addChannel(name, KIND_DOUBLE, scale).double_member = member; }
+    void addInt(const char* name, int FlightStatus::* member)
+    { addChannel(name, KIND_INT).int_member = member; }
+    void addUInt(const char* name, uint FlightStatus::* member)
+    { addChannel(name, KIND_UINT).uint_member = member; }
+    void addBool(const char* name, bool FlightStatus::* member)
+    { addChannel(name, KIND_BOOL).bool_member = member; }
+    void addSmoothed(const char* name, SmoothedValueWithDelay<double> FlightStatus::* member, double scale = 1.0e4)
+    { addChannel(name, KIND_SMOOTHED, scale).smoothed_member = member; }
+    void addString(const char* name, QString FlightStatus::* member)
+    { addChannel(name, KIND_STRING).string_member = member; }
+    void addWaypoint(const char* name, Waypoint FlightStatus::* member)
+    { addChannel(name, KIND_WAYPOINT).waypoint_member = member; }
+    void addNdb(const char* name, Ndb FlightStatus::* member)
+    { addChannel(name, KIND_NDB).ndb_member = member; }
+    void addCharList(const char* name, QList<char> FlightStatus::* member)
+    { addChannel(name, KIND_CHAR_LIST).char_list_member = member; }
+
+protected:
+
+    QVector<Channel> m_channel_list;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+
+//! Records the flightstatus updates to a memory mapped ring file. The file
+//! consists of fixed size blocks, every block starts with a full frame
+//! followed by frames holding only the changed values (delta and varint
+//! encoded). When the file is full, the oldest block is overwritten.
+class FlightRecorder
+{
+public:
+
+    FlightRecorder();
+    virtual ~FlightRecorder();
+
+    //! Creates the given file with the given size (rounded down to whole
+    //! blocks), an existing file is overwritten. Returns true on success.
+    bool open(const QString& filename, uint size_mb);
+    void close();
+
+    inline bool isOpen() const { return m_map != 0; }
+
+    //! Records the given flightstatus with the given time stamp if it was
+    //! updated since the last call (see FlightStatus::updateCount()).
+    //! Returns true if a frame was recorded.
+    bool record(const FlightStatus& flightstatus, qint64 time_ms);
+
+    //! returns the number of recorded frames
+    inline uint frameCount() const { return m_frame_count; }
+
+protected:
+
+    //! starts the next block of the ring, the next frame will be a full one
+    void startBlock(qint64 time_ms);
+
+    //! encodes the frame into m_frame_buffer relative to the last values
+    void encodeFrame(const FlightStatus& flightstatus, qint64 time_ms);
+
+protected:
+
+    FlightRecorderChannels m_channels;
+
+    QFile m_file;
+    uchar* m_map;
+    uint m_block_count;
+
+    uint m_block_sequence;
+    uchar* m_block;
+    uint m_block_used;
+    uint m_block_frame_count;
+    qint64 m_last_time_ms;
+
+    QVector<qint64> m_last_numeric_values;
+    QVector<QByteArray> m_last_byte_values;
+    QByteArray m_change_buffer;
+    QByteArray m_frame_buffer;
+
+    bool m_recorded_once;
+    uint m_recorded_update_count;
+    uint m_frame_count;
+
+private:
+    //! Hidden copy-constructor
+    FlightRecorder(const FlightRecorder&);
+    //! Hidden assignment operator
+    const FlightRecorder& operator = (const FlightRecorder&);
+};
+
+/////////////////////////////////////////////////////////////////////////////
+
+//! Reads the frames of a file written by the FlightRecorder, oldest first.
+class FlightRecording
+{
+public:
+
+    FlightRecording();
+    virtual ~FlightRecording();
+
+    //! opens the given file, returns true on success
+    bool open(const QString& filename);
+    void close();
+
+    inline bool isOpen() const { return m_map != 0; }
+
+    //! restarts at the oldest frame
+    void rewind();
+
+    //! Returns the time stamp of the next frame without reading it, returns
+    //! false at the end of the recording.
+    bool peekFrameTime(qint64& time_ms);
+
+    //! Sets the values of the next frame to the given flightstatus, returns
+    //! false at the end of the recording.
+    bool readFrame(FlightStatus& flightstatus, qint64& time_ms);
+
+protected:
+
+    //! moves to the next block with frames left, returns false at the end
+    bool ensureFrame();
+
+protected:
+
+    FlightRecorderChannels m_channels;
+
+    QFile m_file;
+    const uchar* m_map;
+
+    //! the used blocks ordered by their sequence
+    QList<const uchar*> m_block_list;
+
+    int m_block_index;
+    const uchar* m_block;
+    uint m_block_used;
+    uint m_block_position;
+    qint64 m_last_time_ms;
+
+    QVector<qint64> m_numeric_values;
+    QVector<QByteArray> m_byte_values;
+
+private:
+    //! Hidden copy-constructor
+    FlightRecording(const FlightRecording&);
+    //! Hidden assignment operator
+    const FlightRecording& operator = (const FlightRecording&);
+};
+
+#endif /* FLIGHT_RECORDER_H */
+
+// End of file
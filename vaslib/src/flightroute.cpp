@@ -1396,132 +1396,43 @@ bool FlightRoute::setWaypointOverflyRestriction(uint index, bool is_overfly)
 bool FlightRoute::extractICAORoute(const QString& route, const Navdata& navdata, 
                                    const QRegExp& lat_lon_wpt_regexp, QString& error)
 {
-    clear();
-    error = QString::null;
-
-    if (route.isEmpty()) 
+    NavdataResolvedRoute resolved_route;
+    if (!navdata.resolveICAORoute(route, lat_lon_wpt_regexp, resolved_route))
     {
-        error = "Route is empty";
+        clear();
+        error = resolved_route.error_text;
         return false;
     }
-    
-    // decode route
-    
-    QStringList route_item_list = route.toUpper().trimmed().split(" ", QString::SkipEmptyParts);
 
-    if (route_item_list.count() >= 2 && route_item_list[0] == route_item_list[1]) route_item_list.removeFirst();
-    if (route_item_list.count() >= 2 && 
-        route_item_list[route_item_list.count()-2] == route_item_list[route_item_list.count()-1]) 
-        route_item_list.removeLast();
+    setICAORoute(resolved_route);
+    error = QString::null;
+    return true;
+}
 
-    if (route_item_list.count() < 2)
-    {
-        error = "Could not parse route";
-        return false;
-    }
-   
-    // set departure airport
-            
-    WaypointPtrList result_list;
-    navdata.getAirports(route_item_list[0].trimmed(), result_list);
-    if (result_list.count() == 1)
+/////////////////////////////////////////////////////////////////////////////
+
+void FlightRoute::setICAORoute(const NavdataResolvedRoute& resolved_route)
+{
+    clear();
+
+    if (resolved_route.departure_airport != 0)
     {
-        insertWaypoint(*result_list.at(0), 0);
+        insertWaypoint(*resolved_route.departure_airport, 0);
         setAsDepartureAirport(0, QString::null);
         MYASSERT(departureAirport() != 0);
-        route_item_list.removeFirst();
-    }
-    
-    // set arrival airport
-    
-    Airport *destination_airport = 0;
-
-    result_list.clear();
-    navdata.getAirports(route_item_list[route_item_list.count()-1].trimmed(), result_list);
-    if (result_list.count() == 1)
-    {
-        destination_airport = (Airport*)result_list.at(0)->deepCopy();
-        route_item_list.removeLast();
     }
 
-    // extract route
-
-    int item_index = 0;
-    Waypoint last_wpt;
-    while(item_index < route_item_list.count())
-    {
-        if (route_item_list[item_index].trimmed().isEmpty())
-        {
-            ++item_index;
-            continue;
-        }
-
-        // handle direct waypoints
-        if (route_item_list[item_index].trimmed() == "DCT")
-        {
-            ++item_index;
-            last_wpt = Waypoint();
-            continue;
-        }
-        
-        // if we got no last waypoint search for the new wpt
-        if (!last_wpt.isValid() || (route_item_list.count() - (item_index+1)) < 1)
-        {
-            last_wpt = Waypoint();
-            result_list.clear();
-            
-            navdata.getWaypoints(route_item_list[item_index].trimmed(), result_list, lat_lon_wpt_regexp);
-            if (result_list.count() <= 0)
-            {
-                // we tolerate not finding the last waypoint, because
-                // this could be a star or other procedure
-                if (item_index+1 == route_item_list.count()) break;
-                
-                error = QString("%1 not found").arg(route_item_list[item_index].trimmed());
-                return false;
-            }
-        
-            if (last_wpt.isValid()) result_list.sortByDistance(last_wpt);
-            else                    result_list.sortByDistance(*departureAirport());
-            
-            //TODO search for the right waypoint if we got an airway
-            //and found more than one possible first waypoints
-            appendWaypoint(*result_list.at(0));
-            if ((route_item_list.count() - (item_index+1)) >= 1) last_wpt = *result_list.at(0);
-            ++item_index;
-        }
-        else
-        {
-            result_list.clear();
-            QString error_text;
-            if (!navdata.getWaypointsByAirway(
-                    last_wpt, route_item_list[item_index].trimmed(), 
-                    route_item_list[item_index+1].trimmed(), result_list, error_text))
-            {
-                // if we got no airway we search for a waypoint in the next loop instead
-                last_wpt = Waypoint();
-                continue;
-            }
-            
-            WaypointPtrListIterator iter(result_list);
-            while(iter.hasNext()) appendWaypoint(*iter.next());
-            last_wpt = *result_list.last()->deepCopy();
-            item_index += 2;
-        }
-    }
+    WaypointPtrListIterator iter(resolved_route.waypoints);
+    while(iter.hasNext()) appendWaypoint(*iter.next());
     
-    if (destination_airport != 0)
+    if (resolved_route.destination_airport != 0)
     {
-        appendWaypoint(*destination_airport);
+        appendWaypoint(*resolved_route.destination_airport);
         setAsDestinationAirport(count()-1, QString::null);
         MYASSERT(destinationAirport() != 0);
-        delete destination_airport;
-        destination_airport = 0;
     }
     
     removeDoubleWaypoints();
-
-    return true;
 }
 
 /////////////////////////////////////////////////////////////////////////////
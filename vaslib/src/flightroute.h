@@ -30,6 +30,7 @@
 #include "route.h"
 
 class Navdata;
+class NavdataResolvedRoute;
 class ProjectionBase;
 class QRegExp;
 class FlightStatus;
@@ -280,6 +281,10 @@ public:
     //! text when appropriate.
     bool extractICAORoute(const QString& route, const Navdata& navdata, 
                           const QRegExp& lat_lon_wpt_regexp, QString& error);
+
+    //! Clears the route and inserts the given route resolved by
+    //! Navdata::resolveICAORoute(), e.g. by a navdata query service.
+    void setICAORoute(const NavdataResolvedRoute& resolved_route);
     
     //----- 
 
@@ -54,7 +54,8 @@ FlightStatus::FlightStatus(uint smooth_delay_ms) :
     m_fd_pitch_input_from_external(true),
     m_fd_bank(false, false, 40, smooth_delay_ms), 
     m_fd_bank_input_from_external(true),
-    m_fd_was_active(false)
+    m_fd_was_active(false),
+    m_update_count(0)
 {
     EngineData::m_smooth_delay_ms = smooth_delay_ms;
 
@@ -241,7 +242,7 @@ void FlightStatus::clear()
     m_altimeter_pressure_setting_hpa = 0.0;
 
     doors_open = pitot_heat_on = false;
-    m_flaps_transit_timer = QTime::currentTime().addSecs(-10);
+    m_flaps_transit_timer.startMsAgo(10000);
     pushback_status = FSAccess::PUSHBACK_STOP;
     //TODOtime_of_day = TIME_OF_DAY_INVALID;
 
@@ -258,6 +259,42 @@ QString FlightStatus::toString() const
 
 /////////////////////////////////////////////////////////////////////////////
 
+void FlightStatus::freeze()
+{
+    smoothed_ias.freeze();
+    smoothed_altimeter_readout.freeze();
+    smoothed_vs.freeze();
+    pitch.freeze();
+    bank.freeze();
+    fpv_vertical.freeze();
+    nav1_bearing.freeze();
+    nav2_bearing.freeze();
+    adf1_bearing.freeze();
+    adf2_bearing.freeze();
+    lat_smoothed.freeze();
+    lon_smoothed.freeze();
+    m_true_heading.freeze();
+    m_magnetic_track.freeze();
+    m_fd_pitch.freeze();
+    m_fd_bank.freeze();
+
+    QMap<uint, EngineData>::iterator engine_iter = engine_data.begin();
+    for(; engine_iter != engine_data.end(); ++engine_iter) engine_iter.value().smoothed_n1.freeze();
+
+    nav1.unitVector();
+    nav2.unitVector();
+    adf1.unitVector();
+    adf2.unitVector();
+    current_position_raw.unitVector();
+    current_position_smoothed.unitVector();
+
+    // the non-const access detaches the list from the one of the source
+    for(int index = 0; index < m_tcas_entry_list.count(); ++index)
+        m_tcas_entry_list[index].m_position.unitVector();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
 void FlightStatus::recalc()
 {
     // setup current position
@@ -31,6 +31,7 @@
 #include "ils.h"
 #include "navcalc.h"
 #include "smoothing.h"
+#include "sim_clock.h"
 
 /////////////////////////////////////////////////////////////////////////////
 
@@ -93,6 +94,8 @@ public:
 
 class FlightStatus
 {
+    friend class FlightRecorderChannels;
+
 public:
 
     enum ENGINE_TYPE { ENGINE_TYPE_INVALID = 0,
@@ -129,8 +132,13 @@ public:
     {
         recalc();
         m_valid = true;
+        ++m_update_count;
     }
 
+    //! returns the number of recalcAndSetValid() calls, used to detect
+    //! updates by the FSAccess backends
+    inline uint updateCount() const { return m_update_count; }
+
     // TCAS stuff
 
     void clearTcasEntryList() { m_tcas_entry_list.clear(); }
@@ -139,6 +147,12 @@ public:
 
     // smoothing
 
+    //! Freezes all smoothed values and calculates the cached unit vectors
+    //! of the waypoints, so the const accessors do not change anything
+    //! afterwards and may be used by several threads at once. Used for the
+    //! published snapshots, see FlightStatusPublisher.
+    void freeze();
+
     void advanceMeasurements();
     void updateSmoothedValueWithMeans();
 
@@ -563,6 +577,7 @@ protected:
     SmoothedValueWithDelay<double> m_fd_bank;
     bool m_fd_bank_input_from_external;
     bool m_fd_was_active;
+    uint m_update_count;
 
 private:
 
@@ -573,16 +588,16 @@ private:
     double m_ap_mach;
     double m_altimeter_pressure_setting_hpa;
 
-    QTime m_altimeter_pressure_setting_hpa_read_delay_timer;
-    QTime m_ap_spd_read_delay_timer;
-    QTime m_ap_mach_read_delay_timer;
-    QTime m_ap_hdg_read_delay_timer;
-    QTime m_ap_alt_read_delay_timer;
-    QTime m_ap_vs_read_delay_timer;
+    SimTimer m_altimeter_pressure_setting_hpa_read_delay_timer;
+    SimTimer m_ap_spd_read_delay_timer;
+    SimTimer m_ap_mach_read_delay_timer;
+    SimTimer m_ap_hdg_read_delay_timer;
+    SimTimer m_ap_alt_read_delay_timer;
+    SimTimer m_ap_vs_read_delay_timer;
 
     double m_last_flaps_percent_left;
     double m_last_flaps_percent_right;
-    QTime m_flaps_transit_timer;
+    SimTimer m_flaps_transit_timer;
 };
 
 /////////////////////////////////////////////////////////////////////////////
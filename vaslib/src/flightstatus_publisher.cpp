@@ -0,0 +1,115 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2005-2007 Alexander Wemmer 
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+///////////////////////////////////////////////////////////////////////////////
+
+/*! \file    flightstatus_publisher.cpp
+    \author  Alexander Wemmer, alex@wemmer.at
+*/
+
+#include "flightstatus_publisher.h"
+
+/////////////////////////////////////////////////////////////////////////////
+
+FlightStatusPublisher::FlightStatusPublisher(uint smooth_delay_ms) :
+    m_latest_slot(-1), m_published_update_count(0), m_last_sequence(0), m_dropped_count(0)
+{
+    for(int slot = 0; slot < FLIGHTSTATUS_PUBLISHER_SLOTS; ++slot)
+    {
+        m_slots[slot] = new FlightStatus(smooth_delay_ms);
+        MYASSERT(m_slots[slot] != 0);
+        m_sequence[slot] = 0;
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+FlightStatusPublisher::~FlightStatusPublisher()
+{
+    for(int slot = 0; slot < FLIGHTSTATUS_PUBLISHER_SLOTS; ++slot)
+    {
+        MYASSERT(m_readers[slot] == 0);
+        delete m_slots[slot];
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+bool FlightStatusPublisher::publish(const FlightStatus& flightstatus)
+{
+    if (m_last_sequence > 0 && flightstatus.updateCount() == m_published_update_count) return false;
+
+    // find a slot nobody reads - a reader only acquires the latest slot
+    // and checks afterwards that it still is the latest one, so a slot
+    // without readers is safe to overwrite until it is published
+
+    int latest_slot = latestSlot();
+    int free_slot = -1;
+
+    for(int slot = 0; slot < FLIGHTSTATUS_PUBLISHER_SLOTS; ++slot)
+    {
+        if (slot != latest_slot && m_readers[slot].fetchAndAddOrdered(0) == 0)
+        {
+            free_slot = slot;
+            break;
+        }
+    }
+
+    if (free_slot < 0)
+    {
+        ++m_dropped_count;
+        return false;
+    }
+
+    *m_slots[free_slot] = flightstatus;
+    m_slots[free_slot]->freeze();
+    m_sequence[free_slot] = ++m_last_sequence;
+    m_published_update_count = flightstatus.updateCount();
+
+    m_latest_slot.fetchAndStoreOrdered(free_slot);
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+int FlightStatusPublisher::acquireLatest() const
+{
+    while(true)
+    {
+        int slot = latestSlot();
+        if (slot < 0) return -1;
+
+        m_readers[slot].ref();
+        if (latestSlot() == slot) return slot;
+
+        // the writer published a newer slot in between and may already
+        // write to this one
+        m_readers[slot].deref();
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void FlightStatusPublisher::release(int slot) const
+{
+    MYASSERT(slot >= 0 && slot < FLIGHTSTATUS_PUBLISHER_SLOTS);
+    MYASSERT(m_readers[slot] > 0);
+    m_readers[slot].deref();
+}
+
+// End of file
@@ -0,0 +1,140 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2005-2007 Alexander Wemmer 
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+///////////////////////////////////////////////////////////////////////////////
+
+/*! \file    flightstatus_publisher.h
+    \author  Alexander Wemmer, alex@wemmer.at
+*/
+
+#ifndef FLIGHTSTATUS_PUBLISHER_H
+#define FLIGHTSTATUS_PUBLISHER_H
+
+#include <QAtomicInt>
+
+#include "assert.h"
+#include "flightstatus.h"
+
+/////////////////////////////////////////////////////////////////////////////
+
+//! max. number of snapshots held at the same time plus two
+#define FLIGHTSTATUS_PUBLISHER_SLOTS 8
+
+/////////////////////////////////////////////////////////////////////////////
+
+//! Publishes copies of the flightstatus written by the FSAccess backends,
+//! so readers in other threads get a consistent snapshot without locks.
+//! There must only be one writer (the thread calling publish()). A slot is
+//! only overwritten when it is neither the latest one nor held by any
+//! reader, so a snapshot never changes while it is held.
+class FlightStatusPublisher
+{
+public:
+
+    FlightStatusPublisher(uint smooth_delay_ms);
+    virtual ~FlightStatusPublisher();
+
+    //! Copies the given flightstatus to a free slot, freezes it (see
+    //! FlightStatus::freeze()) and makes it the latest one. Returns false
+    //! when nothing was published because the flightstatus was not updated
+    //! since the last call (see FlightStatus::updateCount()) or because all
+    //! slots are held.
+    bool publish(const FlightStatus& flightstatus);
+
+    //! returns the number of publish() calls which found all slots held
+    inline uint droppedCount() const { return m_dropped_count; }
+
+protected:
+
+    friend class FlightStatusSnapshot;
+
+    //! Returns the latest slot with its reader count incremented, -1 when
+    //! nothing was published yet.
+    int acquireLatest() const;
+
+    //! decrements the reader count of the given slot
+    void release(int slot) const;
+
+    inline int latestSlot() const { return m_latest_slot.fetchAndAddOrdered(0); }
+
+protected:
+
+    FlightStatus* m_slots[FLIGHTSTATUS_PUBLISHER_SLOTS];
+    uint m_sequence[FLIGHTSTATUS_PUBLISHER_SLOTS];
+    mutable QAtomicInt m_readers[FLIGHTSTATUS_PUBLISHER_SLOTS];
+    mutable QAtomicInt m_latest_slot;
+
+    uint m_published_update_count;
+    uint m_last_sequence;
+    uint m_dropped_count;
+
+private:
+    //! Hidden copy-constructor
+    FlightStatusPublisher(const FlightStatusPublisher&);
+    //! Hidden assignment operator
+    const FlightStatusPublisher& operator = (const FlightStatusPublisher&);
+};
+
+/////////////////////////////////////////////////////////////////////////////
+
+//! Holds the latest published flightstatus for as long as it lives. The
+//! held flightstatus is not changed by the publisher and its smoothed
+//! values are frozen, so any number of readers may share it. The smoothed
+//! values and trends are the ones at the time of publishing.
+class FlightStatusSnapshot
+{
+public:
+
+    FlightStatusSnapshot(const FlightStatusPublisher& publisher) : 
+        m_publisher(publisher), m_slot(publisher.acquireLatest())
+    {}
+
+    virtual ~FlightStatusSnapshot()
+    {
+        if (m_slot >= 0) m_publisher.release(m_slot);
+    }
+
+    //! returns false when nothing was published yet
+    inline bool isValid() const { return m_slot >= 0; }
+
+    //! returns the publish sequence number of the snapshot, starting at 1
+    inline uint sequence() const { return isValid() ? m_publisher.m_sequence[m_slot] : 0; }
+
+    inline const FlightStatus& operator*() const
+    {
+        MYASSERT(isValid());
+        return *m_publisher.m_slots[m_slot];
+    }
+
+    inline const FlightStatus* operator->() const { return &(operator*()); }
+
+protected:
+
+    const FlightStatusPublisher& m_publisher;
+    int m_slot;
+
+private:
+    //! Hidden copy-constructor
+    FlightStatusSnapshot(const FlightStatusSnapshot&);
+    //! Hidden assignment operator
+    const FlightStatusSnapshot& operator = (const FlightStatusSnapshot&);
+};
+
+#endif /* FLIGHTSTATUS_PUBLISHER_H */
+
+// End of file
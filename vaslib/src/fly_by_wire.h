@@ -31,6 +31,7 @@
 #include "smoothing.h"
 #include "statistics.h"
 #include "flightstatus.h"
+#include "sim_clock.h"
 
 class FSAccess;
 
@@ -153,12 +154,12 @@ protected:
 
     const FlightStatus* m_flightstatus;
     bool m_init;					
-    QTime m_init_dt;
+    SimTimer m_init_dt;
     double m_bank_target;
     bool m_stable;
     bool m_override_active;
     double m_override_joy_input;
-    QTime m_last_call_dt;
+    SimTimer m_last_call_dt;
 
     double m_p_gain;
     double m_i_gain;
@@ -177,7 +178,7 @@ protected:
 
     bool m_do_statistics;
     Statistics *m_stat;
-    QTime m_stat_timer;
+    SimTimer m_stat_timer;
 };
 
 /////////////////////////////////////////////////////////////////////////////
@@ -327,13 +328,13 @@ protected:
 
     const FlightStatus* m_flightstatus;
     bool m_init;					
-    QTime m_init_dt;
+    SimTimer m_init_dt;
     double m_fpv_target;
     double m_pitch_target;
     bool m_stable;
     bool m_override_active;
     double m_override_joy_input;
-    QTime m_last_call_dt;
+    SimTimer m_last_call_dt;
 
     double m_p_gain;
     double m_i_gain;
@@ -359,7 +360,7 @@ protected:
     
     bool m_do_statistics;
     Statistics *m_stat;
-    QTime m_stat_timer;
+    SimTimer m_stat_timer;
 };
 
 #endif /* __FLY_BY_WIRE_H__ */
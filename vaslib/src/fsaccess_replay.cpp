@@ -0,0 +1,134 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2005-2007 Alexander Wemmer 
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+///////////////////////////////////////////////////////////////////////////////
+
+/*! \file    fsaccess_replay.cpp
+    \author  Alexander Wemmer, alex@wemmer.at
+*/
+
+#include "assert.h"
+#include "logger.h"
+
+#include "fsaccess_replay.h"
+
+/////////////////////////////////////////////////////////////////////////////
+
+#define REPLAY_TIMER_INTERVAL_MS 5
+//! limits the frames applied per timer tick, so the event loop stays alive
+#define REPLAY_MAX_FRAMES_PER_TICK 100
+
+/////////////////////////////////////////////////////////////////////////////
+
+FSAccessReplay::FSAccessReplay(ConfigWidgetProvider* config_widget_provider,
+                               const QString& cfg_file, FlightStatus* flightstatus) :
+    FSAccess(flightstatus), m_cfg(cfg_file), m_speed(1.0), m_stepped_clock(0),
+    m_first_frame_ms(0), m_start_ms(0), m_real_start_ms(0)
+{
+    MYASSERT(config_widget_provider != 0);
+
+    // setup config
+    m_cfg.setValue(CFG_REPLAY_FILE, "");
+    m_cfg.setValue(CFG_REPLAY_SPEED, 1);
+    m_cfg.setValue(CFG_REPLAY_LOOP, 0);
+    m_cfg.loadfromFile();
+    m_cfg.saveToFile();
+    config_widget_provider->registerConfigWidget("Replay Access", &m_cfg);
+
+    bool convok = false;
+    m_speed = m_cfg.getValue(CFG_REPLAY_SPEED).toDouble(&convok);
+    if (!convok || m_speed < 0.0) m_speed = 1.0;
+
+    MYASSERT(connect(&m_replay_timer, SIGNAL(timeout()), this, SLOT(slotReplay())));
+
+    if (!m_recording.open(m_cfg.getValue(CFG_REPLAY_FILE)) || !m_recording.peekFrameTime(m_first_frame_ms))
+    {
+        Logger::log("FSAccessReplay: no recording to replay");
+        return;
+    }
+
+    if (m_speed != 1.0)
+    {
+        m_stepped_clock = new SteppedClock(SimClock::nowMs());
+        MYASSERT(m_stepped_clock != 0);
+        SimClock::setInstance(m_stepped_clock);
+    }
+
+    Logger::log(QString("FSAccessReplay: replaying %1 with speed %2").
+                arg(m_cfg.getValue(CFG_REPLAY_FILE)).arg(m_speed));
+
+    MYASSERT(startReplay());
+    m_replay_timer.start(m_speed == 0.0 ? 0 : REPLAY_TIMER_INTERVAL_MS);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+FSAccessReplay::~FSAccessReplay() 
+{
+    m_replay_timer.stop();
+
+    // continue in real time from the stepped time, so the avionics
+    // timers do not see the time going backwards
+    if (m_stepped_clock != 0) SimClock::setInstance(0);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+bool FSAccessReplay::startReplay()
+{
+    m_recording.rewind();
+    if (!m_recording.peekFrameTime(m_first_frame_ms)) return false;
+
+    m_start_ms = SimClock::nowMs();
+    m_real_start_ms = m_real_clock.currentMs();
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void FSAccessReplay::slotReplay()
+{
+    for(int count = 0; count < REPLAY_MAX_FRAMES_PER_TICK; ++count)
+    {
+        qint64 frame_ms = 0;
+        if (!m_recording.peekFrameTime(frame_ms))
+        {
+            if (m_cfg.getIntValue(CFG_REPLAY_LOOP) == 0 || !startReplay())
+            {
+                Logger::log("FSAccessReplay:slotReplay: end of recording");
+                m_replay_timer.stop();
+                return;
+            }
+
+            Logger::log("FSAccessReplay:slotReplay: restarting recording");
+            return;
+        }
+
+        qint64 replay_ms = qMax((qint64)0, frame_ms - m_first_frame_ms);
+
+        if (m_speed > 0.0 && replay_ms > (m_real_clock.currentMs() - m_real_start_ms) * m_speed) return;
+
+        if (m_stepped_clock != 0)
+            m_stepped_clock->setMs(qMax(m_stepped_clock->currentMs(), m_start_ms + replay_ms));
+
+        if (!m_recording.readFrame(*m_flightstatus, frame_ms)) return;
+        m_flightstatus->recalcAndSetValid();
+    }
+}
+
+// End of file
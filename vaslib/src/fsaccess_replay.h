@@ -0,0 +1,142 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2005-2007 Alexander Wemmer 
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+///////////////////////////////////////////////////////////////////////////////
+
+/*! \file    fsaccess_replay.h
+    \author  Alexander Wemmer, alex@wemmer.at
+*/
+
+#ifndef FSACCESS_REPLAY_H
+#define FSACCESS_REPLAY_H
+
+#include <QTimer>
+
+#include "fsaccess.h"
+#include "flight_recorder.h"
+#include "sim_clock.h"
+
+#define CFG_REPLAY_FILE "replay_file"
+#define CFG_REPLAY_SPEED "replay_speed"
+#define CFG_REPLAY_LOOP "replay_loop"
+
+/////////////////////////////////////////////////////////////////////////////
+
+//! Replays a flight recorded by the FlightRecorder instead of reading from
+//! a flightsim. With a replay speed of 1 the frames are played in real
+//! time, other speeds run the avionics on a SteppedClock following the
+//! recorded time stamps (0 = as fast as possible). All write accesses are
+//! ignored.
+class FSAccessReplay : public FSAccess
+{
+    Q_OBJECT
+
+public:
+
+    //! Standard Constructor
+    FSAccessReplay(ConfigWidgetProvider* config_widget_provider,
+                   const QString& cfg_file, FlightStatus* flightstatus);
+
+    //! Destructor
+    virtual ~FSAccessReplay();
+
+    virtual Config* config() { return &m_cfg; }
+
+    //-----
+
+    virtual bool setNavFrequency(int, uint) { return false; }
+    virtual bool setAdfFrequency(int, uint) { return false; }
+    virtual bool setNavOBS(int, uint) { return false; }
+
+    virtual bool setAutothrustArm(bool) { return false; }
+    virtual bool setAutothrustSpeedHold(bool) { return false; }
+    virtual bool setAutothrustMachHold(bool) { return false; }
+
+    virtual bool setFDOnOff(bool) { return false; }
+    virtual bool setAPOnOff(bool) { return false; }
+    virtual bool setAPHeading(double) { return false; }
+    virtual bool setAPAlt(unsigned int) { return false; }
+    virtual bool setAPAirspeed(unsigned short) { return false; }
+    virtual bool setAPMach(double) { return false; }
+    virtual bool setAPHeadingHold(bool) { return false; }
+    virtual bool setAPAltHold(bool) { return false; }
+    virtual bool setNAV1Arm(bool) { return false; }
+    virtual bool setAPPArm(bool) { return false; }
+
+    virtual bool setUTCTime(const QTime&) { return false; }
+    virtual bool setUTCDate(const QDate&) { return false; }
+
+    virtual bool freeThrottleAxes() { return false; }
+    virtual bool setThrottle(double) { return false; }
+    virtual bool setSBoxTransponder(bool) { return false; }
+    virtual bool setSBoxIdent() { return false; }
+    virtual bool setFlaps(uint) { return false; }
+
+    virtual bool setAileron(double) { return false; }
+    virtual bool setElevator(double) { return false; }
+    virtual bool setElevatorTrimPercent(double) { return false; }
+    virtual bool setElevatorTrimDegrees(double) { return false; }
+
+    virtual bool setSpoiler(double) { return false; }
+
+    virtual bool setAltimeterHpa(const double&) { return false; }
+
+protected slots:
+
+    void slotReplay();
+
+protected:
+
+    virtual bool setAPVs(int) { return false; }
+
+    //! starts the replay at the first frame, returns false if there is none
+    bool startReplay();
+
+protected:
+
+    //! replay fsaccess configuration
+    Config m_cfg;
+
+    FlightRecording m_recording;
+    QTimer m_replay_timer;
+
+    double m_speed;
+
+    //! Clock of the avionics when not replaying in real time, 0 otherwise.
+    //! It is owned by SimClock, see SimClock::setInstance().
+    SteppedClock* m_stepped_clock;
+
+    //! time of the first frame of the recording
+    qint64 m_first_frame_ms;
+    //! clock time at the start of the replay
+    qint64 m_start_ms;
+
+    //! measures the real time for replay speeds other than 0
+    RealTimeClock m_real_clock;
+    qint64 m_real_start_ms;
+
+private:
+    //! Hidden copy-constructor
+    FSAccessReplay(const FSAccessReplay&);
+    //! Hidden assignment operator
+    const FSAccessReplay& operator = (const FSAccessReplay&);
+};
+
+#endif /* FSACCESS_REPLAY_H */
+
+// End of file
@@ -0,0 +1,224 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2005-2007 Alexander Wemmer
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+///////////////////////////////////////////////////////////////////////////////
+
+/*! \file    geo_polygon_store.cpp
+    \author  Alexander Wemmer, alex@wemmer.at
+*/
+
+#include <string.h>
+
+#include "projection.h"
+
+#include "geo_polygon_store.h"
+
+/////////////////////////////////////////////////////////////////////////////
+
+void GeoPolygonStore::clear()
+{
+    m_polygons.clear();
+    m_lat.clear();
+    m_lon.clear();
+    m_x.clear();
+    m_y.clear();
+    m_projection_epoch = 0;
+    m_open_polygon = false;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void GeoPolygonStore::reserve(int polygon_count, int point_count)
+{
+    m_polygons.reserve(polygon_count);
+    m_lat.reserve(point_count);
+    m_lon.reserve(point_count);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void GeoPolygonStore::startPolygon(int id, int level)
+{
+    MYASSERT(!m_open_polygon);
+    m_open_polygon = true;
+
+    GeoPolygon polygon;
+    polygon.id = id;
+    polygon.level = level;
+    polygon.first_point = m_lat.count();
+    polygon.point_count = 0;
+    polygon.west = polygon.east = polygon.south = polygon.north = 0;
+    m_polygons.append(polygon);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void GeoPolygonStore::appendPoints(const int* lat_lon, int count)
+{
+    MYASSERT(m_open_polygon);
+
+    int first_index = m_lat.count();
+    m_lat.resize(first_index + count);
+    m_lon.resize(first_index + count);
+
+    int* lat = m_lat.data() + first_index;
+    int* lon = m_lon.data() + first_index;
+
+    for(int index = 0; index < count; ++index)
+    {
+        lat[index] = lat_lon[2*index];
+        lon[index] = lat_lon[2*index+1];
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void GeoPolygonStore::appendPolygon(const GeoPolygon& polygon, const GeoPolygonStore& source)
+{
+    MYASSERT(!m_open_polygon);
+    MYASSERT(polygon.first_point + polygon.point_count <= source.pointCount());
+
+    GeoPolygon copy = polygon;
+    copy.first_point = m_lat.count();
+    m_polygons.append(copy);
+
+    m_lat.resize(copy.first_point + polygon.point_count);
+    m_lon.resize(copy.first_point + polygon.point_count);
+    memcpy(m_lat.data() + copy.first_point, source.latArray() + polygon.first_point, polygon.point_count * sizeof(int));
+    memcpy(m_lon.data() + copy.first_point, source.lonArray() + polygon.first_point, polygon.point_count * sizeof(int));
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void GeoPolygonStore::finishPolygon()
+{
+    MYASSERT(m_open_polygon);
+    m_open_polygon = false;
+
+    GeoPolygon& polygon = m_polygons.last();
+    polygon.point_count = m_lat.count() - polygon.first_point;
+
+    if (polygon.point_count < 2)
+    {
+        m_lat.resize(polygon.first_point);
+        m_lon.resize(polygon.first_point);
+        m_polygons.resize(m_polygons.count()-1);
+        return;
+    }
+
+    const int* lat = m_lat.constData() + polygon.first_point;
+    const int* lon = m_lon.constData() + polygon.first_point;
+
+    polygon.south = polygon.north = lat[0];
+    polygon.west = polygon.east = lon[0];
+
+    for(int index = 1; index < polygon.point_count; ++index)
+    {
+        if (lat[index] < polygon.south) polygon.south = lat[index];
+        else if (lat[index] > polygon.north) polygon.north = lat[index];
+
+        if (lon[index] < polygon.west) polygon.west = lon[index];
+        else if (lon[index] > polygon.east) polygon.east = lon[index];
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void GeoPolygonStore::calcProjection(const ProjectionBase& projection)
+{
+    MYASSERT(!m_open_polygon);
+
+    int max = m_lat.count();
+    m_x.resize(max);
+    m_y.resize(max);
+
+    projection.convertLatLonArraysToXY(m_lat.constData(), m_lon.constData(), max, m_x.data(), m_y.data());
+    m_projection_epoch = projection.epoch();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+int GeoPolygonStore::memoryUsage() const
+{
+    return
+        m_polygons.capacity() * sizeof(GeoPolygon) +
+        (m_lat.capacity() + m_lon.capacity()) * sizeof(int) +
+        (m_x.capacity() + m_y.capacity()) * sizeof(float);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void GeoPolygonStore::save(QDataStream& stream) const
+{
+    MYASSERT(!m_open_polygon);
+
+    stream << (qint32)m_polygons.count() << (qint32)m_lat.count();
+    stream.writeRawData((const char*)m_polygons.constData(), m_polygons.count() * sizeof(GeoPolygon));
+    stream.writeRawData((const char*)m_lat.constData(), m_lat.count() * sizeof(int));
+    stream.writeRawData((const char*)m_lon.constData(), m_lon.count() * sizeof(int));
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+bool GeoPolygonStore::load(QDataStream& stream)
+{
+    clear();
+
+    qint32 polygon_count = 0;
+    qint32 point_count = 0;
+    stream >> polygon_count >> point_count;
+    if (stream.status() != QDataStream::Ok || polygon_count < 0 || point_count < 0) return false;
+
+    qint64 polygon_size = (qint64)polygon_count * sizeof(GeoPolygon);
+    qint64 point_size = (qint64)point_count * sizeof(int);
+
+    // do not allocate more than the stream can hold
+    if (stream.device() != 0 && stream.device()->bytesAvailable() < polygon_size + 2 * point_size)
+    {
+        stream.setStatus(QDataStream::ReadCorruptData);
+        return false;
+    }
+
+    m_polygons.resize(polygon_count);
+    m_lat.resize(point_count);
+    m_lon.resize(point_count);
+
+    if (stream.readRawData((char*)m_polygons.data(), (int)polygon_size) != polygon_size ||
+        stream.readRawData((char*)m_lat.data(), (int)point_size) != point_size ||
+        stream.readRawData((char*)m_lon.data(), (int)point_size) != point_size)
+    {
+        clear();
+        return false;
+    }
+
+    // do not trust polygons pointing outside of the points
+    for(int index = 0; index < polygon_count; ++index)
+    {
+        const GeoPolygon& polygon = m_polygons[index];
+        if (polygon.first_point < 0 || polygon.point_count < 0 ||
+            (qint64)polygon.first_point + polygon.point_count > point_count)
+        {
+            clear();
+            return false;
+        }
+    }
+
+    return true;
+}
+
+// End of file
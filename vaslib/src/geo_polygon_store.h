@@ -0,0 +1,141 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2005-2007 Alexander Wemmer
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+///////////////////////////////////////////////////////////////////////////////
+
+/*! \file    geo_polygon_store.h
+    \author  Alexander Wemmer, alex@wemmer.at
+*/
+
+#ifndef GEO_POLYGON_STORE_H
+#define GEO_POLYGON_STORE_H
+
+#include <QDataStream>
+#include <QVector>
+
+#include "assert.h"
+
+class ProjectionBase;
+
+/////////////////////////////////////////////////////////////////////////////
+
+//! header of a polygon in the GeoPolygonStore
+struct GeoPolygon
+{
+    int id;
+    //! 1 land, 2 lake, 3 island_in_lake, 4 pond_in_island_in_lake
+    int level;
+    //! index of the first point in the point arrays
+    int first_point;
+    int point_count;
+    //! extent in micro-degrees
+    int west, east, south, north;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+
+//! Compact store of coastline polygons. The points of all polygons are
+//! kept in contiguous lat/lon arrays (micro-degrees, lon within
+//! [-180,180]), the polygons only reference a range of them. After
+//! calcProjection() the projected x/y values are available in parallel
+//! arrays, so drawing does not touch any per-point object.
+class GeoPolygonStore
+{
+public:
+
+    GeoPolygonStore() : m_projection_epoch(0), m_open_polygon(false) {};
+    virtual ~GeoPolygonStore() {};
+
+    void clear();
+
+    //! reserves memory for the given number of polygons and points
+    void reserve(int polygon_count, int point_count);
+
+    //! Starts a new polygon, the following appendPoint() calls add to it
+    //! until finishPolygon() is called.
+    void startPolygon(int id, int level);
+
+    inline void appendPoint(int lat, int lon)
+    {
+        MYASSERT(m_open_polygon);
+        m_lat.append(lat);
+        m_lon.append(lon);
+    }
+
+    //! Appends the given number of points at once, "lat_lon" holds the
+    //! points as lat/lon pairs.
+    void appendPoints(const int* lat_lon, int count);
+
+    //! Appends a copy of the given polygon, whose points are taken from
+    //! the given store. The extent of the polygon is kept.
+    void appendPolygon(const GeoPolygon& polygon, const GeoPolygonStore& source);
+
+    //! Finishes the current polygon and calculates its extent. Polygons
+    //! with less than two points are dropped.
+    void finishPolygon();
+
+    inline int count() const { return m_polygons.count(); }
+    inline int pointCount() const { return m_lat.count(); }
+
+    inline const GeoPolygon& polygon(int index) const { return m_polygons[index]; }
+
+    //! raw point arrays, indexed by GeoPolygon::first_point
+    inline const int* latArray() const { return m_lat.constData(); }
+    inline const int* lonArray() const { return m_lon.constData(); }
+
+    inline double lat(int point_index) const { return m_lat[point_index] * 1.0e-6; }
+    inline double lon(int point_index) const { return m_lon[point_index] * 1.0e-6; }
+
+    //! Projects all points, the result is available via xArray() and
+    //! yArray() until the store is changed.
+    void calcProjection(const ProjectionBase& projection);
+
+    //! projected point arrays, only valid after calcProjection()
+    inline const float* xArray() const { return m_x.constData(); }
+    inline const float* yArray() const { return m_y.constData(); }
+    inline bool isProjected() const { return m_x.count() == m_lat.count(); }
+
+    //! returns the epoch of the projection used by calcProjection(), see
+    //! ProjectionBase::epoch()
+    inline uint projectionEpoch() const { return m_projection_epoch; }
+
+    //! returns the number of bytes used by the store
+    int memoryUsage() const;
+
+    //! Writes the polygons and points in native byte order, the projected
+    //! points are not written.
+    void save(QDataStream& stream) const;
+
+    //! reads a store written by save(), returns true on success
+    bool load(QDataStream& stream);
+
+protected:
+
+    QVector<GeoPolygon> m_polygons;
+    QVector<int> m_lat;
+    QVector<int> m_lon;
+    QVector<float> m_x;
+    QVector<float> m_y;
+    uint m_projection_epoch;
+
+    bool m_open_polygon;
+};
+
+#endif /* GEO_POLYGON_STORE_H */
+
+// End of file
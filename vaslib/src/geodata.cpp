@@ -24,8 +24,21 @@
 
 #include <QApplication>
 #include <QFile>
+#include <QFileInfo>
+#include <QDataStream>
 #include <QDateTime>
+#include <QAtomicInt>
+#include <QPair>
 #include <QRectF>
+#include <QRunnable>
+#include <QVector>
+
+#include <string.h>
+
+#if defined(__SSE2__) || defined(_M_X64)
+#define GEODATA_USE_SSE2
+#include <emmintrin.h>
+#endif
 
 #include "logger.h"
 #include "gshhs.h"
@@ -36,14 +49,95 @@
 
 /////////////////////////////////////////////////////////////////////////////
 
-GeoData::GeoData()
+//! tile size in micro-degrees
+#define GEODATA_TILE_SIZE 2000000
+#define GEODATA_TILE_ROWS (180000000 / GEODATA_TILE_SIZE)
+#define GEODATA_TILE_COLUMNS (360000000 / GEODATA_TILE_SIZE)
+
+//! simplification tolerance of the first level of detail in micro-degrees
+#define GEODATA_LOD_BASE_TOLERANCE 1000
+
+#define GEODATA_LOD_CACHE_MAGIC 0x444f4c47  // "GLOD"
+#define GEODATA_LOD_CACHE_VERSION 1
+
+//! max. number of decoded full resolution tiles kept out of range
+#define GEODATA_MAX_CACHED_TILES 64
+
+/////////////////////////////////////////////////////////////////////////////
+
+//! Builds the simplified levels of detail from all source polygons in a
+//! worker thread, see GeoData::startLevelTask(). The polygons are
+//! decoded one by one, so the full resolution is never held at once.
+class GeoDataLevelTask : public QRunnable
 {
+public:
+
+    GeoDataLevelTask(const QVector<GeoDataSourcePolygon>& source_polygons) :
+        m_source_polygons(source_polygons), m_done(0), m_cancel(0)
+    {
+        setAutoDelete(false);
+    }
+
+    virtual ~GeoDataLevelTask() {};
+
+    virtual void run()
+    {
+        GeoPolygonStore chain[GEODATA_LOD_LEVEL_COUNT];
+        QVector<int> point_buffer;
+
+        for(int index = 0; index < m_source_polygons.count() && m_cancel == 0; ++index)
+        {
+            const GeoDataSourcePolygon& source_polygon = m_source_polygons[index];
+            point_buffer.resize(2 * source_polygon.point_count);
+            GeoData::decodePoints(source_polygon.points, source_polygon.point_count, point_buffer.data());
+
+            chain[0].clear();
+            chain[0].startPolygon(source_polygon.id, source_polygon.level);
+            chain[0].appendPoints(point_buffer.constData(), source_polygon.point_count);
+            chain[0].finishPolygon();
+
+            // every level is simplified from the previous one
+            for(int level = 1; level < GEODATA_LOD_LEVEL_COUNT; ++level)
+            {
+                chain[level].clear();
+                GeoData::simplify(chain[level-1], qRound(GeoData::levelToleranceNm(level) / 60.0 * 1.0e6), chain[level]);
+                for(int polygon = 0; polygon < chain[level].count(); ++polygon)
+                    m_levels[level].appendPolygon(chain[level].polygon(polygon), chain[level]);
+            }
+        }
+
+        m_done.fetchAndStoreOrdered(1);
+    }
+
+    inline bool isDone() const { return m_done.fetchAndAddOrdered(0) != 0; }
+    inline void cancel() { m_cancel.fetchAndStoreOrdered(1); }
+
+    inline const GeoPolygonStore& level(int level) const { return m_levels[level]; }
+
+protected:
+
+    //! the points are referenced in the mapped GSHHS files
+    QVector<GeoDataSourcePolygon> m_source_polygons;
+    //! level 0 is not used
+    GeoPolygonStore m_levels[GEODATA_LOD_LEVEL_COUNT];
+
+    mutable QAtomicInt m_done;
+    QAtomicInt m_cancel;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+
+GeoData::GeoData() : 
+    m_active_filled(false), m_projection_epoch(0), m_use_stamp(0), m_level_task(0), m_level_task_filter_level(0), m_level_task_save_cache(false)
+{
+    m_level_thread_pool.setMaxThreadCount(1);
 }
 
 /////////////////////////////////////////////////////////////////////////////
 
 GeoData::~GeoData()
 {
+    closeSourceFiles();
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -51,148 +145,542 @@ GeoData::~GeoData()
 bool GeoData::readData(uint filter_level)
 {
     bool ret = true;
-    m_route_list.clear();
+    m_active_tiles.clear();
+    for(int level = 0; level < GEODATA_LOD_LEVEL_COUNT; ++level)
+    {
+        m_levels[level].polygons.clear();
+        m_levels[level].tile_parts.clear();
+        m_levels[level].tile_polygons.clear();
+        m_levels[level].active_polygons.clear();
+    }
+
+    closeSourceFiles();
+    m_tile_source_polygons.fill(QVector<int>(), GEODATA_TILE_ROWS * GEODATA_TILE_COLUMNS);
+    m_tile_use_stamp.fill(0, GEODATA_TILE_ROWS * GEODATA_TILE_COLUMNS);
+    m_use_stamp = 0;
+    m_levels[0].tile_parts.fill(QVector<GeoPolygon>(), GEODATA_TILE_ROWS * GEODATA_TILE_COLUMNS);
+    m_levels[0].tile_polygons.fill(QVector<int>(), GEODATA_TILE_ROWS * GEODATA_TILE_COLUMNS);
 
     QTime readtimer;
     readtimer.start();
 
-    long wpt_count = 0;
-
     QStringList::const_iterator iter = m_filename_list.begin();
-    for(; iter != m_filename_list.end(); ++iter)
+    for(; iter != m_filename_list.end(); ++iter) if (!indexSourceFile(*iter, filter_level)) ret = false;
+
+    Logger::log(QString("GeoData:readData: indexed %1 polygons in %2ms").
+                arg(m_source_polygons.count()).arg(readtimer.elapsed()));
+
+    // take the levels of detail from the cache or build them from all points
+
+    readtimer.restart();
+    if (m_source_polygons.isEmpty()) return ret;
+
+    if (ret && loadLevelCache(filter_level))
+    {
+        buildLevelTiles();
+        Logger::log(QString("GeoData:readData: setup levels of detail in %1ms").arg(readtimer.elapsed()));
+    }
+    else
+    {
+        // do not cache the levels of incomplete data
+        startLevelTask(filter_level, ret);
+    }
+
+    return ret;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void GeoData::buildLevelTiles()
+{
+    for(int level = 1; level < GEODATA_LOD_LEVEL_COUNT; ++level)
+    {
+        buildTiles(m_levels[level]);
+        Logger::log(QString("GeoData:buildLevelTiles: level %1 has %2 polygons with %3 points").
+                    arg(level).arg(m_levels[level].polygons.count()).arg(m_levels[level].polygons.pointCount()));
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void GeoData::startLevelTask(uint filter_level, bool save_cache)
+{
+    stopLevelTask();
+
+    Logger::log("GeoData:startLevelTask: building the levels of detail in the background");
+
+    m_level_task = new GeoDataLevelTask(m_source_polygons);
+    MYASSERT(m_level_task != 0);
+    m_level_task_filter_level = filter_level;
+    m_level_task_save_cache = save_cache;
+    m_level_thread_pool.start(m_level_task);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+bool GeoData::finishLevelTask()
+{
+    if (m_level_task == 0 || !m_level_task->isDone()) return false;
+    m_level_thread_pool.waitForDone();
+
+    for(int level = 1; level < GEODATA_LOD_LEVEL_COUNT; ++level) m_levels[level].polygons = m_level_task->level(level);
+
+    delete m_level_task;
+    m_level_task = 0;
+
+    buildLevelTiles();
+    if (m_level_task_save_cache) saveLevelCache(m_level_task_filter_level);
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void GeoData::stopLevelTask()
+{
+    if (m_level_task == 0) return;
+
+    m_level_task->cancel();
+    m_level_thread_pool.waitForDone();
+
+    delete m_level_task;
+    m_level_task = 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void GeoData::closeSourceFiles()
+{
+    // the level task reads the mapped files
+    stopLevelTask();
+
+    m_source_polygons.clear();
+    m_level0_source_polygons.clear();
+    m_tile_source_polygons.clear();
+    m_source_buffer_list.clear();
+
+    // closing the files unmaps them
+    qDeleteAll(m_source_file_list);
+    m_source_file_list.clear();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+bool GeoData::indexSourceFile(const QString& filename, uint filter_level)
+{
+    QFile* file = new QFile(VasPath::prependPath(filename));
+    MYASSERT(file != 0);
+
+    if (!file->exists())
+    {
+        Logger::log(QString("GeoData:indexSourceFile: file not found (%1)").arg(filename));
+        delete file;
+        return false;
+    }
+
+    if (!file->open(QIODevice::ReadOnly))
     {
-        QFile file(VasPath::prependPath(*iter));
-        if (!file.exists())
+        Logger::log(QString("GeoData:indexSourceFile: could not open file for reading (%1)").arg(filename));
+        delete file;
+        return false;
+    }
+
+    qint64 size = file->size();
+    const uchar* data = file->map(0, size);
+
+    if (data != 0)
+    {
+        m_source_file_list.append(file);
+    }
+    else
+    {
+        Logger::log(QString("GeoData:indexSourceFile: could not map file, reading it (%1)").arg(filename));
+        m_source_buffer_list.append(file->readAll());
+        delete file;
+        data = (const uchar*)m_source_buffer_list.last().constData();
+        size = m_source_buffer_list.last().size();
+    }
+
+    qint64 pos = 0;
+    while(pos < size)
+    {
+        if (pos + (qint64)sizeof(GSHHS) > size)
         {
-            Logger::log(QString("GeoData:readData: file not found (%1)").arg(*iter));
-            ret = false;
-            continue;
+            Logger::log(QString("GeoData:indexSourceFile: could not read GSHHS header at pos (%1)").arg(pos));
+            return false;
         }
 
-        if (!file.open(QIODevice::ReadOnly))
+        GSHHS header;
+        memcpy(&header, data + pos, sizeof(GSHHS));
+        pos += sizeof(GSHHS);
+
+        if (QSysInfo::ByteOrder == QSysInfo::LittleEndian)
         {
-            Logger::log(QString("GeoData:readData: could not open file for reading (%1)").arg(*iter));
-            ret = false;
-            continue;
+            header.id = swabi4 ((unsigned int)header.id);
+            header.n  = swabi4 ((unsigned int)header.n);
+            header.level = swabi4 ((unsigned int)header.level);
+            header.west  = swabi4 ((unsigned int)header.west);
+            header.east  = swabi4 ((unsigned int)header.east);
+            header.south = swabi4 ((unsigned int)header.south);
+            header.north = swabi4 ((unsigned int)header.north);
+        }
+
+        qint64 points_size = (qint64)header.n * sizeof(GSHHS_POINT);
+        if (header.n < 0 || pos + points_size > size)
+        {
+            Logger::log(QString("GeoData:indexSourceFile: invalid GSHHS point count (%1) at pos (%2)").
+                        arg(header.n).arg(pos));
+            return false;
         }
 
-        Route* current_route = 0;
+        const uchar* points = data + pos;
+        pos += points_size;
+
+        if (header.level > (int)filter_level || header.n < 2) continue;
+
+        GeoDataSourcePolygon source_polygon;
+        source_polygon.id = header.id;
+        source_polygon.level = header.level;
+        source_polygon.point_count = header.n;
+        source_polygon.points = points;
+        source_polygon.decoded = false;
+
+        int index = m_source_polygons.count();
+        m_source_polygons.append(source_polygon);
+
+        // register the polygon with all tiles of its extent, the extent
+        // is given in [0,360] or [-180,180] longitudes
+
+        int first_row = tileIndex(header.south, 0) / GEODATA_TILE_COLUMNS;
+        int last_row = tileIndex(header.north, 0) / GEODATA_TILE_COLUMNS;
 
-        while(!file.atEnd())
+        int first_column = 0;
+        int last_column = GEODATA_TILE_COLUMNS - 1;
+
+        if (header.east - header.west < 360000000 - GEODATA_TILE_SIZE)
         {
-            GSHHS header;
-            if (file.read((char*)&header, sizeof(GSHHS)) != sizeof(GSHHS))
-            {
-                Logger::log(QString("GeoData:readData: could not read GSHHS header at pos (%1)").arg(file.pos()));
-                ret = false;
-                break;
-            }
+            int west = (header.west > 180000000) ? header.west - 360000000 : header.west;
+            int east = (header.east > 180000000) ? header.east - 360000000 : header.east;
+            first_column = tileIndex(0, west) % GEODATA_TILE_COLUMNS;
+            last_column = tileIndex(0, east) % GEODATA_TILE_COLUMNS;
 
-            if (QSysInfo::ByteOrder == QSysInfo::LittleEndian)
-            {
-                header.id = swabi4 ((unsigned int)header.id);
-                header.n  = swabi4 ((unsigned int)header.n);
-                header.level = swabi4 ((unsigned int)header.level);
-                header.west  = swabi4 ((unsigned int)header.west);
-                header.east  = swabi4 ((unsigned int)header.east);
-                header.south = swabi4 ((unsigned int)header.south);
-                header.north = swabi4 ((unsigned int)header.north);
-                header.area  = swabi4 ((unsigned int)header.area);
-                header.version  = swabi4 ((unsigned int)header.version);
-                header.greenwich = swabi2 ((unsigned int)header.greenwich);
-                header.source = swabi2 ((unsigned int)header.source);
-            }
+            // across the date line
+            if (last_column < first_column) last_column += GEODATA_TILE_COLUMNS;
+        }
 
-            current_route = new Route(QString::number(header.id));
-            MYASSERT(current_route != 0);
-            m_route_list.append(current_route);
+        for(int row = first_row; row <= last_row; ++row)
+            for(int column = first_column; column <= last_column; ++column)
+                m_tile_source_polygons[row * GEODATA_TILE_COLUMNS + column % GEODATA_TILE_COLUMNS].append(index);
+    }
 
-            for(int wpt_index=0; wpt_index<header.n; ++wpt_index)
-            {
-                GSHHS_POINT point;
-                if (file.read((char*)&point, sizeof(GSHHS_POINT)) != sizeof(GSHHS_POINT))
-                {
-                    Logger::log(QString("GeoData:readData: could not read GSHHS point at pos (%1)").arg(file.pos()));
-                    ret = false;
-                    break;
-                }
+    return true;
+}
 
-                if (QSysInfo::ByteOrder == QSysInfo::LittleEndian)
-                {
-                    point.x = swabi4 ((unsigned int)point.x);
-                    point.y = swabi4 ((unsigned int)point.y);
-               }
-
-                if (header.level > (int)filter_level) continue;
-                
-                current_route->appendWaypoint(Waypoint("p", QString::null, point.lat(), point.lon(header.greenwich)));
-                ++wpt_count;
+/////////////////////////////////////////////////////////////////////////////
+
+void GeoData::decodePoints(const uchar* data, int count, int* lat_lon)
+{
+    // the mapped data may not be aligned
+    memcpy(lat_lon, data, count * sizeof(GSHHS_POINT));
+
+    int word_count = 2 * count;
+    quint32* words = (quint32*)lat_lon;
+
+    if (QSysInfo::ByteOrder == QSysInfo::LittleEndian)
+    {
+        int index = 0;
+
+#ifdef GEODATA_USE_SSE2
+        // swap four words at once, first the bytes of each half word,
+        // then the half words of each word
+        for(; index + 4 <= word_count; index += 4)
+        {
+            __m128i value = _mm_loadu_si128((const __m128i*)(words + index));
+            value = _mm_or_si128(_mm_slli_epi16(value, 8), _mm_srli_epi16(value, 8));
+            value = _mm_shufflelo_epi16(value, _MM_SHUFFLE(2,3,0,1));
+            value = _mm_shufflehi_epi16(value, _MM_SHUFFLE(2,3,0,1));
+            _mm_storeu_si128((__m128i*)(words + index), value);
+        }
+#endif
+
+        for(; index < word_count; ++index) words[index] = swabi4(words[index]);
+    }
+
+    // x/y to lat/lon
+    for(int index = 0; index < word_count; index += 2)
+    {
+        int x = lat_lon[index];
+        lat_lon[index] = lat_lon[index+1];
+        lat_lon[index+1] = (x > 180000000) ? x - 360000000 : x;
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void GeoData::decodeSourcePolygon(int index)
+{
+    GeoDataSourcePolygon& source_polygon = m_source_polygons[index];
+    if (source_polygon.decoded) return;
+    source_polygon.decoded = true;
+
+    m_point_buffer.resize(2 * source_polygon.point_count);
+    decodePoints(source_polygon.points, source_polygon.point_count, m_point_buffer.data());
+
+    GeoDataLevel& level = m_levels[0];
+    int polygon_index = level.polygons.count();
+
+    level.polygons.startPolygon(source_polygon.id, source_polygon.level);
+    level.polygons.appendPoints(m_point_buffer.constData(), source_polygon.point_count);
+    level.polygons.finishPolygon();
+
+    if (level.polygons.count() > polygon_index)
+    {
+        m_level0_source_polygons.append(index);
+        splitPolygon(level, polygon_index);
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void GeoData::decodeTile(int tile)
+{
+    if (m_tile_use_stamp[tile] == 0)
+    {
+        const QVector<int>& source_polygons = m_tile_source_polygons[tile];
+        for(int index = 0; index < source_polygons.count(); ++index) decodeSourcePolygon(source_polygons[index]);
+    }
+
+    m_tile_use_stamp[tile] = m_use_stamp;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void GeoData::evictTiles()
+{
+    // the decoded tiles out of range, the least recently used first
+
+    QList< QPair<uint, int> > cached_tiles;
+    for(int tile = 0; tile < m_tile_use_stamp.count(); ++tile)
+        if (m_tile_use_stamp[tile] != 0 && m_tile_use_stamp[tile] != m_use_stamp) 
+            cached_tiles.append(qMakePair(m_tile_use_stamp[tile], tile));
+
+    if (cached_tiles.count() <= GEODATA_MAX_CACHED_TILES) return;
+
+    // evict down to the half, so this does not happen with every tile
+    qSort(cached_tiles);
+    int evict_count = cached_tiles.count() - GEODATA_MAX_CACHED_TILES / 2;
+    for(int index = 0; index < evict_count; ++index) m_tile_use_stamp[cached_tiles[index].second] = 0;
+
+    // keep the source polygons of the remaining tiles
+
+    for(int index = 0; index < m_source_polygons.count(); ++index) m_source_polygons[index].decoded = false;
+
+    for(int tile = 0; tile < m_tile_use_stamp.count(); ++tile)
+    {
+        if (m_tile_use_stamp[tile] == 0) continue;
+        const QVector<int>& source_polygons = m_tile_source_polygons[tile];
+        for(int index = 0; index < source_polygons.count(); ++index) m_source_polygons[source_polygons[index]].decoded = true;
+    }
+
+    GeoDataLevel& level = m_levels[0];
+    GeoPolygonStore polygons;
+    QVector<int> level0_source_polygons;
+
+    for(int index = 0; index < level.polygons.count(); ++index)
+    {
+        int source_index = m_level0_source_polygons[index];
+        if (!m_source_polygons[source_index].decoded) continue;
+
+        polygons.appendPolygon(level.polygons.polygon(index), level.polygons);
+        level0_source_polygons.append(source_index);
+    }
+
+    level.polygons = polygons;
+    m_level0_source_polygons = level0_source_polygons;
+    buildTiles(level);
+
+    Logger::log(QString("GeoData:evictTiles: evicted %1 tiles, %2 polygons with %3 points left").
+                arg(evict_count).arg(level.polygons.count()).arg(level.polygons.pointCount()));
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+int GeoData::tileIndex(int lat, int lon)
+{
+    int row = qMax(0, qMin(GEODATA_TILE_ROWS-1, (lat + 90000000) / GEODATA_TILE_SIZE));
+    int column = qMax(0, qMin(GEODATA_TILE_COLUMNS-1, (lon + 180000000) / GEODATA_TILE_SIZE));
+    return row * GEODATA_TILE_COLUMNS + column;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void GeoData::splitPolygon(GeoDataLevel& level, int polygon_index)
+{
+    const GeoPolygonStore& polygons = level.polygons;
+    const GeoPolygon& polygon = polygons.polygon(polygon_index);
+    const int* lat = polygons.latArray();
+    const int* lon = polygons.lonArray();
+
+    int point_end = polygon.first_point + polygon.point_count;
+    int part_start = polygon.first_point;
+    int part_tile = tileIndex(lat[part_start], lon[part_start]);
+
+    for(int point = polygon.first_point + 1; point <= point_end; ++point)
+    {
+        int tile = (point < point_end) ? tileIndex(lat[point], lon[point]) : -1;
+        if (tile == part_tile) continue;
+
+        GeoPolygon part = polygon;
+        part.first_point = part_start;
+        part.point_count = point - part_start;
+
+        if (part.point_count >= 2)
+        {
+            part.south = part.north = lat[part_start];
+            part.west = part.east = lon[part_start];
+            for(int part_point = part_start+1; part_point < point; ++part_point)
+            {
+                part.south = qMin(part.south, lat[part_point]);
+                part.north = qMax(part.north, lat[part_point]);
+                part.west = qMin(part.west, lon[part_point]);
+                part.east = qMax(part.east, lon[part_point]);
             }
+
+            level.tile_parts[part_tile].append(part);
+
+            // a polygon may enter a tile more than once
+            QVector<int>& tile_polygons = level.tile_polygons[part_tile];
+            if (!tile_polygons.contains(polygon_index)) tile_polygons.append(polygon_index);
         }
+
+        // the next part starts with the last point of this one
+        part_start = point - 1;
+        part_tile = tile;
     }
+}
 
-    Logger::log(QString("GeoData:readData: added %1 waypoints in %2ms").arg(wpt_count).arg(readtimer.elapsed()));
-    return ret;
+/////////////////////////////////////////////////////////////////////////////
+
+void GeoData::buildTiles(GeoDataLevel& level)
+{
+    level.tile_parts.fill(QVector<GeoPolygon>(), GEODATA_TILE_ROWS * GEODATA_TILE_COLUMNS);
+    level.tile_polygons.fill(QVector<int>(), GEODATA_TILE_ROWS * GEODATA_TILE_COLUMNS);
+
+    int max = level.polygons.count();
+    for(int index=0; index<max; ++index) splitPolygon(level, index);
 }
 
 /////////////////////////////////////////////////////////////////////////////
 
-void GeoData::updateActiveRouteList(const Waypoint& center, int max_dist_nm)
+void GeoData::getTilesInRange(const Waypoint& center, int max_dist_nm, QVector<int>& tiles) const
 {
-    m_active_route_list.clear();
+    tiles.clear();
 
-    QTime geotime;
-    geotime.start();
+    // planar test in degrees with the longitude scaled by the latitude,
+    // the tile edge nearest to the pole is used to stay on the safe side
+
+    double max_dist_deg = max_dist_nm / 60.0;
+    bool includes_pole = qAbs(center.lat()) + max_dist_deg >= 90.0;
+    double tile_size_deg = GEODATA_TILE_SIZE * 1.0e-6;
 
-    uint max = m_route_list.count();
-    for(uint index=0; index<max; ++index)
+    int first_row = tileIndex((int)(qMax(-90.0, center.lat() - max_dist_deg) * 1.0e6), 0) / GEODATA_TILE_COLUMNS;
+    int last_row = tileIndex((int)(qMin(90.0, center.lat() + max_dist_deg) * 1.0e6), 0) / GEODATA_TILE_COLUMNS;
+
+    for(int row = first_row; row <= last_row; ++row)
     {
-        Route* copy_route = new Route;
-        MYASSERT(copy_route != 0);
+        double south = row * tile_size_deg - 90.0;
+        double north = south + tile_size_deg;
+        double lat_dist = qMax(0.0, qMax(south - center.lat(), center.lat() - north));
+        if (lat_dist > max_dist_deg) continue;
+
+        double lon_dist = 180.0;
+        if (!includes_pole)
+        {
+            double cos_lat = cos(Navcalc::toRad(qMax(qAbs(south), qAbs(north))));
+            if (cos_lat > 0.0) lon_dist = sqrt(max_dist_deg*max_dist_deg - lat_dist*lat_dist) / cos_lat;
+        }
 
-        const Waypoint* prev_wpt = 0;
-        bool out_of_range = false;
+        int first_column = (int)floor((center.lon() - lon_dist + 180.0) / tile_size_deg);
+        int last_column = (int)floor((center.lon() + lon_dist + 180.0) / tile_size_deg);
 
-        WaypointPtrListIterator wpt_iter(m_route_list.at(index)->waypointList());
-        while(wpt_iter.hasNext()) 
+        // near the antimeridian the wrapped range may cover a column twice
+        if (lon_dist >= 180.0 || last_column - first_column + 1 >= GEODATA_TILE_COLUMNS)
         {
-            const Waypoint* wpt = wpt_iter.next();
+            for(int column = 0; column < GEODATA_TILE_COLUMNS; ++column) tiles.append(row * GEODATA_TILE_COLUMNS + column);
+            continue;
+        }
 
-            if (out_of_range)
-            {
-                if (Navcalc::getDistBetweenWaypoints(center, *wpt) > max_dist_nm)
-                {
-                    prev_wpt = wpt;
+        for(int column = first_column; column <= last_column; ++column)
+            tiles.append(row * GEODATA_TILE_COLUMNS + (column + GEODATA_TILE_COLUMNS) % GEODATA_TILE_COLUMNS);
+    }
 
-                    if (copy_route != 0)
-                    {
-                        if (copy_route->count() < 2)  delete copy_route;
-                        else                          m_active_route_list.append(copy_route);
-                        copy_route = 0;
-                    }
+    qSort(tiles);
+}
 
-                    continue;
-                }
+/////////////////////////////////////////////////////////////////////////////
 
-                if (copy_route == 0)
-                {
-                    copy_route = new Route();
-                    MYASSERT(copy_route != 0);
-                }
+void GeoData::updateActiveRouteList(const Waypoint& center, int max_dist_nm, bool filled)
+{
+    QTime geotime;
+    geotime.start();
 
-                if (prev_wpt != 0) copy_route->appendWaypoint(*prev_wpt);
-                prev_wpt = 0;
-                out_of_range = false;
+    // the levels of detail built in the background replace level 0
+    if (finishLevelTask()) m_active_tiles.clear();
+
+    QVector<int> tiles;
+    getTilesInRange(center, max_dist_nm, tiles);
+    if (tiles == m_active_tiles && filled == m_active_filled) return;
+
+    m_active_tiles = tiles;
+    m_active_filled = filled;
+
+    // decode the full resolution polygons of the tiles on first use and
+    // drop the ones not used for a while
+    ++m_use_stamp;
+    QVector<int>::const_iterator iter = m_active_tiles.begin();
+    for(; iter != m_active_tiles.end(); ++iter) decodeTile(*iter);
+    evictTiles();
+
+    for(int level_index = 0; level_index < GEODATA_LOD_LEVEL_COUNT; ++level_index)
+    {
+        GeoDataLevel& level = m_levels[level_index];
+        level.active_polygons.clear();
+        if (level.tile_parts.isEmpty()) continue;
+
+        if (filled)
+        {
+            // the whole polygons, every polygon only once
+            QVector<int> polygon_indexes;
+            for(iter = m_active_tiles.begin(); iter != m_active_tiles.end(); ++iter)
+                polygon_indexes += level.tile_polygons[*iter];
+            qSort(polygon_indexes);
+
+            int last_index = -1;
+            for(int index = 0; index < polygon_indexes.count(); ++index)
+            {
+                if (polygon_indexes[index] == last_index) continue;
+                last_index = polygon_indexes[index];
+                level.active_polygons.appendPolygon(level.polygons.polygon(last_index), level.polygons);
             }
 
-            copy_route->appendWaypoint(*wpt);
-            out_of_range = Navcalc::getDistBetweenWaypoints(center, *wpt) > max_dist_nm;
+            continue;
+        }
+
+        int part_count = 0;
+        int point_count = 0;
+        for(iter = m_active_tiles.begin(); iter != m_active_tiles.end(); ++iter)
+        {
+            const QVector<GeoPolygon>& parts = level.tile_parts[*iter];
+            part_count += parts.count();
+            for(int part = 0; part < parts.count(); ++part) point_count += parts[part].point_count;
         }
 
-        if (copy_route != 0)
+        level.active_polygons.reserve(part_count, point_count);
+
+        for(iter = m_active_tiles.begin(); iter != m_active_tiles.end(); ++iter)
         {
-            if (copy_route->count() < 2)  delete copy_route;
-            else                          m_active_route_list.append(copy_route);
+            const QVector<GeoPolygon>& parts = level.tile_parts[*iter];
+            for(int part = 0; part < parts.count(); ++part)
+                level.active_polygons.appendPolygon(parts[part], level.polygons);
         }
     }
 
@@ -203,24 +691,215 @@ void GeoData::updateActiveRouteList(const Waypoint& center, int max_dist_nm)
 
 /////////////////////////////////////////////////////////////////////////////
 
-void GeoData::calcProjection(const ProjectionBase& projection)
+void GeoData::calcProjectionActiveRoute(const ProjectionBase& projection)
 {
 //     QTime geotime;
 //     geotime.start();
-    uint max = m_route_list.count();
-    for(uint index=0; index<max; ++index) m_route_list.at(index)->calcProjection(projection);
-    //Logger::log(QString("GeoData:calcProjection: processed projection in %1ms").arg(geotime.elapsed()));
+    for(int level = 0; level < GEODATA_LOD_LEVEL_COUNT; ++level)
+    {
+        if (m_drawn_levels[level].fetchAndAddOrdered(0) == 0) continue;
+
+        // levels not built yet are drawn from level 0, see activePolygons()
+        GeoPolygonStore& polygons = m_levels[isLevelBuilt(level) ? level : 0].active_polygons;
+        if (polygons.isProjected() && polygons.projectionEpoch() == projection.epoch()) continue;
+        polygons.calcProjection(projection);
+    }
+
+    // levels no longer drawn are dropped with the next epoch
+    if (m_projection_epoch != projection.epoch())
+    {
+        for(int level = 0; level < GEODATA_LOD_LEVEL_COUNT; ++level) m_drawn_levels[level].fetchAndStoreOrdered(0);
+        m_projection_epoch = projection.epoch();
+    }
+    //Logger::log(QString("GeoData:calcProjectionActiveRoute: processed projection in %1ms").arg(geotime.elapsed()));
 }
 
 /////////////////////////////////////////////////////////////////////////////
 
-void GeoData::calcProjectionActiveRoute(const ProjectionBase& projection)
+double GeoData::levelToleranceNm(int level)
 {
-//     QTime geotime;
-//     geotime.start();
-    uint max = m_active_route_list.count();
-    for(uint index=0; index<max; ++index) m_active_route_list.at(index)->calcProjection(projection);
-    //Logger::log(QString("GeoData:calcProjectionActiveRoute: processed projection in %1ms").arg(geotime.elapsed()));
+    MYASSERT(level >= 0 && level < GEODATA_LOD_LEVEL_COUNT);
+    if (level == 0) return 0.0;
+
+    // 0.06nm for level 1, every further level is four times coarser
+    return GEODATA_LOD_BASE_TOLERANCE * 1.0e-6 * 60.0 * (1 << (2*(level-1)));
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+int GeoData::levelForResolution(double nm_per_pixel)
+{
+    for(int level = GEODATA_LOD_LEVEL_COUNT-1; level > 0; --level)
+        if (levelToleranceNm(level) <= nm_per_pixel) return level;
+    return 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void GeoData::simplify(const GeoPolygonStore& source, int tolerance, GeoPolygonStore& target)
+{
+    const int* lat = source.latArray();
+    const int* lon = source.lonArray();
+    double max_dist_sq = (double)tolerance * tolerance;
+
+    QVector<char> keep;
+    QVector<int> stack;
+
+    int max = source.count();
+    for(int index=0; index<max; ++index)
+    {
+        const GeoPolygon& polygon = source.polygon(index);
+        if (polygon.north - polygon.south < tolerance && polygon.east - polygon.west < tolerance) continue;
+
+        int first = polygon.first_point;
+        int count = polygon.point_count;
+
+        keep.fill(0, count);
+        keep[0] = keep[count-1] = 1;
+
+        stack.clear();
+        stack.append(0);
+        stack.append(count-1);
+
+        while(!stack.isEmpty())
+        {
+            int start = stack[stack.count()-2];
+            int end = stack[stack.count()-1];
+            stack.resize(stack.count()-2);
+
+            double start_lat = lat[first+start];
+            double start_lon = lon[first+start];
+            double seg_lat = lat[first+end] - start_lat;
+            double seg_lon = lon[first+end] - start_lon;
+            double seg_len_sq = seg_lat*seg_lat + seg_lon*seg_lon;
+
+            int farthest = -1;
+            double farthest_dist_sq = max_dist_sq;
+
+            for(int point = start+1; point < end; ++point)
+            {
+                double point_lat = lat[first+point] - start_lat;
+                double point_lon = lon[first+point] - start_lon;
+
+                double dist_sq = 0.0;
+                if (seg_len_sq <= 0.0)
+                {
+                    // closed rings start and end at the same point
+                    dist_sq = point_lat*point_lat + point_lon*point_lon;
+                }
+                else
+                {
+                    double cross = point_lat*seg_lon - point_lon*seg_lat;
+                    dist_sq = cross*cross / seg_len_sq;
+                }
+
+                if (dist_sq <= farthest_dist_sq) continue;
+                farthest = point;
+                farthest_dist_sq = dist_sq;
+            }
+
+            if (farthest < 0) continue;
+
+            keep[farthest] = 1;
+            stack.append(start);
+            stack.append(farthest);
+            stack.append(farthest);
+            stack.append(end);
+        }
+
+        target.startPolygon(polygon.id, polygon.level);
+        for(int point = 0; point < count; ++point)
+            if (keep[point]) target.appendPoint(lat[first+point], lon[first+point]);
+        target.finishPolygon();
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+QString GeoData::levelCacheFilename() const
+{
+    MYASSERT(!m_filename_list.isEmpty());
+    return VasPath::prependPath(m_filename_list.first()) + ".lod";
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+QByteArray GeoData::levelCacheKey(uint filter_level) const
+{
+    QByteArray key;
+    QDataStream stream(&key, QIODevice::WriteOnly);
+
+    stream << (quint32)filter_level << (qint32)GEODATA_LOD_BASE_TOLERANCE;
+
+    QStringList::const_iterator iter = m_filename_list.begin();
+    for(; iter != m_filename_list.end(); ++iter)
+    {
+        QFileInfo info(VasPath::prependPath(*iter));
+        stream << *iter << (qint64)info.size() << (quint32)info.lastModified().toTime_t();
+    }
+
+    return key;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+bool GeoData::loadLevelCache(uint filter_level)
+{
+    QFile file(levelCacheFilename());
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    QDataStream stream(&file);
+
+    quint32 magic = 0;
+    qint32 version = 0;
+    qint32 byte_order = 0;
+    QByteArray key;
+    qint32 level_count = 0;
+    stream >> magic >> version >> byte_order >> key >> level_count;
+
+    if (stream.status() != QDataStream::Ok ||
+        magic != GEODATA_LOD_CACHE_MAGIC || version != GEODATA_LOD_CACHE_VERSION ||
+        byte_order != QSysInfo::ByteOrder || level_count != GEODATA_LOD_LEVEL_COUNT ||
+        key != levelCacheKey(filter_level))
+    {
+        Logger::log(QString("GeoData:loadLevelCache: %1 is outdated").arg(file.fileName()));
+        return false;
+    }
+
+    for(int level = 1; level < GEODATA_LOD_LEVEL_COUNT; ++level)
+    {
+        if (m_levels[level].polygons.load(stream)) continue;
+
+        Logger::log(QString("GeoData:loadLevelCache: could not read level %1 from %2").arg(level).arg(file.fileName()));
+        for(level = 1; level < GEODATA_LOD_LEVEL_COUNT; ++level) m_levels[level].polygons.clear();
+        return false;
+    }
+
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+bool GeoData::saveLevelCache(uint filter_level) const
+{
+    QFile file(levelCacheFilename());
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        Logger::log(QString("GeoData:saveLevelCache: could not open %1 for writing").arg(file.fileName()));
+        return false;
+    }
+
+    QDataStream stream(&file);
+    stream << (quint32)GEODATA_LOD_CACHE_MAGIC << (qint32)GEODATA_LOD_CACHE_VERSION
+           << (qint32)QSysInfo::ByteOrder << levelCacheKey(filter_level) << (qint32)GEODATA_LOD_LEVEL_COUNT;
+
+    for(int level = 1; level < GEODATA_LOD_LEVEL_COUNT; ++level) m_levels[level].polygons.save(stream);
+
+    if (stream.status() == QDataStream::Ok) return true;
+
+    Logger::log(QString("GeoData:saveLevelCache: could not write %1").arg(file.fileName()));
+    file.remove();
+    return false;
 }
 
 // End of file
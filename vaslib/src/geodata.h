@@ -25,12 +25,48 @@
 #ifndef GEODATA_H
 #define GEODATA_H
 
+#include <QAtomicInt>
+#include <QByteArray>
+#include <QFile>
+#include <QList>
 #include <QObject>
 #include <QStringList>
+#include <QThreadPool>
+#include <QVector>
 
-#include "route.h"
+#include "waypoint.h"
+#include "geo_polygon_store.h"
 
 class ProjectionBase;
+class GeoDataLevelTask;
+
+/////////////////////////////////////////////////////////////////////////////
+
+//! number of levels of detail, level 0 holds the full resolution
+#define GEODATA_LOD_LEVEL_COUNT 5
+
+//! polygons of one level of detail, split into tiles
+struct GeoDataLevel
+{
+    GeoPolygonStore polygons;
+    //! polygon parts of every tile, referencing the points of the polygons
+    QVector< QVector<GeoPolygon> > tile_parts;
+    //! indexes of the polygons with parts in every tile
+    QVector< QVector<int> > tile_polygons;
+    //! the parts of the tiles in range, or the whole polygons when filled
+    GeoPolygonStore active_polygons;
+};
+
+//! a not yet decoded polygon of a memory mapped GSHHS file
+struct GeoDataSourcePolygon
+{
+    int id;
+    int level;
+    int point_count;
+    //! big endian GSHHS points within the mapped file
+    const uchar* points;
+    bool decoded;
+};
 
 /////////////////////////////////////////////////////////////////////////////
 
@@ -49,25 +85,153 @@ public:
     //! Filenames shall be specified as relative paths (relative to vasFMC directory)
     void setFilenames(const QStringList& filename_list) { m_filename_list = filename_list; }
 
+    //! Maps the GSHHS files and indexes the polygon headers, the points of
+    //! the full resolution are decoded when a tile in range needs them.
+    //! The simplified levels of detail are cached in a ".lod" file next to
+    //! the first GSHHS file. When the cache is outdated, they are built
+    //! from all points in the background and the full resolution is used
+    //! until they are ready.
     //! filter_level = 1 land, 2 lake, 3 island_in_lake, 4 pond_in_island_in_lake
     bool readData(uint filter_level);
 
-    inline const RoutePtrList& routeList() const { return m_route_list; }
-    void calcProjection(const ProjectionBase& projection);
-
-    void updateActiveRouteList(const Waypoint& center, int max_dist_nm);
-    inline const RoutePtrList& activeRouteList() const { return m_active_route_list; }
+    //! All polygons at the given level of detail, level 0 only holds the
+    //! polygons of the tiles decoded at the moment.
+    inline const GeoPolygonStore& polygons(int level = 0) const
+    { MYASSERT(level >= 0 && level < GEODATA_LOD_LEVEL_COUNT); return m_levels[level].polygons; }
+
+    //! Collects the polygon parts of all tiles within the given distance of
+    //! the center into the active polygons of every level. When "filled"
+    //! is set, the whole polygons touching these tiles are collected
+    //! instead, because the parts can not be filled. The active polygons
+    //! are only rebuilt (and signalActiveRouteChanged() emitted) when a
+    //! tile enters or leaves the range or "filled" changes. The full
+    //! resolution of the tiles which left the range is dropped when it
+    //! was not used for a while.
+    void updateActiveRouteList(const Waypoint& center, int max_dist_nm, bool filled = false);
+    //! returns the active polygons of level 0 while the given level is not built yet
+    inline const GeoPolygonStore& activePolygons(int level = 0) const
+    {
+        MYASSERT(level >= 0 && level < GEODATA_LOD_LEVEL_COUNT);
+        return isLevelBuilt(level) ? m_levels[level].active_polygons : m_levels[0].active_polygons;
+    }
+    inline bool isLevelBuilt(int level) const { return !m_levels[level].tile_parts.isEmpty(); }
+    //! returns true when the active polygons are whole polygons which may be filled
+    inline bool activePolygonsFilled() const { return m_active_filled; }
+    //! Marks the given level of detail as drawn, may be called from any
+    //! thread. Only the active polygons of drawn levels are projected.
+    inline void setLevelDrawn(int level) const
+    {
+        MYASSERT(level >= 0 && level < GEODATA_LOD_LEVEL_COUNT);
+        m_drawn_levels[level].fetchAndStoreOrdered(1);
+    }
+    //! Projects the active polygons of the levels drawn since the last
+    //! epoch change, when not yet projected with the current epoch of the
+    //! given projection. Levels which become drawn are projected with the
+    //! next call.
     void calcProjectionActiveRoute(const ProjectionBase& projection);
 
+    //! returns the simplification tolerance of the given level in NM
+    static double levelToleranceNm(int level);
+
+    //! Returns the coarsest level of detail whose error stays below one
+    //! pixel, when one pixel covers the given distance.
+    static int levelForResolution(double nm_per_pixel);
+
 signals:
 
     void signalActiveRouteChanged();
 
+protected:
+
+    friend class GeoDataLevelTask;
+
+    //! returns the index of the tile containing the given point (micro-degrees)
+    static int tileIndex(int lat, int lon);
+
+    //! Splits the given polygon of the given level into parts per tile,
+    //! every part starts with the last point of the previous part, so the
+    //! parts stay connected. The polygon is registered with the tiles of
+    //! its parts.
+    static void splitPolygon(GeoDataLevel& level, int polygon_index);
+
+    //! splits all polygons of the given level into tiles
+    void buildTiles(GeoDataLevel& level);
+
+    void closeSourceFiles();
+
+    //! maps the given GSHHS file and indexes its polygon headers
+    bool indexSourceFile(const QString& filename, uint filter_level);
+
+    //! decodes the given source polygon into level 0, if not done yet
+    void decodeSourcePolygon(int index);
+
+    //! decodes the source polygons of the given tile and marks it as used
+    void decodeTile(int tile);
+
+    //! Drops the least recently used decoded tiles out of range from level
+    //! 0, when there are more than GEODATA_MAX_CACHED_TILES of them.
+    void evictTiles();
+
+    //! Copies the given number of big endian GSHHS points from "data" to
+    //! "lat_lon" as host order lat/lon pairs with the lon within [-180,180].
+    static void decodePoints(const uchar* data, int count, int* lat_lon);
+
+    //! returns the sorted indexes of the tiles within the given distance
+    void getTilesInRange(const Waypoint& center, int max_dist_nm, QVector<int>& tiles) const;
+
+    //! Appends the polygons of "source" simplified with the given tolerance
+    //! (micro-degrees, Douglas-Peucker) to "target". Polygons smaller than
+    //! the tolerance are dropped.
+    static void simplify(const GeoPolygonStore& source, int tolerance, GeoPolygonStore& target);
+
+    QString levelCacheFilename() const;
+    //! returns a key of the sizes and modification times of the GSHHS files
+    QByteArray levelCacheKey(uint filter_level) const;
+    bool loadLevelCache(uint filter_level);
+    bool saveLevelCache(uint filter_level) const;
+
+    //! splits the levels of detail into tiles
+    void buildLevelTiles();
+
+    //! starts building the levels of detail from all source polygons in the background
+    void startLevelTask(uint filter_level, bool save_cache);
+    //! takes over the levels of a finished level task, returns true if so
+    bool finishLevelTask();
+    //! cancels a running level task and waits for it
+    void stopLevelTask();
+
 protected:
 
     QStringList m_filename_list;
-    RoutePtrList m_route_list;
-    RoutePtrList m_active_route_list;
+    GeoDataLevel m_levels[GEODATA_LOD_LEVEL_COUNT];
+
+    //! the tiles of the active polygons
+    QVector<int> m_active_tiles;
+    bool m_active_filled;
+
+    //! levels drawn since the last epoch change, see setLevelDrawn()
+    mutable QAtomicInt m_drawn_levels[GEODATA_LOD_LEVEL_COUNT];
+    uint m_projection_epoch;
+
+    //! the mapped GSHHS files
+    QList<QFile*> m_source_file_list;
+    //! contents of the files which could not be mapped
+    QList<QByteArray> m_source_buffer_list;
+    QVector<GeoDataSourcePolygon> m_source_polygons;
+    //! indexes of the source polygons overlapping every tile
+    QVector< QVector<int> > m_tile_source_polygons;
+    //! index of the source polygon of every polygon of level 0
+    QVector<int> m_level0_source_polygons;
+    //! last use of every tile whose source polygons are decoded, 0 if not decoded
+    QVector<uint> m_tile_use_stamp;
+    uint m_use_stamp;
+
+    QThreadPool m_level_thread_pool;
+    GeoDataLevelTask* m_level_task;
+    uint m_level_task_filter_level;
+    bool m_level_task_save_cache;
+    //! decode buffer
+    QVector<int> m_point_buffer;
     
 private:
     //! Hidden copy-constructor
@@ -30,6 +30,7 @@
 
 #include "serialization_iface.h"
 #include "assert.h"
+#include "sim_clock.h"
 
 //! Holding definitions
 class Holding 
@@ -181,7 +182,7 @@ protected:
     int m_true_target_track;
     bool m_turn_to_target_track_with_left_turn;
     Status m_status;
-    QTime m_timer;
+    SimTimer m_timer;
     EntryType m_entry_type;
     double m_inbd_track_lat;
     double m_inbd_track_lon;
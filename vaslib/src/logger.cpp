@@ -78,14 +78,18 @@ void Logger::setLogFile(const QString& logfilename)
 void Logger::logText(const QString& text)
 {
     QString logtext = QString("%1: %2").arg(QDateTime::currentDateTime().toString("yyyy.MM.dd hh:mm:ss:zzz")).arg(text);
-    
-    // write out the text
-    printf("%s\n", logtext.toLatin1().data());
-    fflush(stdout);
-    
-    // write the text to the logfile
-    if (m_logfilestream != 0) *m_logfilestream << logtext << endl;
-    
+
+    {
+        QMutexLocker locker(&m_mutex);
+
+        // write out the text
+        printf("%s\n", logtext.toLatin1().data());
+        fflush(stdout);
+
+        // write the text to the logfile
+        if (m_logfilestream != 0) *m_logfilestream << logtext << endl;
+    }
+
     emit signalLogging(logtext);
 }
 
@@ -94,7 +98,9 @@ void Logger::logText(const QString& text)
 void Logger::logTextToFileOnly(const QString& text)
 {
     QString logtext = QString("%1: %2").arg(QDateTime::currentDateTime().toString("yyyy.MM.dd hh:mm:ss:zzz")).arg(text);
-    
+
+    QMutexLocker locker(&m_mutex);
+
     // write the text to the logfile
     if (m_logfilestream != 0) *m_logfilestream << logtext << endl;
 }
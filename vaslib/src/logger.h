@@ -31,6 +31,7 @@
 #include <QTextStream>
 #include <QObject>
 #include <QDateTime>
+#include <QMutex>
 
 #include "assert.h"
 
@@ -86,6 +87,9 @@ protected:
     QFile* m_logfile;
     QTextStream* m_logfilestream;
 
+    //! serializes the logging of multiple threads
+    QMutex m_mutex;
+
 private:
     //! Hidden copy-constructor
     Logger(const Logger&);
@@ -25,15 +25,22 @@
 #ifndef MEANVALUE_H
 #define MEANVALUE_H
 
+#include <QVector>
+
 /////////////////////////////////////////////////////////////////////////////
 
-//! mean value
+//! Running mean value over a fixed number of values, which are kept in a
+//! ring buffer. The sum is recalculated every time the ring wraps around,
+//! so rounding errors of the running updates do not accumulate.
 template <class TYPE> class MeanValue 
 {
 public:
     //! Standard Constructor
-    MeanValue(uint length, const TYPE& init_value) : m_length(length), m_mean_value(init_value), m_mean_init_value(init_value)
-    {};
+    MeanValue(uint length, const TYPE& init_value) : 
+        m_length(length), m_count(0), m_next_slot(0), m_mean_value(init_value), m_mean_init_value(init_value)
+    {
+        m_value_list.resize(m_length);
+    };
 
     //! Destructor
     virtual ~MeanValue()
@@ -42,13 +49,20 @@ public:
     //! calculates the new mean value with the given value
     inline void add(const TYPE& value) 
     { 
-        if (m_value_list.count() >= (int)m_length)
+        if (m_count >= m_length) m_mean_value -= m_value_list[m_next_slot] / m_length;
+        else                     ++m_count;
+
+        m_value_list[m_next_slot] = value;
+        m_mean_value += value / m_length;
+
+        if (++m_next_slot >= m_length)
         {
-            m_mean_value -= m_value_list.first() / m_length;
-            m_value_list.removeFirst();
+            m_next_slot = 0;
+
+            TYPE mean_value = m_mean_init_value;
+            for(uint index=0; index<m_length; ++index) mean_value += m_value_list[index] / m_length;
+            m_mean_value = mean_value;
         }
-        m_value_list.append(value); 
-        m_mean_value += value / m_length;
     }
 
     //! returns the calculated mean value
@@ -56,14 +70,17 @@ public:
 
     void clear()
     {
-        m_value_list.clear();
+        m_count = 0;
+        m_next_slot = 0;
         m_mean_value = m_mean_init_value;
     }
 
 protected:
 
-    QList<TYPE> m_value_list;
+    QVector<TYPE> m_value_list;
     uint m_length;
+    uint m_count;
+    uint m_next_slot;
     TYPE m_mean_value;
     TYPE m_mean_init_value;
 };
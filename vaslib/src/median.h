@@ -25,58 +25,140 @@
 #ifndef MEDIAN_H
 #define MEDIAN_H
 
+#include <QVector>
+
 #include "assert.h"
-#include "navcalc.h"
 
 /////////////////////////////////////////////////////////////////////////////
 
-//! mean value
+//! Sliding window median. The window is kept in a ring buffer and is
+//! always full (initially with the init value). The ring slots are ordered
+//! by two heaps, a max heap holding the lower half of the window and a min
+//! heap holding the upper half, so adding a value costs O(log n) and the
+//! median is the top of the lower heap. For even lengths the upper one of
+//! the two middle values is returned.
 template <class TYPE> class Median 
 {
 public:
     //! Standard Constructor
     Median(uint length, const TYPE& init_value) : 
-        m_init_value(init_value), m_middle_index(Navcalc::round(length/2.0)), m_length(length)
+        m_init_value(init_value), m_length(length), m_low_count(length/2 + 1), m_oldest_slot(0)
     {
-        for(uint index=0; index<length; ++index) m_value_list.append(init_value);
-        m_sorted_list = m_value_list;
+        MYASSERT(length > 0);
+        clear();
     };
 
     //! Destructor
     virtual ~Median()
     {};
 
-    //! calculates the new mean value with the given value
+    //! replaces the oldest value of the window with the given one
     inline void add(const TYPE& value) 
     { 
-        m_value_list.removeFirst();
-        m_value_list.append(value);
-        MYASSERT(m_value_list.count() == (int)m_length);
-    
-        m_sorted_list = m_value_list;
-        qSort(m_sorted_list.begin(), m_sorted_list.end());
+        int slot = m_oldest_slot;
+        if (++m_oldest_slot >= (int)m_length) m_oldest_slot = 0;
+
+        m_values[slot] = value;
+
+        // restore the heap the slot belongs to, then the order between the
+        // heaps - only their tops can be in the wrong order
+
+        int position = m_positions[slot];
+        if (position < m_low_count)
+        {
+            if (!siftUp(position, 0, true)) siftDown(position, 0, m_low_count, true);
+        }
+        else
+        {
+            if (!siftUp(position, m_low_count, false)) siftDown(position, m_low_count, m_length, false);
+        }
+
+        if (m_low_count < (int)m_length && m_values[m_heap[m_low_count]] < m_values[m_heap[0]])
+        {
+            swapPositions(0, m_low_count);
+            siftDown(0, 0, m_low_count, true);
+            siftDown(m_low_count, m_low_count, m_length, false);
+        }
     }
     
-    //! returns the calculated mean value
-    inline const TYPE& median() const { return m_value_list[m_middle_index]; }
+    //! returns the calculated median value
+    inline const TYPE& median() const { return m_values[m_heap[0]]; }
 
     inline uint length() const { return m_length; }
 
     void clear()
     {
-        m_value_list.clear();
-        m_sorted_list.clear();
-        for(uint index=0; index<m_length; ++index) m_value_list.append(m_init_value);
-        m_sorted_list = m_value_list;
+        m_values.fill(m_init_value, m_length);
+        m_heap.resize(m_length);
+        m_positions.resize(m_length);
+        for(uint index=0; index<m_length; ++index) m_heap[index] = m_positions[index] = index;
+        m_oldest_slot = 0;
     }
     
+protected:
+
+    //! returns true when the slot at heap position "a" belongs above the
+    //! one at "b"
+    inline bool isAbove(int a, int b, bool max_heap) const
+    {
+        const TYPE& value_a = m_values[m_heap[a]];
+        const TYPE& value_b = m_values[m_heap[b]];
+        return max_heap ? value_b < value_a : value_a < value_b;
+    }
+
+    inline void swapPositions(int a, int b)
+    {
+        qSwap(m_heap[a], m_heap[b]);
+        m_positions[m_heap[a]] = a;
+        m_positions[m_heap[b]] = b;
+    }
+
+    //! Moves the entry at the given position up within the heap starting
+    //! at "base", returns true if it was moved.
+    bool siftUp(int position, int base, bool max_heap)
+    {
+        bool moved = false;
+        while(position > base)
+        {
+            int parent = base + (position - base - 1) / 2;
+            if (!isAbove(position, parent, max_heap)) break;
+            swapPositions(position, parent);
+            position = parent;
+            moved = true;
+        }
+        return moved;
+    }
+
+    //! moves the entry at the given position down within the heap [base,end)
+    void siftDown(int position, int base, int end, bool max_heap)
+    {
+        while(true)
+        {
+            int child = base + 2 * (position - base) + 1;
+            if (child >= end) break;
+            if (child + 1 < end && isAbove(child + 1, child, max_heap)) ++child;
+            if (!isAbove(child, position, max_heap)) break;
+            swapPositions(position, child);
+            position = child;
+        }
+    }
+
 protected:
     
     TYPE m_init_value;
-    int m_middle_index;
-    QList<TYPE> m_value_list;
-    QList<TYPE> m_sorted_list;
     uint m_length;
+    //! number of slots in the lower (max) heap
+    int m_low_count;
+    //! the next slot to be replaced
+    int m_oldest_slot;
+
+    //! ring buffer of the window values
+    QVector<TYPE> m_values;
+    //! slots ordered as lower max heap [0,m_low_count) and upper min heap
+    //! [m_low_count,m_length)
+    QVector<int> m_heap;
+    //! position of each slot in m_heap
+    QVector<int> m_positions;
 };
 
 #endif /* MEDIAN_H */
@@ -18,6 +18,13 @@
 //
 ///////////////////////////////////////////////////////////////////////////////
 
+#if defined(__SSE2__) || defined(_M_X64)
+#define NAVCALC_USE_SSE2
+#include <emmintrin.h>
+#endif
+
+#include <QVector>
+
 #include "assert.h"
 #include "logger.h"
 #include "waypoint.h"
@@ -115,25 +122,7 @@ double Navcalc::getDistanceToAltitude(double alt_diff_ft,
 double Navcalc::getTrackBetweenWaypoints(const Waypoint& fix1, const Waypoint& fix2)
 {
     if (fix1.lat() == fix2.lat() && fix1.lon() == fix2.lon()) return 0.0;
-
-    double rad_lat1 = toRad(fix1.lat());
-    double rad_lon1 = toRad(fix1.lon());
-    double rad_lat2 = toRad(fix2.lat());
-    double rad_lon2 = toRad(fix2.lon());
-
-    double sin_lat1 = sin(rad_lat1);
-    double sin_lat2 = sin(rad_lat2);
-    double cos_lat1 = cos(rad_lat1);
-    double cos_lat2 = cos(rad_lat2);
-    double lon1_min_lon2 = rad_lon1-rad_lon2;
-
-    // source: http://williams.best.vwh.net/avform.htm
-
-    double track_rad =
-        fmod(atan2(sin(lon1_min_lon2)*cos_lat2,
-                   cos_lat1*sin_lat2-sin_lat1*cos_lat2*cos(lon1_min_lon2)), 2*M_PI);
-
-    return trimHeading(toDeg(-track_rad));
+    return getTrackBetweenWaypoints(fix1.unitVector(), fix2.unitVector());
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -142,19 +131,7 @@ double Navcalc::getDistBetweenWaypoints(const Waypoint& fix1,
 										const Waypoint& fix2)
 {
 	if (fix1.lat() == fix2.lat() && fix1.lon() == fix2.lon()) return 0.0;
-
-    double rad_lat1 = toRad(fix1.lat());
-    double rad_lon1 = toRad(fix1.lon());
-    double rad_lat2 = toRad(fix2.lat());
-    double rad_lon2 = toRad(fix2.lon());
-
-    double sin_lat1 = sin(rad_lat1);
-    double sin_lat2 = sin(rad_lat2);
-    double cos_lat1 = cos(rad_lat1);
-    double cos_lat2 = cos(rad_lat2);
-    double lon1_min_lon2 = rad_lon1-rad_lon2;
-
-    return toDeg(acos(sin_lat1*sin_lat2 + cos_lat1*cos_lat2*cos(lon1_min_lon2))) * 60.0;
+    return getDistBetweenWaypoints(fix1.unitVector(), fix2.unitVector());
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -169,35 +146,84 @@ bool Navcalc::getDistAndTrackBetweenWaypoints(const Waypoint& fix1,
 
     if (fix1.lat() == fix2.lat() && fix1.lon() == fix2.lon()) return true;
 
-    double rad_lat1 = toRad(fix1.lat());
-    double rad_lon1 = toRad(fix1.lon());
-    double rad_lat2 = toRad(fix2.lat());
-    double rad_lon2 = toRad(fix2.lon());
+    getDistAndTrackBetweenWaypoints(fix1.unitVector(), fix2.unitVector(), distance_nm, track_degrees);
+    return true;
+}
 
-    double sin_lat1 = sin(rad_lat1);
-    double sin_lat2 = sin(rad_lat2);
-    double cos_lat1 = cos(rad_lat1);
-    double cos_lat2 = cos(rad_lat2);
-    double lon1_min_lon2 = rad_lon1-rad_lon2;
+/////////////////////////////////////////////////////////////////////////////
+
+// With the unit vectors a and b of two positions the great circle angle
+// between them is atan2(|a x b|, a.b). The track at a is the direction of
+// b in the tangent plane at a, which is spanned by the east vector
+// e = z x a and the north vector n = a x e (both scaled by cos(lat_a)):
+//
+//   b.e = cos(lat_b)*sin(dlon)
+//   b.n = cos(lat_a)*sin(lat_b) - sin(lat_a)*cos(lat_b)*cos(dlon)
+//
+// source of the lat/lon forms: http://williams.best.vwh.net/avform.htm
 
-    // source: http://williams.best.vwh.net/avform.htm
+double Navcalc::getTrackBetweenWaypoints(const GeoVector& fix1,
+                                         const GeoVector& fix2)
+{
+    double east = fix1.x*fix2.y - fix1.y*fix2.x;
+    double north = fix2.z*(fix1.x*fix1.x + fix1.y*fix1.y) - fix1.z*(fix1.x*fix2.x + fix1.y*fix2.y);
+    if (east == 0.0 && north == 0.0) return 0.0;
+    return trimHeading(toDeg(atan2(east, north)));
+}
 
-    double distance_rad =
-        acos(sin_lat1*sin_lat2 + cos_lat1*cos_lat2*cos(lon1_min_lon2));
+/////////////////////////////////////////////////////////////////////////////
 
-    double track_rad =
-        fmod(atan2(sin(lon1_min_lon2)*cos_lat2,
-                   cos_lat1*sin_lat2-sin_lat1*cos_lat2*cos(lon1_min_lon2)), 2*M_PI);
+double Navcalc::getDistBetweenWaypoints(const GeoVector& fix1,
+                                        const GeoVector& fix2)
+{
+    return toDeg(atan2(fix1.cross(fix2).length(), fix1.dot(fix2))) * 60.0;
+}
 
-    distance_nm = toDeg(distance_rad) * 60.0;
-    track_degrees = trimHeading(toDeg(-track_rad));
+/////////////////////////////////////////////////////////////////////////////
 
-//     printf("%s (%lf/%lf) -> %s (%lf/%lf): dist %lfnm, track %lf�\n",
-//            fix1.id().latin1(), fix1.lat(), fix1.lon(),
-//            fix2.id().latin1(), fix2.lat(), fix2.lon(),
-//            distance_nm, track_degrees);
+void Navcalc::getDistAndTrackBetweenWaypoints(const GeoVector& fix1,
+                                              const GeoVector& fix2,
+                                              double& distance_nm,
+                                              double& track_degrees)
+{
+    distance_nm = getDistBetweenWaypoints(fix1, fix2);
+    track_degrees = getTrackBetweenWaypoints(fix1, fix2);
+}
 
-    return true;
+/////////////////////////////////////////////////////////////////////////////
+
+double Navcalc::getCrossTrackDistance(const GeoVector& from_wpt,
+                                      const GeoVector& to_wpt,
+                                      const GeoVector& current_pos)
+{
+    // the normal of the course great circle points to the left of the course
+    GeoVector normal = from_wpt.cross(to_wpt);
+    double normal_length = normal.length();
+    if (normal_length == 0.0) return 0.0;
+
+    double sin_xtd = current_pos.dot(normal) / normal_length;
+    if (sin_xtd > 1.0) sin_xtd = 1.0;
+    else if (sin_xtd < -1.0) sin_xtd = -1.0;
+
+    return -toDeg(asin(sin_xtd)) * 60.0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+GeoVector Navcalc::getIntermediatePoint(const GeoVector& from_wpt,
+                                        const GeoVector& to_wpt,
+                                        const double& dist_from_inter)
+{
+    double sin_d = from_wpt.cross(to_wpt).length();
+    double d = atan2(sin_d, from_wpt.dot(to_wpt));
+    if (sin_d == 0.0) return from_wpt;
+
+    double f = toRad(dist_from_inter / 60.0) / d;
+    if (f > 1.0)       f = 1.0;
+    else if (f < 0.0)  f = 0.0;
+
+    // A=sin((1-f)*d)/sin(d), B=sin(f*d)/sin(d)
+    return from_wpt * (sin((1-f)*d) / sin_d) + to_wpt * (sin(f*d) / sin_d);
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -220,6 +246,281 @@ double Navcalc::getCrossTrackDistance(const Waypoint& from_wpt,
 
 /////////////////////////////////////////////////////////////////////////////
 
+// The batch great circle kernels. Per point they calculate
+//
+//   a     = sin^2(dlat/2) + cos(lat1)*cos(lat2)*sin^2(dlon/2)
+//   dist  = 2*atan2(sqrt(a), sqrt(1-a))
+//   track = atan2(sin(dlon)*cos(lat2), cos(lat1)*sin(lat2)-sin(lat1)*cos(lat2)*cos(dlon))
+//
+// The sines and cosines are calculated two points at a time with SSE2,
+// only the final atan2() calls are scalar.
+
+//! result of the vector part of the kernel for a single point
+struct GreatCircleTerms
+{
+    double sqrt_a;
+    double sqrt_1_min_a;
+    double track_y;
+    double track_x;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+
+static inline void getGreatCircleTerms(double sin_lat1, double cos_lat1, double lat1, double lon1,
+                                       double lat2, double lon2, GreatCircleTerms& terms)
+{
+    double rad_lat2 = Navcalc::toRad(lat2);
+    double sin_lat2 = sin(rad_lat2);
+    double cos_lat2 = cos(rad_lat2);
+    double sin_half_dlat = sin(Navcalc::toRad(lat2 - lat1) * 0.5);
+    double sin_half_dlon = sin(Navcalc::toRad(lon2 - lon1) * 0.5);
+    double cos_half_dlon = cos(Navcalc::toRad(lon2 - lon1) * 0.5);
+
+    double a = sin_half_dlat*sin_half_dlat + cos_lat1*cos_lat2*sin_half_dlon*sin_half_dlon;
+    a = qMax(0.0, qMin(1.0, a));
+
+    terms.sqrt_a = sqrt(a);
+    terms.sqrt_1_min_a = sqrt(1.0 - a);
+    terms.track_y = 2.0*sin_half_dlon*cos_half_dlon * cos_lat2;
+    terms.track_x = cos_lat1*sin_lat2 - sin_lat1*cos_lat2*(1.0 - 2.0*sin_half_dlon*sin_half_dlon);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+#ifdef NAVCALC_USE_SSE2
+
+//! Calculates the sine and cosine of two angles given in degrees. The
+//! angles are reduced to [-45,45] degrees, where the fdlibm kernel
+//! polynomials are accurate to about one ulp.
+static inline void sinCosDeg(__m128d degrees, __m128d& sine, __m128d& cosine)
+{
+    __m128i quadrant = _mm_cvtpd_epi32(_mm_mul_pd(degrees, _mm_set1_pd(1.0/90.0)));
+    __m128d reduced = _mm_sub_pd(degrees, _mm_mul_pd(_mm_cvtepi32_pd(quadrant), _mm_set1_pd(90.0)));
+    __m128d x = _mm_mul_pd(reduced, _mm_set1_pd(M_PI/180.0));
+    __m128d x2 = _mm_mul_pd(x, x);
+
+    __m128d sin_poly = _mm_set1_pd(1.58969099521155010221e-10);
+    sin_poly = _mm_add_pd(_mm_mul_pd(sin_poly, x2), _mm_set1_pd(-2.50507602534068634195e-08));
+    sin_poly = _mm_add_pd(_mm_mul_pd(sin_poly, x2), _mm_set1_pd(2.75573137070700676789e-06));
+    sin_poly = _mm_add_pd(_mm_mul_pd(sin_poly, x2), _mm_set1_pd(-1.98412698298579493134e-04));
+    sin_poly = _mm_add_pd(_mm_mul_pd(sin_poly, x2), _mm_set1_pd(8.33333333332248946124e-03));
+    sin_poly = _mm_add_pd(_mm_mul_pd(sin_poly, x2), _mm_set1_pd(-1.66666666666666324348e-01));
+    __m128d sin_x = _mm_add_pd(x, _mm_mul_pd(_mm_mul_pd(x, x2), sin_poly));
+
+    __m128d cos_poly = _mm_set1_pd(-1.13596475577881948265e-11);
+    cos_poly = _mm_add_pd(_mm_mul_pd(cos_poly, x2), _mm_set1_pd(2.08757232129817482790e-09));
+    cos_poly = _mm_add_pd(_mm_mul_pd(cos_poly, x2), _mm_set1_pd(-2.75573143513906633035e-07));
+    cos_poly = _mm_add_pd(_mm_mul_pd(cos_poly, x2), _mm_set1_pd(2.48015872894767294178e-05));
+    cos_poly = _mm_add_pd(_mm_mul_pd(cos_poly, x2), _mm_set1_pd(-1.38888888888741095749e-03));
+    cos_poly = _mm_add_pd(_mm_mul_pd(cos_poly, x2), _mm_set1_pd(4.16666666666666019037e-02));
+    __m128d cos_x = _mm_add_pd(_mm_sub_pd(_mm_set1_pd(1.0), _mm_mul_pd(_mm_set1_pd(0.5), x2)),
+                               _mm_mul_pd(_mm_mul_pd(x2, x2), cos_poly));
+
+    // spread the two 32 bit quadrants to 64 bit lanes for the masks
+    __m128i quadrant64 = _mm_shuffle_epi32(quadrant, _MM_SHUFFLE(1,1,0,0));
+    __m128i one = _mm_set1_epi32(1);
+    __m128i two = _mm_set1_epi32(2);
+
+    __m128d swap = _mm_castsi128_pd(_mm_cmpeq_epi32(_mm_and_si128(quadrant64, one), one));
+    __m128d sin_negate = _mm_castsi128_pd(_mm_cmpeq_epi32(_mm_and_si128(quadrant64, two), two));
+    __m128d cos_negate = _mm_castsi128_pd(
+        _mm_cmpeq_epi32(_mm_and_si128(_mm_add_epi32(quadrant64, one), two), two));
+    __m128d sign = _mm_set1_pd(-0.0);
+
+    sine = _mm_or_pd(_mm_and_pd(swap, cos_x), _mm_andnot_pd(swap, sin_x));
+    cosine = _mm_or_pd(_mm_and_pd(swap, sin_x), _mm_andnot_pd(swap, cos_x));
+    sine = _mm_xor_pd(sine, _mm_and_pd(sin_negate, sign));
+    cosine = _mm_xor_pd(cosine, _mm_and_pd(cos_negate, sign));
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+//! calculates the terms of the points at "lat" and "lat+1"
+static inline void getGreatCircleTerms2(__m128d sin_lat1, __m128d cos_lat1, __m128d lat1, __m128d lon1,
+                                        const double* lat, const double* lon, GreatCircleTerms* terms)
+{
+    __m128d lat2 = _mm_loadu_pd(lat);
+    __m128d lon2 = _mm_loadu_pd(lon);
+    __m128d half = _mm_set1_pd(0.5);
+    __m128d one = _mm_set1_pd(1.0);
+
+    __m128d sin_lat2, cos_lat2, sin_half_dlat, cos_half_dlat, sin_half_dlon, cos_half_dlon;
+    sinCosDeg(lat2, sin_lat2, cos_lat2);
+    sinCosDeg(_mm_mul_pd(_mm_sub_pd(lat2, lat1), half), sin_half_dlat, cos_half_dlat);
+    sinCosDeg(_mm_mul_pd(_mm_sub_pd(lon2, lon1), half), sin_half_dlon, cos_half_dlon);
+
+    __m128d sin_half_dlon_sq = _mm_mul_pd(sin_half_dlon, sin_half_dlon);
+    __m128d a = _mm_add_pd(_mm_mul_pd(sin_half_dlat, sin_half_dlat),
+                           _mm_mul_pd(_mm_mul_pd(cos_lat1, cos_lat2), sin_half_dlon_sq));
+    a = _mm_max_pd(_mm_setzero_pd(), _mm_min_pd(one, a));
+
+    __m128d sqrt_a = _mm_sqrt_pd(a);
+    __m128d sqrt_1_min_a = _mm_sqrt_pd(_mm_sub_pd(one, a));
+    __m128d track_y = _mm_mul_pd(_mm_mul_pd(_mm_add_pd(sin_half_dlon, sin_half_dlon), cos_half_dlon), cos_lat2);
+    __m128d cos_dlon = _mm_sub_pd(one, _mm_add_pd(sin_half_dlon_sq, sin_half_dlon_sq));
+    __m128d track_x = _mm_sub_pd(_mm_mul_pd(cos_lat1, sin_lat2),
+                                 _mm_mul_pd(_mm_mul_pd(sin_lat1, cos_lat2), cos_dlon));
+
+    double values[2];
+    _mm_storeu_pd(values, sqrt_a); terms[0].sqrt_a = values[0]; terms[1].sqrt_a = values[1];
+    _mm_storeu_pd(values, sqrt_1_min_a); terms[0].sqrt_1_min_a = values[0]; terms[1].sqrt_1_min_a = values[1];
+    _mm_storeu_pd(values, track_y); terms[0].track_y = values[0]; terms[1].track_y = values[1];
+    _mm_storeu_pd(values, track_x); terms[0].track_x = values[0]; terms[1].track_x = values[1];
+}
+
+#endif
+
+/////////////////////////////////////////////////////////////////////////////
+
+//! output of the common batch kernel
+enum GreatCircleOutput
+{
+    //! distance only
+    GREAT_CIRCLE_DIST = 0,
+    //! distance and track in degrees
+    GREAT_CIRCLE_DIST_AND_TRACK,
+    //! east and north components of the distance vector
+    GREAT_CIRCLE_DIST_VECTOR
+};
+
+//! stores the results of a single point
+static inline void storeGreatCircleResult(const GreatCircleTerms& terms,
+                                          GreatCircleOutput output,
+                                          int index,
+                                          double* result1,
+                                          double* result2)
+{
+    const double rad_to_nm = 2.0 * 180.0 / M_PI * 60.0;
+    double distance_nm = atan2(terms.sqrt_a, terms.sqrt_1_min_a) * rad_to_nm;
+
+    switch(output)
+    {
+        case(GREAT_CIRCLE_DIST): {
+            result1[index] = distance_nm;
+            break;
+        }
+        case(GREAT_CIRCLE_DIST_AND_TRACK): {
+            result1[index] = distance_nm;
+            result2[index] = Navcalc::trimHeading(Navcalc::toDeg(atan2(terms.track_y, terms.track_x)));
+            break;
+        }
+        case(GREAT_CIRCLE_DIST_VECTOR): {
+            // the track terms are the sine and cosine of the track scaled
+            // by the same factor, so no trig call is needed here
+            double length = sqrt(terms.track_y*terms.track_y + terms.track_x*terms.track_x);
+            double factor = (length > 0.0) ? distance_nm / length : 0.0;
+            result1[index] = terms.track_y * factor;
+            result2[index] = terms.track_x * factor;
+            break;
+        }
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+//! the common batch kernel, "result2" is only used for two value outputs
+static void getGreatCircleBatch(const Waypoint& ref_wpt,
+                                const double* lat,
+                                const double* lon,
+                                int count,
+                                GreatCircleOutput output,
+                                double* result1,
+                                double* result2)
+{
+    MYASSERT(count >= 0);
+    MYASSERT(lat != 0 && lon != 0 && result1 != 0);
+    MYASSERT(output == GREAT_CIRCLE_DIST || result2 != 0);
+
+    double lat1 = ref_wpt.lat();
+    double lon1 = ref_wpt.lon();
+    double sin_lat1 = sin(Navcalc::toRad(lat1));
+    double cos_lat1 = cos(Navcalc::toRad(lat1));
+
+    GreatCircleTerms terms[2];
+    int index = 0;
+
+#ifdef NAVCALC_USE_SSE2
+    __m128d sin_lat1_2 = _mm_set1_pd(sin_lat1);
+    __m128d cos_lat1_2 = _mm_set1_pd(cos_lat1);
+    __m128d lat1_2 = _mm_set1_pd(lat1);
+    __m128d lon1_2 = _mm_set1_pd(lon1);
+
+    for(; index + 2 <= count; index += 2)
+    {
+        getGreatCircleTerms2(sin_lat1_2, cos_lat1_2, lat1_2, lon1_2, lat + index, lon + index, terms);
+        storeGreatCircleResult(terms[0], output, index, result1, result2);
+        storeGreatCircleResult(terms[1], output, index+1, result1, result2);
+    }
+#endif
+
+    for(; index < count; ++index)
+    {
+        getGreatCircleTerms(sin_lat1, cos_lat1, lat1, lon1, lat[index], lon[index], terms[0]);
+        storeGreatCircleResult(terms[0], output, index, result1, result2);
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void Navcalc::getDistsFromWaypoint(const Waypoint& ref_wpt,
+                                   const double* lat,
+                                   const double* lon,
+                                   int count,
+                                   double* distance_nm)
+{
+    getGreatCircleBatch(ref_wpt, lat, lon, count, GREAT_CIRCLE_DIST, distance_nm, 0);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void Navcalc::getDistsAndTracksFromWaypoint(const Waypoint& ref_wpt,
+                                            const double* lat,
+                                            const double* lon,
+                                            int count,
+                                            double* distance_nm,
+                                            double* track_degrees)
+{
+    getGreatCircleBatch(ref_wpt, lat, lon, count, GREAT_CIRCLE_DIST_AND_TRACK, distance_nm, track_degrees);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void Navcalc::getDistVectorsFromWaypoint(const Waypoint& ref_wpt,
+                                         const double* lat,
+                                         const double* lon,
+                                         int count,
+                                         double* east_nm,
+                                         double* north_nm)
+{
+    getGreatCircleBatch(ref_wpt, lat, lon, count, GREAT_CIRCLE_DIST_VECTOR, east_nm, north_nm);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void Navcalc::getCrossTrackDistances(const Waypoint& from_wpt,
+                                     const Waypoint& to_wpt,
+                                     const double* lat,
+                                     const double* lon,
+                                     int count,
+                                     double* cross_track_nm)
+{
+    double dist_from_to = 0.0;
+    double crs_from_to = 0.0;
+    getDistAndTrackBetweenWaypoints(from_wpt, to_wpt, dist_from_to, crs_from_to);
+
+    // the tracks are collected in the result array and replaced afterwards
+    QVector<double> distance_nm(count);
+    getGreatCircleBatch(from_wpt, lat, lon, count, GREAT_CIRCLE_DIST_AND_TRACK, distance_nm.data(), cross_track_nm);
+
+    for(int index = 0; index < count; ++index)
+    {
+        double alpha = getSignedHeadingDiff(crs_from_to, cross_track_nm[index]);
+        cross_track_nm[index] = sin(toRad(alpha)) * distance_nm[index];
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
 Waypoint Navcalc::getLatOnGreatCircleByLon(const Waypoint& from_wpt,
                                            const Waypoint& to_wpt,
                                            const Waypoint& current_pos)
@@ -248,38 +549,8 @@ Waypoint Navcalc::getIntermediateWaypoint(const Waypoint& from_wpt,
                                           const Waypoint& to_wpt,
                                           const double& dist_from_inter)
 {
-    double dist_from_to = getDistBetweenWaypoints(from_wpt, to_wpt);
-    double dist_frac = dist_from_inter / dist_from_to;
-
-    if (dist_frac > 1.0)       dist_frac = 1.0;
-    else if (dist_frac < 0.0)  dist_frac = 0.0;
-
-    double f = dist_frac;
-    double d = toRad(dist_from_to) / 60.0;
-
-    double lat1 = toRad(from_wpt.lat());
-    double lon1 = toRad(from_wpt.lon());
-    double lat2 = toRad(to_wpt.lat());
-    double lon2 = toRad(to_wpt.lon());
-
-    // A=sin((1-f)*d)/sin(d)
-    double a = sin((1-f)*d)/sin(d);
-
-    // B=sin(f*d)/sin(d)
-    double b = sin(f*d)/sin(d);
-
-    // x = A*cos(lat1)*cos(lon1)  +  B*cos(lat2)*cos(lon2)
-    double x = a * cos(lat1)*cos(lon1) +  b*cos(lat2)*cos(lon2);
-
-    // y = A*cos(lat1)*sin(lon1)  +  B*cos(lat2)*sin(lon2)
-    double y = a*cos(lat1)*sin(lon1) +  b*cos(lat2)*sin(lon2);
-
-    // z = A*sin(lat1)  +  B*sin(lat2)
-    double z = a*sin(lat1)  +  b*sin(lat2);
-
-    // lat=atan2(z,sqrt(x^2+y^2))
-    // lon=atan2(y,x)
-    return Waypoint("inter", "inter", toDeg(atan2(z,sqrt(x*x+y*y))), toDeg(atan2(y,x)));
+    GeoVector inter = getIntermediatePoint(from_wpt.unitVector(), to_wpt.unitVector(), dist_from_inter);
+    return Waypoint("inter", "inter", inter.lat(), inter.lon());
 }
 
 /////////////////////////////////////////////////////////////////////////////
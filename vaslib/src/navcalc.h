@@ -26,6 +26,7 @@
 #include <QString>
 
 class Waypoint;
+class GeoVector;
 class Declination;
 
 /////////////////////////////////////////////////////////////////////////////
@@ -134,6 +135,75 @@ public:
                                         double& crs_from_current,
                                         double& dist_from_current);
 
+    //----- versions working on the earth centered unit vectors of the
+    //----- positions (see Waypoint::unitVector()), they do not need any
+    //----- sin/cos calls
+
+    static double getTrackBetweenWaypoints(const GeoVector& fix1,
+                                           const GeoVector& fix2);
+
+    static double getDistBetweenWaypoints(const GeoVector& fix1,
+                                          const GeoVector& fix2);
+
+    static void getDistAndTrackBetweenWaypoints(const GeoVector& fix1,
+                                                const GeoVector& fix2,
+                                                double& distance_nm,
+                                                double& track_degrees);
+
+    //! Returns the great circle cross track distance of "current_pos" to
+    //! the course from "from_wpt" to "to_wpt", positive values are right
+    //! of the course.
+    static double getCrossTrackDistance(const GeoVector& from_wpt,
+                                        const GeoVector& to_wpt,
+                                        const GeoVector& current_pos);
+
+    //! Returns the point on the great circle from "from_wpt" to "to_wpt"
+    //! at the given distance from "from_wpt", the distance is clipped to
+    //! the distance between the waypoints.
+    static GeoVector getIntermediatePoint(const GeoVector& from_wpt,
+                                          const GeoVector& to_wpt,
+                                          const double& dist_from_inter);
+
+    //----- batch versions for many points, the points are given as
+    //----- separate lat/lon arrays in degrees, "count" entries each
+
+    //! Calculates the distances from "ref_wpt" to all given points like
+    //! getDistBetweenWaypoints(), but with the haversine formula, which
+    //! is also exact for short distances.
+    static void getDistsFromWaypoint(const Waypoint& ref_wpt,
+                                     const double* lat,
+                                     const double* lon,
+                                     int count,
+                                     double* distance_nm);
+
+    //! Calculates the distances and tracks from "ref_wpt" to all given
+    //! points like getDistAndTrackBetweenWaypoints().
+    static void getDistsAndTracksFromWaypoint(const Waypoint& ref_wpt,
+                                              const double* lat,
+                                              const double* lon,
+                                              int count,
+                                              double* distance_nm,
+                                              double* track_degrees);
+
+    //! Calculates the distance vectors from "ref_wpt" to all given points,
+    //! "east_nm" is distance*sin(track) and "north_nm" is distance*cos(track).
+    static void getDistVectorsFromWaypoint(const Waypoint& ref_wpt,
+                                           const double* lat,
+                                           const double* lon,
+                                           int count,
+                                           double* east_nm,
+                                           double* north_nm);
+
+    //! Calculates the cross track distances of all given points to the
+    //! course from "from_wpt" to "to_wpt" like getCrossTrackDistance(),
+    //! positive values are right of the course.
+    static void getCrossTrackDistances(const Waypoint& from_wpt,
+                                       const Waypoint& to_wpt,
+                                       const double* lat,
+                                       const double* lon,
+                                       int count,
+                                       double* cross_track_nm);
+
     static Waypoint getLatOnGreatCircleByLon(const Waypoint& from_wpt,
                                              const Waypoint& to_wpt,
                                              const Waypoint& current_pos);
@@ -27,13 +27,20 @@
 #include <QChar>
 #include <QDateTime>
 #include <QMessageBox>
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QRunnable>
+#include <QSet>
+#include <QThreadPool>
+#include <QVector>
 
-#include <QDomElement>
+#include <QXmlStreamReader>
 
 #include "logger.h"
 #include "navcalc.h"
 #include "vas_path.h"
 
+#include "navdata_image.h"
 #include "navdata.h"
 
 /////////////////////////////////////////////////////////////////////////////
@@ -45,7 +52,10 @@
 #define CFG_AIRWAY_FILENAME "airwayfile"
 #define CFG_AIRPORT_FILENAME "airportfile"
 #define CFG_NAVAID_FILENAME "navaidfile"
+#define CFG_IMAGE_FILENAME "imagefile"
+#define CFG_INDEX_FILENAME "indexfile"
 
+// obsolete, the indexes are kept in the index file now
 #define CFG_WAYPOINT_INDEX "waypointindex"
 #define CFG_AIRWAY_INDEX "airwayindex"
 #define CFG_AIRPORT_INDEX "airportindex"
@@ -59,16 +69,26 @@
 #define CFG_STAR_SUBDIR "starsubdir"
 #define CFG_LEVELD_PROCEDURES_SUBDIR "level_procedures_subdir"
 
+#define CFG_PROCEDURE_CACHE_SIZE_KB "procedure_cache_size_kb"
+#define CFG_PROCEDURE_PREFETCH_COUNT "procedure_prefetch_count"
+#define CFG_PROCEDURE_PREFETCH_RADIUS_NM "procedure_prefetch_radius_nm"
+
 /////////////////////////////////////////////////////////////////////////////
 
 #define AIRAC_WAYPOINT_FILENAME_DEFAULT "navdata/waypoints.txt"
 #define AIRAC_AIRWAY_FILENAME_DEFAULT "navdata/ats.txt"
 #define AIRAC_AIRPORT_FILENAME_DEFAULT "navdata/airports.txt"
 #define AIRAC_NAVAID_FILENAME_DEFAULT "navdata/navaids.txt"
+#define AIRAC_IMAGE_FILENAME_DEFAULT "navdata/navdata.img"
+#define AIRAC_INDEX_FILENAME_DEFAULT "navdata/navdata.idx"
 #define AIRAC_SID_SUBDIR_DEFAULT "navdata/sid"
 #define AIRAC_STAR_SUBDIR_DEFAULT "navdata/star"
 #define AIRAC_LEVELD_PROCEDURES_SUBDIR_DEFAULT "navdata/leveld_proc"
 
+#define PROCEDURE_CACHE_SIZE_KB_DEFAULT 4096
+#define PROCEDURE_PREFETCH_COUNT_DEFAULT 6
+#define PROCEDURE_PREFETCH_RADIUS_NM_DEFAULT 150
+
 /////////////////////////////////////////////////////////////////////////////
 
 #define AIRAC_CYCLE_RECORD_PREFIX 'X'
@@ -170,8 +190,6 @@
 /////////////////////////////////////////////////////////////////////////////
 
 #define NDSEP "|"
-#define INDEX_ITEM_SEP '@'
-#define INDEX_TUPLE_SEP ','
 #define COORD_FACTOR 1000000.0
 #define DIST_FACTOR 100.0
 #define FT_TO_M 0.3048
@@ -180,9 +198,23 @@
 
 /////////////////////////////////////////////////////////////////////////////
 
+//! per thread handles of the AIRAC text files, see Navdata::queryFile()
+class NavdataReadCursors
+{
+public:
+
+    NavdataReadCursors() { for(int index = 0; index < NavdataIndexFile::SOURCE_COUNT; ++index) files[index] = 0; }
+    ~NavdataReadCursors() { for(int index = 0; index < NavdataIndexFile::SOURCE_COUNT; ++index) delete files[index]; }
+
+    QFile* files[NavdataIndexFile::SOURCE_COUNT];
+};
+
+/////////////////////////////////////////////////////////////////////////////
+
 Navdata::Navdata(const QString& navdata_config_filename, const QString& navdata_index_config_filename) :
     m_valid(false), m_navdata_config(0), m_navdata_index_config(0),
-    m_waypoint_file(0), m_airway_file(0), m_airport_file(0), m_navaid_file(0)
+    m_waypoint_file(0), m_airway_file(0), m_airport_file(0), m_navaid_file(0), m_image(0),
+    m_procedure_cache(PROCEDURE_CACHE_SIZE_KB_DEFAULT * 1024), m_procedure_prefetcher(0)
 {
     Logger::log("Navdata: init");
 
@@ -202,6 +234,10 @@ Navdata::Navdata(const QString& navdata_config_filename, const QString& navdata_
     m_navdata_config->loadfromFile();
     m_navdata_index_config->loadfromFile();
 
+    m_procedure_cache.setMaxSize(m_navdata_config->getIntValue(CFG_PROCEDURE_CACHE_SIZE_KB) * 1024);
+    m_procedure_prefetcher = new NavdataProcedurePrefetcher(*this);
+    MYASSERT(m_procedure_prefetcher != 0);
+
     // setup database
 
     bool file_setup_done = false;
@@ -237,7 +273,19 @@ Navdata::Navdata(const QString& navdata_config_filename, const QString& navdata_
     }
 
     MYASSERT(extractAiracCycle());
-    MYASSERT(setupIndexes());
+
+    // the binary image is used when it is up to date, otherwise we fall
+    // back to the indexed text files
+    // the airway graph of the text files is part of their indexes
+    if (!setupImage())
+    {
+        MYASSERT(setupIndexes());
+    }
+    else
+    {
+        if (!buildAirwayGraph()) Logger::log("Navdata: could not build the airway graph");
+    }
+
     m_valid = true;
     m_navdata_config->saveToFile();
     m_navdata_index_config->saveToFile();
@@ -253,17 +301,18 @@ void Navdata::setupDefaultConfig()
     m_navdata_config->setValue(CFG_WAYPOINT_FILENAME, AIRAC_WAYPOINT_FILENAME_DEFAULT);
     m_navdata_config->setValue(CFG_AIRWAY_FILENAME, AIRAC_AIRWAY_FILENAME_DEFAULT);
     m_navdata_config->setValue(CFG_NAVAID_FILENAME, AIRAC_NAVAID_FILENAME_DEFAULT);
+    m_navdata_config->setValue(CFG_IMAGE_FILENAME, AIRAC_IMAGE_FILENAME_DEFAULT);
+    m_navdata_config->setValue(CFG_INDEX_FILENAME, AIRAC_INDEX_FILENAME_DEFAULT);
     m_navdata_config->setValue(CFG_SID_SUBDIR, AIRAC_SID_SUBDIR_DEFAULT);
     m_navdata_config->setValue(CFG_STAR_SUBDIR, AIRAC_STAR_SUBDIR_DEFAULT);
     m_navdata_config->setValue(CFG_LEVELD_PROCEDURES_SUBDIR, AIRAC_LEVELD_PROCEDURES_SUBDIR_DEFAULT);
+    m_navdata_config->setValue(CFG_PROCEDURE_CACHE_SIZE_KB, PROCEDURE_CACHE_SIZE_KB_DEFAULT);
+    m_navdata_config->setValue(CFG_PROCEDURE_PREFETCH_COUNT, PROCEDURE_PREFETCH_COUNT_DEFAULT);
+    m_navdata_config->setValue(CFG_PROCEDURE_PREFETCH_RADIUS_NM, PROCEDURE_PREFETCH_RADIUS_NM_DEFAULT);
 
     MYASSERT(m_navdata_index_config != 0);
     m_navdata_index_config->setValue(CFG_AIRAC_CYCLE_TITLE, "");
     m_navdata_index_config->setValue(CFG_AIRAC_CYCLE_DATES, "");
-    m_navdata_index_config->setValue(CFG_AIRPORT_INDEX, "");
-    m_navdata_index_config->setValue(CFG_WAYPOINT_INDEX, "");
-    m_navdata_index_config->setValue(CFG_AIRWAY_INDEX, "");
-    m_navdata_index_config->setValue(CFG_NAVAID_INDEX, "");
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -369,278 +418,319 @@ bool Navdata::extractAiracCycle()
 
 /////////////////////////////////////////////////////////////////////////////
 
-bool Navdata::setupIndexes()
+//! Runs the indexing pass over one AIRAC text file in the thread pool of
+//! Navdata::setupIndexes().
+class NavdataIndexTask : public QRunnable
 {
-    bool config_airac_matches = false;
+public:
 
-    // if the airac data in the config match the airac data files, we
-    // will load the indexes from the config for faster startup
-
-    if (m_navdata_index_config->getValue(CFG_AIRAC_CYCLE_TITLE) == m_airac_cycle_title &&
-        m_navdata_index_config->getValue(CFG_AIRAC_CYCLE_DATES) == m_airac_cycle_dates)
+    NavdataIndexTask(Navdata& navdata, NavdataIndexFile::Source source) :
+        m_navdata(navdata), m_source(source), m_result(false)
     {
-        Logger::log("Navdata:setupIndexes: config airac title and data matched");
-
-        if (m_navdata_index_config->getValue(CFG_AIRPORT_INDEX).isEmpty() ||
-            m_navdata_index_config->getValue(CFG_WAYPOINT_INDEX).isEmpty() ||
-            m_navdata_index_config->getValue(CFG_AIRWAY_INDEX).isEmpty() ||
-            m_navdata_index_config->getValue(CFG_NAVAID_INDEX).isEmpty())
-        {
-            Logger::log("Navdata:setupIndexes: config airac index empty");
-            config_airac_matches = false;
-        }
-        else
-        {
-            Logger::log("Navdata:setupIndexes: config airac index ok");
-            config_airac_matches = true;
-        }
+        setAutoDelete(false);
     }
 
-    if (!config_airac_matches)
-    {
-        Logger::log("Navdata:setupIndexes: config airac not ok");
-
-        m_navdata_index_config->setValue(CFG_AIRAC_CYCLE_TITLE, m_airac_cycle_title);
-        m_navdata_index_config->setValue(CFG_AIRAC_CYCLE_DATES, m_airac_cycle_dates);
-
-        MYASSERT(indexAirports());
-        MYASSERT(indexWaypoints());
-        MYASSERT(indexAirways());
-        MYASSERT(indexNavaids());
+    virtual ~NavdataIndexTask() {};
 
-        m_navdata_index_config->setValue(CFG_AIRPORT_INDEX, serializeIndexMap(m_airport_index_map));
-        m_navdata_index_config->setValue(CFG_WAYPOINT_INDEX, serializeIndexMap(m_waypoint_index_map));
-        m_navdata_index_config->setValue(CFG_AIRWAY_INDEX, serializeIndexMap(m_airway_index_map));
-        m_navdata_index_config->setValue(CFG_NAVAID_INDEX, serializeIndexMap(m_navaid_index_map));
+    virtual void run() { m_result = m_navdata.indexSourceFile(m_source, m_hash); }
 
-        m_navdata_index_config->setValue(
-            CFG_AIRPORT_COORDINATE_INDEX, serializeAirportCoordinateIndexMap(m_airport_list_coordinate_index_map));
-        m_navdata_index_config->setValue(
-            CFG_VOR_COORDINATE_INDEX, serializeVorCoordinateIndexMap(m_vor_list_coordinate_index_map));
-        m_navdata_index_config->setValue(
-            CFG_NDB_COORDINATE_INDEX, serializeNdbCoordinateIndexMap(m_ndb_list_coordinate_index_map));
-    }
-    else
-    {
-        m_airport_index_map = deSerializeIndexMap(m_navdata_index_config->getValue(CFG_AIRPORT_INDEX));
-        m_waypoint_index_map = deSerializeIndexMap(m_navdata_index_config->getValue(CFG_WAYPOINT_INDEX));
-        m_airway_index_map = deSerializeIndexMap(m_navdata_index_config->getValue(CFG_AIRWAY_INDEX));
-        m_navaid_index_map = deSerializeIndexMap(m_navdata_index_config->getValue(CFG_NAVAID_INDEX));
+    inline NavdataIndexFile::Source source() const { return m_source; }
+    inline bool result() const { return m_result; }
+    inline const QByteArray& hash() const { return m_hash; }
 
-        m_airport_list_coordinate_index_map =
-            deSerializeAirportCoordinateIndexMap(m_navdata_index_config->getValue(CFG_AIRPORT_COORDINATE_INDEX));
-        m_vor_list_coordinate_index_map =
-            deSerializeVorCoordinateIndexMap(m_navdata_index_config->getValue(CFG_VOR_COORDINATE_INDEX));
-        m_ndb_list_coordinate_index_map =
-            deSerializeNdbCoordinateIndexMap(m_navdata_index_config->getValue(CFG_NDB_COORDINATE_INDEX));
-    }
+protected:
 
-    return true;
-}
+    Navdata& m_navdata;
+    NavdataIndexFile::Source m_source;
+    bool m_result;
+    QByteArray m_hash;
+};
 
 /////////////////////////////////////////////////////////////////////////////
 
-QString Navdata::serializeIndexMap(const IndexMap& map)
+bool Navdata::setupIndexes()
 {
-    QString result_string;
+    QTime start_time;
+    start_time.start();
+
+    // drop the indexes of former versions from the index config
+    m_navdata_index_config->removeValue(CFG_WAYPOINT_INDEX);
+    m_navdata_index_config->removeValue(CFG_AIRWAY_INDEX);
+    m_navdata_index_config->removeValue(CFG_AIRPORT_INDEX);
+    m_navdata_index_config->removeValue(CFG_NAVAID_INDEX);
+    m_navdata_index_config->removeValue(CFG_AIRPORT_COORDINATE_INDEX);
+    m_navdata_index_config->removeValue(CFG_VOR_COORDINATE_INDEX);
+    m_navdata_index_config->removeValue(CFG_NDB_COORDINATE_INDEX);
+    m_navdata_index_config->setValue(CFG_AIRAC_CYCLE_TITLE, m_airac_cycle_title);
+    m_navdata_index_config->setValue(CFG_AIRAC_CYCLE_DATES, m_airac_cycle_dates);
+
+    QString index_filename = VasPath::prependPath(m_navdata_config->getValue(CFG_INDEX_FILENAME));
 
-    IndexMap::const_iterator iter = map.begin();
-    for(; iter != map.end(); ++iter)
+    NavdataIndexFile index_file;
+    if (!index_file.load(index_filename, m_airac_cycle_title, m_airac_cycle_dates))
+        Logger::log("Navdata:setupIndexes: no valid index file found - indexing all files");
+
+    // take over the indexes of unchanged files and reindex the other files
+    // in parallel, the passes over different files are independent
+
+    QThreadPool thread_pool;
+    QList<NavdataIndexTask*> task_list;
+
+    for(int source = 0; source < NavdataIndexFile::SOURCE_COUNT; ++source)
     {
-        result_string += QString("%1%2%3%4").arg(iter.key()).arg(INDEX_ITEM_SEP).
-                         arg(*iter).arg(INDEX_TUPLE_SEP);
-    }
+        NavdataIndexFile::Source index_source = (NavdataIndexFile::Source)source;
 
-    return result_string;
-};
+        if (index_file.isValid(index_source, *sourceFile(index_source)) &&
+            deSerializeIndex(index_source, index_file.payload(index_source))) continue;
 
-/////////////////////////////////////////////////////////////////////////////
+        NavdataIndexTask* task = new NavdataIndexTask(*this, index_source);
+        MYASSERT(task != 0);
+        task_list.append(task);
+        thread_pool.start(task);
+    }
 
-QString Navdata::serializeAirportCoordinateIndexMap(const AirportListCoordinateIndexMap& map)
-{
-    QString result_string;
+    thread_pool.waitForDone();
 
-    AirportListCoordinateIndexMap::const_iterator iter = map.begin();
-    for(; iter != map.end(); ++iter)
+    bool ok = true;
+    QList<NavdataIndexTask*>::const_iterator iter = task_list.begin();
+    for(; iter != task_list.end(); ++iter)
     {
-        const AirportList& airportlist = iter.value();
+        const NavdataIndexTask& task = **iter;
 
-        AirportList::const_iterator list_iter = airportlist.begin();
-        for(; list_iter != airportlist.end(); ++list_iter)
+        if (!task.result())
         {
-            const Airport& airport = *list_iter;
-            result_string += QString("%1%2%3%4%5%6").arg(airport.id()).arg(INDEX_ITEM_SEP).
-                             arg(airport.lat()).arg(INDEX_ITEM_SEP).arg(airport.lon()).arg(INDEX_TUPLE_SEP);
+            Logger::log(QString("Navdata:setupIndexes: ERROR: could not index %1").
+                        arg(sourceFile(task.source())->fileName()));
+            ok = false;
+            continue;
         }
+
+        index_file.setSection(task.source(), *sourceFile(task.source()), task.hash(), serializeIndex(task.source()));
     }
 
-    return result_string;
+    uint reindexed_count = task_list.count();
+    qDeleteAll(task_list);
+    if (!ok) return false;
+
+    if (index_file.isModified() && !index_file.save(index_filename, m_airac_cycle_title, m_airac_cycle_dates))
+        Logger::log(QString("Navdata:setupIndexes: could not save the index file %1").arg(index_filename));
+
+    buildSpatialIndexes();
+
+    Logger::log(QString("Navdata:setupIndexes: reindexed %1 of %2 files, %3 waypoints, %4 navaids, "
+                        "%5 airports, %6 airways in %7ms").
+                arg(reindexed_count).arg(NavdataIndexFile::SOURCE_COUNT).
+                arg(m_waypoint_ident_index.referenceCount()).arg(m_navaid_ident_index.referenceCount()).
+                arg(m_airport_ident_index.referenceCount()).arg(m_airway_ident_index.referenceCount()).
+                arg(start_time.elapsed()));
+    return true;
 }
 
 /////////////////////////////////////////////////////////////////////////////
 
-QString Navdata::serializeVorCoordinateIndexMap(const VorListCoordinateIndexMap& map)
+bool Navdata::setupImage()
 {
-    QString result_string;
+    delete m_image;
+    m_image = 0;
 
-    VorListCoordinateIndexMap::const_iterator iter = map.begin();
-    for(; iter != map.end(); ++iter)
+    NavdataImage* image = new NavdataImage;
+    MYASSERT(image != 0);
+
+    if (!image->open(VasPath::prependPath(m_navdata_config->getValue(CFG_IMAGE_FILENAME))))
     {
-        const VorList& vorlist = iter.value();
+        Logger::log("Navdata:setupImage: no binary image found - "
+                    "compile it with the --compile-navdata option for faster lookups");
+        delete image;
+        return false;
+    }
 
-        VorList::const_iterator list_iter = vorlist.begin();
-        for(; list_iter != vorlist.end(); ++list_iter)
-        {
-            const Vor& vor = *list_iter;
-            result_string += QString("%1%2%3%4%5%6%7%8").arg(vor.id()).arg(INDEX_ITEM_SEP).
-                             arg(vor.lat()).arg(INDEX_ITEM_SEP).arg(vor.lon()).
-                             arg(INDEX_ITEM_SEP).arg(vor.hasDME()).arg(INDEX_TUPLE_SEP);
-        }
+    if (image->airacCycleTitle() != m_airac_cycle_title ||
+        image->airacCycleDates() != m_airac_cycle_dates ||
+        !image->matchesSourceFile(NavdataImageHeader::SOURCE_WAYPOINTS, QFileInfo(*m_waypoint_file)) ||
+        !image->matchesSourceFile(NavdataImageHeader::SOURCE_AIRWAYS, QFileInfo(*m_airway_file)) ||
+        !image->matchesSourceFile(NavdataImageHeader::SOURCE_AIRPORTS, QFileInfo(*m_airport_file)) ||
+        !image->matchesSourceFile(NavdataImageHeader::SOURCE_NAVAIDS, QFileInfo(*m_navaid_file)))
+    {
+        Logger::log("Navdata:setupImage: binary image is stale - "
+                    "using text files, recompile it with the --compile-navdata option");
+        delete image;
+        return false;
     }
 
-    return result_string;
-}
+    // fill the spatial lists from the image records
 
-/////////////////////////////////////////////////////////////////////////////
+    m_spatial_airport_list.clear();
+    m_spatial_vor_list.clear();
+    m_spatial_ndb_list.clear();
 
-QString Navdata::serializeNdbCoordinateIndexMap(const NdbListCoordinateIndexMap& map)
-{
-    QString result_string;
+    const NavdataImageNavaid* navaids = image->navaidRecords();
+    for(uint index = 0; index < image->navaidCount(); ++index)
+    {
+        if (navaids[index].type == NavdataImageNavaid::TYPE_ILS) continue;
+
+        Waypoint* navaid = image->createNavaid(navaids[index]);
+
+        if (navaid->asVor() != 0)
+            m_spatial_vor_list.append(*navaid->asVor());
+        else if (navaid->asNdb() != 0)
+            m_spatial_ndb_list.append(*navaid->asNdb());
+
+        delete navaid;
+    }
+
+    // airports with at least one runway longer than 2000m
 
-    NdbListCoordinateIndexMap::const_iterator iter = map.begin();
-    for(; iter != map.end(); ++iter)
+    const NavdataImageAirport* airports = image->airportRecords();
+    const NavdataImageRunway* runways = image->runwayRecords();
+    for(uint index = 0; index < image->airportCount(); ++index)
     {
-        const NdbList& ndblist = iter.value();
+        const NavdataImageAirport& record = airports[index];
 
-        NdbList::const_iterator list_iter = ndblist.begin();
-        for(; list_iter != ndblist.end(); ++list_iter)
+        for(uint rwy_index = record.first_runway; rwy_index < record.first_runway + record.runway_count; ++rwy_index)
         {
-            const Ndb& ndb = *list_iter;
-            result_string += QString("%1%2%3%4%5%6").arg(ndb.id()).arg(INDEX_ITEM_SEP).
-                             arg(ndb.lat()).arg(INDEX_ITEM_SEP).arg(ndb.lon()).arg(INDEX_TUPLE_SEP);
+            if (runways[rwy_index].length_m < 2000) continue;
+
+            Airport* airport = image->createAirport(record);
+            m_spatial_airport_list.append(*airport);
+            delete airport;
+            break;
         }
     }
 
-    return result_string;
+    m_image = image;
+    buildSpatialIndexes();
+    buildImageIdentSearch();
+
+    Logger::log(QString("Navdata:setupImage: using binary image (%1 intersections, %2 navaids, "
+                        "%3 airports, %4 airways)").
+                arg(m_image->intersectionCount()).arg(m_image->navaidCount()).
+                arg(m_image->airportCount()).arg(m_image->airwayCount()));
+    return true;
 }
 
 /////////////////////////////////////////////////////////////////////////////
 
-IndexMap Navdata::deSerializeIndexMap(const QString& line)
+bool Navdata::compileImage()
 {
-    MYASSERT(!line.isEmpty());
-    IndexMap result_map;
-
-    QStringList tuple_list = line.split(INDEX_TUPLE_SEP, QString::SkipEmptyParts);
-    MYASSERT(tuple_list.count() > 0);
-
-    QStringList::const_iterator iter = tuple_list.begin();
-    for(; iter != tuple_list.end(); ++iter)
+    if (m_waypoint_file == 0 || m_airway_file == 0 || m_airport_file == 0 || m_navaid_file == 0)
     {
-        QStringList item_list = (*iter).split(INDEX_ITEM_SEP);
-        MYASSERT(item_list.count() == 2);
-
-        bool convok = false;
-        result_map.insert(item_list[0], item_list[1].toLong(&convok));
-        MYASSERT(convok);
+        Logger::log("Navdata:compileImage: navdata files not setup");
+        return false;
     }
 
-    return result_map;
-};
-
-/////////////////////////////////////////////////////////////////////////////
+    QTime start_time;
+    start_time.start();
 
-AirportListCoordinateIndexMap Navdata::deSerializeAirportCoordinateIndexMap(const QString& line)
-{
-    MYASSERT(!line.isEmpty());
-    AirportListCoordinateIndexMap result_map;
+    NavdataImageWriter writer;
+    writer.setAiracCycle(m_airac_cycle_title, m_airac_cycle_dates);
+    writer.setSourceFile(NavdataImageHeader::SOURCE_WAYPOINTS, QFileInfo(*m_waypoint_file));
+    writer.setSourceFile(NavdataImageHeader::SOURCE_AIRWAYS, QFileInfo(*m_airway_file));
+    writer.setSourceFile(NavdataImageHeader::SOURCE_AIRPORTS, QFileInfo(*m_airport_file));
+    writer.setSourceFile(NavdataImageHeader::SOURCE_NAVAIDS, QFileInfo(*m_navaid_file));
 
-    QStringList tuple_list = line.split(INDEX_TUPLE_SEP, QString::SkipEmptyParts);
-    MYASSERT(tuple_list.count() > 0);
+    // intersections
 
-    QStringList::const_iterator iter = tuple_list.begin();
-    for(; iter != tuple_list.end(); ++iter)
+    MYASSERT(m_waypoint_file->reset());
+    while(!m_waypoint_file->atEnd())
     {
-        QStringList item_list = (*iter).split(INDEX_ITEM_SEP);
-        MYASSERT(item_list.count() == 3);
-
-        bool convok = false;
-        double lat = item_list[1].toDouble(&convok);
-        MYASSERT(convok);
-        double lon = item_list[2].toDouble(&convok);
-        MYASSERT(convok);
+        QString line(m_waypoint_file->readLine());
+        line = line.trimmed();
+        if (line.isEmpty()) continue;
+        line = line.toUpper();
 
-        Airport airport(item_list[0], "", lat, lon, 0);
-        result_map[getCoordinateIndex(airport)].append(airport);
+        Intersection* intersection = parseIntersection(line);
+        if (intersection == 0) continue;
+        writer.addIntersection(*intersection);
+        delete intersection;
     }
 
-    return result_map;
-}
+    // navaids
 
-/////////////////////////////////////////////////////////////////////////////
+    MYASSERT(m_navaid_file->reset());
+    while(!m_navaid_file->atEnd())
+    {
+        QString line(m_navaid_file->readLine());
+        line = line.trimmed();
+        if (line.isEmpty()) continue;
+        line = line.toUpper();
 
-VorListCoordinateIndexMap Navdata::deSerializeVorCoordinateIndexMap(const QString& line)
-{
-    MYASSERT(!line.isEmpty());
-    VorListCoordinateIndexMap result_map;
+        Waypoint* navaid = parseNavaid(line);
+        if (navaid == 0) continue;
+        writer.addNavaid(*navaid);
+        delete navaid;
+    }
 
-    QStringList tuple_list = line.split(INDEX_TUPLE_SEP, QString::SkipEmptyParts);
-    MYASSERT(tuple_list.count() > 0);
+    // airports
 
-    QStringList::const_iterator iter = tuple_list.begin();
-    for(; iter != tuple_list.end(); ++iter)
+    MYASSERT(m_airport_file->reset());
+    while(!m_airport_file->atEnd())
     {
-        QStringList item_list = (*iter).split(INDEX_ITEM_SEP);
-        MYASSERT(item_list.count() == 4);
-
-        bool convok = false;
-        double lat = item_list[1].toDouble(&convok);
-        MYASSERT(convok);
-        double lon = item_list[2].toDouble(&convok);
-        MYASSERT(convok);
-        bool dme = item_list[3].toInt(&convok);
-        MYASSERT(convok);
+        QString line(m_airport_file->readLine());
+        line = line.trimmed();
+        if (line.isEmpty()) continue;
+        line = line.toUpper();
 
-        Vor vor(item_list[0], "", lat, lon, 0, dme, 0, 0, QString::null);
-        result_map[getCoordinateIndex(vor)].append(vor);
-    }
+        if (line.at(0) != AIRPORT_RECORD_PREFIX) continue;
 
-    return result_map;
-}
+        QStringList runway_lines;
+        while(!m_airport_file->atEnd())
+        {
+            QString line(m_airport_file->readLine());
+            line = line.trimmed();
+            if (line.isEmpty()) break;
+            line = line.toUpper();
+            if (line.at(0) != RUNWAY_RECORD_PREFIX) break;
+            runway_lines.append(line);
+        }
 
-/////////////////////////////////////////////////////////////////////////////
+        Airport airport;
+        if (!parseAirport(line, runway_lines, &airport))
+        {
+            Logger::log(QString("Navdata:compileImage: ERROR: Could not parse airport (%1)").arg(line));
+            return false;
+        }
 
-NdbListCoordinateIndexMap Navdata::deSerializeNdbCoordinateIndexMap(const QString& line)
-{
-    MYASSERT(!line.isEmpty());
-    NdbListCoordinateIndexMap result_map;
+        writer.addAirport(airport);
+    }
 
-    QStringList tuple_list = line.split(INDEX_TUPLE_SEP, QString::SkipEmptyParts);
-    MYASSERT(tuple_list.count() > 0);
+    // airways
 
-    QStringList::const_iterator iter = tuple_list.begin();
-    for(; iter != tuple_list.end(); ++iter)
+    MYASSERT(m_airway_file->reset());
+    while(!m_airway_file->atEnd())
     {
-        QStringList item_list = (*iter).split(INDEX_ITEM_SEP);
-        MYASSERT(item_list.count() == 3);
+        QString line(m_airway_file->readLine());
+        line = line.trimmed();
+        if (line.isEmpty()) continue;
+        line = line.toUpper();
+
+        if (line.at(0) != AIRWAY_ROUTE_PREFIX) continue;
 
-        bool convok = false;
-        double lat = item_list[1].toDouble(&convok);
-        MYASSERT(convok);
-        double lon = item_list[2].toDouble(&convok);
-        MYASSERT(convok);
+        QString airway_name;
+        int segment_count = 0;
+        if (!parseAirwayRoute(line, airway_name, segment_count))
+        {
+            Logger::log(QString("Navdata:compileImage: ERROR: Could not parse airway (%1)").arg(line));
+            return false;
+        }
 
-        Ndb ndb(item_list[0], "", lat, lon, 0, 0, 0, QString::null);
-        result_map[getCoordinateIndex(ndb)].append(ndb);
+        Airway* airway = readAirwaySegments(*m_airway_file, airway_name);
+        if (airway == 0) return false;
+        if (airway->count() > 0) writer.addAirway(*airway);
+        delete airway;
     }
 
-    return result_map;
+    if (!writer.write(VasPath::prependPath(m_navdata_config->getValue(CFG_IMAGE_FILENAME)))) return false;
+
+    Logger::log(QString("Navdata:compileImage: compiled image in %1ms").arg(start_time.elapsed()));
+    return setupImage();
 }
 
 /////////////////////////////////////////////////////////////////////////////
 
 Navdata::~Navdata()
 {
+    delete m_procedure_prefetcher;
+    delete m_image;
     delete m_waypoint_file;
     delete m_airway_file;
     delete m_airport_file;
@@ -651,245 +741,523 @@ Navdata::~Navdata()
 ////////////////////////// INDEX METHODS ////////////////////////////////////
 /////////////////////////////////////////////////////////////////////////////
 
-bool Navdata::generateIndex(QFile* file_to_read, IndexMap& index_map, bool generate_navaid_coordinate_index)
+QFile* Navdata::sourceFile(NavdataIndexFile::Source source) const
 {
-    QList<QChar> current_index;
-    current_index.append(QChar('*'));
-    current_index.append(QChar('*'));
+    switch(source)
+    {
+        case(NavdataIndexFile::SOURCE_WAYPOINTS): return m_waypoint_file;
+        case(NavdataIndexFile::SOURCE_AIRWAYS): return m_airway_file;
+        case(NavdataIndexFile::SOURCE_AIRPORTS): return m_airport_file;
+        case(NavdataIndexFile::SOURCE_NAVAIDS): return m_navaid_file;
+        default: break;
+    }
 
-    unsigned long linecount = 0;
+    MYASSERT(false);
+    return 0;
+}
 
-    while(!file_to_read->atEnd())
-    {
-        qint64 read_pos = file_to_read->pos();
+/////////////////////////////////////////////////////////////////////////////
 
-        QByteArray line_array = file_to_read->readLine();
-        ++linecount;
-        QString line(line_array);
-        line = line.trimmed();
-        if (line.isEmpty()) continue;
-        line = line.toUpper();
+QFile* Navdata::queryFile(NavdataIndexFile::Source source) const
+{
+    // the thread owning the navdata uses the shared file handles
+    if (QThread::currentThread() == thread()) return sourceFile(source);
 
-        if (line.at(0) != current_index[0])
-        {
-            current_index[0] = line.at(0);
-            index_map.insert(current_index[0], read_pos);
+    if (!m_read_cursors.hasLocalData())
+    {
+        NavdataReadCursors* cursors = new NavdataReadCursors;
+        MYASSERT(cursors != 0);
 
-            current_index[1] = '*';
-            if (line.length() > 1)
-            {
-                current_index[1] = line.at(1);
-                index_map.insert(QString(current_index[0])+current_index[1], read_pos);
-            }
-        }
-        else if (line.length() > 1 && line.at(1) != current_index[1])
+        for(int index = 0; index < NavdataIndexFile::SOURCE_COUNT; ++index)
         {
-            current_index[1] = line.at(1);
-            index_map.insert(QString(current_index[0])+current_index[1], read_pos);
+            QFile* file = new QFile(sourceFile((NavdataIndexFile::Source)index)->fileName());
+            MYASSERT(file != 0);
+            if (!file->open(QIODevice::ReadOnly | QIODevice::Text))
+                Logger::log(QString("Navdata:queryFile: could not open %1").arg(file->fileName()));
+            cursors->files[index] = file;
         }
 
-        // create VOR&NDB coordinate index
-        if (generate_navaid_coordinate_index)
-        {
-            Waypoint* navaid = parseNavaid(line, QString::null);
-
-            if (navaid != 0)
-            {
-                QString coordinate_index = getCoordinateIndex(*navaid);
-
-                if (navaid->asIls() != 0) {}
-                else if (navaid->asVor() != 0)
-                    m_vor_list_coordinate_index_map[coordinate_index].append(*navaid->asVor());
-                else if (navaid->asNdb() != 0)
-                    m_ndb_list_coordinate_index_map[coordinate_index].append(*navaid->asNdb());
-
-                delete navaid;
-                navaid = 0;
-            }
-        }
+        m_read_cursors.setLocalData(cursors);
     }
 
-    return true;
+    return m_read_cursors.localData()->files[source];
 }
 
 /////////////////////////////////////////////////////////////////////////////
 
-bool Navdata::indexWaypoints()
+bool Navdata::indexSourceFile(NavdataIndexFile::Source source, QByteArray& hash)
 {
-    m_valid = false;
-    MYASSERT(m_waypoint_file->reset());
-    m_waypoint_index_map.clear();
+    QCryptographicHash file_hash(QCryptographicHash::Md5);
+    bool ok = false;
 
-    bool ret = generateIndex(m_waypoint_file, m_waypoint_index_map);
+    switch(source)
+    {
+        case(NavdataIndexFile::SOURCE_WAYPOINTS): ok = indexWaypoints(file_hash); break;
+        case(NavdataIndexFile::SOURCE_AIRWAYS): ok = indexAirways(file_hash); break;
+        case(NavdataIndexFile::SOURCE_AIRPORTS): ok = indexAirports(file_hash); break;
+        case(NavdataIndexFile::SOURCE_NAVAIDS): ok = indexNavaids(file_hash); break;
+        default: MYASSERT(false); break;
+    }
 
-    Logger::log(QString("Navdata:indexWaypoints: generated %1 index lines").arg(m_waypoint_index_map.count()));
-    return ret;
+    hash = file_hash.result();
+    return ok;
 }
 
 /////////////////////////////////////////////////////////////////////////////
 
-bool Navdata::indexNavaids()
+bool Navdata::indexWaypoints(QCryptographicHash& hash)
 {
-    m_valid = false;
-    MYASSERT(m_navaid_file->reset());
-    m_navaid_index_map.clear();
-    m_vor_list_coordinate_index_map.clear();
-    m_ndb_list_coordinate_index_map.clear();
+    m_waypoint_ident_index.clear();
+    m_waypoint_ident_search.clear();
+
+    MYASSERT(m_waypoint_file->reset());
+    while(!m_waypoint_file->atEnd())
+    {
+        qint64 read_pos = m_waypoint_file->pos();
+        QByteArray line_array = m_waypoint_file->readLine();
+        hash.addData(line_array);
+
+        QString line(line_array);
+        line = line.trimmed();
+        if (line.isEmpty()) continue;
+
+        QStringList item_list = line.split(NDSEP);
+        if (item_list.count() != 4) continue;
 
-    bool ret = generateIndex(m_navaid_file, m_navaid_index_map, true);
+        QString item_id = item_list[WPT_ID_INDEX];
+        normalizeID(item_id);
+        m_waypoint_ident_index.insert(item_id, read_pos, NavdataIdentIndex::TYPE_INTERSECTION,
+                                      item_list[WPT_CCODE_INDEX]);
+
+        bool convok1 = false, convok2 = false;
+        double lat = item_list[WPT_LAT_INDEX].toDouble(&convok1)/COORD_FACTOR;
+        double lon = item_list[WPT_LON_INDEX].toDouble(&convok2)/COORD_FACTOR;
+        if (convok1 && convok2)
+            m_waypoint_ident_search.insert(item_id, item_id, lat, lon, NavdataIdentIndex::TYPE_INTERSECTION);
+    }
 
-    Logger::log(QString("Navdata:indexNavaids: generated %1 index lines").arg(m_navaid_index_map.count()));
-    return ret;
+    m_waypoint_ident_index.finalize();
+    m_waypoint_ident_search.finalize();
+    return true;
 }
 
 /////////////////////////////////////////////////////////////////////////////
 
-bool Navdata::indexAirways()
+bool Navdata::indexNavaids(QCryptographicHash& hash)
 {
-    m_valid = false;
-    MYASSERT(m_airway_file->reset());
-    m_airway_index_map.clear();
+    m_navaid_ident_index.clear();
+    m_navaid_ident_search.clear();
+    m_spatial_vor_list.clear();
+    m_spatial_ndb_list.clear();
 
-    QList<QChar> current_index;
-    current_index.append(QChar('*'));
-    current_index.append(QChar('*'));
-
-    while(!m_airway_file->atEnd())
+    MYASSERT(m_navaid_file->reset());
+    while(!m_navaid_file->atEnd())
     {
-        qint64 read_pos = m_airway_file->pos();
+        qint64 read_pos = m_navaid_file->pos();
+        QByteArray line_array = m_navaid_file->readLine();
+        hash.addData(line_array);
 
-        QByteArray line_array = m_airway_file->readLine();
         QString line(line_array);
         line = line.trimmed();
         if (line.isEmpty()) continue;
         line = line.toUpper();
 
-        if (line.at(0) != AIRWAY_ROUTE_PREFIX) continue;
-
-        QString found_airway_name;
-        int segment_count;
-
-        if (!parseAirwayRoute(line, found_airway_name, segment_count))
-        {
-            Logger::log(QString("Navdata:indexAirways: ERROR: "
-                                "Could not parse airway (%1)").arg(line));
-            return false;
-        }
+        QStringList item_list = line.split(NDSEP);
+        if (item_list.count() != 10) continue;
 
-        if (found_airway_name.at(0) != current_index[0])
+        // same type decision as in parseNavaid()
+        NavdataIdentIndex::RecordType type = NavdataIdentIndex::TYPE_VOR;
+        if (item_list[NAVAID_VORFLAG_INDEX] == "0")
         {
-            current_index[0] = found_airway_name.at(0);
-            m_airway_index_map.insert(current_index[0], read_pos);
-
-            current_index[1] = '*';
-            if (found_airway_name.length() > 1)
-            {
-                current_index[1] = found_airway_name.at(1);
-                m_airway_index_map.insert(QString(current_index[0])+current_index[1], read_pos);
-            }
+            if (item_list[NAVAID_NAME_INDEX].contains("ILS") || item_list[NAVAID_DMEFLAG_INDEX].toInt() != 0)
+                type = NavdataIdentIndex::TYPE_ILS;
+            else
+                type = NavdataIdentIndex::TYPE_NDB;
         }
-        else if (found_airway_name.length() > 1 && found_airway_name.at(1) != current_index[1])
+        else if (item_list[NAVAID_VORFLAG_INDEX] != "1")
         {
-            current_index[1] = found_airway_name.at(1);
-            m_airway_index_map.insert(QString(current_index[0])+current_index[1], read_pos);
+            continue;
         }
+
+        QString item_id = item_list[NAVAID_ID_INDEX];
+        normalizeID(item_id);
+        m_navaid_ident_index.insert(item_id, read_pos, type, item_list[NAVAID_CCODE_INDEX]);
+
+        bool convok1 = false, convok2 = false;
+        double lat = item_list[NAVAID_LAT_INDEX].toDouble(&convok1)/COORD_FACTOR;
+        double lon = item_list[NAVAID_LON_INDEX].toDouble(&convok2)/COORD_FACTOR;
+        if (convok1 && convok2) m_navaid_ident_search.insert(item_id, item_id, lat, lon, type);
+
+        // VORs and NDBs are spatially indexed, ILSs are not
+
+        if (type == NavdataIdentIndex::TYPE_ILS) continue;
+
+        Waypoint* navaid = parseNavaid(line);
+        if (navaid == 0) continue;
+
+        if (navaid->asVor() != 0)
+            m_spatial_vor_list.append(*navaid->asVor());
+        else if (navaid->asNdb() != 0)
+            m_spatial_ndb_list.append(*navaid->asNdb());
+
+        delete navaid;
     }
 
-    Logger::log(QString("Navdata:indexAirways: generated %1 index lines").arg(m_airway_index_map.count()));
+    m_navaid_ident_index.finalize();
+    m_navaid_ident_search.finalize();
     return true;
 }
 
 /////////////////////////////////////////////////////////////////////////////
 
-bool Navdata::indexAirports()
+bool Navdata::indexAirways(QCryptographicHash& hash)
 {
-    m_valid = false;
-    MYASSERT(m_airport_file->reset());
-    m_airport_index_map.clear();
-    m_airport_list_coordinate_index_map.clear();
-
-    QList<QChar> current_index;
-    current_index.append(QChar('*'));
-    current_index.append(QChar('*'));
+    m_airway_ident_index.clear();
 
-    while(!m_airport_file->atEnd())
+    MYASSERT(m_airway_file->reset());
+    while(!m_airway_file->atEnd())
     {
-        // read the airport line
+        qint64 read_pos = m_airway_file->pos();
+        QByteArray line_array = m_airway_file->readLine();
+        hash.addData(line_array);
 
-        qint64 read_pos = m_airport_file->pos();
-        QByteArray line_array = m_airport_file->readLine();
         QString line(line_array);
         line = line.trimmed();
-        if (line.isEmpty()) continue;
-        line = line.toUpper();
+        if (line.isEmpty() || line.at(0).toUpper() != AIRWAY_ROUTE_PREFIX) continue;
 
-        if (line.at(0) != AIRPORT_RECORD_PREFIX) continue;
+        QStringList item_list = line.split(NDSEP);
+        if (item_list.count() <= AIRWAY_NAME_INDEX) continue;
+        m_airway_ident_index.insert(item_list[AIRWAY_NAME_INDEX], read_pos, NavdataIdentIndex::TYPE_AIRWAY);
+    }
 
-        // read the runway lines of the airport
+    m_airway_ident_index.finalize();
 
-        QStringList runway_lines;
-        while(!m_airport_file->atEnd())
-        {
-            QByteArray line_array = m_airport_file->readLine();
-            QString line(line_array);
-            line = line.trimmed();
-            if (line.isEmpty()) break;
-            line = line.toUpper();
-            if (line.at(0) != RUNWAY_RECORD_PREFIX) break;
-            runway_lines.append(line);
-        }
+    // an empty graph is kept, the file would not parse next time either
+    if (!buildAirwayGraph()) Logger::log("Navdata:indexAirways: could not build the airway graph");
+    return true;
+}
 
-        // parse the data
+/////////////////////////////////////////////////////////////////////////////
 
-        Airport found_airport;
+bool Navdata::indexAirports(QCryptographicHash& hash)
+{
+    m_airport_ident_index.clear();
+    m_airport_ident_search.clear();
+    m_spatial_airport_list.clear();
 
-        if (!parseAirport(line, runway_lines, &found_airport))
-        {
-            Logger::log(QString("Navdata:indexAirports: ERROR: "
-                                "Could not parse airport (%1)").arg(line));
-            return false;
-        }
+    QString airport_line;
+    QStringList runway_lines;
 
-        // create ID index
+    MYASSERT(m_airport_file->reset());
+    while(true)
+    {
+        bool at_end = m_airport_file->atEnd();
+        qint64 read_pos = m_airport_file->pos();
+        QString line;
 
-        if (found_airport.id().at(0) != current_index[0])
+        if (!at_end)
         {
-            current_index[0] = found_airport.id().at(0);
-            m_airport_index_map.insert(current_index[0], read_pos);
+            QByteArray line_array = m_airport_file->readLine();
+            hash.addData(line_array);
 
-            current_index[1] = '*';
-            if (found_airport.id().length() > 1)
+            line = QString(line_array).trimmed().toUpper();
+            if (!line.isEmpty() && line.at(0) == RUNWAY_RECORD_PREFIX)
             {
-                current_index[1] = found_airport.id().at(1);
-                m_airport_index_map.insert(QString(current_index[0])+current_index[1], read_pos);
+                if (!airport_line.isEmpty()) runway_lines.append(line);
+                continue;
             }
         }
-        else if (line.length() > 1 && found_airport.id().at(1) != current_index[1])
-        {
-            current_index[1] = found_airport.id().at(1);
-            m_airport_index_map.insert(QString(current_index[0])+current_index[1], read_pos);
-        }
 
-        // create coordinate index for airport with at least one runway longer than 2000m
+        // every non-runway line terminates the current airport
 
-        RunwayMapIterator rwy_iter = found_airport.runwayMapIterator();
-        while(rwy_iter.hasNext())
+        if (!airport_line.isEmpty())
         {
-            const Runway& rwy = rwy_iter.next().value();
+            Airport airport;
+            if (!parseAirport(airport_line, runway_lines, &airport))
+            {
+                Logger::log(QString("Navdata:indexAirports: ERROR: "
+                                    "Could not parse airport (%1)").arg(airport_line));
+                return false;
+            }
 
-            if (rwy.lengthM() >= 2000)
+            // airports are searched by ident and by the words of their name
+
+            m_airport_ident_search.insert(airport.id(), airport.id(), airport.lat(), airport.lon(),
+                                          NavdataIdentIndex::TYPE_AIRPORT);
+
+            QStringList name_keys = NavdataIdentSearch::nameKeys(airport.name());
+            QStringList::const_iterator key_iter = name_keys.begin();
+            for(; key_iter != name_keys.end(); ++key_iter)
+                m_airport_ident_search.insert(*key_iter, airport.id(), airport.lat(), airport.lon(),
+                                              NavdataIdentIndex::TYPE_AIRPORT);
+
+            // airports with at least one runway longer than 2000m are spatially indexed
+
+            RunwayMapIterator rwy_iter = airport.runwayMapIterator();
+            while(rwy_iter.hasNext())
             {
-                QString coordinate_index = getCoordinateIndex(found_airport);
-                m_airport_list_coordinate_index_map[coordinate_index].append(found_airport);
+                if (rwy_iter.next().value().lengthM() < 2000) continue;
+                m_spatial_airport_list.append(airport);
                 break;
             }
+
+            airport_line = QString::null;
+            runway_lines.clear();
         }
+
+        if (at_end) break;
+        if (line.isEmpty() || line.at(0) != AIRPORT_RECORD_PREFIX) continue;
+
+        QStringList item_list = line.split(NDSEP);
+        if (item_list.count() <= AIRPORT_ID_INDEX) continue;
+        m_airport_ident_index.insert(item_list[AIRPORT_ID_INDEX], read_pos, NavdataIdentIndex::TYPE_AIRPORT);
+        airport_line = line;
     }
 
-    Logger::log(QString("Navdata::indexAirports: generated %1 ID index lines").
-                arg(m_airport_index_map.count()));
-    Logger::log(QString("Navdata::indexAirports: generated %1 coordinate index lines").
-                arg(m_airport_list_coordinate_index_map.count()));
+    m_airport_ident_index.finalize();
+    m_airport_ident_search.finalize();
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+template <class TYPE> static void serializeList(const QList<TYPE>& list, QDataStream& out)
+{
+    out << (qint32)list.count();
+    for(int index = 0; index < list.count(); ++index) list[index] >> out;
+}
+
+template <class TYPE> static void deSerializeList(QList<TYPE>& list, QDataStream& in)
+{
+    list.clear();
+
+    qint32 count = 0;
+    in >> count;
+    for(int index = 0; index < count && in.status() == QDataStream::Ok; ++index)
+    {
+        TYPE item;
+        item << in;
+        list.append(item);
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+QByteArray Navdata::serializeIndex(NavdataIndexFile::Source source) const
+{
+    QByteArray payload;
+    QDataStream out(&payload, QIODevice::WriteOnly);
+    out.setVersion(QDataStream::Qt_4_0);
+
+    switch(source)
+    {
+        case(NavdataIndexFile::SOURCE_WAYPOINTS): {
+            m_waypoint_ident_index >> out;
+            m_waypoint_ident_search >> out;
+            break;
+        }
+        case(NavdataIndexFile::SOURCE_AIRWAYS): {
+            m_airway_ident_index >> out;
+            m_airway_graph >> out;
+            break;
+        }
+        case(NavdataIndexFile::SOURCE_AIRPORTS): {
+            m_airport_ident_index >> out;
+            m_airport_ident_search >> out;
+            serializeList(m_spatial_airport_list, out);
+            break;
+        }
+        case(NavdataIndexFile::SOURCE_NAVAIDS): {
+            m_navaid_ident_index >> out;
+            m_navaid_ident_search >> out;
+            serializeList(m_spatial_vor_list, out);
+            serializeList(m_spatial_ndb_list, out);
+            break;
+        }
+        default: {
+            MYASSERT(false);
+            break;
+        }
+    }
+
+    return payload;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+bool Navdata::deSerializeIndex(NavdataIndexFile::Source source, const QByteArray& payload)
+{
+    QDataStream in(payload);
+    in.setVersion(QDataStream::Qt_4_0);
+
+    switch(source)
+    {
+        case(NavdataIndexFile::SOURCE_WAYPOINTS): {
+            m_waypoint_ident_index << in;
+            m_waypoint_ident_search << in;
+            break;
+        }
+        case(NavdataIndexFile::SOURCE_AIRWAYS): {
+            m_airway_ident_index << in;
+            m_airway_graph << in;
+            break;
+        }
+        case(NavdataIndexFile::SOURCE_AIRPORTS): {
+            m_airport_ident_index << in;
+            m_airport_ident_search << in;
+            deSerializeList(m_spatial_airport_list, in);
+            break;
+        }
+        case(NavdataIndexFile::SOURCE_NAVAIDS): {
+            m_navaid_ident_index << in;
+            m_navaid_ident_search << in;
+            deSerializeList(m_spatial_vor_list, in);
+            deSerializeList(m_spatial_ndb_list, in);
+            break;
+        }
+        default: {
+            MYASSERT(false);
+            break;
+        }
+    }
+
+    if (in.status() != QDataStream::Ok)
+    {
+        Logger::log(QString("Navdata:deSerializeIndex: corrupt index of %1").arg(sourceFile(source)->fileName()));
+        return false;
+    }
+
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void Navdata::buildImageIdentSearch()
+{
+    MYASSERT(m_image != 0);
+
+    m_waypoint_ident_search.clear();
+    const NavdataImageIntersection* intersections = m_image->intersectionRecords();
+    for(uint index = 0; index < m_image->intersectionCount(); ++index)
+    {
+        const NavdataImageIntersection& record = intersections[index];
+        QString id = m_image->string(record.id);
+        m_waypoint_ident_search.insert(id, id, record.lat / COORD_FACTOR, record.lon / COORD_FACTOR,
+                                       NavdataIdentIndex::TYPE_INTERSECTION);
+    }
+    m_waypoint_ident_search.finalize();
+
+    m_navaid_ident_search.clear();
+    const NavdataImageNavaid* navaids = m_image->navaidRecords();
+    for(uint index = 0; index < m_image->navaidCount(); ++index)
+    {
+        const NavdataImageNavaid& record = navaids[index];
+
+        NavdataIdentIndex::RecordType type = NavdataIdentIndex::TYPE_VOR;
+        if (record.type == NavdataImageNavaid::TYPE_NDB) type = NavdataIdentIndex::TYPE_NDB;
+        else if (record.type == NavdataImageNavaid::TYPE_ILS) type = NavdataIdentIndex::TYPE_ILS;
+
+        QString id = m_image->string(record.id);
+        m_navaid_ident_search.insert(id, id, record.lat / COORD_FACTOR, record.lon / COORD_FACTOR, type);
+    }
+    m_navaid_ident_search.finalize();
+
+    m_airport_ident_search.clear();
+    const NavdataImageAirport* airports = m_image->airportRecords();
+    for(uint index = 0; index < m_image->airportCount(); ++index)
+    {
+        const NavdataImageAirport& record = airports[index];
+        QString id = m_image->string(record.id);
+        double lat = record.lat / COORD_FACTOR;
+        double lon = record.lon / COORD_FACTOR;
+
+        m_airport_ident_search.insert(id, id, lat, lon, NavdataIdentIndex::TYPE_AIRPORT);
+
+        QStringList name_keys = NavdataIdentSearch::nameKeys(m_image->string(record.name));
+        QStringList::const_iterator key_iter = name_keys.begin();
+        for(; key_iter != name_keys.end(); ++key_iter)
+            m_airport_ident_search.insert(*key_iter, id, lat, lon, NavdataIdentIndex::TYPE_AIRPORT);
+    }
+    m_airport_ident_search.finalize();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void Navdata::buildSpatialIndexes()
+{
+    m_airport_spatial_index.clear();
+    for(int index = 0; index < m_spatial_airport_list.count(); ++index)
+        m_airport_spatial_index.insert(m_spatial_airport_list[index].lat(), m_spatial_airport_list[index].lon(), index);
+    m_airport_spatial_index.finalize();
+
+    m_vor_spatial_index.clear();
+    for(int index = 0; index < m_spatial_vor_list.count(); ++index)
+        m_vor_spatial_index.insert(m_spatial_vor_list[index].lat(), m_spatial_vor_list[index].lon(), index);
+    m_vor_spatial_index.finalize();
+
+    m_ndb_spatial_index.clear();
+    for(int index = 0; index < m_spatial_ndb_list.count(); ++index)
+        m_ndb_spatial_index.insert(m_spatial_ndb_list[index].lat(), m_spatial_ndb_list[index].lon(), index);
+    m_ndb_spatial_index.finalize();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+bool Navdata::buildAirwayGraph()
+{
+    QTime start_time;
+    start_time.start();
+
+    m_airway_graph.clear();
+
+    if (m_image != 0)
+    {
+        const NavdataImageAirway* airways = m_image->airwayRecords();
+        for(uint index = 0; index < m_image->airwayCount(); ++index)
+        {
+            Airway* airway = m_image->createAirway(airways[index]);
+            m_airway_graph.addAirway(*airway);
+            delete airway;
+        }
+    }
+    else
+    {
+        MYASSERT(m_airway_file->reset());
+        while(!m_airway_file->atEnd())
+        {
+            QString line(m_airway_file->readLine());
+            line = line.trimmed();
+            if (line.isEmpty()) continue;
+            line = line.toUpper();
+
+            if (line.at(0) != AIRWAY_ROUTE_PREFIX) continue;
+
+            QString airway_name;
+            int segment_count = 0;
+            if (!parseAirwayRoute(line, airway_name, segment_count))
+            {
+                Logger::log(QString("Navdata:buildAirwayGraph: ERROR: Could not parse airway (%1)").arg(line));
+                m_airway_graph.clear();
+                return false;
+            }
+
+            Airway* airway = readAirwaySegments(*m_airway_file, airway_name);
+            if (airway == 0)
+            {
+                m_airway_graph.clear();
+                return false;
+            }
+
+            m_airway_graph.addAirway(*airway);
+            delete airway;
+        }
+    }
+
+    m_airway_graph.finalize();
+
+    Logger::log(QString("Navdata:buildAirwayGraph: %1 fixes, %2 edges, %3 airways in %4ms").
+                arg(m_airway_graph.nodeCount()).arg(m_airway_graph.edgeCount()).
+                arg(m_airway_graph.airwayCount()).arg(start_time.elapsed()));
     return true;
 }
 
@@ -1097,6 +1465,40 @@ bool Navdata::parseAirport(const QString& line,
 
 /////////////////////////////////////////////////////////////////////////////
 
+Intersection* Navdata::parseIntersection(const QString& line) const
+{
+    QStringList item_list = line.split(NDSEP);
+    if (item_list.count() != 4)
+    {
+        Logger::log(QString("Navdata:parseIntersection: ERROR: "
+                            "could not find 4 items in line (%1)").arg(line));
+        return 0;
+    }
+
+    QString item_id = item_list[WPT_ID_INDEX];
+    //NOTE: this normalization is done because of erronous character
+    //inside the navdata waypoints file.
+    normalizeID(item_id);
+
+    bool convok1 = false, convok2 = false;
+    double lat = item_list[WPT_LAT_INDEX].toDouble(&convok1)/COORD_FACTOR;
+    double lon = item_list[WPT_LON_INDEX].toDouble(&convok2)/COORD_FACTOR;
+
+    if (!convok1 || ! convok2)
+    {
+        Logger::log(QString("Navdata:parseIntersection: ERROR: "
+                            "Could not convert LAT/LON of (%1/%2/%3)").
+                    arg(item_id).arg(item_list[WPT_LAT_INDEX]).arg(item_list[WPT_LON_INDEX]));
+        return 0;
+    }
+
+    Intersection* intersection = new Intersection(item_id, item_id, lat, lon, item_list[WPT_CCODE_INDEX]);
+    MYASSERT(intersection);
+    return intersection;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
 Waypoint* Navdata::parseNavaid(const QString& line,
                                const QString& wanted_id,
                                const QString& wanted_country_code,
@@ -1187,77 +1589,27 @@ uint Navdata::getNavaids(const QString& wanted_id,
                          const QString& wanted_country_code,
                          const QString& wanted_type) const
 {
-    QTime start_time;
-    start_time.start();
-
     MYASSERT(!wanted_id.isEmpty());
+    if (m_image != 0) return m_image->getNavaids(wanted_id, wpt_list, wanted_country_code, wanted_type);
 
-    if (!m_navaid_index_map.contains(wanted_id.at(0)))
-    {
-        Logger::log(QString("Navdata:getNavaids: WARNING: "
-                            "Could not find index for navaid (%1)").arg(wanted_id));
-
-        return 0;
-    }
-    else
-    {
-        if (wanted_id.length() > 1)
-        {
-            if (!m_navaid_index_map.contains(QString(wanted_id.at(0))+wanted_id.at(1)))
-            {
-                Logger::log(QString("Navdata:getNavaids: no two-char-index for %1").arg(wanted_id));
-                return 0;
-            }
-            m_navaid_file->seek(m_navaid_index_map[QString(wanted_id.at(0))+wanted_id.at(1)]);
-        }
-        else
-        {
-            m_navaid_file->seek(m_navaid_index_map[wanted_id.at(0)]);
-        }
-    }
+    QList<qint64> offset_list;
+    if (m_navaid_ident_index.lookup(wanted_id, offset_list, NavdataIdentIndex::recordType(wanted_type),
+                                    wanted_country_code) == 0)
+        return wpt_list.count();
 
-    bool found_navaid = false;
+    QFile* navaid_file = queryFile(NavdataIndexFile::SOURCE_NAVAIDS);
 
-    while (!m_navaid_file->atEnd())
+    QList<qint64>::const_iterator iter = offset_list.begin();
+    for(; iter != offset_list.end(); ++iter)
     {
-        QString line(m_navaid_file->readLine());
-        line = line.trimmed();
-        if (line.isEmpty()) continue;
-        line = line.toUpper();
-
-        Waypoint* navaid = parseNavaid(line, wanted_id, wanted_country_code, wanted_type);
-        if (navaid != 0)
-        {
-            found_navaid = true;
-            wpt_list.append(navaid);
-
-            // check if we are already past the possible cases in the navaid file
-
-            if (navaid->id().at(0) != wanted_id.at(0))
-            {
-                break;
-            }
-            else if (wanted_id.length() > 1 &&
-                     navaid->id().length() > 1 &&
-                     navaid->id().at(1) > wanted_id.at(1))
-            {
-                break;
-            }
-            else if (wanted_id.length() > 2 &&
-                     navaid->id().length() > 2 &&
-                     navaid->id().at(1) >= wanted_id.at(1) &&
-                     navaid->id().at(2) > wanted_id.at(2))
-            {
-                break;
-            }
+        navaid_file->seek(*iter);
+        QString line(navaid_file->readLine());
+        line = line.trimmed().toUpper();
 
-            if (found_navaid && navaid->id() != wanted_id) break;
-        }
+        Waypoint* navaid = parseNavaid(line, wanted_id.toUpper(), wanted_country_code, wanted_type);
+        if (navaid != 0) wpt_list.append(navaid);
     }
 
-//     Logger::log(QString("Navdata:getNavaids: searching for [%1] fin, found %2 entries in %3ms").
-//                 arg(wanted_id).arg(wpt_list.count()).arg(start_time.elapsed()));
-
     return wpt_list.count();
 }
 
@@ -1298,117 +1650,25 @@ Waypoint* Navdata::getElementsWithSignal(const QString& id,
 
 uint Navdata::getIntersections(const QString& wanted_id, WaypointPtrList& wpt_list) const
 {
-    //Logger::log(QString("Navdata:getIntersections: searching for [%1]").arg(wanted_id));
-
-    QTime start_time;
-    start_time.start();
-
     MYASSERT(!wanted_id.isEmpty());
+    if (m_image != 0) return m_image->getIntersections(wanted_id, wpt_list);
 
-    if (!m_waypoint_index_map.contains(wanted_id.at(0)))
-    {
-        Logger::log(QString("Navdata:getIntersections: WARNING: "
-                            "Could not find index for waypoint (%1)").arg(wanted_id));
-
-        return 0;
-    }
-    else
-    {
-        if (wanted_id.length() > 1)
-        {
-            if (!m_waypoint_index_map.contains(QString(wanted_id.at(0))+wanted_id.at(1)))
-            {
-                Logger::log(QString("Navdata:getNavaids: no two-char-index for %1").arg(wanted_id));
-                return 0;
-            }
+    QList<qint64> offset_list;
+    if (m_waypoint_ident_index.lookup(wanted_id, offset_list) == 0) return wpt_list.count();
 
-            m_waypoint_file->seek(m_waypoint_index_map[QString(wanted_id.at(0))+wanted_id.at(1)]);
-        }
-        else
-        {
-            m_waypoint_file->seek(m_waypoint_index_map[wanted_id.at(0)]);
-        }
-    }
-
-    bool found_waypoint = false;
+    QFile* waypoint_file = queryFile(NavdataIndexFile::SOURCE_WAYPOINTS);
 
-    while(!m_waypoint_file->atEnd())
+    QList<qint64>::const_iterator iter = offset_list.begin();
+    for(; iter != offset_list.end(); ++iter)
     {
-        QString line(m_waypoint_file->readLine());
-        line = line.trimmed();
-        if (line.isEmpty()) continue;
-        line = line.toUpper();
-
-        QStringList item_list = line.split(NDSEP);
-        if (item_list.count() != 4)
-        {
-            Logger::log(QString("Navdata:getIntersections: ERROR: "
-                                "could not find 4 items in line (%1)").arg(line));
-            continue;
-        }
-
-        // check if we found an item
-
-        QString item_id = item_list[WPT_ID_INDEX];
-        //NOTE: this normalization is done because of erronous character
-        //inside the navdata waypoints file.
-        normalizeID(item_id);
-
-        if (item_id == wanted_id)
-        {
-            found_waypoint = true;
-
-            bool convok1 = false, convok2 = false;
-
-            Intersection* intersection =
-                new Intersection(item_id,
-                                 item_id,
-                                 item_list[WPT_LAT_INDEX].toDouble(&convok1)/COORD_FACTOR,
-                                 item_list[WPT_LON_INDEX].toDouble(&convok2)/COORD_FACTOR,
-                                 item_list[WPT_CCODE_INDEX]);
-            MYASSERT(intersection);
-
-            if (!convok1 || ! convok2)
-            {
-                Logger::log(QString("Navdata:getIntersections: ERROR: "
-                                    "Could not convert LAT/LON of (%1/%2/%3)").
-                            arg(item_id).
-                            arg(item_list[WPT_LAT_INDEX]).
-                            arg(item_list[WPT_LON_INDEX]));
-
-                delete intersection;
-            }
-            else
-            {
-                wpt_list.append(intersection);
-            }
-        }
-
-        // check if we are already past the possible cases in the navaid file
-
-        if (item_id.at(0) != wanted_id.at(0))
-        {
-            break;
-        }
-        else if (wanted_id.length() > 1 &&
-                 item_id.length() > 1 &&
-                 item_id.at(1) > wanted_id.at(1))
-        {
-            break;
-        }
-        else if (wanted_id.length() > 2 &&
-                 item_id.length() > 2 &&
-                 item_id.at(1) >= wanted_id.at(1) &&
-                 item_id.at(2) > wanted_id.at(2))
-        {
-            break;
-        }
+        waypoint_file->seek(*iter);
+        QString line(waypoint_file->readLine());
+        line = line.trimmed().toUpper();
 
-        if (found_waypoint && item_id != wanted_id) break;
+        Intersection* intersection = parseIntersection(line);
+        if (intersection != 0) wpt_list.append(intersection);
     }
 
-    Logger::log(QString("Navdata:getIntersections: searching for [%1] fin, found %2 entries in %3ms").
-                arg(wanted_id).arg(wpt_list.count()).arg(start_time.elapsed()));
     return wpt_list.count();
 }
 
@@ -1487,294 +1747,617 @@ uint Navdata::getWaypoints(const QString& wpt_name,
 
 /////////////////////////////////////////////////////////////////////////////
 
-Waypoint* Navdata::getIntersectionFromLatLonString(const QString& id,
-                                                   const QString& latlon_string,
-                                                   const QRegExp& regexp) const
+uint Navdata::getWaypointCandidates(const QStringList& ids, WaypointCandidateMap& candidates) const
 {
-    if (latlon_string.isEmpty() || !regexp.isValid() || regexp.isEmpty()) return 0;
+    // unique IDs which are not yet in the map
 
-    QRegExp latlon_regexp = regexp;
-    if (latlon_regexp.indexIn(latlon_string) < 0) return 0;
+    QStringList wanted_ids;
+    QSet<QString> wanted_id_set;
+    QStringList::const_iterator id_iter = ids.begin();
+    for(; id_iter != ids.end(); ++id_iter)
+    {
+        QString id = id_iter->trimmed().toUpper();
+        if (id.isEmpty() || id.contains(" ") || candidates.contains(id) || wanted_id_set.contains(id)) continue;
+        wanted_id_set.insert(id);
+        wanted_ids.append(id);
+    }
 
-    // convert latitude
+    if (wanted_ids.isEmpty()) return 0;
 
-    QString lat_char = latlon_regexp.cap(1);
-    QString lat_deg_string = latlon_regexp.cap(2);
-    QString lat_min_string = latlon_regexp.cap(3);
+    // per ID lists of the found airports, navaids and intersections
 
-    double lat = lat_deg_string.toDouble() + (lat_min_string.toDouble() * (1/60.0));
-    if (lat_char == "S") lat *= -1.0;
+    QVector<WaypointPtrList*> airport_lists(wanted_ids.count());
+    QVector<WaypointPtrList*> navaid_lists(wanted_ids.count());
+    QVector<WaypointPtrList*> intersection_lists(wanted_ids.count());
 
-    // convert longitude
+    for(int index = 0; index < wanted_ids.count(); ++index)
+    {
+        airport_lists[index] = new WaypointPtrList;
+        navaid_lists[index] = new WaypointPtrList;
+        intersection_lists[index] = new WaypointPtrList;
+        MYASSERT(airport_lists[index] != 0 && navaid_lists[index] != 0 && intersection_lists[index] != 0);
+    }
 
-    QString lon_char = latlon_regexp.cap(4);
-    QString lon_deg_string = latlon_regexp.cap(5);
-    QString lon_min_string = latlon_regexp.cap(6);
+    if (m_image != 0)
+    {
+        for(int index = 0; index < wanted_ids.count(); ++index)
+        {
+            const QString& id = wanted_ids[index];
+            if (id.length() <= 4) m_image->getAirports(id, *airport_lists[index]);
+            m_image->getNavaids(id, *navaid_lists[index]);
+            m_image->getIntersections(id, *intersection_lists[index]);
+        }
+    }
+    else
+    {
+        // collect the file offsets of all IDs, sort them and read every
+        // file in a single forward pass instead of seeking back and forth
 
-    double lon = lon_deg_string.toDouble() + (lon_min_string.toDouble() * (1/60.0));
-    if (lon_char == "W") lon *= -1.0;
+        QList<CandidateRead> airport_reads;
+        QList<CandidateRead> navaid_reads;
+        QList<CandidateRead> intersection_reads;
 
-    Waypoint* wpt = new Waypoint(id, QString::null, lat, lon);
-    MYASSERT(wpt != 0);
-    return wpt;
-}
+        for(int index = 0; index < wanted_ids.count(); ++index)
+        {
+            const QString& id = wanted_ids[index];
+            QList<qint64> offset_list;
 
-/////////////////////////////////////////////////////////////////////////////
+            if (id.length() <= 4) m_airport_ident_index.lookup(id, offset_list);
+            addCandidateReads(offset_list, index, airport_reads);
 
-uint Navdata::getAirways(const QString& airway_name, AirwayPtrList& airways) const
-{
-    QTime start_time;
-    start_time.start();
+            m_navaid_ident_index.lookup(id, offset_list);
+            addCandidateReads(offset_list, index, navaid_reads);
 
-    MYASSERT(!airway_name.isEmpty());
-    airways.clear();
+            m_waypoint_ident_index.lookup(id, offset_list);
+            addCandidateReads(offset_list, index, intersection_reads);
+        }
 
-    if (!m_airway_index_map.contains(airway_name.at(0)))
-    {
-        Logger::log(QString("Navdata:getAirways: WARNING: "
-                            "Could not find index for airway (%1)").arg(airway_name));
-        return 0;
+        qSort(airport_reads);
+        qSort(navaid_reads);
+        qSort(intersection_reads);
+
+        QList<CandidateRead>::const_iterator read_iter = airport_reads.begin();
+        for(; read_iter != airport_reads.end(); ++read_iter)
+        {
+            Airport* airport = readAirport(read_iter->offset);
+            if (airport != 0) airport_lists[read_iter->id_index]->append(airport);
+        }
+
+        QFile* navaid_file = queryFile(NavdataIndexFile::SOURCE_NAVAIDS);
+        for(read_iter = navaid_reads.begin(); read_iter != navaid_reads.end(); ++read_iter)
+        {
+            if (navaid_file->pos() != read_iter->offset) navaid_file->seek(read_iter->offset);
+            QString line(navaid_file->readLine());
+            line = line.trimmed().toUpper();
+
+            Waypoint* navaid = parseNavaid(line, wanted_ids[read_iter->id_index]);
+            if (navaid != 0) navaid_lists[read_iter->id_index]->append(navaid);
+        }
+
+        QFile* waypoint_file = queryFile(NavdataIndexFile::SOURCE_WAYPOINTS);
+        for(read_iter = intersection_reads.begin(); read_iter != intersection_reads.end(); ++read_iter)
+        {
+            if (waypoint_file->pos() != read_iter->offset) waypoint_file->seek(read_iter->offset);
+            QString line(waypoint_file->readLine());
+            line = line.trimmed().toUpper();
+
+            Intersection* intersection = parseIntersection(line);
+            if (intersection != 0) intersection_lists[read_iter->id_index]->append(intersection);
+        }
     }
-    else
+
+    // merge the lists like getWaypoints() does
+
+    uint added_count = 0;
+    for(int index = 0; index < wanted_ids.count(); ++index)
     {
-        if (airway_name.length() > 1)
+        WaypointPtrList* result_list = airport_lists[index];
+        WaypointPtrList* navaid_list = navaid_lists[index];
+        WaypointPtrList* intersection_list = intersection_lists[index];
+
+        while(!navaid_list->isEmpty()) result_list->append(navaid_list->takeFirst());
+
+        while(!intersection_list->isEmpty())
         {
-            if (!m_airway_index_map.contains(QString(airway_name.at(0))+airway_name.at(1)))
+            Waypoint* intersection = intersection_list->takeFirst();
+
+            bool is_the_same = false;
+            WaypointPtrListIterator result_iter(*result_list);
+            while(result_iter.hasNext() && !is_the_same)
             {
-                Logger::log(QString("Navdata:getAirways: no two-char-index for %1").arg(airway_name));
-                return 0;
+                const Waypoint* waypoint = result_iter.next();
+                is_the_same = (waypoint->asNdb() != 0 && *waypoint == *intersection);
             }
-            m_airway_file->seek(m_airway_index_map[QString(airway_name.at(0))+airway_name.at(1)]);
+
+            if (is_the_same) delete intersection;
+            else result_list->append(intersection);
         }
-        else
+
+        delete navaid_list;
+        delete intersection_list;
+
+        if (result_list->isEmpty())
         {
-            m_airway_file->seek(m_airway_index_map[airway_name.at(0)]);
+            delete result_list;
+            continue;
         }
+
+        candidates.insert(wanted_ids[index], result_list);
+        ++added_count;
     }
 
-    while(!m_airway_file->atEnd())
+    return added_count;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void Navdata::addCandidateReads(QList<qint64>& offset_list, int id_index, QList<CandidateRead>& reads)
+{
+    QList<qint64>::const_iterator iter = offset_list.begin();
+    for(; iter != offset_list.end(); ++iter)
     {
-        QByteArray line_array = m_airway_file->readLine();
-        QString line(line_array);
-        line = line.trimmed();
-        if (line.isEmpty()) continue;
-        line = line.toUpper();
+        CandidateRead read;
+        read.offset = *iter;
+        read.id_index = id_index;
+        reads.append(read);
+    }
 
-        QStringList item_list = line.split(NDSEP);
-        if (item_list[AIRWAY_PREFIX_INDEX].at(0) != AIRWAY_ROUTE_PREFIX) continue;
+    offset_list.clear();
+}
 
-        QString found_airway_name;
-        int segment_count = 0;
+/////////////////////////////////////////////////////////////////////////////
+
+uint Navdata::resolveRoutes(const QList<QStringList>& routes,
+                            const QRegExp& lat_lon_regexp,
+                            NavdataResolvedRoutePtrList& results) const
+{
+    // look up all fixes of all routes at once, airway names are looked up
+    // too, but they normally do not match any fix
+
+    QStringList ids;
+    QList<QStringList>::const_iterator route_iter = routes.begin();
+    for(; route_iter != routes.end(); ++route_iter) ids += *route_iter;
 
-        if (!parseAirwayRoute(line, found_airway_name, segment_count))
+    WaypointCandidateMap candidates;
+    getWaypointCandidates(ids, candidates);
+
+    uint resolved_count = 0;
+    int first_result = results.count();
+
+    for(route_iter = routes.begin(); route_iter != routes.end(); ++route_iter)
+    {
+        NavdataResolvedRoute* result = new NavdataResolvedRoute;
+        MYASSERT(result != 0);
+        results.append(result);
+
+        if (resolveRoute(*route_iter, Waypoint(), lat_lon_regexp, candidates, *result)) ++resolved_count;
+    }
+
+    // resolve the navaids among the airway fixes of all routes at once
+
+    QStringList airway_fix_ids;
+    for(int index = first_result; index < results.count(); ++index)
+    {
+        WaypointPtrListIterator wpt_iter(results[index]->waypoints);
+        while(wpt_iter.hasNext())
         {
-            Logger::log(QString("Navdata:getAirways: ERROR: "
-                                "Could not read parse airway (%1) - aborting").arg(line));
-            airways.clear();
-            return 0;
+            const Waypoint* waypoint = wpt_iter.next();
+            if (waypoint->type() == Waypoint::TYPE_WAYPOINT && !waypoint->parent().isEmpty())
+                airway_fix_ids.append(waypoint->id());
         }
+    }
+
+    getWaypointCandidates(airway_fix_ids, candidates);
+
+    for(int index = first_result; index < results.count(); ++index)
+        resolveAirwayNavaids(results[index]->waypoints, &candidates);
+
+    qDeleteAll(candidates);
+    return resolved_count;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+bool Navdata::resolveRoute(const QStringList& route,
+                           const Waypoint& reference,
+                           const QRegExp& lat_lon_regexp,
+                           NavdataResolvedRoute& result) const
+{
+    WaypointCandidateMap candidates;
+    getWaypointCandidates(route, candidates);
+
+    bool ok = resolveRoute(route, reference, lat_lon_regexp, candidates, result);
+    resolveAirwayNavaids(result.waypoints, &candidates);
+
+    qDeleteAll(candidates);
+    return ok;
+}
+
+/////////////////////////////////////////////////////////////////////////////
 
-        // check if we should break
+bool Navdata::resolveICAORoute(const QString& route,
+                               const QRegExp& lat_lon_regexp,
+                               NavdataResolvedRoute& result) const
+{
+    result.waypoints.clear();
+    delete result.departure_airport;
+    result.departure_airport = 0;
+    delete result.destination_airport;
+    result.destination_airport = 0;
 
-        if (found_airway_name.at(0) != airway_name.at(0))
+    if (route.isEmpty()) 
+    {
+        result.error_text = "Route is empty";
+        return false;
+    }
+
+    QStringList route_item_list = route.toUpper().trimmed().split(" ", QString::SkipEmptyParts);
+
+    if (route_item_list.count() >= 2 && route_item_list[0] == route_item_list[1]) route_item_list.removeFirst();
+    if (route_item_list.count() >= 2 && 
+        route_item_list[route_item_list.count()-2] == route_item_list[route_item_list.count()-1]) 
+        route_item_list.removeLast();
+
+    if (route_item_list.count() < 2)
+    {
+        result.error_text = "Could not parse route";
+        return false;
+    }
+
+    // departure and destination airport
+
+    WaypointPtrList airport_list;
+    getAirports(route_item_list.first(), airport_list);
+    if (airport_list.count() == 1)
+    {
+        result.departure_airport = (Airport*)airport_list.takeFirst();
+        route_item_list.removeFirst();
+    }
+
+    airport_list.clear();
+    getAirports(route_item_list.last(), airport_list);
+    if (airport_list.count() == 1)
+    {
+        result.destination_airport = (Airport*)airport_list.takeFirst();
+        route_item_list.removeLast();
+    }
+
+    // the route in between
+
+    Waypoint reference_wpt;
+    if (result.departure_airport != 0) reference_wpt = *result.departure_airport;
+
+    if (!resolveRoute(route_item_list, reference_wpt, lat_lon_regexp, result))
+    {
+        if (result.failed_token_index+1 != route_item_list.count()) return false;
+
+        // we tolerate not finding the last waypoint, because
+        // this could be a star or other procedure
+        result.failed_token_index = -1;
+        result.error_text = QString::null;
+    }
+
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+bool Navdata::resolveRoute(const QStringList& route,
+                           const Waypoint& reference,
+                           const QRegExp& lat_lon_regexp,
+                           const WaypointCandidateMap& candidates,
+                           NavdataResolvedRoute& result) const
+{
+    result.waypoints.clear();
+    result.failed_token_index = -1;
+    result.error_text = QString::null;
+
+    // the last fix added by this route, 0 after a "DCT"
+    const Waypoint* last_wpt = 0;
+
+    for(int index = 0; index < route.count(); ++index)
+    {
+        QString token = route[index].trimmed().toUpper();
+        if (token.isEmpty()) continue;
+
+        if (token == "DCT")
         {
-            break;
+            last_wpt = 0;
+            continue;
         }
-        else if (found_airway_name.length() > 1 &&
-                 airway_name.length() > 1 &&
-                 found_airway_name.at(1) > airway_name.at(1))
+
+        //----- try an airway from the last fix
+
+        if (last_wpt != 0 && index+1 < route.count())
         {
-            break;
+            int count_before = result.waypoints.count();
+            if (m_airway_graph.getWaypointsByAirway(*last_wpt, token, route[index+1].trimmed().toUpper(),
+                                                    result.waypoints))
+            {
+                last_wpt = result.waypoints.last();
+                ++index;
+                continue;
+            }
+
+            while(result.waypoints.count() > count_before) result.waypoints.removeAt(count_before);
         }
-        else if (found_airway_name.length() > 1 &&
-                 airway_name.length() > 1 &&
-                 found_airway_name.at(1) > airway_name.at(1))
+
+        //----- look up a single fix
+
+        WaypointPtrList lookup_list;
+        const WaypointPtrList* candidate_list = candidates.value(token);
+
+        if (candidate_list == 0)
         {
-            break;
+            // LAT/LON and runway waypoints are not in the candidate map
+            getWaypoints(token, lookup_list, lat_lon_regexp);
+            candidate_list = &lookup_list;
         }
-        else if (found_airway_name.length() > 2 &&
-                 airway_name.length() > 2 &&
-                 found_airway_name.at(1) >= airway_name.at(1) &&
-                 found_airway_name.at(2) > airway_name.at(2))
+
+        if (candidate_list->isEmpty())
         {
-            break;
+            result.failed_token_index = index;
+            result.error_text = QString("%1 not found").arg(token);
+            return false;
         }
 
-        if (found_airway_name != airway_name) continue;
+        const Waypoint* chosen_wpt = 0;
 
-        //Logger::log(QString("Navdata:getAirways: found (%1)").arg(found_airway_name));
+        if (last_wpt != 0)
+        {
+            chosen_wpt = nearestCandidate(*candidate_list, *last_wpt);
+        }
+        else if (reference.isValid())
+        {
+            chosen_wpt = nearestCandidate(*candidate_list, reference);
+        }
+        else
+        {
+            // take the first later fix with a unique ID as the reference
+            const Waypoint* unique_wpt = 0;
+            for(int later_index = index+1; later_index < route.count() && unique_wpt == 0; ++later_index)
+            {
+                const WaypointPtrList* later_list = candidates.value(route[later_index].trimmed().toUpper());
+                if (later_list != 0 && later_list->count() == 1) unique_wpt = later_list->first();
+            }
 
-        //----- loop through airway segments
+            chosen_wpt = (unique_wpt != 0) ?
+                         nearestCandidate(*candidate_list, *unique_wpt) : candidate_list->first();
+        }
 
-        bool first_segment = true;
-        Waypoint prev_waypoint2;
-        Airway* airway = new Airway(airway_name);
-        MYASSERT(airway);
+        MYASSERT(chosen_wpt != 0);
+        result.waypoints.append(chosen_wpt->deepCopy());
+        last_wpt = result.waypoints.last();
+    }
 
-        while(!m_airway_file->atEnd())
-        {
-            QByteArray line_array = m_airway_file->readLine();
-            QString line(line_array);
-            line = line.trimmed();
-            if (line.isEmpty()) break;
-            line = line.toUpper();
+    return true;
+}
 
-            QStringList item_list = line.split(NDSEP);
-            if (item_list[AIRWAY_SEGMENT_PREFIX_INDEX].at(0) !=
-                AIRWAY_ROUTE_SEGMENT_PREFIX) break;
+/////////////////////////////////////////////////////////////////////////////
 
-            Waypoint waypoint1;
-            Waypoint waypoint2;
-            int inbound_course = 0;
-            int outbound_course = 0;
-            double distance = 0;
+const Waypoint* Navdata::nearestCandidate(const WaypointPtrList& candidates, const Waypoint& reference) const
+{
+    MYASSERT(!candidates.isEmpty());
+    if (!reference.isValid()) return candidates.first();
 
-            if (!parseAirwayRouteSegment(line, waypoint1, waypoint2,
-                                         inbound_course, outbound_course, distance))
-            {
-                Logger::log(QString("Navdata:getAirways: ERROR: "
-                                    "Could not read parse airway segment (%1) - aborting").arg(line));
+    const Waypoint* nearest_wpt = 0;
+    double nearest_distance_nm = 0.0;
 
-                airways.clear();
-                delete airway;
-                airway = 0;
-                return 0;
-            }
+    WaypointPtrListIterator iter(candidates);
+    while(iter.hasNext())
+    {
+        const Waypoint* waypoint = iter.next();
+        double distance_nm = Navcalc::getDistBetweenWaypoints(reference, *waypoint);
+        if (nearest_wpt != 0 && distance_nm >= nearest_distance_nm) continue;
 
-            waypoint1.setParent(airway->id());
-            waypoint2.setParent(airway->id());
+        nearest_wpt = waypoint;
+        nearest_distance_nm = distance_nm;
+    }
 
-            if (first_segment)
-            {
-                airway->appendWaypoint(waypoint1);
-                first_segment = false;
-            }
-            else
-            {
-                if (waypoint1.name() != prev_waypoint2.name())
-                {
-                    Logger::log(QString("Navdata:getAirways: ERROR: "
-                                        "(AW: %1) 2nd waypoint of the last segment is different "
-                                        "from the 1st waypoint of the current segment "
-                                        "(%2 vs. %3) - aborting").
-                                arg(airway_name).arg(prev_waypoint2.name()).arg(waypoint1.name()));
-
-                    airways.clear();
-                    delete airway;
-                    airway = 0;
-                    return 0;
-                }
-            }
+    return nearest_wpt;
+}
 
-            airway->appendWaypoint(waypoint2);
-            prev_waypoint2 = waypoint2;
-        }
+/////////////////////////////////////////////////////////////////////////////
 
-// add airway to list
+Waypoint* Navdata::getIntersectionFromLatLonString(const QString& id,
+                                                   const QString& latlon_string,
+                                                   const QRegExp& regexp) const
+{
+    if (latlon_string.isEmpty() || !regexp.isValid() || regexp.isEmpty()) return 0;
 
-        if (airway != 0 && airway->count() > 0)
-            airways.append(airway);
-        else
-            delete airway;
-    }
+    QRegExp latlon_regexp = regexp;
+    if (latlon_regexp.indexIn(latlon_string) < 0) return 0;
 
-    Logger::log(QString("Navdata:getAirways: searching for [%1] fin, found %2 entries in %3ms").
-                arg(airway_name).arg(airways.count()).arg(start_time.elapsed()));
+    // convert latitude
 
-    return airways.count();
+    QString lat_char = latlon_regexp.cap(1);
+    QString lat_deg_string = latlon_regexp.cap(2);
+    QString lat_min_string = latlon_regexp.cap(3);
+
+    double lat = lat_deg_string.toDouble() + (lat_min_string.toDouble() * (1/60.0));
+    if (lat_char == "S") lat *= -1.0;
+
+    // convert longitude
+
+    QString lon_char = latlon_regexp.cap(4);
+    QString lon_deg_string = latlon_regexp.cap(5);
+    QString lon_min_string = latlon_regexp.cap(6);
+
+    double lon = lon_deg_string.toDouble() + (lon_min_string.toDouble() * (1/60.0));
+    if (lon_char == "W") lon *= -1.0;
+
+    Waypoint* wpt = new Waypoint(id, QString::null, lat, lon);
+    MYASSERT(wpt != 0);
+    return wpt;
 }
 
 /////////////////////////////////////////////////////////////////////////////
 
-uint Navdata::getAirports(const QString& name, WaypointPtrList& airports) const
+uint Navdata::getAirways(const QString& airway_name, AirwayPtrList& airways) const
 {
-    QTime start_time;
-    start_time.start();
+    MYASSERT(!airway_name.isEmpty());
+    if (m_image != 0) return m_image->getAirways(airway_name, airways);
 
-    MYASSERT(!name.isEmpty());
+    airways.clear();
 
-    if (!m_airport_index_map.contains(name.at(0)))
-    {
-        Logger::log(QString("Navdata:getAirports: WARNING: "
-                            "Could not find index for airport (%1)").arg(name));
+    QList<qint64> offset_list;
+    if (m_airway_ident_index.lookup(airway_name, offset_list) == 0) return 0;
 
-        return 0;
-    }
-    else
+    QFile* airway_file = queryFile(NavdataIndexFile::SOURCE_AIRWAYS);
+
+    QList<qint64>::const_iterator iter = offset_list.begin();
+    for(; iter != offset_list.end(); ++iter)
     {
-        if (name.length() > 1)
+        // skip the airway route line, the segments follow
+        airway_file->seek(*iter);
+        airway_file->readLine();
+
+        Airway* airway = readAirwaySegments(*airway_file, airway_name.toUpper());
+        if (airway == 0)
         {
-            if (!m_airport_index_map.contains(QString(name.at(0))+name.at(1)))
-            {
-                Logger::log(QString("Navdata:getAirports: no two-char-index for %1").arg(name));
-                return 0;
-            }
-            m_airport_file->seek(m_airport_index_map[QString(name.at(0))+name.at(1)]);
+            airways.clear();
+            return 0;
         }
+
+        if (airway->count() > 0)
+            airways.append(airway);
         else
-        {
-            m_airport_file->seek(m_airport_index_map[name.at(0)]);
-        }
+            delete airway;
     }
 
-    bool found_airport = false;
+    return airways.count();
+}
 
-    while(!m_airport_file->atEnd())
-    {
-        // read the airport line
+/////////////////////////////////////////////////////////////////////////////
 
-        QByteArray line_array = m_airport_file->readLine();
+Airway* Navdata::readAirwaySegments(QFile& airway_file, const QString& airway_name) const
+{
+    bool first_segment = true;
+    Waypoint prev_waypoint2;
+    Airway* airway = new Airway(airway_name);
+    MYASSERT(airway);
+
+    while(!airway_file.atEnd())
+    {
+        QByteArray line_array = airway_file.readLine();
         QString line(line_array);
         line = line.trimmed();
-        if (line.isEmpty()) continue;
+        if (line.isEmpty()) break;
         line = line.toUpper();
 
-        if (line.at(0) != AIRPORT_RECORD_PREFIX) continue;
+        QStringList item_list = line.split(NDSEP);
+        if (item_list[AIRWAY_SEGMENT_PREFIX_INDEX].at(0) !=
+            AIRWAY_ROUTE_SEGMENT_PREFIX) break;
 
-        // read the runway lines of the airport
+        Waypoint waypoint1;
+        Waypoint waypoint2;
+        int inbound_course = 0;
+        int outbound_course = 0;
+        double distance = 0;
 
-        QStringList runway_lines;
-        while(!m_airport_file->atEnd())
+        if (!parseAirwayRouteSegment(line, waypoint1, waypoint2,
+                                     inbound_course, outbound_course, distance))
         {
-            QByteArray line_array = m_airport_file->readLine();
-            QString line(line_array);
-            line = line.trimmed();
-            if (line.isEmpty()) break;
-            line = line.toUpper();
-            if (line.at(0) != RUNWAY_RECORD_PREFIX) break;
-            runway_lines.append(line);
+            Logger::log(QString("Navdata:readAirwaySegments: ERROR: "
+                                "Could not read parse airway segment (%1) - aborting").arg(line));
+            delete airway;
+            return 0;
         }
 
-        // parse the data
-
-        Airport* airport = new Airport();
-        MYASSERT(airport);
+        waypoint1.setParent(airway->id());
+        waypoint2.setParent(airway->id());
 
-        if (!parseAirport(line, runway_lines, airport))
+        if (first_segment)
         {
-            Logger::log(QString("Navdata:getAirports: ERROR: "
-                                "Could not parse airport from line (%1) - aborting").arg(line));
+            airway->appendWaypoint(waypoint1);
+            first_segment = false;
+        }
+        else
+        {
+            if (waypoint1.name() != prev_waypoint2.name())
+            {
+                Logger::log(QString("Navdata:readAirwaySegments: ERROR: "
+                                    "(AW: %1) 2nd waypoint of the last segment is different "
+                                    "from the 1st waypoint of the current segment "
+                                    "(%2 vs. %3) - aborting").
+                            arg(airway_name).arg(prev_waypoint2.name()).arg(waypoint1.name()));
+                delete airway;
+                return 0;
+            }
+        }
+
+        airway->appendWaypoint(waypoint2);
+        prev_waypoint2 = waypoint2;
+    }
+
+    return airway;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+uint Navdata::getAirports(const QString& name, WaypointPtrList& airports) const
+{
+    MYASSERT(!name.isEmpty());
+    if (m_image != 0) return m_image->getAirports(name, airports);
+
+    QList<qint64> offset_list;
+    if (m_airport_ident_index.lookup(name, offset_list) == 0) return airports.count();
 
+    QList<qint64>::const_iterator iter = offset_list.begin();
+    for(; iter != offset_list.end(); ++iter)
+    {
+        Airport* airport = readAirport(*iter);
+        if (airport == 0)
+        {
             airports.clear();
-            delete airport;
-            airport = 0;
             break;
         }
 
-        if (airport->id().at(0) != name.at(0)) break;
-        if (found_airport && airport->id() != name) break;
+        airports.append(airport);
+    }
 
-        if (airport->id() == name)
-        {
-            found_airport = true;
-            airports.append(airport);
-        }
+    return airports.count();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+Airport* Navdata::readAirport(qint64 offset) const
+{
+    QFile* airport_file = queryFile(NavdataIndexFile::SOURCE_AIRPORTS);
+
+    // read the airport line
+
+    airport_file->seek(offset);
+    QString line(airport_file->readLine());
+    line = line.trimmed().toUpper();
+
+    // read the runway lines of the airport
+
+    QStringList runway_lines;
+    while(!airport_file->atEnd())
+    {
+        QString line(airport_file->readLine());
+        line = line.trimmed();
+        if (line.isEmpty()) break;
+        line = line.toUpper();
+        if (line.at(0) != RUNWAY_RECORD_PREFIX) break;
+        runway_lines.append(line);
     }
 
-    Logger::log(QString("Navdata:getAirports: searching for [%1] fin, found %2 entries in %3ms").
-                arg(name).arg(airports.count()).arg(start_time.elapsed()));
+    // parse the data
 
-    return airports.count();
+    Airport* airport = new Airport();
+    MYASSERT(airport);
+
+    if (!parseAirport(line, runway_lines, airport))
+    {
+        Logger::log(QString("Navdata:readAirport: ERROR: "
+                            "Could not parse airport from line (%1)").arg(line));
+        delete airport;
+        return 0;
+    }
+
+    return airport;
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -2015,369 +2598,408 @@ uint Navdata::getLevelDProcedures(const QString& airport,
     MYASSERT(!airport.isEmpty());
     procedures.clear();
 
-    const QDomDocument *proceduredb_dom = 0;
-
-    if (!m_airport_to_leveld_procedure_chache_map.contains(airport))
+    if (!m_procedure_cache.getProcedures(airport, wanted_type, procedures))
     {
-        QFile procfile(VasPath::prependPath(m_navdata_config->getValue(CFG_LEVELD_PROCEDURES_SUBDIR)+
-                                            "/"+airport.toLower()+LEVELD_PROCEDURE_FILE_EXT));
-        bool procedure_opened = true;
+        QString filename = levelDProcedureFilename(airport);
 
-        if (!procfile.open(QIODevice::ReadOnly))
+        if (!QFile::exists(filename))
         {
-            procedure_opened = false;
 #ifndef Q_OS_WIN32
             if (isOnCaseSensitiveFilesystem())
             {
                 Logger::log(QString("Navdata::getProcedures: no procedures found for airport "
-                                    "%1 (%2). Your filesystem is case-sensitive, renaming all proc files to lowercase").arg(airport).arg(procfile.fileName()));
+                                    "%1 (%2). Your filesystem is case-sensitive, renaming all proc files to lowercase").arg(airport).arg(filename));
                 renameNavdataFilenamesToLower(VasPath::prependPath(m_navdata_config->getValue(CFG_LEVELD_PROCEDURES_SUBDIR)));
             }
 #else
-            Logger::log(QString("Navdata:getLevelDProcedures: could not open procedure file (%1)").
-                        arg(procfile.fileName()));
+            Logger::log(QString("Navdata:getLevelDProcedures: could not open procedure file (%1)").arg(filename));
 #endif
         }
-        if (!m_airport_to_leveld_procedure_chache_map[airport].setContent(&procfile))
+
+        if (!loadLevelDProcedures(airport, filename))
+        {
+            // remember the airport, so we will not try to read the file again
+            m_procedure_cache.insert(airport, ProcedurePtrList(), ProcedurePtrList(), ProcedurePtrList());
+            return 0;
+        }
+
+        m_procedure_cache.getProcedures(airport, wanted_type, procedures);
+    }
+
+    Logger::log(QString("Navdata:getLevelDProcedures: found %1 procedures of type %2 for %3").
+                arg(procedures.count()).arg(wanted_type).arg(airport));
+
+    return procedures.count();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+QString Navdata::levelDProcedureFilename(const QString& airport) const
+{
+    return VasPath::prependPath(m_navdata_config->getValue(CFG_LEVELD_PROCEDURES_SUBDIR)+
+                                "/"+airport.toLower()+LEVELD_PROCEDURE_FILE_EXT);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void Navdata::prefetchProcedures(const Waypoint& airport)
+{
+    MYASSERT(m_procedure_prefetcher != 0);
+
+    QStringList airport_list;
+    airport_list.append(airport.id());
+
+    NavdataSpatialIndex::HitList hits;
+    getNearestAirports(airport, m_navdata_config->getIntValue(CFG_PROCEDURE_PREFETCH_COUNT) + 1, hits);
+
+    NavdataSpatialIndex::HitList::const_iterator iter = hits.begin();
+    for(; iter != hits.end(); ++iter)
+    {
+        if (iter->distance_nm > m_navdata_config->getIntValue(CFG_PROCEDURE_PREFETCH_RADIUS_NM)) break;
+        const QString& id = spatialAirport(*iter).id();
+        if (!airport_list.contains(id)) airport_list.append(id);
+    }
+
+    QStringList::const_iterator airport_iter = airport_list.begin();
+    for(; airport_iter != airport_list.end(); ++airport_iter)
+    {
+        if (m_procedure_cache.contains(*airport_iter)) continue;
+
+        // missing files are handled by getLevelDProcedures()
+        QString filename = levelDProcedureFilename(*airport_iter);
+        if (QFile::exists(filename)) m_procedure_prefetcher->prefetch(*airport_iter, filename);
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+bool Navdata::loadLevelDProcedures(const QString& airport, const QString& filename) const
+{
+    QFile procfile(filename);
+    if (!procfile.open(QIODevice::ReadOnly)) return false;
+
+    ProcedurePtrList sids;
+    ProcedurePtrList stars;
+    ProcedurePtrList approaches;
+
+    bool airport_found = false;
+    QXmlStreamReader reader(&procfile);
+
+    while(!reader.atEnd())
+    {
+        reader.readNext();
+        if (!reader.isStartElement()) continue;
+
+        QString element_name = reader.name().toString();
+
+        if (element_name == "Airport")
+        {
+            QString icao = reader.attributes().value("ICAOcode").toString();
+            if (icao.toUpper() != airport.toUpper())
+            {
+                Logger::log(QString("Navdata:loadLevelDProcedures: airport node value (%1) "
+                                    "did not match wanted airport (%2)").arg(icao).arg(airport));
+                return false;
+            }
+
+            airport_found = true;
+            continue;
+        }
+
+        if (!airport_found) continue;
+
+        // parse the procedure definition
+
+        Procedure* procedure = 0;
+        QString wpt_flag;
+        ProcedurePtrList* procedure_list = 0;
+
+        QString name = reader.attributes().value("Name").toString().trimmed();
+        QStringList runways = reader.attributes().value("Runways").toString().split(",");
+
+        if (element_name == "Sid")
+        {
+            procedure = new Sid(name, runways);
+            wpt_flag = Waypoint::FLAG_SID;
+            procedure_list = &sids;
+        }
+        else if (element_name == "Star")
+        {
+            procedure = new Star(name, runways);
+            wpt_flag = Waypoint::FLAG_STAR;
+            procedure_list = &stars;
+        }
+        else if (element_name == "Approach")
+        {
+            procedure = new Approach(name, QStringList());
+            wpt_flag = Waypoint::FLAG_APPROACH;
+            procedure_list = &approaches;
+        }
+        else
+        {
+            skipLevelDElement(reader);
+            continue;
+        }
+
+        MYASSERT(procedure != 0);
+
+        // fetch procedure waypoints
+
+        readLevelDProcedure(reader, *procedure, wpt_flag);
+
+        if (procedure->count() <= 0)
+        {
+            Logger::log(QString("Navdata:loadLevelDProcedures: skipping empty procedure %1").
+                        arg(procedure->id()));
+            delete procedure;
+            continue;
+        }
+
+        // approaches have to have one runway
+        if (procedure->asApproach() != 0 && procedure->asApproach()->runwayList().count() != 1)
         {
-            procedure_opened = false;
-            Logger::log(QString("Navdata:getLevelDProcedures: could not parse procedure file (%1)").
-                        arg(procfile.fileName()));
+            delete procedure;
+            continue;
         }
-        procfile.close();
 
-//        Logger::log(QString("Navdata:getLevelDProcedures: found procedure file (%1)").
-//                     arg(procfile.fileName()));
-//-----
-        return 0;
+        procedure_list->append(procedure);
     }
 
-    MYASSERT(m_airport_to_leveld_procedure_chache_map.contains(airport));
-    proceduredb_dom = &m_airport_to_leveld_procedure_chache_map[airport];
-
-    QDomNode proceduredb_node = proceduredb_dom->namedItem("ProceduresDB");
-    if (proceduredb_node.isNull())
+    if (reader.hasError())
     {
-        Logger::log("Navdata:getLevelDProcedures: DOM has no ProceduresDB node");
-        return 0;
+        Logger::log(QString("Navdata:loadLevelDProcedures: could not parse procedure file (%1): %2").
+                    arg(filename).arg(reader.errorString()));
+        return false;
     }
 
-    if (proceduredb_node.namedItem("Airport").isNull())
+    if (!airport_found)
     {
-        Logger::log("Navdata:getLevelDProcedures: DOM has no airport node");
-        return 0;
+        Logger::log(QString("Navdata:loadLevelDProcedures: no airport node in (%1)").arg(filename));
+        return false;
     }
 
-    if (proceduredb_node.namedItem("Airport").attributes().namedItem("ICAOcode").nodeValue().toUpper() != airport.toUpper())
-    {
-        Logger::log(QString("Navdata:getLevelDProcedures: airport node value (%1) did not match wanted airport (%2)").
-                    arg(proceduredb_node.namedItem("Airport").attributes().namedItem("ICAOcode").nodeValue()).
-                    arg(airport));
-        return 0;
-    }
+    m_procedure_cache.insert(airport, sids, stars, approaches);
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
 
-    QDomNode procedure_node = proceduredb_node.namedItem("Airport").firstChild();
-    for(;!procedure_node.isNull(); procedure_node = procedure_node.nextSibling())
+void Navdata::readLevelDProcedure(QXmlStreamReader& reader, Procedure& procedure, const QString& wpt_flag) const
+{
+    while(!reader.atEnd())
     {
-        if (!procedure_node.isElement()) continue;
-        QDomElement procedure_element = procedure_node.toElement();
+        reader.readNext();
+        if (reader.isEndElement()) return;
+        if (!reader.isStartElement()) continue;
 
-        // parse the procedure definition line
+        QString element_name = reader.name().toString();
 
-        Procedure* procedure = parseLevelDProcedure(procedure_element, wanted_type);
-        if (procedure == 0) continue;
+        if (element_name == "App_Transition" || element_name == "Sid_Transition")
+        {
+            Procedure* parent_procedure = (element_name == "App_Transition") ?
+                                          (Procedure*)procedure.asApproach() : (Procedure*)procedure.asSID();
+            if (parent_procedure == 0)
+            {
+                skipLevelDElement(reader);
+                continue;
+            }
 
-//         //TODO
-//         Logger::log(QString("Navdata:getLevelDProcedures: ======================== %1 =====================").
-//                     arg(procedure->id()));
+            Transition* transition =
+                new Transition(reader.attributes().value("Name").toString().trimmed(),
+                               parent_procedure->runwayList());
+            MYASSERT(transition != 0);
+            transition->setParentProcedure(parent_procedure);
 
-        // fetch procedure waypoints
+            readLevelDProcedure(reader, *transition, (element_name == "App_Transition") ?
+                                Waypoint::FLAG_APP_TRANS : Waypoint::FLAG_SID_TRANS);
 
-        QDomNode wpt_node = procedure_element.firstChild();
-        for(;!wpt_node.isNull(); wpt_node = wpt_node.nextSibling())
+            if (transition->count() > 0)
+            {
+                if (procedure.asApproach() != 0)
+                    procedure.asApproach()->transitions().append(transition);
+                else
+                    procedure.asSID()->transitions().append(transition);
+            }
+            else
+            {
+                Logger::log(QString("Navdata:readLevelDProcedure: skipping empty transition %1 of %2").
+                            arg(transition->id()).arg(procedure.id()));
+                delete transition;
+            }
+        }
+        else if (element_name == "Sid_Waypoint" ||
+                 element_name == "Star_Waypoint" ||
+                 element_name == "App_Waypoint" ||
+                 element_name == "SidTr_Waypoint" ||
+                 element_name == "AppTr_Waypoint")
         {
-            if (!wpt_node.isElement()) continue;
-            QDomElement wpt_element = wpt_node.toElement();
+            LevelDFieldMap fields;
+            readLevelDFields(reader, fields);
 
-            Waypoint* proc_wpt = parseLevelDProcedureWaypoint(wpt_element, *procedure);
+            Waypoint* proc_wpt = parseLevelDProcedureWaypoint(element_name, fields, procedure);
             if (proc_wpt == 0) continue;
 
-            proc_wpt->setParent(procedure->id());
-            if (wanted_type == Route::TYPE_SID) proc_wpt->setFlag(Waypoint::FLAG_SID);
-            else if (wanted_type == Route::TYPE_STAR) proc_wpt->setFlag(Waypoint::FLAG_STAR);
-            else if (wanted_type == Route::TYPE_APPROACH) proc_wpt->setFlag(Waypoint::FLAG_APPROACH);
-
-            procedure->appendWaypoint(*proc_wpt);
+            proc_wpt->setParent(procedure.id());
+            proc_wpt->setFlag(wpt_flag);
+            procedure.appendWaypoint(*proc_wpt);
             delete proc_wpt;
-            proc_wpt = 0;
-        }
-
-        if (procedure->count() > 0)
-        {
-            // in add this procedure, but in case it is an approach, it has to have one runway
-            if (procedure->asApproach() == 0 ||
-                procedure->asApproach()->runwayList().count() == 1)
-            {
-                procedures.append(procedure);
-            }
-
-            //Logger::log(QString("Navdata:getProcedures: added proc (%1)").arg(procedure->toString()));
         }
         else
         {
-            Logger::log(QString("Navdata:getLevelDProcedures: skipping empty procedure %1").
-                        arg(procedure->id()));
-
-            delete procedure;
-            procedure = 0;
+            skipLevelDElement(reader);
         }
     }
+}
 
-    //-----
+/////////////////////////////////////////////////////////////////////////////
 
-    Logger::log(QString("Navdata:getLevelDProcedures: found %1 procedures of type %2 for %3").
-                arg(procedures.count()).arg(wanted_type).arg(airport));
+void Navdata::readLevelDFields(QXmlStreamReader& reader, LevelDFieldMap& fields)
+{
+    while(!reader.atEnd())
+    {
+        reader.readNext();
+        if (reader.isEndElement()) return;
+        if (!reader.isStartElement()) continue;
 
-    return procedures.count();
+        QString field_name = reader.name().toString();
+        fields.insert(field_name, reader.readElementText());
+    }
 }
 
 /////////////////////////////////////////////////////////////////////////////
 
-Procedure* Navdata::parseLevelDProcedure(const QDomElement& element, const QString& wanted_type) const
+void Navdata::skipLevelDElement(QXmlStreamReader& reader)
 {
-    if (wanted_type == Procedure::TYPE_SID)
-    {
-        if (element.tagName() != "Sid") return 0;
-        return new Sid(element.attributes().namedItem("Name").nodeValue().trimmed(),
-                       element.attributes().namedItem("Runways").nodeValue().split(","));
-    }
-    else if (wanted_type == Route::TYPE_STAR)
-    {
-        if (element.tagName() != "Star") return 0;
-        return new Star(element.attributes().namedItem("Name").nodeValue().trimmed(),
-                        element.attributes().namedItem("Runways").nodeValue().split(","));
-    }
-    else if (wanted_type == Route::TYPE_APPROACH)
+    int depth = 1;
+    while(depth > 0 && !reader.atEnd())
     {
-        if (element.tagName() != "Approach") return 0;
-        return new Approach(element.attributes().namedItem("Name").nodeValue().trimmed(), QStringList());
+        reader.readNext();
+        if (reader.isStartElement()) ++depth;
+        else if (reader.isEndElement()) --depth;
     }
-
-    return 0;
 }
 
 /////////////////////////////////////////////////////////////////////////////
 
-Waypoint* Navdata::parseLevelDProcedureWaypoint(const QDomElement& element,
+Waypoint* Navdata::parseLevelDProcedureWaypoint(const QString& element_name,
+                                                const LevelDFieldMap& fields,
                                                 Procedure& procedure) const
 {
-    if (element.nodeName() == "App_Transition")
-    {
-        if (procedure.asApproach() == 0) return false;
-
-        Transition* transition =
-            new Transition(element.attributes().namedItem("Name").nodeValue().trimmed(),
-                           procedure.asApproach()->runwayList());
-        MYASSERT(transition != 0);
-        transition->setParentProcedure(procedure.asApproach());
-        MYASSERT(transition->parentProcedure()->asApproach() != 0);
+    QString wpt_name = fields.value("Name").trimmed();
+    QString wpt_type = fields.value("Type");
+    double lat = fields.value("Latitude").toDouble();
+    double lon = fields.value("Longitude").toDouble();
 
-        QDomNode trans_wpt_node = element.firstChild();
-        for(;!trans_wpt_node.isNull(); trans_wpt_node = trans_wpt_node.nextSibling())
-        {
-            if (!trans_wpt_node.isElement()) continue;
-            QDomElement wpt_element = trans_wpt_node.toElement();
-
-            Waypoint* proc_wpt = parseLevelDProcedureWaypoint(wpt_element, *transition);
-            if (proc_wpt == 0) continue;
+    Waypoint* parsed_wpt = 0;
 
-            proc_wpt->setParent(transition->id());
-            proc_wpt->setFlag(Waypoint::FLAG_APP_TRANS);
-            transition->appendWaypoint(*proc_wpt);
-            delete proc_wpt;
-            proc_wpt = 0;
-        }
+    //TODO add more waypoint types (hdg2alt, etc.)
+    if (wpt_type == "Runway")
+    {
+        if (wpt_name.startsWith("RW")) wpt_name = wpt_name.mid(2);
 
-        if (transition->count() > 0)
-        {
-            procedure.asApproach()->transitions().append(transition);
-        }
-        else
-        {
-            Logger::log(QString("Navdata:parseLevelDProcedureWaypoint: skipping empty transition %1 of APP %2").
-                        arg(transition->id()).arg(procedure.id()));
-            delete transition;
-            transition = 0;
-        }
+        parsed_wpt = new Runway(wpt_name, lat, lon,
+                                fields.value("Hdg_Crs_value").toUInt(),
+                                0, false, 0, 0,
+                                fields.value("Altitude").toUInt(),
+                                0, 0);
 
-        return 0;
+        // set the approach runway list when we got a runway waypoint
+        if (procedure.asApproach() != 0)
+            procedure.asApproach()->setRunwayList(QStringList(wpt_name));
     }
-    else if (element.nodeName() == "Sid_Transition")
+    else if (wpt_type == "Hold")
     {
-        if (procedure.asSID() == 0) return false;
-
-        Transition* transition =
-            new Transition(element.attributes().namedItem("Name").nodeValue().trimmed(),
-                           procedure.asSID()->runwayList());
-        MYASSERT(transition != 0);
-        transition->setParentProcedure(procedure.asSID());
-        MYASSERT(transition->parentProcedure()->asSID() != 0);
-
-        QDomNode trans_wpt_node = element.firstChild();
-        for(;!trans_wpt_node.isNull(); trans_wpt_node = trans_wpt_node.nextSibling())
+        if (procedure.asApproach() != 0 && procedure.count() > 0)
         {
-            if (!trans_wpt_node.isElement()) continue;
-            QDomElement wpt_element = trans_wpt_node.toElement();
-
-            Waypoint* proc_wpt = parseLevelDProcedureWaypoint(wpt_element, *transition);
-            if (proc_wpt == 0) continue;
+            Waypoint* last_procedure_wpt = procedure.waypoint(procedure.count()-1);
+            MYASSERT(last_procedure_wpt != 0);
 
-            proc_wpt->setParent(transition->id());
-            proc_wpt->setFlag(Waypoint::FLAG_SID_TRANS);
-            transition->appendWaypoint(*proc_wpt);
-            delete proc_wpt;
-            proc_wpt = 0;
-        }
+            Holding holding;
+            holding.setHoldingTrack(fields.value("Hdg_Crs_value").toUInt());
+            holding.setIsLeftHolding(fields.value("Hld_Turn") == "Left");
 
-        if (transition->count() > 0)
-        {
-            procedure.asSID()->transitions().append(transition);
-        }
-        else
-        {
-            Logger::log(QString("Navdata:parseLevelDProcedureWaypoint: skipping empty transition %1 of SID %2").
-                        arg(transition->id()).arg(procedure.id()));
+            if (fields.value("Hld_Time_or_Dist") == "Time")
+                holding.setHoldLegLengthMin(fields.value("Hld_td_value").toDouble());
 
-            delete transition;
-            transition = 0;
+            last_procedure_wpt->setHolding(holding);
         }
 
-        return 0;
     }
-    else if (element.nodeName() == "Sid_Waypoint" ||
-             element.nodeName() == "Star_Waypoint" ||
-             element.nodeName() == "App_Waypoint" ||
-             element.nodeName() == "SidTr_Waypoint" ||
-             element.nodeName() == "AppTr_Waypoint")
+    else if (wpt_type == "Normal")
     {
-        QString wpt_name = element.namedItem("Name").toElement().text().trimmed();
-        QString wpt_type = element.namedItem("Type").toElement().text();
-        double lat = element.namedItem("Latitude").toElement().text().toDouble();
-        double lon = element.namedItem("Longitude").toElement().text().toDouble();
-
-        Waypoint* parsed_wpt = 0;
+        parsed_wpt = new Waypoint(wpt_name, "", lat, lon);
+    }
+    else if (wpt_type == "ConstHdgtoAlt")
+    {
+        parsed_wpt = new WaypointHdgToAlt(
+            wpt_name, fields.value("Hdg_Crs_value").toUInt());
+    }
+    else if (wpt_type == "Intc")
+    {
+        Navcalc::TURN_DIRECTION turndir = Navcalc::TURN_AUTO;
 
-        //TODO add more waypoint types (hdg2alt, etc.)
-        if (wpt_type == "Runway")
-        {
-            if (wpt_name.startsWith("RW")) wpt_name = wpt_name.mid(2);
+        if (fields.value("Sp_Turn") == "Right")     turndir = Navcalc::TURN_RIGHT;
+        else if (fields.value("Sp_Turn") == "Left") turndir = Navcalc::TURN_LEFT;
 
-            parsed_wpt = new Runway(wpt_name, lat, lon,
-                                    element.namedItem("Hdg_Crs_value").toElement().text().toUInt(),
-                                    0, false, 0, 0,
-                                    element.namedItem("Altitude").toElement().text().toUInt(),
-                                    0, 0);
+        parsed_wpt = new WaypointHdgToIntercept(
+            wpt_name, 0.0, 0.0, Waypoint("Fix2Intercept", "", lat, lon),
+            fields.value("RadialtoIntercept").toUInt(),
+            fields.value("Hdg_Crs_value").toUInt(),
+            turndir);
+        //TODO set if to hold the heading or the course!
+    }
+    else
+    {
+        Logger::log(QString("Navdata::parseLevelDProcedureWaypoint: skipped wpt %1 of %2 - unsupported type %3").
+                    arg(wpt_name).arg(procedure.id()).arg(wpt_type));
+    }
 
-            // set the approach runway list when we got a runway waypoint
-            if (procedure.asApproach() != 0)
-                procedure.asApproach()->setRunwayList(QStringList(wpt_name));
-        }
-        else if (wpt_type == "Hold")
-        {
-            if (procedure.asApproach() != 0 && procedure.count() > 0)
-            {
-                Waypoint* last_procedure_wpt = procedure.waypoint(procedure.count()-1);
-                MYASSERT(last_procedure_wpt != 0);
+    if (parsed_wpt == 0) return 0;
 
-                Holding holding;
-                holding.setHoldingTrack(element.namedItem("Hdg_Crs_value").toElement().text().toUInt());
-                holding.setIsLeftHolding(element.namedItem("Hld_Turn").toElement().text() == "Left");
+    // parse the waypoint info
 
-                if (element.namedItem("Hld_Time_or_Dist").toElement().text() == "Time")
-                    holding.setHoldLegLengthMin(element.namedItem("Hld_td_value").toElement().text().toDouble());
+    parsed_wpt->restrictions().setOverflyRestriction(false);
+    if (fields.contains("Flytype") && fields.value("Flytype") == "Fly-by")
+        parsed_wpt->restrictions().setOverflyRestriction(false);
+    if (fields.contains("Flytype") && fields.value("Flytype") == "Fly-over")
+        parsed_wpt->restrictions().setOverflyRestriction(true);
 
-                last_procedure_wpt->setHolding(holding);
-            }
+    if (fields.contains("Speed"))
+        parsed_wpt->restrictions().setSpeedRestrictionKts(fields.value("Speed").toUInt());
 
-        }
-        else if (wpt_type == "Normal")
-        {
-            parsed_wpt = new Waypoint(wpt_name, "", lat, lon);
-        }
-        else if (wpt_type == "ConstHdgtoAlt")
-        {
-            parsed_wpt = new WaypointHdgToAlt(
-                wpt_name, element.namedItem("Hdg_Crs_value").toElement().text().toUInt());
-        }
-        else if (wpt_type == "Intc")
-        {
-            Navcalc::TURN_DIRECTION turndir = Navcalc::TURN_AUTO;
+    if (fields.contains("Altitude"))
+        parsed_wpt->restrictions().setAltitudeRestrictionFt(fields.value("Altitude").toUInt());
 
-            if (element.namedItem("Sp_Turn").toElement().text() == "Right")     turndir = Navcalc::TURN_RIGHT;
-            else if (element.namedItem("Sp_Turn").toElement().text() == "Left") turndir = Navcalc::TURN_LEFT;
+    if (fields.contains("AltitudeRestriction"))
+    {
+        const QString& alt_res = fields.value("AltitudeRestriction");
 
-            parsed_wpt = new WaypointHdgToIntercept(
-                wpt_name, 0.0, 0.0, Waypoint("Fix2Intercept", "", lat, lon),
-                element.namedItem("RadialtoIntercept").toElement().text().toUInt(),
-                element.namedItem("Hdg_Crs_value").toElement().text().toUInt(),
-                turndir);
-            //TODO set if to hold the heading or the course!
-        }
-        else
+        if (alt_res == "above")
         {
-            Logger::log(QString("Navdata::parseLevelDProcedureWaypoint: skipped wpt %1 of %2 - unsupported type %3").
-                        arg(wpt_name).arg(procedure.id()).arg(wpt_type));
+            parsed_wpt->restrictions().setAltitudeRestrictionType(WaypointRestrictions::RESTRICTION_ALT_GREATER);
+            if (element_name == "Sid_Waypoint" && fields.value("Type") == "Normal")
+                parsed_wpt->restrictions().setOverflyRestriction(true);
         }
 
-        if (parsed_wpt == 0) return 0;
-
-        // parse the waypoint info
-
-        parsed_wpt->restrictions().setOverflyRestriction(false);
-        if (!element.namedItem("Flytype").isNull() && element.namedItem("Flytype").toElement().text() == "Fly-by")
-            parsed_wpt->restrictions().setOverflyRestriction(false);
-        if (!element.namedItem("Flytype").isNull() && element.namedItem("Flytype").toElement().text() == "Fly-over")
-            parsed_wpt->restrictions().setOverflyRestriction(true);
-
-        if (!element.namedItem("Speed").isNull())
-            parsed_wpt->restrictions().setSpeedRestrictionKts(element.namedItem("Speed").toElement().text().toUInt());
-
-        if (!element.namedItem("Altitude").isNull())
-            parsed_wpt->restrictions().setAltitudeRestrictionFt(element.namedItem("Altitude").toElement().text().toUInt());
-
-        if (!element.namedItem("AltitudeRestriction").isNull())
-        {
-            const QString& alt_res = element.namedItem("AltitudeRestriction").toElement().text();
-
-            if (alt_res == "above")
-            {
-                parsed_wpt->restrictions().setAltitudeRestrictionType(WaypointRestrictions::RESTRICTION_ALT_GREATER);
-                if (element.nodeName() == "Sid_Waypoint" && element.namedItem("Type").toElement().text() == "Normal")
-                    parsed_wpt->restrictions().setOverflyRestriction(true);
-            }
-
-            if (alt_res == "below")
-                parsed_wpt->restrictions().setAltitudeRestrictionType(WaypointRestrictions::RESTRICTION_ALT_SMALLER);
-            if (alt_res == "at")
-                parsed_wpt->restrictions().setAltitudeRestrictionType(WaypointRestrictions::RESTRICTION_ALT_EQUAL);
-        }
+        if (alt_res == "below")
+            parsed_wpt->restrictions().setAltitudeRestrictionType(WaypointRestrictions::RESTRICTION_ALT_SMALLER);
+        if (alt_res == "at")
+            parsed_wpt->restrictions().setAltitudeRestrictionType(WaypointRestrictions::RESTRICTION_ALT_EQUAL);
+    }
 
-        if (wpt_type == "ConstHdgtoAlt")
+    if (wpt_type == "ConstHdgtoAlt")
+    {
+        if (parsed_wpt->restrictions().altitudeRestrictionFt() <= 0)
         {
-            if (parsed_wpt->restrictions().altitudeRestrictionFt() <= 0)
-            {
-                Logger::log(QString("Navdata::parseLevelDProcedureWaypoint: "
-                                    "skipped wpt %1 of %2 - hdg2alt and no alt restriction").
-                            arg(wpt_name).arg(procedure.id()));
-                delete parsed_wpt;
-                parsed_wpt = 0;
-            }
+            Logger::log(QString("Navdata::parseLevelDProcedureWaypoint: "
+                                "skipped wpt %1 of %2 - hdg2alt and no alt restriction").
+                        arg(wpt_name).arg(procedure.id()));
+            delete parsed_wpt;
+            parsed_wpt = 0;
         }
-
-        return parsed_wpt;
     }
 
-    return 0;
+    return parsed_wpt;
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -2480,33 +3102,14 @@ Intersection* Navdata::getIntersection(const QString& id, const QString& country
 /////////////////////////////////////////////////////////////////////////////
 
 uint Navdata::getAirportListByCoordinates(const Waypoint& current_position,
-                                          int variation,
                                           uint max_distance_nm,
                                           WaypointPtrList& airports)
 {
-    MYASSERT(variation >= 0);
-
-    int lat_start = (int)current_position.lat() - variation;
-    int lon_start = (int)current_position.lon() - variation;
-    int lat_end   = (int)current_position.lat() + variation;
-    int lon_end   = (int)current_position.lon() + variation;
-
-    for(int lat_var=lat_start; lat_var <= lat_end; ++lat_var)
-        for(int lon_var=lon_start; lon_var <= lon_end; ++lon_var)
-        {
-            QString index = getCoordinateIndex(lat_var, lon_var);
+    NavdataSpatialIndex::HitList hits;
+    getAirportsWithinRadius(current_position, max_distance_nm, hits);
 
-            if (!m_airport_list_coordinate_index_map.contains(index)) continue;
-
-            const AirportList& airportlist = m_airport_list_coordinate_index_map[index];
-            AirportList::const_iterator list_iter = airportlist.begin();
-            for(; list_iter != airportlist.end(); ++list_iter)
-            {
-                const Airport& airport = *list_iter;
-                if (Navcalc::getDistBetweenWaypoints(current_position, airport) > max_distance_nm) continue;
-                airports.append(airport.deepCopy());
-            }
-        }
+    NavdataSpatialIndex::HitList::const_iterator iter = hits.begin();
+    for(; iter != hits.end(); ++iter) airports.append(spatialAirport(*iter).deepCopy());
 
     return airports.count();
 }
@@ -2514,34 +3117,14 @@ uint Navdata::getAirportListByCoordinates(const Waypoint& current_position,
 /////////////////////////////////////////////////////////////////////////////
 
 uint Navdata::getVorListByCoordinates(const Waypoint& current_position,
-                                      int variation,
                                       uint max_distance_nm,
                                       WaypointPtrList& vors)
 {
-    MYASSERT(variation >= 0);
+    NavdataSpatialIndex::HitList hits;
+    getVorsWithinRadius(current_position, max_distance_nm, hits);
 
-    int lat_start = (int)current_position.lat() - variation;
-    int lon_start = (int)current_position.lon() - variation;
-    int lat_end   = (int)current_position.lat() + variation;
-    int lon_end   = (int)current_position.lon() + variation;
-
-    for(int lat_var=lat_start; lat_var <= lat_end; ++lat_var)
-        for(int lon_var=lon_start; lon_var <= lon_end; ++lon_var)
-        {
-            QString index = getCoordinateIndex(lat_var, lon_var);
-
-            if (!m_vor_list_coordinate_index_map.contains(index)) continue;
-
-            const VorList& vorlist = m_vor_list_coordinate_index_map[index];
-            VorList::const_iterator list_iter = vorlist.begin();
-            for(; list_iter != vorlist.end(); ++list_iter)
-            {
-                const Vor& vor = *list_iter;
-
-                if (Navcalc::getDistBetweenWaypoints(current_position, vor) > max_distance_nm) continue;
-                vors.append(vor.deepCopy());
-            }
-        }
+    NavdataSpatialIndex::HitList::const_iterator iter = hits.begin();
+    for(; iter != hits.end(); ++iter) vors.append(spatialVor(*iter).deepCopy());
 
     return vors.count();
 }
@@ -2549,36 +3132,78 @@ uint Navdata::getVorListByCoordinates(const Waypoint& current_position,
 /////////////////////////////////////////////////////////////////////////////
 
 uint Navdata::getNdbListByCoordinates(const Waypoint& current_position,
-                                      int variation,
                                       uint max_distance_nm,
                                       WaypointPtrList& ndbs)
 {
-    MYASSERT(variation >= 0);
+    NavdataSpatialIndex::HitList hits;
+    getNdbsWithinRadius(current_position, max_distance_nm, hits);
 
-    int lat_start = (int)current_position.lat() - variation;
-    int lon_start = (int)current_position.lon() - variation;
-    int lat_end   = (int)current_position.lat() + variation;
-    int lon_end   = (int)current_position.lon() + variation;
+    NavdataSpatialIndex::HitList::const_iterator iter = hits.begin();
+    for(; iter != hits.end(); ++iter) ndbs.append(spatialNdb(*iter).deepCopy());
 
-    for(int lat_var=lat_start; lat_var <= lat_end; ++lat_var)
-        for(int lon_var=lon_start; lon_var <= lon_end; ++lon_var)
-        {
-            QString index = getCoordinateIndex(lat_var, lon_var);
+    return ndbs.count();
+}
 
-            if (!m_ndb_list_coordinate_index_map.contains(index)) continue;
+/////////////////////////////////////////////////////////////////////////////
 
-            const NdbList& ndblist = m_ndb_list_coordinate_index_map[index];
-            NdbList::const_iterator list_iter = ndblist.begin();
-            for(; list_iter != ndblist.end(); ++list_iter)
-            {
-                const Ndb& ndb = *list_iter;
+uint Navdata::getAirportsWithinRadius(const Waypoint& center, double radius_nm,
+                                      NavdataSpatialIndex::HitList& hits) const
+{
+    return m_airport_spatial_index.getWithinRadius(center.lat(), center.lon(), radius_nm, hits);
+}
 
-                if (Navcalc::getDistBetweenWaypoints(current_position, ndb) > max_distance_nm) continue;
-                ndbs.append(ndb.deepCopy());
-            }
-        }
+/////////////////////////////////////////////////////////////////////////////
 
-    return ndbs.count();
+uint Navdata::getNearestAirports(const Waypoint& center, uint max_count,
+                                 NavdataSpatialIndex::HitList& hits) const
+{
+    return m_airport_spatial_index.getNearest(center.lat(), center.lon(), max_count, hits);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+uint Navdata::getVorsWithinRadius(const Waypoint& center, double radius_nm,
+                                  NavdataSpatialIndex::HitList& hits) const
+{
+    return m_vor_spatial_index.getWithinRadius(center.lat(), center.lon(), radius_nm, hits);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+uint Navdata::getNearestVors(const Waypoint& center, uint max_count,
+                             NavdataSpatialIndex::HitList& hits) const
+{
+    return m_vor_spatial_index.getNearest(center.lat(), center.lon(), max_count, hits);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+uint Navdata::getNdbsWithinRadius(const Waypoint& center, double radius_nm,
+                                  NavdataSpatialIndex::HitList& hits) const
+{
+    return m_ndb_spatial_index.getWithinRadius(center.lat(), center.lon(), radius_nm, hits);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+uint Navdata::getNearestNdbs(const Waypoint& center, uint max_count,
+                             NavdataSpatialIndex::HitList& hits) const
+{
+    return m_ndb_spatial_index.getNearest(center.lat(), center.lon(), max_count, hits);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+uint Navdata::searchIdents(const QString& text,
+                           const Waypoint& position,
+                           uint max_count,
+                           NavdataIdentSearch::MatchList& matches,
+                           bool fuzzy) const
+{
+    matches.clear();
+    m_airport_ident_search.search(text, position.lat(), position.lon(), max_count, matches, fuzzy);
+    m_navaid_ident_search.search(text, position.lat(), position.lon(), max_count, matches, fuzzy);
+    return m_waypoint_ident_search.search(text, position.lat(), position.lon(), max_count, matches, fuzzy);
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -2592,90 +3217,78 @@ bool Navdata::getWaypointsByAirway(const Waypoint& from_waypoint,
     Logger::log(QString("Navdata:getWaypointsByAirway: Searching for airway (%1) from (%2) to (%3)").
                 arg(airway).arg(from_waypoint.id()).arg(to_waypoint));
 
-    AirwayPtrList found_airways;
-    if (!getAirways(airway, found_airways) || found_airways.count() <= 0)
+    result_wpt_list.clear();
+
+    if (!m_airway_graph.getWaypointsByAirway(from_waypoint, airway.toUpper(), to_waypoint.toUpper(), result_wpt_list))
     {
-        error_text = QString("No Airway %1 from %2 to %3").arg(airway).arg(from_waypoint.id()).arg(to_waypoint);
-        Logger::log(QString("Navdata:getWaypointsByAirway: %1").arg(error_text));
+        result_wpt_list.clear();
+        Logger::log("Navdata:getWaypointsByAirway: airway not found");
+        error_text = "Airway not found";
         return false;
     }
 
-    // search for the right airway
+    resolveAirwayNavaids(result_wpt_list);
+    return true;
+}
 
-    bool finished = false;
+/////////////////////////////////////////////////////////////////////////////
 
-    AirwayPtrListIterator airway_iter(found_airways);
-    for (; airway_iter.hasNext();)
+bool Navdata::getRouteByAirways(const Waypoint& from_waypoint,
+                                const Waypoint& to_waypoint,
+                                WaypointPtrList& result_wpt_list,
+                                double& distance_nm,
+                                const QStringList& allowed_airways) const
+{
+    WaypointPtrList route_wpt_list;
+    if (!m_airway_graph.findRoute(from_waypoint, to_waypoint, route_wpt_list, distance_nm, allowed_airways))
     {
-        const Airway* airway = airway_iter.next();
-
-//         Logger::log(QString("Navdata:getWaypointsByAirway: loop airway (%1) with %2 waypoints").
-//                     arg(airway->id()).arg(airway->count()));
-
-        bool found_from_waypoint = false;
-        result_wpt_list.clear();
-
-        const WaypointPtrList& waypoint_list = airway->waypointList();
-        WaypointPtrListIterator wpt_iter(waypoint_list);
-        for(; wpt_iter.hasNext();)
-        {
-            Waypoint* waypoint = wpt_iter.next();
-            waypoint->setParent(airway->id());
+        Logger::log(QString("Navdata:getRouteByAirways: no route from (%1) to (%2)").
+                    arg(from_waypoint.id()).arg(to_waypoint.id()));
+        return false;
+    }
 
-            //Logger::log(QString("Navdata:getWaypointsByAirway: loop waypoint (%1)").arg(waypoint->id()));
+    resolveAirwayNavaids(route_wpt_list);
 
-            if (*waypoint == from_waypoint)
-            {
-                found_from_waypoint = true;
-                continue;
-            }
+    WaypointPtrListIterator iter(route_wpt_list);
+    while(iter.hasNext()) result_wpt_list.append(iter.next()->deepCopy());
+    return true;
+}
 
-            if (found_from_waypoint)
-            {
-                // search for navaid with the waypoint name to get more infos
-                bool added_navaid = false;
-                WaypointPtrList possible_navaid_list;
-                if (getNavaids(waypoint->id(), possible_navaid_list) > 0)
-                {
-                    WaypointPtrListIterator navaid_iter(possible_navaid_list);
-                    for(; navaid_iter.hasNext(); )
-                    {
-                        Waypoint* navaid = navaid_iter.next();
-
-                        if (*navaid == *waypoint)
-                        {
-                            navaid->setParent(airway->id());
-                            result_wpt_list.append(navaid->deepCopy());
-                            added_navaid = true;
-                            break;
-                        }
-                    }
-                }
+/////////////////////////////////////////////////////////////////////////////
 
-                if (!added_navaid) result_wpt_list.append(waypoint->deepCopy());
+void Navdata::resolveAirwayNavaids(WaypointPtrList& wpt_list, const WaypointCandidateMap* candidates) const
+{
+    for(int index = 0; index < wpt_list.count(); ++index)
+    {
+        Waypoint* waypoint = wpt_list[index];
 
-//                 Logger::log(QString("Navdata:getWaypointsByAirway: added waypoint %1").
-//                             arg(waypoint->id()));
+        // search for navaid with the waypoint name to get more infos
+        WaypointPtrList possible_navaid_list;
+        const WaypointPtrList* navaid_list = &possible_navaid_list;
 
-                if (waypoint->id() == to_waypoint)
-                {
-                    finished = true;
-                    break;
-                }
-            }
+        if (candidates != 0)
+        {
+            navaid_list = candidates->value(waypoint->id());
+            if (navaid_list == 0) continue;
+        }
+        else if (getNavaids(waypoint->id(), possible_navaid_list) <= 0)
+        {
+            continue;
         }
 
-        if (finished) break;
-    }
+        WaypointPtrListIterator navaid_iter(*navaid_list);
+        for(; navaid_iter.hasNext(); )
+        {
+            const Waypoint* navaid = navaid_iter.next();
+            if (navaid->asNdb() == 0 || *navaid != *waypoint) continue;
 
-    if (!finished)
-    {
-        Logger::log("Navdata:getWaypointsByAirway: airway not found");
-        error_text = "Airway not found";
-        return false;
+            Waypoint* navaid_copy = navaid->deepCopy();
+            navaid_copy->setParent(waypoint->parent());
+            wpt_list.replace(index, navaid_copy);
+            delete waypoint;
+            break;
+        }
     }
-
-    return true;
 }
 
 /////////////////////////////////////////////////////////////////////////////
@@ -2710,3 +3323,67 @@ void Navdata::renameNavdataFilenamesToLower(const QString& relative_path) const
 }
 
 /////////////////////////////////////////////////////////////////////////////
+
+/////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+NavdataProcedurePrefetcher::NavdataProcedurePrefetcher(const Navdata& navdata) :
+    m_navdata(navdata), m_stop(false)
+{
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+NavdataProcedurePrefetcher::~NavdataProcedurePrefetcher()
+{
+    m_mutex.lock();
+    m_stop = true;
+    m_airport_queue.clear();
+    m_filename_queue.clear();
+    m_queue_condition.wakeAll();
+    m_mutex.unlock();
+
+    wait();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void NavdataProcedurePrefetcher::prefetch(const QString& airport, const QString& filename)
+{
+    QMutexLocker locker(&m_mutex);
+    if (m_stop || m_airport_queue.contains(airport)) return;
+
+    m_airport_queue.append(airport);
+    m_filename_queue.append(filename);
+    m_queue_condition.wakeAll();
+
+    if (!isRunning()) start(QThread::LowPriority);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void NavdataProcedurePrefetcher::run()
+{
+    while(true)
+    {
+        QString airport;
+        QString filename;
+
+        m_mutex.lock();
+        while(!m_stop && m_airport_queue.isEmpty()) m_queue_condition.wait(&m_mutex);
+        if (m_stop)
+        {
+            m_mutex.unlock();
+            return;
+        }
+        airport = m_airport_queue.takeFirst();
+        filename = m_filename_queue.takeFirst();
+        m_mutex.unlock();
+
+        if (m_navdata.m_procedure_cache.contains(airport)) continue;
+        if (m_navdata.loadLevelDProcedures(airport, filename))
+            Logger::log(QString("NavdataProcedurePrefetcher:run: prefetched procedures of %1").arg(airport));
+    }
+}
+
+// End of file
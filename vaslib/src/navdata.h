@@ -25,7 +25,13 @@
 #include <QObject>
 #include <QStringList>
 #include <QString>
-#include <QDomDocument>
+#include <QHash>
+#include <QMap>
+#include <QVector>
+#include <QMutex>
+#include <QThread>
+#include <QThreadStorage>
+#include <QWaitCondition>
 
 #include "config.h"
 #include "assert.h"
@@ -41,19 +47,60 @@
 #include "star.h"
 #include "transition.h"
 #include "approach.h"
+#include "navdata_ident_index.h"
+#include "navdata_ident_search.h"
+#include "navdata_spatial_index.h"
+#include "airway_graph.h"
+#include "procedure_cache.h"
+#include "navdata_index_file.h"
 
-typedef QMap<QString, long> IndexMap;
+class NavdataImage;
 
 typedef QList<Airport> AirportList;
-typedef QMap<QString, AirportList> AirportListCoordinateIndexMap;
-
 typedef QList<Vor> VorList;
-typedef QMap<QString, VorList> VorListCoordinateIndexMap;
-
 typedef QList<Ndb> NdbList;
-typedef QMap<QString, NdbList> NdbListCoordinateIndexMap;
 
-class QDomElement;
+class QCryptographicHash;
+class QXmlStreamReader;
+class NavdataProcedurePrefetcher;
+class NavdataIndexTask;
+class NavdataReadCursors;
+
+//! child element name to text map of a Level-D procedure waypoint
+typedef QHash<QString, QString> LevelDFieldMap;
+
+//! ID to waypoint candidates map, see Navdata::getWaypointCandidates()
+typedef QHash<QString, WaypointPtrList*> WaypointCandidateMap;
+
+/////////////////////////////////////////////////////////////////////////////
+
+//! Result of the resolution of a route string, see Navdata::resolveRoutes()
+class NavdataResolvedRoute
+{
+public:
+
+    NavdataResolvedRoute() : departure_airport(0), destination_airport(0), failed_token_index(-1) {};
+    virtual ~NavdataResolvedRoute() { delete departure_airport; delete destination_airport; }
+
+    inline bool isValid() const { return failed_token_index < 0; }
+
+    //! the resolved waypoints, on error the waypoints up to the failed token
+    WaypointPtrList waypoints;
+    //! only set by Navdata::resolveICAORoute(), 0 if not found
+    Airport* departure_airport;
+    Airport* destination_airport;
+    //! index of the route token which could not be resolved, -1 on success
+    int failed_token_index;
+    QString error_text;
+
+private:
+    //! Hidden copy-constructor
+    NavdataResolvedRoute(const NavdataResolvedRoute&);
+    //! Hidden assignment operator
+    const NavdataResolvedRoute& operator = (const NavdataResolvedRoute&);
+};
+
+typedef PtrList<NavdataResolvedRoute> NavdataResolvedRoutePtrList;
 
 /////////////////////////////////////////////////////////////////////////////
 
@@ -75,6 +122,13 @@ public:
     inline const QString& getAiracCycleTitle() const { return m_airac_cycle_title; }
     inline const QString& getAiracCycleDates() const { return m_airac_cycle_dates; }
 
+    //! Compiles the AIRAC text files into the binary navdata image and
+    //! switches to the image afterwards. Returns true on success.
+    bool compileImage();
+
+    //! returns true if queries are answered from the binary navdata image
+    inline bool usesImage() const { return m_image != 0; }
+
     //! the given list will be cleared first
     uint getAirways(const QString& airway_name, AirwayPtrList& airways) const;
 
@@ -96,6 +150,46 @@ public:
                       WaypointPtrList& result_list,
                       const QRegExp& lat_lon_regexp) const;
 
+    //! Searches the airports (for IDs with up to 4 characters), navaids and
+    //! intersections of all given IDs at once. The text files are read in
+    //! a single forward pass each, sorted by file offset. For every ID with
+    //! at least one match the map holds a list with the airports first, then
+    //! the navaids and the intersections, intersections at the position of
+    //! a navaid with the same ID are skipped. Existing map entries are kept.
+    //! Returns the number of IDs added to the map.
+    //! ATTENTION: The caller is responsible to delete the lists in the map.
+    uint getWaypointCandidates(const QStringList& ids, WaypointCandidateMap& candidates) const;
+
+    //! Resolves the given routes, each a list of tokens like
+    //! "WPT1 AIRWAY WPT2 DCT WPT3". The fixes of all routes are looked up in
+    //! a single batch (see getWaypointCandidates()). Ambiguous fixes are
+    //! resolved by the distance to the previous fix of the route. A result
+    //! is appended to the given list for every route, also for failed ones.
+    //! Returns the number of successfully resolved routes.
+    uint resolveRoutes(const QList<QStringList>& routes,
+                       const QRegExp& lat_lon_regexp,
+                       NavdataResolvedRoutePtrList& results) const;
+
+    //! Resolves a single route like resolveRoutes(). When the given reference
+    //! is valid, it is used to choose between ambiguous first fixes,
+    //! otherwise the nearest later fix with a unique ID is used.
+    //! Returns true on success.
+    bool resolveRoute(const QStringList& route,
+                      const Waypoint& reference,
+                      const QRegExp& lat_lon_regexp,
+                      NavdataResolvedRoute& result) const;
+
+    //! Resolves an ICAO route string like "ADEP WPT1 AIRWAY WPT2 ADES". The
+    //! first and last items are taken as the departure and destination
+    //! airports when they are unique airport IDs. Not finding the last
+    //! item of the route between the airports is tolerated, because it
+    //! could be a STAR or another procedure. Returns true on success,
+    //! otherwise the error text of the result is set.
+    //! This may be called from any thread.
+    bool resolveICAORoute(const QString& route,
+                          const QRegExp& lat_lon_regexp,
+                          NavdataResolvedRoute& result) const;
+
     //! Searches for an airway from "from_waypoint" to "to_waypoint" and adds all waypoints to
     //! "result_wpt_list". Returns true on success, false otherwise.
     bool getWaypointsByAirway(const Waypoint& from_waypoint,
@@ -104,6 +198,31 @@ public:
                               WaypointPtrList& result_wpt_list,
                               QString& error_text) const;
 
+    //! Searches the shortest route via airways from "from_waypoint" to
+    //! "to_waypoint" and adds the waypoints in between to "result_wpt_list".
+    //! When "allowed_airways" is not empty, only those airways are used.
+    //! Returns true on success, false otherwise.
+    bool getRouteByAirways(const Waypoint& from_waypoint,
+                           const Waypoint& to_waypoint,
+                           WaypointPtrList& result_wpt_list,
+                           double& distance_nm,
+                           const QStringList& allowed_airways = QStringList()) const;
+
+    inline const AirwayGraph& airwayGraph() const { return m_airway_graph; }
+
+    //! Searches intersections, navaids and airports whose ident (or a word
+    //! of the airport name) starts with the given text or, when "fuzzy" is
+    //! set, has an edit distance of one to the text. Exact matches come
+    //! first, then prefix matches and fuzzy matches, each sorted by the
+    //! distance from the given position. Returns at most "max_count" matches.
+    //! This does not touch any file and may be called from any thread.
+    //! ATTENTION: The given list will be cleared first.
+    uint searchIdents(const QString& text,
+                      const Waypoint& position,
+                      uint max_count,
+                      NavdataIdentSearch::MatchList& matches,
+                      bool fuzzy = true) const;
+
     //! Will parse the given LAT/LON string and will return an intersection with the given data.
     //! Will return NULL on error.
     //! ATTENTION: The calling method will be responsible to delete the returned pointer.
@@ -117,6 +236,10 @@ public:
                                     const QString& wanted_country_code = QString::null,
                                     const QString& wanted_type = Waypoint::TYPE_ALL);
 
+    //! Loads the procedures of the given airport and its neighbour airports
+    //! into the procedure cache in the background.
+    void prefetchProcedures(const Waypoint& airport);
+
     uint getSids(const QString& airport, ProcedurePtrList& procedures) const;
     uint getStars(const QString& airport, ProcedurePtrList& procedures) const;
     uint getApproaches(const QString& airport, ProcedurePtrList& procedures) const;
@@ -140,30 +263,61 @@ public:
 
     //----- coordinate access
 
-    //! Adds airport matching the given LAT/LON values to the given list.
-    //! "variation" is used to span a search rectangle based on the given LAT/LON values.
+    //! Adds copies of the airports within "max_distance_nm" around the
+    //! given position to the given list, see getAirportsWithinRadius() for
+    //! a search without copies.
     //! ATTENTION: The given list will *not* be cleared.
     uint getAirportListByCoordinates(const Waypoint& current_position,
-                                     int variation,
                                      uint max_distance_nm,
                                      WaypointPtrList& airports);
 
-    //! Adds Vor matching the given LAT/LON values to the given list.
-    //! "variation" is used to span a search rectangle based on the given LAT/LON values.
+    //! Adds copies of the VORs within "max_distance_nm" around the
+    //! given position to the given list, see getVorsWithinRadius() for
+    //! a search without copies.
     //! ATTENTION: The given list will *not* be cleared.
     uint getVorListByCoordinates(const Waypoint& current_position,
-                                 int variation,
                                  uint max_distance_nm,
                                  WaypointPtrList& vors);
 
-    //! Adds Ndb matching the given LAT/LON values to the given list.
-    //! "variation" is used to span a search rectangle based on the given LAT/LON values.
+    //! Adds copies of the NDBs within "max_distance_nm" around the
+    //! given position to the given list, see getNdbsWithinRadius() for
+    //! a search without copies.
     //! ATTENTION: The given list will *not* be cleared.
     uint getNdbListByCoordinates(const Waypoint& current_position,
-                                 int variation,
                                  uint max_distance_nm,
                                  WaypointPtrList& ndbs);
 
+    //----- spatial access without copies, the hits are sorted by distance
+    //----- and reference the airports/VORs/NDBs returned by spatialAirport() etc.
+
+    //! the given list will *not* be cleared
+    uint getAirportsWithinRadius(const Waypoint& center, double radius_nm,
+                                 NavdataSpatialIndex::HitList& hits) const;
+    //! the given list will *not* be cleared
+    uint getNearestAirports(const Waypoint& center, uint max_count,
+                            NavdataSpatialIndex::HitList& hits) const;
+
+    //! the given list will *not* be cleared
+    uint getVorsWithinRadius(const Waypoint& center, double radius_nm,
+                             NavdataSpatialIndex::HitList& hits) const;
+    //! the given list will *not* be cleared
+    uint getNearestVors(const Waypoint& center, uint max_count,
+                        NavdataSpatialIndex::HitList& hits) const;
+
+    //! the given list will *not* be cleared
+    uint getNdbsWithinRadius(const Waypoint& center, double radius_nm,
+                             NavdataSpatialIndex::HitList& hits) const;
+    //! the given list will *not* be cleared
+    uint getNearestNdbs(const Waypoint& center, uint max_count,
+                        NavdataSpatialIndex::HitList& hits) const;
+
+    inline const Airport& spatialAirport(const NavdataSpatialIndex::Hit& hit) const
+    { return m_spatial_airport_list[hit.index]; }
+    inline const Vor& spatialVor(const NavdataSpatialIndex::Hit& hit) const
+    { return m_spatial_vor_list[hit.index]; }
+    inline const Ndb& spatialNdb(const NavdataSpatialIndex::Hit& hit) const
+    { return m_spatial_ndb_list[hit.index]; }
+
 signals:
 
     void signalWaypointChoose(const WaypointPtrList& waypoint_list, Waypoint** waypoint_to_insert);
@@ -172,34 +326,94 @@ protected:
 
     bool setupFiles();
     bool extractAiracCycle();
-    //! returns true when successfull, false otherwise
+    //! Loads the indexes of the unchanged AIRAC text files from the index
+    //! file and rebuilds the indexes of the changed files in parallel.
+    //! Returns true when successfull, false otherwise.
     bool setupIndexes();
+    //! Opens the binary navdata image, returns false if there is no
+    //! image or it does not match the AIRAC text files.
+    bool setupImage();
 
     bool isOnCaseSensitiveFilesystem() const;
     void renameNavdataFilenamesToLower(const QString& relative_path) const;
 
-    QString serializeIndexMap(const IndexMap& map);
-    QString serializeAirportCoordinateIndexMap(const AirportListCoordinateIndexMap& map);
-    QString serializeVorCoordinateIndexMap(const VorListCoordinateIndexMap& map);
-    QString serializeNdbCoordinateIndexMap(const NdbListCoordinateIndexMap& map);
+    QFile* sourceFile(NavdataIndexFile::Source source) const;
+
+    //! Returns the handle of the given AIRAC text file to be used by
+    //! queries. Other threads than the one owning the navdata get their own
+    //! handles, so queries may run concurrently without sharing file positions.
+    QFile* queryFile(NavdataIndexFile::Source source) const;
+
+    //! Indexes the given AIRAC text file in a single pass and returns the
+    //! content hash of the file. Builds the ident index of the file, which
+    //! maps every ident to the file offsets of its records, and for airports
+    //! and navaids also the spatial lists.
+    //! ATTENTION: this is called from the index threads, the passes over
+    //! different files only touch disjoint members.
+    bool indexSourceFile(NavdataIndexFile::Source source, QByteArray& hash);
+    bool indexWaypoints(QCryptographicHash& hash);
+    bool indexAirways(QCryptographicHash& hash);
+    bool indexAirports(QCryptographicHash& hash);
+    bool indexNavaids(QCryptographicHash& hash);
+
+    //! returns the index data of the given AIRAC text file for the index file
+    QByteArray serializeIndex(NavdataIndexFile::Source source) const;
+    //! restores the index data of the given AIRAC text file from the index file
+    bool deSerializeIndex(NavdataIndexFile::Source source, const QByteArray& payload);
+
+    //! Builds the ident search indexes from the binary navdata image.
+    void buildImageIdentSearch();
+
+    //! Builds the spatial indexes from the spatial lists.
+    void buildSpatialIndexes();
+
+    //! Builds the airway graph from all airways of the image or the text
+    //! file. Without an image this is part of indexAirways(), so the graph
+    //! is kept in the index file.
+    bool buildAirwayGraph();
+
+    //! Replaces the given airway fixes by the navaids with the same ID and
+    //! position, if any, to get the additional navaid data. When a
+    //! candidate map is given, the navaids are taken from it instead of
+    //! being looked up one by one.
+    void resolveAirwayNavaids(WaypointPtrList& wpt_list, const WaypointCandidateMap* candidates = 0) const;
+
+    //! Resolves the given route with the given candidates. Airway fixes are
+    //! not resolved to navaids. Returns true on success.
+    bool resolveRoute(const QStringList& route,
+                      const Waypoint& reference,
+                      const QRegExp& lat_lon_regexp,
+                      const WaypointCandidateMap& candidates,
+                      NavdataResolvedRoute& result) const;
+
+    //! Returns the candidate of the given ID nearest to the given reference
+    //! or, when the reference is not valid, the first candidate.
+    const Waypoint* nearestCandidate(const WaypointPtrList& candidates, const Waypoint& reference) const;
+
+    //! ATTENTION: the caller is responsible to delete the returned airport, returns 0 on error.
+    Airport* readAirport(qint64 offset) const;
+
+    //! a record to read for getWaypointCandidates()
+    struct CandidateRead
+    {
+        qint64 offset;
+        //! index of the wanted ID
+        int id_index;
+
+        inline bool operator<(const CandidateRead& other) const { return offset < other.offset; }
+    };
+
+    //! Appends a read for every given offset and clears the offset list.
+    static void addCandidateReads(QList<qint64>& offset_list, int id_index, QList<CandidateRead>& reads);
 
-    IndexMap deSerializeIndexMap(const QString& line);
-    AirportListCoordinateIndexMap deSerializeAirportCoordinateIndexMap(const QString& line);
-    VorListCoordinateIndexMap deSerializeVorCoordinateIndexMap(const QString& line);
-    NdbListCoordinateIndexMap deSerializeNdbCoordinateIndexMap(const QString& line);
-
-    bool generateIndex(QFile* file_to_read, IndexMap& index_map, bool generate_navaid_coordinate_index = false);
-    bool indexWaypoints();
-    bool indexAirways();
-    bool indexAirports();
-    bool indexNavaids();
+    bool parseAirwayRoute(const QString& line, QString& airway_name, int& segment_count) const;
 
-    inline QString getCoordinateIndex(const Waypoint& waypoint)
-    { return QString("%1/%2").arg(waypoint.lat(), 0, 'f', 0).arg(waypoint.lon(), 0, 'f', 0); }
-    inline QString getCoordinateIndex(const double& lat, const double& lon)
-    { return QString("%1/%2").arg(lat, 0, 'f', 0).arg(lon, 0, 'f', 0); }
+    //! Reads the segments following an airway route line from the given airway file.
+    //! ATTENTION: the caller is responsible to delete the returned airway, returns 0 on error.
+    Airway* readAirwaySegments(QFile& airway_file, const QString& airway_name) const;
 
-    bool parseAirwayRoute(const QString& line, QString& airway_name, int& segment_count) const;
+    //! ATTENTION: the caller is responsible to delete the returned intersection
+    Intersection* parseIntersection(const QString& line) const;
 
     bool parseAirport(const QString& line, const QStringList& runway_lines, Airport* airport) const;
 
@@ -234,10 +448,23 @@ protected:
                              const QString& wanted_type,
                              ProcedurePtrList& procedures) const;
 
+    QString levelDProcedureFilename(const QString& airport) const;
+
+    //! Parses all procedures of the given Level-D procedure file and stores
+    //! them in the procedure cache. Returns true on success.
+    //! ATTENTION: this is also called from the prefetch thread.
+    bool loadLevelDProcedures(const QString& airport, const QString& filename) const;
 
-    Procedure* parseLevelDProcedure(const QDomElement& element, const QString& wanted_type) const;
+    //! reads the waypoints and transitions of the current procedure element
+    void readLevelDProcedure(QXmlStreamReader& reader, Procedure& procedure, const QString& wpt_flag) const;
 
-    Waypoint* parseLevelDProcedureWaypoint(const QDomElement& element,
+    //! reads the child elements of the current element into the given map
+    static void readLevelDFields(QXmlStreamReader& reader, LevelDFieldMap& fields);
+
+    static void skipLevelDElement(QXmlStreamReader& reader);
+
+    Waypoint* parseLevelDProcedureWaypoint(const QString& element_name,
+                                           const LevelDFieldMap& fields,
                                            Procedure& procedure) const;
 
 protected:
@@ -251,25 +478,73 @@ protected:
     QString m_airac_cycle_dates;
 
     QFile* m_waypoint_file;
-    IndexMap m_waypoint_index_map;
-
     QFile* m_airway_file;
-    IndexMap m_airway_index_map;
-
     QFile* m_airport_file;
-    IndexMap m_airport_index_map;
-    AirportListCoordinateIndexMap m_airport_list_coordinate_index_map;
-
     QFile* m_navaid_file;
-    IndexMap m_navaid_index_map;
-    VorListCoordinateIndexMap m_vor_list_coordinate_index_map;
-    NdbListCoordinateIndexMap m_ndb_list_coordinate_index_map;
 
-    //! airport ICAO to level-d DOM object map
-    mutable QMap<QString, QDomDocument> m_airport_to_leveld_procedure_chache_map;
+    NavdataIdentIndex m_waypoint_ident_index;
+    NavdataIdentIndex m_airway_ident_index;
+    NavdataIdentIndex m_airport_ident_index;
+    NavdataIdentIndex m_navaid_ident_index;
+
+    NavdataIdentSearch m_waypoint_ident_search;
+    NavdataIdentSearch m_airport_ident_search;
+    NavdataIdentSearch m_navaid_ident_search;
+
+    //! airports with at least one runway longer than 2000m
+    AirportList m_spatial_airport_list;
+    NavdataSpatialIndex m_airport_spatial_index;
+    VorList m_spatial_vor_list;
+    NavdataSpatialIndex m_vor_spatial_index;
+    NdbList m_spatial_ndb_list;
+    NavdataSpatialIndex m_ndb_spatial_index;
+
+    AirwayGraph m_airway_graph;
+
+    //! binary navdata image, 0 when the text files are used
+    NavdataImage* m_image;
+
+    //! parsed level-d procedures
+    mutable ProcedureCache m_procedure_cache;
+    NavdataProcedurePrefetcher* m_procedure_prefetcher;
+
+    //! text file handles of the query threads, see queryFile()
+    mutable QThreadStorage<NavdataReadCursors*> m_read_cursors;
 
 private:
 
+    friend class NavdataProcedurePrefetcher;
+    friend class NavdataIndexTask;
+
+};
+
+/////////////////////////////////////////////////////////////////////////////
+
+//! Loads Level-D procedures into the procedure cache of the navdata in the
+//! background.
+class NavdataProcedurePrefetcher : public QThread
+{
+public:
+
+    NavdataProcedurePrefetcher(const Navdata& navdata);
+    virtual ~NavdataProcedurePrefetcher();
+
+    //! queues the given airport
+    void prefetch(const QString& airport, const QString& filename);
+
+protected:
+
+    virtual void run();
+
+protected:
+
+    const Navdata& m_navdata;
+
+    QMutex m_mutex;
+    QWaitCondition m_queue_condition;
+    QStringList m_airport_queue;
+    QStringList m_filename_queue;
+    bool m_stop;
 };
 
 #endif
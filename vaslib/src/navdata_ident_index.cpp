@@ -0,0 +1,265 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2005-2006 Alexander Wemmer
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <string.h>
+
+#include <QtAlgorithms>
+
+#include "waypoint.h"
+
+#include "navdata_ident_index.h"
+
+/////////////////////////////////////////////////////////////////////////////
+
+NavdataIdentIndex::NavdataIdentIndex() : m_slot_mask(0), m_used_slot_count(0)
+{
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void NavdataIdentIndex::clear()
+{
+    m_pending_records.clear();
+    m_slots.clear();
+    m_slot_mask = 0;
+    m_used_slot_count = 0;
+    m_keys.clear();
+    m_references.clear();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void NavdataIdentIndex::insert(const QString& ident, qint64 offset, RecordType type, const QString& country_code)
+{
+    PendingRecord record;
+    record.key = normalize(ident);
+    record.reference.offset = offset;
+    record.reference.country_code = packCountryCode(country_code);
+    record.reference.type = type;
+    m_pending_records.append(record);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void NavdataIdentIndex::finalize()
+{
+    // group the records by key, keep the insertion order within a group
+    qStableSort(m_pending_records);
+
+    uint key_count = 0;
+    for(int index = 0; index < m_pending_records.count(); ++index)
+        if (index == 0 || m_pending_records[index].key != m_pending_records[index-1].key) ++key_count;
+
+    // keep the load factor at or below 50%
+    uint capacity = 16;
+    while(capacity < key_count * 2) capacity <<= 1;
+
+    Slot empty_slot;
+    memset(&empty_slot, 0, sizeof(empty_slot));
+
+    m_slots.fill(empty_slot, capacity);
+    m_slot_mask = capacity - 1;
+    m_used_slot_count = 0;
+    m_keys.clear();
+    m_references.clear();
+    m_references.reserve(m_pending_records.count());
+
+    int index = 0;
+    while(index < m_pending_records.count())
+    {
+        const QByteArray& key = m_pending_records[index].key;
+
+        Slot slot;
+        slot.hash = hash(key.constData(), key.size());
+        slot.key_offset = m_keys.size();
+        slot.first_reference = m_references.count();
+        slot.reference_count = 0;
+
+        m_keys.append(key);
+        m_keys.append('\0');
+
+        for(; index < m_pending_records.count() && m_pending_records[index].key == key; ++index)
+        {
+            m_references.append(m_pending_records[index].reference);
+            ++slot.reference_count;
+        }
+
+        // linear probing
+        quint32 position = slot.hash & m_slot_mask;
+        while(m_slots[position].reference_count != 0) position = (position + 1) & m_slot_mask;
+        m_slots[position] = slot;
+        ++m_used_slot_count;
+    }
+
+    m_pending_records.clear();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void NavdataIdentIndex::operator<<(QDataStream& in)
+{
+    clear();
+
+    quint32 slot_count = 0, used_slot_count = 0, reference_count = 0;
+    in >> slot_count >> used_slot_count >> m_keys >> reference_count;
+
+    // the capacity is always a power of two
+    if (in.status() != QDataStream::Ok || (slot_count & (slot_count - 1)) != 0)
+    {
+        in.setStatus(QDataStream::ReadCorruptData);
+        clear();
+        return;
+    }
+
+    m_slots.resize(slot_count);
+    for(uint index = 0; index < slot_count; ++index)
+    {
+        Slot& slot = m_slots[index];
+        in >> slot.hash >> slot.key_offset >> slot.first_reference >> slot.reference_count;
+    }
+
+    m_references.resize(reference_count);
+    for(uint index = 0; index < reference_count; ++index)
+    {
+        Reference& reference = m_references[index];
+        in >> reference.offset >> reference.country_code >> reference.type;
+    }
+
+    if (in.status() != QDataStream::Ok || !isConsistent(used_slot_count))
+    {
+        in.setStatus(QDataStream::ReadCorruptData);
+        clear();
+        return;
+    }
+
+    m_slot_mask = (slot_count == 0) ? 0 : slot_count - 1;
+    m_used_slot_count = used_slot_count;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+bool NavdataIdentIndex::isConsistent(uint used_slot_count) const
+{
+    uint counted_slots = 0;
+
+    for(int index = 0; index < m_slots.count(); ++index)
+    {
+        const Slot& slot = m_slots[index];
+        if (slot.reference_count == 0) continue;
+        ++counted_slots;
+
+        // the references of the slot must be inside the reference table
+        if (slot.first_reference > (quint32)m_references.count() ||
+            slot.reference_count > (quint32)m_references.count() - slot.first_reference) return false;
+
+        // the key must be a terminated string inside the key buffer
+        if (slot.key_offset >= (quint32)m_keys.size() ||
+            memchr(m_keys.constData() + slot.key_offset, '\0', m_keys.size() - slot.key_offset) == 0) return false;
+    }
+
+    // findSlot() stops probing at the first empty slot
+    return counted_slots == used_slot_count && (m_slots.isEmpty() || counted_slots < (uint)m_slots.count());
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void NavdataIdentIndex::operator>>(QDataStream& out) const
+{
+    MYASSERT(m_pending_records.isEmpty());
+
+    out << (quint32)m_slots.count() << (quint32)m_used_slot_count << m_keys << (quint32)m_references.count();
+
+    for(int index = 0; index < m_slots.count(); ++index)
+    {
+        const Slot& slot = m_slots[index];
+        out << slot.hash << slot.key_offset << slot.first_reference << slot.reference_count;
+    }
+
+    for(int index = 0; index < m_references.count(); ++index)
+    {
+        const Reference& reference = m_references[index];
+        out << reference.offset << reference.country_code << reference.type;
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+const NavdataIdentIndex::Slot* NavdataIdentIndex::findSlot(const QByteArray& key) const
+{
+    if (m_slots.isEmpty()) return 0;
+
+    quint32 key_hash = hash(key.constData(), key.size());
+    quint32 position = key_hash & m_slot_mask;
+
+    while(true)
+    {
+        const Slot& slot = m_slots[position];
+        if (slot.reference_count == 0) return 0;
+        if (slot.hash == key_hash && qstrcmp(m_keys.constData() + slot.key_offset, key.constData()) == 0)
+            return &slot;
+        position = (position + 1) & m_slot_mask;
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+uint NavdataIdentIndex::lookup(const QString& ident,
+                               QList<qint64>& offsets,
+                               RecordType type,
+                               const QString& country_code) const
+{
+    const Slot* slot = findSlot(normalize(ident));
+    if (slot == 0) return 0;
+
+    quint16 packed_country_code = packCountryCode(country_code);
+    uint found_count = 0;
+
+    for(uint index = slot->first_reference; index < slot->first_reference + slot->reference_count; ++index)
+    {
+        const Reference& reference = m_references[index];
+        if (type != TYPE_ANY && reference.type != type) continue;
+        if (packed_country_code != 0 && reference.country_code != packed_country_code) continue;
+        offsets.append(reference.offset);
+        ++found_count;
+    }
+
+    return found_count;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+bool NavdataIdentIndex::contains(const QString& ident) const
+{
+    return findSlot(normalize(ident)) != 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+NavdataIdentIndex::RecordType NavdataIdentIndex::recordType(const QString& waypoint_type)
+{
+    if (waypoint_type == Waypoint::TYPE_INTERSECTION) return TYPE_INTERSECTION;
+    if (waypoint_type == Waypoint::TYPE_VOR) return TYPE_VOR;
+    if (waypoint_type == Waypoint::TYPE_NDB) return TYPE_NDB;
+    if (waypoint_type == Waypoint::TYPE_ILS) return TYPE_ILS;
+    if (waypoint_type == Waypoint::TYPE_AIRPORT) return TYPE_AIRPORT;
+    return TYPE_ANY;
+}
+
+// End of file
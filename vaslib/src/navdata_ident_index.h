@@ -0,0 +1,157 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2005-2006 Alexander Wemmer
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef NAVDATA_IDENT_INDEX_H
+#define NAVDATA_IDENT_INDEX_H
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QList>
+#include <QString>
+#include <QVector>
+
+#include "assert.h"
+
+/////////////////////////////////////////////////////////////////////////////
+
+//! Open addressing hash index from a normalized ident to the references
+//! (file offsets or image record indices) of all records with that ident.
+//! Every reference also carries the record type and country code, so
+//! lookups can be filtered without touching the record itself.
+//! Records are collected with insert() and the table is built by finalize().
+class NavdataIdentIndex
+{
+public:
+
+    enum RecordType { TYPE_INTERSECTION = 0,
+                      TYPE_VOR,
+                      TYPE_NDB,
+                      TYPE_ILS,
+                      TYPE_AIRPORT,
+                      TYPE_AIRWAY,
+                      TYPE_ANY = 0xff
+    };
+
+    struct Reference
+    {
+        qint64 offset;
+        quint16 country_code;
+        quint8 type;
+    };
+
+    NavdataIdentIndex();
+    virtual ~NavdataIdentIndex() {};
+
+    void clear();
+
+    //! adds a record, call finalize() when all records have been added
+    void insert(const QString& ident, qint64 offset, RecordType type,
+                const QString& country_code = QString::null);
+
+    //! builds the hash table from the inserted records
+    void finalize();
+
+    //! reads a finalized index, sets the stream status to ReadCorruptData
+    //! when the index is not consistent
+    void operator<<(QDataStream& in);
+    //! writes a finalized index
+    void operator>>(QDataStream& out) const;
+
+    inline bool isEmpty() const { return m_references.isEmpty(); }
+    inline uint identCount() const { return m_used_slot_count; }
+    inline uint referenceCount() const { return m_references.count(); }
+
+    //! Appends the offsets of all records with the given ident to the given
+    //! list and returns the number of appended offsets. When "country_code"
+    //! is not empty, only records with that country code are returned.
+    uint lookup(const QString& ident,
+                QList<qint64>& offsets,
+                RecordType type = TYPE_ANY,
+                const QString& country_code = QString::null) const;
+
+    //! returns true if there is at least one record with the given ident
+    bool contains(const QString& ident) const;
+
+    //! Maps a Waypoint::TYPE_* string to a record type, returns TYPE_ANY for
+    //! Waypoint::TYPE_ALL and unknown types.
+    static RecordType recordType(const QString& waypoint_type);
+
+    //! upper case and trimmed, like the IDs in the AIRAC files
+    static inline QByteArray normalize(const QString& ident) { return ident.trimmed().toUpper().toLatin1(); }
+
+    static inline quint16 packCountryCode(const QString& country_code)
+    {
+        QByteArray latin1 = country_code.trimmed().toUpper().toLatin1();
+        if (latin1.isEmpty()) return 0;
+        if (latin1.size() == 1) return (quint8)latin1[0] << 8;
+        return ((quint8)latin1[0] << 8) | (quint8)latin1[1];
+    }
+
+    //! FNV-1a hash of the given key
+    static inline quint32 hash(const char* key, int length)
+    {
+        quint32 value = 2166136261u;
+        for(int index = 0; index < length; ++index)
+        {
+            value ^= (quint8)key[index];
+            value *= 16777619u;
+        }
+        return value;
+    }
+
+protected:
+
+    struct Slot
+    {
+        quint32 hash;
+        quint32 key_offset;
+        quint32 first_reference;
+        quint32 reference_count;
+    };
+
+    struct PendingRecord
+    {
+        QByteArray key;
+        Reference reference;
+        bool operator<(const PendingRecord& other) const { return key < other.key; }
+    };
+
+    //! returns the slot of the given key or 0 if not found
+    const Slot* findSlot(const QByteArray& key) const;
+
+    //! Returns true when all slots reference keys and references inside
+    //! the buffers and the number of used slots matches the given one.
+    bool isConsistent(uint used_slot_count) const;
+
+protected:
+
+    QList<PendingRecord> m_pending_records;
+
+    //! capacity is always a power of two, empty slots have a reference count of 0
+    QVector<Slot> m_slots;
+    quint32 m_slot_mask;
+    uint m_used_slot_count;
+
+    //! zero terminated keys
+    QByteArray m_keys;
+    QVector<Reference> m_references;
+};
+
+#endif
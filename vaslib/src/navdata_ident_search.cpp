@@ -0,0 +1,426 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2005-2006 Alexander Wemmer
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <math.h>
+#include <string.h>
+
+#include <QIODevice>
+#include <QRegExp>
+#include <QSet>
+#include <QStringList>
+#include <QtAlgorithms>
+
+#include "navcalc.h"
+
+#include "navdata_ident_search.h"
+
+/////////////////////////////////////////////////////////////////////////////
+
+//! shorter keys are only found by prefix, their variants would match
+//! almost everything
+#define FUZZY_MIN_KEY_LENGTH 3
+
+//! keys are limited to fit into the key length field
+#define MAX_KEY_LENGTH 255
+
+//! bytes of a streamed entry: offsets, position, key length and type
+#define ENTRY_STREAM_SIZE (4 + 4 + 4 + 4 + 1 + 1)
+
+/////////////////////////////////////////////////////////////////////////////
+
+NavdataIdentSearch::NavdataIdentSearch()
+{
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void NavdataIdentSearch::clear()
+{
+    m_pending_entries.clear();
+    m_entries.clear();
+    m_variants.clear();
+    m_strings.clear();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void NavdataIdentSearch::insert(const QString& key, const QString& ident, double lat, double lon,
+                                NavdataIdentIndex::RecordType type)
+{
+    PendingEntry entry;
+    entry.key = NavdataIdentIndex::normalize(key).left(MAX_KEY_LENGTH);
+    if (entry.key.isEmpty()) return;
+    entry.ident = NavdataIdentIndex::normalize(ident);
+    entry.lat = Navcalc::toRad(lat);
+    entry.lon = Navcalc::toRad(lon);
+    entry.type = type;
+    m_pending_entries.append(entry);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+quint32 NavdataIdentSearch::addString(const QByteArray& string)
+{
+    quint32 offset = m_strings.size();
+    m_strings.append(string);
+    m_strings.append('\0');
+    return offset;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void NavdataIdentSearch::finalize()
+{
+    qStableSort(m_pending_entries);
+
+    m_entries.clear();
+    m_entries.reserve(m_pending_entries.count());
+    m_variants.clear();
+    m_strings.clear();
+
+    quint32 key_offset = 0;
+
+    for(int index = 0; index < m_pending_entries.count(); ++index)
+    {
+        const PendingEntry& pending = m_pending_entries[index];
+        bool new_key = (index == 0 || pending.key != m_pending_entries[index-1].key);
+
+        if (new_key)
+        {
+            key_offset = addString(pending.key);
+
+            // index the key and all its one-deletion variants
+
+            if (pending.key.size() >= FUZZY_MIN_KEY_LENGTH)
+            {
+                Variant variant;
+                variant.first_entry = m_entries.count();
+                variant.hash = NavdataIdentIndex::hash(pending.key.constData(), pending.key.size());
+                m_variants.append(variant);
+
+                QByteArray deleted;
+                for(int position = 0; position < pending.key.size(); ++position)
+                {
+                    // deleting one of several equal characters gives the same variant
+                    if (position > 0 && pending.key[position] == pending.key[position-1]) continue;
+
+                    deleted = pending.key;
+                    deleted.remove(position, 1);
+                    variant.hash = NavdataIdentIndex::hash(deleted.constData(), deleted.size());
+                    m_variants.append(variant);
+                }
+            }
+        }
+
+        Entry entry;
+        entry.key_offset = key_offset;
+        entry.ident_offset = (pending.ident == pending.key) ? key_offset : addString(pending.ident);
+        entry.lat = pending.lat;
+        entry.lon = pending.lon;
+        entry.key_length = pending.key.size();
+        entry.type = pending.type;
+        m_entries.append(entry);
+    }
+
+    qSort(m_variants);
+    m_pending_entries.clear();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+int NavdataIdentSearch::lowerBound(const QByteArray& key) const
+{
+    int first = 0;
+    int count = m_entries.count();
+
+    while(count > 0)
+    {
+        int step = count / 2;
+        int middle = first + step;
+
+        if (qstrcmp(this->key(m_entries[middle]), key.constData()) < 0)
+        {
+            first = middle + 1;
+            count -= step + 1;
+        }
+        else
+        {
+            count = step;
+        }
+    }
+
+    return first;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+uint NavdataIdentSearch::search(const QString& text, double lat, double lon, uint max_count,
+                                MatchList& matches, bool fuzzy) const
+{
+    QByteArray search_key = NavdataIdentIndex::normalize(text);
+    if (search_key.isEmpty() || m_entries.isEmpty() || max_count == 0) return matches.count();
+
+    double lat_rad = Navcalc::toRad(lat);
+    double sin_lat = sin(lat_rad);
+    double cos_lat = cos(lat_rad);
+    double lon_rad = Navcalc::toRad(lon);
+
+    // all keys starting with the text follow each other in the table
+
+    int index = lowerBound(search_key);
+    while(index < m_entries.count())
+    {
+        const Entry& entry = m_entries[index];
+        if (qstrncmp(key(entry), search_key.constData(), search_key.size()) != 0) break;
+
+        Quality quality = (entry.key_length == search_key.size()) ? QUALITY_EXACT : QUALITY_PREFIX;
+
+        int next_index = index + 1;
+        while(next_index < m_entries.count() && m_entries[next_index].key_offset == entry.key_offset) ++next_index;
+
+        addMatches(index, quality, sin_lat, cos_lat, lon_rad, max_count, matches);
+        index = next_index;
+    }
+
+    if (!fuzzy || search_key.size() < FUZZY_MIN_KEY_LENGTH - 1) return matches.count();
+
+    // look up the variants of the text, the text itself matches keys with
+    // one more character and the deletions match keys with one less or one
+    // substituted character
+
+    QList<quint32> variant_hashes;
+    variant_hashes.append(NavdataIdentIndex::hash(search_key.constData(), search_key.size()));
+
+    QByteArray deleted;
+    for(int position = 0; position < search_key.size(); ++position)
+    {
+        if (position > 0 && search_key[position] == search_key[position-1]) continue;
+        deleted = search_key;
+        deleted.remove(position, 1);
+        variant_hashes.append(NavdataIdentIndex::hash(deleted.constData(), deleted.size()));
+    }
+
+    QSet<quint32> checked_entries;
+
+    QList<quint32>::const_iterator hash_iter = variant_hashes.begin();
+    for(; hash_iter != variant_hashes.end(); ++hash_iter)
+    {
+        Variant wanted;
+        wanted.hash = *hash_iter;
+        QVector<Variant>::const_iterator iter = qLowerBound(m_variants.begin(), m_variants.end(), wanted);
+
+        for(; iter != m_variants.end() && iter->hash == wanted.hash; ++iter)
+        {
+            if (checked_entries.contains(iter->first_entry)) continue;
+            checked_entries.insert(iter->first_entry);
+
+            const Entry& entry = m_entries[iter->first_entry];
+
+            // prefix matches were already added above
+            if (entry.key_length >= search_key.size() &&
+                qstrncmp(key(entry), search_key.constData(), search_key.size()) == 0) continue;
+
+            if (!isEditDistanceOne(key(entry), entry.key_length, search_key.constData(), search_key.size())) continue;
+
+            addMatches(iter->first_entry, QUALITY_FUZZY, sin_lat, cos_lat, lon_rad, max_count, matches);
+        }
+    }
+
+    return matches.count();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void NavdataIdentSearch::addMatches(int first_entry, Quality quality, double sin_lat, double cos_lat, double lon_rad,
+                                    uint max_count, MatchList& matches) const
+{
+    quint32 key_offset = m_entries[first_entry].key_offset;
+
+    for(int index = first_entry; index < m_entries.count() && m_entries[index].key_offset == key_offset; ++index)
+    {
+        const Entry& entry = m_entries[index];
+
+        double dot = sin_lat * sin(entry.lat) + cos_lat * cos(entry.lat) * cos(entry.lon - lon_rad);
+        if (dot > 1.0) dot = 1.0;
+        else if (dot < -1.0) dot = -1.0;
+        double distance_nm = Navcalc::toDeg(acos(dot)) * 60.0;
+
+        // skip the construction of the match when it would not make it into the list
+        if ((uint)matches.count() >= max_count)
+        {
+            const Match& worst = matches.last();
+            if (quality > worst.quality || (quality == worst.quality && distance_nm >= worst.distance_nm)) continue;
+        }
+
+        Match match;
+        match.ident = QString::fromLatin1(ident(entry));
+        match.key = QString::fromLatin1(key(entry));
+        match.type = (NavdataIdentIndex::RecordType)entry.type;
+        match.lat = Navcalc::toDeg(entry.lat);
+        match.lon = Navcalc::toDeg(entry.lon);
+        match.quality = quality;
+        match.distance_nm = distance_nm;
+        insertMatch(match, max_count, matches);
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void NavdataIdentSearch::insertMatch(const Match& match, uint max_count, MatchList& matches)
+{
+    // a record may be found by its ident and by its name, keep the better match
+
+    for(int index = 0; index < matches.count(); ++index)
+    {
+        const Match& other = matches[index];
+        if (other.type != match.type || other.ident != match.ident ||
+            other.lat != match.lat || other.lon != match.lon) continue;
+
+        if (!(match < other)) return;
+        matches.removeAt(index);
+        break;
+    }
+
+    MatchList::iterator iter = qUpperBound(matches.begin(), matches.end(), match);
+    matches.insert(iter, match);
+    while((uint)matches.count() > max_count) matches.removeLast();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+bool NavdataIdentSearch::isEditDistanceOne(const char* key1, int length1, const char* key2, int length2)
+{
+    if (length1 < length2) return isEditDistanceOne(key2, length2, key1, length1);
+    if (length1 - length2 > 1) return false;
+
+    int position = 0;
+    while(position < length2 && key1[position] == key2[position]) ++position;
+    if (position == length2) return length1 != length2;
+
+    // substitution or deletion at the first difference, the rest must be equal
+    if (length1 == length2)
+        return memcmp(key1 + position + 1, key2 + position + 1, length1 - position - 1) == 0;
+    return memcmp(key1 + position + 1, key2 + position, length2 - position) == 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+QStringList NavdataIdentSearch::nameKeys(const QString& name)
+{
+    QStringList keys;
+
+    QStringList words = name.toUpper().split(QRegExp("[^A-Z0-9]+"), QString::SkipEmptyParts);
+    QStringList::const_iterator iter = words.begin();
+    for(; iter != words.end(); ++iter)
+        if (iter->length() >= FUZZY_MIN_KEY_LENGTH && !keys.contains(*iter)) keys.append(*iter);
+
+    return keys;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void NavdataIdentSearch::operator<<(QDataStream& in)
+{
+    clear();
+
+    quint32 entry_count = 0, variant_count = 0;
+    in >> m_strings >> entry_count >> variant_count;
+    if (in.status() != QDataStream::Ok) { clear(); return; }
+
+    // do not allocate more entries than the stream can hold
+    if (in.device() != 0 && in.device()->bytesAvailable() < (qint64)entry_count * ENTRY_STREAM_SIZE)
+    {
+        in.setStatus(QDataStream::ReadCorruptData);
+        clear();
+        return;
+    }
+
+    m_entries.resize(entry_count);
+    for(uint index = 0; index < entry_count; ++index)
+    {
+        Entry& entry = m_entries[index];
+        in >> entry.key_offset >> entry.ident_offset >> entry.lat >> entry.lon >> entry.key_length >> entry.type;
+    }
+
+    m_variants.resize(variant_count);
+    for(uint index = 0; index < variant_count; ++index)
+    {
+        Variant& variant = m_variants[index];
+        in >> variant.hash >> variant.first_entry;
+    }
+
+    if (in.status() != QDataStream::Ok || !isConsistent())
+    {
+        in.setStatus(QDataStream::ReadCorruptData);
+        clear();
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+bool NavdataIdentSearch::isConsistent() const
+{
+    quint32 string_size = m_strings.size();
+
+    for(int index = 0; index < m_entries.count(); ++index)
+    {
+        const Entry& entry = m_entries[index];
+
+        // the key must be terminated right after its length, the ident anywhere
+        if (entry.key_offset >= string_size || entry.key_length >= string_size - entry.key_offset ||
+            m_strings[(int)(entry.key_offset + entry.key_length)] != '\0' ||
+            (int)qstrlen(key(entry)) != entry.key_length) return false;
+
+        if (entry.ident_offset >= string_size ||
+            memchr(ident(entry), '\0', string_size - entry.ident_offset) == 0) return false;
+    }
+
+    for(int index = 0; index < m_variants.count(); ++index)
+    {
+        // the variants are binary searched by hash
+        if (m_variants[index].first_entry >= (quint32)m_entries.count()) return false;
+        if (index > 0 && m_variants[index].hash < m_variants[index-1].hash) return false;
+    }
+
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void NavdataIdentSearch::operator>>(QDataStream& out) const
+{
+    MYASSERT(m_pending_entries.isEmpty());
+
+    out << m_strings << (quint32)m_entries.count() << (quint32)m_variants.count();
+
+    for(int index = 0; index < m_entries.count(); ++index)
+    {
+        const Entry& entry = m_entries[index];
+        out << entry.key_offset << entry.ident_offset << entry.lat << entry.lon << entry.key_length << entry.type;
+    }
+
+    for(int index = 0; index < m_variants.count(); ++index)
+    {
+        const Variant& variant = m_variants[index];
+        out << variant.hash << variant.first_entry;
+    }
+}
+
+// End of file
@@ -0,0 +1,174 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2005-2006 Alexander Wemmer
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef NAVDATA_IDENT_SEARCH_H
+#define NAVDATA_IDENT_SEARCH_H
+
+#include <QByteArray>
+#include <QDataStream>
+#include <QList>
+#include <QString>
+#include <QVector>
+
+#include "assert.h"
+#include "navdata_ident_index.h"
+
+/////////////////////////////////////////////////////////////////////////////
+
+//! Search index for autocompletion over idents and airport names.
+//! The keys are kept in a sorted table, so all keys with a given prefix
+//! form a contiguous range found by a binary search. Keys within an edit
+//! distance of one are found with a symmetric delete index: every key is
+//! also indexed by the hashes of all its variants with one character
+//! removed, and two keys with an edit distance of one always share such a
+//! variant.
+class NavdataIdentSearch
+{
+public:
+
+    //! better matches have lower values
+    enum Quality { QUALITY_EXACT = 0,
+                   QUALITY_PREFIX,
+                   QUALITY_FUZZY
+    };
+
+    struct Match
+    {
+        //! the ident of the found record
+        QString ident;
+        //! the matched key, differs from the ident for airport name matches
+        QString key;
+        NavdataIdentIndex::RecordType type;
+        double lat;
+        double lon;
+        Quality quality;
+        double distance_nm;
+
+        inline bool operator<(const Match& other) const
+        {
+            if (quality != other.quality) return quality < other.quality;
+            return distance_nm < other.distance_nm;
+        }
+    };
+
+    typedef QList<Match> MatchList;
+
+    NavdataIdentSearch();
+    virtual ~NavdataIdentSearch() {};
+
+    void clear();
+
+    //! Adds a record with the given search key (the ident itself or e.g.
+    //! a word of an airport name), call finalize() when all records have
+    //! been added.
+    void insert(const QString& key, const QString& ident, double lat, double lon,
+                NavdataIdentIndex::RecordType type);
+
+    //! builds the search tables from the inserted records
+    void finalize();
+
+    inline bool isEmpty() const { return m_entries.isEmpty(); }
+    inline uint count() const { return m_entries.count(); }
+
+    //! Searches keys starting with the given text and, when "fuzzy" is
+    //! set, keys with an edit distance of one to the given text. The matches
+    //! are merged into the given list, which is kept sorted by quality and
+    //! by distance from the given position and is limited to "max_count"
+    //! matches. So the list may be passed to several searches to get the
+    //! best matches over all of them. Returns the number of matches in the list.
+    uint search(const QString& text, double lat, double lon, uint max_count,
+                MatchList& matches, bool fuzzy = true) const;
+
+    //! returns the words of the given airport name to be used as search keys
+    static QStringList nameKeys(const QString& name);
+
+    //! reads a finalized search index, sets the stream status to
+    //! ReadCorruptData when the index is not consistent
+    void operator<<(QDataStream& in);
+    //! writes a finalized search index
+    void operator>>(QDataStream& out) const;
+
+protected:
+
+    struct Entry
+    {
+        quint32 key_offset;
+        quint32 ident_offset;
+        float lat;
+        float lon;
+        quint8 key_length;
+        quint8 type;
+    };
+
+    //! one entry per variant of a unique key
+    struct Variant
+    {
+        quint32 hash;
+        //! index of the first entry with the key
+        quint32 first_entry;
+
+        inline bool operator<(const Variant& other) const { return hash < other.hash; }
+    };
+
+    struct PendingEntry
+    {
+        QByteArray key;
+        QByteArray ident;
+        float lat;
+        float lon;
+        quint8 type;
+
+        inline bool operator<(const PendingEntry& other) const { return key < other.key; }
+    };
+
+    inline const char* key(const Entry& entry) const { return m_strings.constData() + entry.key_offset; }
+    inline const char* ident(const Entry& entry) const { return m_strings.constData() + entry.ident_offset; }
+
+    quint32 addString(const QByteArray& string);
+
+    //! Returns true when all entries reference strings inside the string
+    //! buffer and all variants reference existing entries in hash order.
+    bool isConsistent() const;
+
+    //! returns the index of the first entry not less than the given key
+    int lowerBound(const QByteArray& key) const;
+
+    //! adds all entries with the same key starting at the given entry
+    void addMatches(int first_entry, Quality quality, double sin_lat, double cos_lat, double lon_rad,
+                    uint max_count, MatchList& matches) const;
+
+    static void insertMatch(const Match& match, uint max_count, MatchList& matches);
+
+    //! returns true if the edit distance of the given keys is exactly one
+    static bool isEditDistanceOne(const char* key1, int length1, const char* key2, int length2);
+
+protected:
+
+    QList<PendingEntry> m_pending_entries;
+
+    //! sorted by key
+    QVector<Entry> m_entries;
+    //! sorted by hash
+    QVector<Variant> m_variants;
+    //! zero terminated keys and idents
+    QByteArray m_strings;
+};
+
+#endif
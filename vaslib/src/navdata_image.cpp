@@ -0,0 +1,730 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2005-2006 Alexander Wemmer
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <string.h>
+
+#include <QDateTime>
+#include <QtAlgorithms>
+
+#include "logger.h"
+#include "airport.h"
+#include "runway.h"
+#include "airway.h"
+#include "intersection.h"
+#include "ndb.h"
+#include "vor.h"
+#include "ils.h"
+
+#include "navdata_image.h"
+
+/////////////////////////////////////////////////////////////////////////////
+
+#define COORD_FACTOR 1000000.0
+
+/////////////////////////////////////////////////////////////////////////////
+
+NavdataImageWriter::NavdataImageWriter()
+{
+    memset(&m_header, 0, sizeof(m_header));
+    m_header.magic = NAVDATA_IMAGE_MAGIC;
+    m_header.version = NAVDATA_IMAGE_VERSION;
+    m_header.airac_cycle_title = addString(QString::null);
+    m_header.airac_cycle_dates = m_header.airac_cycle_title;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void NavdataImageWriter::setAiracCycle(const QString& title, const QString& dates)
+{
+    m_header.airac_cycle_title = addString(title);
+    m_header.airac_cycle_dates = addString(dates);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void NavdataImageWriter::setSourceFile(NavdataImageHeader::SourceFile source, const QFileInfo& file_info)
+{
+    MYASSERT(source < NavdataImageHeader::SOURCE_COUNT);
+    m_header.source_files[source].size = (quint32)file_info.size();
+    m_header.source_files[source].modified = file_info.lastModified().toTime_t();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+quint32 NavdataImageWriter::addString(const QString& string)
+{
+    QByteArray latin1 = string.toLatin1();
+
+    QHash<QByteArray, quint32>::const_iterator iter = m_string_offset_map.find(latin1);
+    if (iter != m_string_offset_map.end()) return iter.value();
+
+    quint32 offset = m_strings.size();
+    m_strings.append(latin1);
+    m_strings.append('\0');
+    m_string_offset_map.insert(latin1, offset);
+    return offset;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void NavdataImageWriter::addIntersection(const Intersection& intersection)
+{
+    Entry<NavdataImageIntersection> entry;
+    entry.key = intersection.id().toLatin1();
+    entry.detail_index = -1;
+    entry.record.id = addString(intersection.id());
+    entry.record.country_code = addString(intersection.countryCode());
+    entry.record.lat = qRound(intersection.lat() * COORD_FACTOR);
+    entry.record.lon = qRound(intersection.lon() * COORD_FACTOR);
+    m_intersections.append(entry);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void NavdataImageWriter::addNavaid(const Waypoint& navaid)
+{
+    const Ndb* ndb = navaid.asNdb();
+    if (ndb == 0) return;
+
+    Entry<NavdataImageNavaid> entry;
+    entry.key = ndb->id().toLatin1();
+    entry.detail_index = -1;
+    entry.record.id = addString(ndb->id());
+    entry.record.name = addString(ndb->name());
+    entry.record.country_code = addString(ndb->countryCode());
+    entry.record.lat = qRound(ndb->lat() * COORD_FACTOR);
+    entry.record.lon = qRound(ndb->lon() * COORD_FACTOR);
+    entry.record.freq = ndb->freq();
+    entry.record.range_nm = ndb->rangeNm();
+    entry.record.elevation_ft = ndb->elevationFt();
+    entry.record.has_dme = 0;
+    entry.record.course = 0;
+
+    if (navaid.asIls() != 0)
+    {
+        entry.record.type = NavdataImageNavaid::TYPE_ILS;
+        entry.record.has_dme = navaid.asIls()->hasDME();
+        entry.record.course = navaid.asIls()->course();
+    }
+    else if (navaid.asVor() != 0)
+    {
+        entry.record.type = NavdataImageNavaid::TYPE_VOR;
+        entry.record.has_dme = navaid.asVor()->hasDME();
+    }
+    else
+    {
+        entry.record.type = NavdataImageNavaid::TYPE_NDB;
+    }
+
+    m_navaids.append(entry);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void NavdataImageWriter::addAirport(const Airport& airport)
+{
+    Entry<NavdataImageAirport> entry;
+    entry.key = airport.id().toLatin1();
+    entry.detail_index = m_airport_runways.count();
+    entry.record.id = addString(airport.id());
+    entry.record.name = addString(airport.name());
+    entry.record.lat = qRound(airport.lat() * COORD_FACTOR);
+    entry.record.lon = qRound(airport.lon() * COORD_FACTOR);
+    entry.record.elevation_ft = airport.elevationFt();
+    entry.record.first_runway = 0;
+    entry.record.runway_count = airport.runwayCount();
+
+    QList<NavdataImageRunway> runway_list;
+
+    RunwayMapIterator rwy_iter = airport.runwayMapIterator();
+    while(rwy_iter.hasNext())
+    {
+        const Runway& runway = rwy_iter.next().value();
+
+        NavdataImageRunway record;
+        record.id = addString(runway.id());
+        record.lat = qRound(runway.lat() * COORD_FACTOR);
+        record.lon = qRound(runway.lon() * COORD_FACTOR);
+        record.hdg = runway.hdg();
+        record.length_m = runway.lengthM();
+        record.has_ils = runway.hasILS();
+        record.ils_freq = runway.ILSFreq();
+        record.ils_hdg = runway.ILSHdg();
+        record.threshold_elevation_ft = runway.thresholdElevationFt();
+        record.gs_angle = runway.GSAngle();
+        record.threshold_overflying_height_ft = runway.thresholdOverflyingHeightFt();
+        runway_list.append(record);
+    }
+
+    m_airport_runways.append(runway_list);
+    m_airports.append(entry);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void NavdataImageWriter::addAirway(const Airway& airway)
+{
+    Entry<NavdataImageAirway> entry;
+    entry.key = airway.id().toLatin1();
+    entry.detail_index = m_airway_points.count();
+    entry.record.id = addString(airway.id());
+    entry.record.first_point = 0;
+    entry.record.point_count = airway.count();
+
+    QList<NavdataImageAirwayPoint> point_list;
+
+    WaypointPtrListIterator iter(airway.waypointList());
+    while(iter.hasNext())
+    {
+        const Waypoint* waypoint = iter.next();
+        MYASSERT(waypoint != 0);
+
+        NavdataImageAirwayPoint record;
+        record.id = addString(waypoint->id());
+        record.lat = qRound(waypoint->lat() * COORD_FACTOR);
+        record.lon = qRound(waypoint->lon() * COORD_FACTOR);
+        point_list.append(record);
+    }
+
+    m_airway_points.append(point_list);
+    m_airways.append(entry);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+template <class RECORD> bool NavdataImageWriter::writeSection(QFile& file,
+                                                             const QList< Entry<RECORD> >& entries,
+                                                             NavdataImageSection& section)
+{
+    section.offset = (quint32)file.pos();
+    section.count = entries.count();
+
+    typename QList< Entry<RECORD> >::const_iterator iter = entries.begin();
+    for(; iter != entries.end(); ++iter)
+        if (file.write((const char*)&(*iter).record, sizeof(RECORD)) != sizeof(RECORD)) return false;
+
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+template <class RECORD> bool NavdataImageWriter::writeSection(QFile& file,
+                                                             const QList<RECORD>& records,
+                                                             NavdataImageSection& section)
+{
+    section.offset = (quint32)file.pos();
+    section.count = records.count();
+
+    typename QList<RECORD>::const_iterator iter = records.begin();
+    for(; iter != records.end(); ++iter)
+        if (file.write((const char*)&(*iter), sizeof(RECORD)) != sizeof(RECORD)) return false;
+
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+bool NavdataImageWriter::write(const QString& filename)
+{
+    // sort all tables by ID, keep the file order of entries with the same ID
+
+    qStableSort(m_intersections);
+    qStableSort(m_navaids);
+    qStableSort(m_airports);
+    qStableSort(m_airways);
+
+    // flatten the runway and airway point lists in the sorted order
+
+    QList<NavdataImageRunway> runway_list;
+    QList< Entry<NavdataImageAirport> >::iterator airport_iter = m_airports.begin();
+    for(; airport_iter != m_airports.end(); ++airport_iter)
+    {
+        (*airport_iter).record.first_runway = runway_list.count();
+        runway_list += m_airport_runways[(*airport_iter).detail_index];
+    }
+
+    QList<NavdataImageAirwayPoint> airway_point_list;
+    QList< Entry<NavdataImageAirway> >::iterator airway_iter = m_airways.begin();
+    for(; airway_iter != m_airways.end(); ++airway_iter)
+    {
+        (*airway_iter).record.first_point = airway_point_list.count();
+        airway_point_list += m_airway_points[(*airway_iter).detail_index];
+    }
+
+    // write the image
+
+    QFile file(filename);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        Logger::log(QString("NavdataImageWriter:write: could not open (%1)").arg(filename));
+        return false;
+    }
+
+    // the header is written twice, the second time with the final section offsets
+    bool ok = file.write((const char*)&m_header, sizeof(m_header)) == sizeof(m_header);
+
+    ok = ok && writeSection(file, m_intersections, m_header.sections[NavdataImageHeader::SECTION_INTERSECTIONS]);
+    ok = ok && writeSection(file, m_navaids, m_header.sections[NavdataImageHeader::SECTION_NAVAIDS]);
+    ok = ok && writeSection(file, m_airports, m_header.sections[NavdataImageHeader::SECTION_AIRPORTS]);
+    ok = ok && writeSection(file, runway_list, m_header.sections[NavdataImageHeader::SECTION_RUNWAYS]);
+    ok = ok && writeSection(file, m_airways, m_header.sections[NavdataImageHeader::SECTION_AIRWAYS]);
+    ok = ok && writeSection(file, airway_point_list, m_header.sections[NavdataImageHeader::SECTION_AIRWAY_POINTS]);
+
+    m_header.sections[NavdataImageHeader::SECTION_STRINGS].offset = (quint32)file.pos();
+    m_header.sections[NavdataImageHeader::SECTION_STRINGS].count = m_strings.size();
+    ok = ok && file.write(m_strings) == m_strings.size();
+
+    ok = ok && file.seek(0);
+    ok = ok && file.write((const char*)&m_header, sizeof(m_header)) == sizeof(m_header);
+
+    file.close();
+
+    if (!ok)
+    {
+        Logger::log(QString("NavdataImageWriter:write: ERROR: could not write (%1)").arg(filename));
+        file.remove();
+        return false;
+    }
+
+    Logger::log(QString("NavdataImageWriter:write: wrote %1: %2 intersections, %3 navaids, "
+                        "%4 airports, %5 airways, %6 bytes of strings").
+                arg(filename).arg(m_intersections.count()).arg(m_navaids.count()).
+                arg(m_airports.count()).arg(m_airways.count()).arg(m_strings.size()));
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
+NavdataImage::NavdataImage() : m_data(0), m_size(0), m_header(0), m_strings(0)
+{
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+NavdataImage::~NavdataImage()
+{
+    close();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+bool NavdataImage::open(const QString& filename)
+{
+    close();
+
+    m_file.setFileName(filename);
+    if (!m_file.open(QIODevice::ReadOnly))
+    {
+        Logger::log(QString("NavdataImage:open: could not open (%1)").arg(filename));
+        return false;
+    }
+
+    m_size = m_file.size();
+    if (m_size < (qint64)sizeof(NavdataImageHeader))
+    {
+        Logger::log(QString("NavdataImage:open: file too small (%1)").arg(filename));
+        close();
+        return false;
+    }
+
+    m_data = m_file.map(0, m_size);
+    if (m_data == 0)
+    {
+        Logger::log(QString("NavdataImage:open: could not map (%1)").arg(filename));
+        close();
+        return false;
+    }
+
+    const NavdataImageHeader* header = (const NavdataImageHeader*)m_data;
+
+    if (header->magic != NAVDATA_IMAGE_MAGIC || header->version != NAVDATA_IMAGE_VERSION)
+    {
+        Logger::log(QString("NavdataImage:open: wrong magic or version %1 (%2)").
+                    arg(header->version).arg(filename));
+        close();
+        return false;
+    }
+
+    // check that all sections are within the file
+
+    static const uint record_sizes[NavdataImageHeader::SECTION_COUNT] =
+        { sizeof(NavdataImageIntersection), sizeof(NavdataImageNavaid),
+          sizeof(NavdataImageAirport), sizeof(NavdataImageRunway),
+          sizeof(NavdataImageAirway), sizeof(NavdataImageAirwayPoint), 1 };
+
+    for(int index = 0; index < NavdataImageHeader::SECTION_COUNT; ++index)
+    {
+        const NavdataImageSection& section = header->sections[index];
+        if (section.offset < sizeof(NavdataImageHeader) ||
+            (qint64)section.offset + (qint64)section.count * record_sizes[index] > m_size)
+        {
+            Logger::log(QString("NavdataImage:open: section %1 out of range (%2)").arg(index).arg(filename));
+            close();
+            return false;
+        }
+    }
+
+    const NavdataImageSection& strings = header->sections[NavdataImageHeader::SECTION_STRINGS];
+    if (strings.count == 0 || m_data[strings.offset + strings.count - 1] != '\0')
+    {
+        Logger::log(QString("NavdataImage:open: invalid string table (%1)").arg(filename));
+        close();
+        return false;
+    }
+
+    m_header = header;
+    m_strings = (const char*)(m_data + strings.offset);
+
+    if (!checkRecords())
+    {
+        Logger::log(QString("NavdataImage:open: invalid record (%1)").arg(filename));
+        close();
+        return false;
+    }
+
+    buildIdentIndexes();
+
+    Logger::log(QString("NavdataImage:open: mapped %1 (%2 bytes, AIRAC %3)").
+                arg(filename).arg(m_size).arg(airacCycleTitle()));
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void NavdataImage::close()
+{
+    if (m_data != 0) m_file.unmap((uchar*)m_data);
+    if (m_file.isOpen()) m_file.close();
+
+    m_data = 0;
+    m_size = 0;
+    m_header = 0;
+    m_strings = 0;
+
+    m_intersection_index.clear();
+    m_navaid_index.clear();
+    m_airport_index.clear();
+    m_airway_index.clear();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+//! the string table ends with a zero, so every offset inside it is terminated
+static inline bool isValidString(quint32 offset, quint32 string_table_size)
+{
+    return offset == NAVDATA_IMAGE_NO_STRING || offset < string_table_size;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+bool NavdataImage::checkRecords() const
+{
+    MYASSERT(m_header != 0);
+    quint32 string_size = sectionCount(NavdataImageHeader::SECTION_STRINGS);
+
+    if (!isValidString(m_header->airac_cycle_title, string_size) ||
+        !isValidString(m_header->airac_cycle_dates, string_size)) return false;
+
+    const NavdataImageIntersection* intersections = intersectionRecords();
+    for(uint index = 0; index < intersectionCount(); ++index)
+        if (!isValidString(intersections[index].id, string_size) ||
+            !isValidString(intersections[index].country_code, string_size)) return false;
+
+    const NavdataImageNavaid* navaids = navaidRecords();
+    for(uint index = 0; index < navaidCount(); ++index)
+        if (!isValidString(navaids[index].id, string_size) ||
+            !isValidString(navaids[index].name, string_size) ||
+            !isValidString(navaids[index].country_code, string_size)) return false;
+
+    quint32 runway_count = sectionCount(NavdataImageHeader::SECTION_RUNWAYS);
+    const NavdataImageAirport* airports = airportRecords();
+    for(uint index = 0; index < airportCount(); ++index)
+    {
+        const NavdataImageAirport& airport = airports[index];
+        if (!isValidString(airport.id, string_size) || !isValidString(airport.name, string_size) ||
+            airport.first_runway > runway_count || airport.runway_count > runway_count - airport.first_runway)
+            return false;
+    }
+
+    const NavdataImageRunway* runways = runwayRecords();
+    for(uint index = 0; index < runway_count; ++index)
+        if (!isValidString(runways[index].id, string_size)) return false;
+
+    quint32 airway_point_count = sectionCount(NavdataImageHeader::SECTION_AIRWAY_POINTS);
+    const NavdataImageAirway* airways = airwayRecords();
+    for(uint index = 0; index < airwayCount(); ++index)
+    {
+        const NavdataImageAirway& airway = airways[index];
+        if (!isValidString(airway.id, string_size) ||
+            airway.first_point > airway_point_count || airway.point_count > airway_point_count - airway.first_point)
+            return false;
+    }
+
+    const NavdataImageAirwayPoint* airway_points = airwayPointRecords();
+    for(uint index = 0; index < airway_point_count; ++index)
+        if (!isValidString(airway_points[index].id, string_size)) return false;
+
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+NavdataIdentIndex::RecordType NavdataImage::identIndexType(const NavdataImageNavaid& record)
+{
+    switch(record.type)
+    {
+        case(NavdataImageNavaid::TYPE_VOR): return NavdataIdentIndex::TYPE_VOR;
+        case(NavdataImageNavaid::TYPE_ILS): return NavdataIdentIndex::TYPE_ILS;
+        default: return NavdataIdentIndex::TYPE_NDB;
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void NavdataImage::buildIdentIndexes()
+{
+    const NavdataImageIntersection* intersections = intersectionRecords();
+    for(uint index = 0; index < intersectionCount(); ++index)
+        m_intersection_index.insert(string(intersections[index].id), index, NavdataIdentIndex::TYPE_INTERSECTION,
+                                    string(intersections[index].country_code));
+    m_intersection_index.finalize();
+
+    const NavdataImageNavaid* navaids = navaidRecords();
+    for(uint index = 0; index < navaidCount(); ++index)
+        m_navaid_index.insert(string(navaids[index].id), index, identIndexType(navaids[index]),
+                              string(navaids[index].country_code));
+    m_navaid_index.finalize();
+
+    const NavdataImageAirport* airports = airportRecords();
+    for(uint index = 0; index < airportCount(); ++index)
+        m_airport_index.insert(string(airports[index].id), index, NavdataIdentIndex::TYPE_AIRPORT);
+    m_airport_index.finalize();
+
+    const NavdataImageAirway* airways = airwayRecords();
+    for(uint index = 0; index < airwayCount(); ++index)
+        m_airway_index.insert(string(airways[index].id), index, NavdataIdentIndex::TYPE_AIRWAY);
+    m_airway_index.finalize();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+bool NavdataImage::matchesSourceFile(NavdataImageHeader::SourceFile source, const QFileInfo& file_info) const
+{
+    if (m_header == 0) return false;
+    MYASSERT(source < NavdataImageHeader::SOURCE_COUNT);
+    return m_header->source_files[source].size == (quint32)file_info.size() &&
+        m_header->source_files[source].modified == file_info.lastModified().toTime_t();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+QString NavdataImage::airacCycleTitle() const
+{
+    if (m_header == 0) return QString::null;
+    return QString::fromLatin1(string(m_header->airac_cycle_title));
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+QString NavdataImage::airacCycleDates() const
+{
+    if (m_header == 0) return QString::null;
+    return QString::fromLatin1(string(m_header->airac_cycle_dates));
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+Intersection* NavdataImage::createIntersection(const NavdataImageIntersection& record) const
+{
+    QString id = QString::fromLatin1(string(record.id));
+    Intersection* intersection = new Intersection(id, id, toDegrees(record.lat), toDegrees(record.lon),
+                                                  QString::fromLatin1(string(record.country_code)));
+    MYASSERT(intersection != 0);
+    return intersection;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+Waypoint* NavdataImage::createNavaid(const NavdataImageNavaid& record) const
+{
+    Waypoint* navaid = 0;
+
+    switch(record.type)
+    {
+        case(NavdataImageNavaid::TYPE_VOR):
+            navaid = new Vor(QString::fromLatin1(string(record.id)), QString::fromLatin1(string(record.name)),
+                             toDegrees(record.lat), toDegrees(record.lon),
+                             record.freq, record.has_dme, record.range_nm, record.elevation_ft,
+                             QString::fromLatin1(string(record.country_code)));
+            break;
+        case(NavdataImageNavaid::TYPE_ILS):
+            navaid = new Ils(QString::fromLatin1(string(record.id)), QString::fromLatin1(string(record.name)),
+                             toDegrees(record.lat), toDegrees(record.lon),
+                             record.freq, record.has_dme, record.range_nm, record.elevation_ft,
+                             QString::fromLatin1(string(record.country_code)), record.course);
+            break;
+        default:
+            navaid = new Ndb(QString::fromLatin1(string(record.id)), QString::fromLatin1(string(record.name)),
+                             toDegrees(record.lat), toDegrees(record.lon),
+                             record.freq, record.range_nm, record.elevation_ft,
+                             QString::fromLatin1(string(record.country_code)));
+            break;
+    }
+
+    MYASSERT(navaid != 0);
+    return navaid;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+Airport* NavdataImage::createAirport(const NavdataImageAirport& record) const
+{
+    Airport* airport = new Airport(QString::fromLatin1(string(record.id)), QString::fromLatin1(string(record.name)),
+                                   toDegrees(record.lat), toDegrees(record.lon), record.elevation_ft);
+    MYASSERT(airport != 0);
+
+    const NavdataImageRunway* runways = runwayRecords();
+    MYASSERT(record.first_runway + record.runway_count <= sectionCount(NavdataImageHeader::SECTION_RUNWAYS));
+
+    for(uint index = record.first_runway; index < record.first_runway + record.runway_count; ++index)
+    {
+        const NavdataImageRunway& rwy = runways[index];
+        airport->addRunway(Runway(QString::fromLatin1(string(rwy.id)),
+                                  toDegrees(rwy.lat), toDegrees(rwy.lon),
+                                  rwy.hdg, rwy.length_m, rwy.has_ils, rwy.ils_freq, rwy.ils_hdg,
+                                  rwy.threshold_elevation_ft, rwy.gs_angle, rwy.threshold_overflying_height_ft));
+    }
+
+    return airport;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+Airway* NavdataImage::createAirway(const NavdataImageAirway& record) const
+{
+    Airway* airway = new Airway(QString::fromLatin1(string(record.id)));
+    MYASSERT(airway != 0);
+
+    const NavdataImageAirwayPoint* points = airwayPointRecords();
+    MYASSERT(record.first_point + record.point_count <= sectionCount(NavdataImageHeader::SECTION_AIRWAY_POINTS));
+
+    for(uint index = record.first_point; index < record.first_point + record.point_count; ++index)
+    {
+        const NavdataImageAirwayPoint& point = points[index];
+        Waypoint waypoint(QString::fromLatin1(string(point.id)), QString::null,
+                          toDegrees(point.lat), toDegrees(point.lon));
+        waypoint.setParent(airway->id());
+        airway->appendWaypoint(waypoint);
+    }
+
+    return airway;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+uint NavdataImage::getIntersections(const QString& id, WaypointPtrList& waypoints) const
+{
+    if (m_header == 0 || id.isEmpty()) return waypoints.count();
+
+    QList<qint64> record_index_list;
+    m_intersection_index.lookup(id, record_index_list);
+
+    const NavdataImageIntersection* records = intersectionRecords();
+    QList<qint64>::const_iterator iter = record_index_list.begin();
+    for(; iter != record_index_list.end(); ++iter) waypoints.append(createIntersection(records[*iter]));
+
+    return waypoints.count();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+uint NavdataImage::getNavaids(const QString& id,
+                              WaypointPtrList& waypoints,
+                              const QString& wanted_country_code,
+                              const QString& wanted_type) const
+{
+    if (m_header == 0 || id.isEmpty()) return waypoints.count();
+
+    NavdataIdentIndex::RecordType type = NavdataIdentIndex::recordType(wanted_type);
+    if (wanted_type != Waypoint::TYPE_ALL &&
+        type != NavdataIdentIndex::TYPE_VOR && type != NavdataIdentIndex::TYPE_NDB && type != NavdataIdentIndex::TYPE_ILS)
+        return waypoints.count();
+
+    QList<qint64> record_index_list;
+    m_navaid_index.lookup(id, record_index_list, type, wanted_country_code);
+
+    QByteArray country_code = wanted_country_code.toLatin1();
+    const NavdataImageNavaid* records = navaidRecords();
+
+    QList<qint64>::const_iterator iter = record_index_list.begin();
+    for(; iter != record_index_list.end(); ++iter)
+    {
+        const NavdataImageNavaid& record = records[*iter];
+
+        // the index only compares the first two characters of the country code
+        if (!country_code.isEmpty() && qstrcmp(string(record.country_code), country_code.constData()) != 0)
+            continue;
+
+        waypoints.append(createNavaid(record));
+    }
+
+    return waypoints.count();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+uint NavdataImage::getAirports(const QString& id, WaypointPtrList& airports) const
+{
+    if (m_header == 0 || id.isEmpty()) return airports.count();
+
+    QList<qint64> record_index_list;
+    m_airport_index.lookup(id, record_index_list);
+
+    const NavdataImageAirport* records = airportRecords();
+    QList<qint64>::const_iterator iter = record_index_list.begin();
+    for(; iter != record_index_list.end(); ++iter) airports.append(createAirport(records[*iter]));
+
+    return airports.count();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+uint NavdataImage::getAirways(const QString& airway_name, AirwayPtrList& airways) const
+{
+    airways.clear();
+    if (m_header == 0 || airway_name.isEmpty()) return 0;
+
+    QList<qint64> record_index_list;
+    m_airway_index.lookup(airway_name, record_index_list);
+
+    const NavdataImageAirway* records = airwayRecords();
+    QList<qint64>::const_iterator iter = record_index_list.begin();
+    for(; iter != record_index_list.end(); ++iter)
+    {
+        if (records[*iter].point_count == 0) continue;
+        airways.append(createAirway(records[*iter]));
+    }
+
+    return airways.count();
+}
+
+// End of file
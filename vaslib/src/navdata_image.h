@@ -0,0 +1,337 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2005-2006 Alexander Wemmer
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef NAVDATA_IMAGE_H
+#define NAVDATA_IMAGE_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QFileInfo>
+#include <QHash>
+#include <QList>
+#include <QString>
+
+#include "assert.h"
+#include "navdata_ident_index.h"
+#include "waypoint.h"
+#include "airway.h"
+
+class Airport;
+class Intersection;
+
+/////////////////////////////////////////////////////////////////////////////
+
+// The navdata image is a compiled, versioned copy of the AIRAC text
+// files. All records have a fixed size and consist of 32 bit fields only,
+// strings are stored as offsets into a common string table. The records
+// are read directly from the memory mapped file, the lookups by ID go
+// through the NavdataIdentIndex hash tables built by buildIdentIndexes()
+// when the image is opened.
+
+#define NAVDATA_IMAGE_MAGIC 0x4d49444e  // "NDIM"
+#define NAVDATA_IMAGE_VERSION 2
+
+//! no string, e.g. for navaids without country code
+#define NAVDATA_IMAGE_NO_STRING 0xffffffff
+
+struct NavdataImageSourceFile
+{
+    quint32 size;
+    quint32 modified;
+};
+
+struct NavdataImageSection
+{
+    quint32 offset;
+    quint32 count;
+};
+
+struct NavdataImageHeader
+{
+    enum SourceFile { SOURCE_WAYPOINTS = 0,
+                      SOURCE_AIRWAYS,
+                      SOURCE_AIRPORTS,
+                      SOURCE_NAVAIDS,
+                      SOURCE_COUNT
+    };
+
+    enum Section { SECTION_INTERSECTIONS = 0,
+                   SECTION_NAVAIDS,
+                   SECTION_AIRPORTS,
+                   SECTION_RUNWAYS,
+                   SECTION_AIRWAYS,
+                   SECTION_AIRWAY_POINTS,
+                   SECTION_STRINGS,
+                   SECTION_COUNT
+    };
+
+    quint32 magic;
+    quint32 version;
+    quint32 airac_cycle_title;
+    quint32 airac_cycle_dates;
+    NavdataImageSourceFile source_files[SOURCE_COUNT];
+    NavdataImageSection sections[SECTION_COUNT];
+};
+
+//! lat/lon values are stored in micro-degrees like in the AIRAC text files
+struct NavdataImageIntersection
+{
+    quint32 id;
+    quint32 country_code;
+    qint32 lat;
+    qint32 lon;
+};
+
+struct NavdataImageNavaid
+{
+    enum Type { TYPE_VOR = 0,
+                TYPE_NDB,
+                TYPE_ILS
+    };
+
+    quint32 id;
+    quint32 name;
+    quint32 country_code;
+    qint32 lat;
+    qint32 lon;
+    qint32 freq;
+    qint32 range_nm;
+    qint32 elevation_ft;
+    quint32 type;
+    quint32 has_dme;
+    //! localizer course of ILSs, 0 for all other types
+    qint32 course;
+};
+
+struct NavdataImageAirport
+{
+    quint32 id;
+    quint32 name;
+    qint32 lat;
+    qint32 lon;
+    qint32 elevation_ft;
+    quint32 first_runway;
+    quint32 runway_count;
+};
+
+struct NavdataImageRunway
+{
+    quint32 id;
+    qint32 lat;
+    qint32 lon;
+    qint32 hdg;
+    qint32 length_m;
+    qint32 has_ils;
+    qint32 ils_freq;
+    qint32 ils_hdg;
+    qint32 threshold_elevation_ft;
+    qint32 gs_angle;
+    qint32 threshold_overflying_height_ft;
+};
+
+struct NavdataImageAirway
+{
+    quint32 id;
+    quint32 first_point;
+    quint32 point_count;
+};
+
+struct NavdataImageAirwayPoint
+{
+    quint32 id;
+    qint32 lat;
+    qint32 lon;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+
+//! Collects parsed navdata and writes the binary navdata image.
+class NavdataImageWriter
+{
+public:
+
+    NavdataImageWriter();
+    virtual ~NavdataImageWriter() {};
+
+    void setAiracCycle(const QString& title, const QString& dates);
+    void setSourceFile(NavdataImageHeader::SourceFile source, const QFileInfo& file_info);
+
+    void addIntersection(const Intersection& intersection);
+    //! accepts VORs, NDBs and ILSs, all other waypoints will be ignored
+    void addNavaid(const Waypoint& navaid);
+    void addAirport(const Airport& airport);
+    void addAirway(const Airway& airway);
+
+    //! returns true when successfull, false otherwise
+    bool write(const QString& filename);
+
+protected:
+
+    quint32 addString(const QString& string);
+
+    template <class RECORD> struct Entry
+    {
+        QByteArray key;
+        RECORD record;
+        //! index into the detail lists (runways, airway points)
+        int detail_index;
+        bool operator<(const Entry& other) const { return key < other.key; }
+    };
+
+    template <class RECORD> static bool writeSection(QFile& file,
+                                                     const QList< Entry<RECORD> >& entries,
+                                                     NavdataImageSection& section);
+
+    template <class RECORD> static bool writeSection(QFile& file,
+                                                     const QList<RECORD>& records,
+                                                     NavdataImageSection& section);
+
+protected:
+
+    NavdataImageHeader m_header;
+
+    QByteArray m_strings;
+    QHash<QByteArray, quint32> m_string_offset_map;
+
+    QList< Entry<NavdataImageIntersection> > m_intersections;
+    QList< Entry<NavdataImageNavaid> > m_navaids;
+    QList< Entry<NavdataImageAirport> > m_airports;
+    QList< QList<NavdataImageRunway> > m_airport_runways;
+    QList< Entry<NavdataImageAirway> > m_airways;
+    QList< QList<NavdataImageAirwayPoint> > m_airway_points;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+
+//! Memory mapped, read-only access to a binary navdata image.
+class NavdataImage
+{
+public:
+
+    NavdataImage();
+    virtual ~NavdataImage();
+
+    //! returns true when successfull, false otherwise
+    bool open(const QString& filename);
+    void close();
+
+    inline bool isOpen() const { return m_header != 0; }
+
+    //! Returns true if the image was compiled from the given source files,
+    //! false if one of them changed after the image was compiled.
+    bool matchesSourceFile(NavdataImageHeader::SourceFile source, const QFileInfo& file_info) const;
+
+    QString airacCycleTitle() const;
+    QString airacCycleDates() const;
+
+    //----- queries, the semantics match the corresponding Navdata methods
+
+    //! the given list will *not* be cleared
+    uint getIntersections(const QString& id, WaypointPtrList& waypoints) const;
+
+    //! the given list will *not* be cleared
+    uint getNavaids(const QString& id,
+                    WaypointPtrList& waypoints,
+                    const QString& wanted_country_code = QString::null,
+                    const QString& wanted_type = Waypoint::TYPE_ALL) const;
+
+    //! the given list will *not* be cleared
+    uint getAirports(const QString& id, WaypointPtrList& airports) const;
+
+    //! the given list will be cleared first
+    uint getAirways(const QString& airway_name, AirwayPtrList& airways) const;
+
+    //----- raw record access
+
+    inline uint intersectionCount() const { return sectionCount(NavdataImageHeader::SECTION_INTERSECTIONS); }
+    inline uint navaidCount() const { return sectionCount(NavdataImageHeader::SECTION_NAVAIDS); }
+    inline uint airportCount() const { return sectionCount(NavdataImageHeader::SECTION_AIRPORTS); }
+    inline uint airwayCount() const { return sectionCount(NavdataImageHeader::SECTION_AIRWAYS); }
+
+    inline const NavdataImageIntersection* intersectionRecords() const
+    { return section<NavdataImageIntersection>(NavdataImageHeader::SECTION_INTERSECTIONS); }
+    inline const NavdataImageNavaid* navaidRecords() const
+    { return section<NavdataImageNavaid>(NavdataImageHeader::SECTION_NAVAIDS); }
+    inline const NavdataImageAirport* airportRecords() const
+    { return section<NavdataImageAirport>(NavdataImageHeader::SECTION_AIRPORTS); }
+    inline const NavdataImageRunway* runwayRecords() const
+    { return section<NavdataImageRunway>(NavdataImageHeader::SECTION_RUNWAYS); }
+    inline const NavdataImageAirway* airwayRecords() const
+    { return section<NavdataImageAirway>(NavdataImageHeader::SECTION_AIRWAYS); }
+    inline const NavdataImageAirwayPoint* airwayPointRecords() const
+    { return section<NavdataImageAirwayPoint>(NavdataImageHeader::SECTION_AIRWAY_POINTS); }
+
+    //! returns the zero terminated string at the given string table offset
+    inline const char* string(quint32 offset) const
+    { return (offset == NAVDATA_IMAGE_NO_STRING) ? "" : m_strings + offset; }
+
+    //----- record to object conversion
+
+    //! ATTENTION: the caller is responsible to delete the returned objects
+    Intersection* createIntersection(const NavdataImageIntersection& record) const;
+    Waypoint* createNavaid(const NavdataImageNavaid& record) const;
+    Airport* createAirport(const NavdataImageAirport& record) const;
+    Airway* createAirway(const NavdataImageAirway& record) const;
+
+protected:
+
+    inline uint sectionCount(NavdataImageHeader::Section section) const
+    { return (m_header == 0) ? 0 : m_header->sections[section].count; }
+
+    template <class RECORD> inline const RECORD* section(NavdataImageHeader::Section index) const
+    {
+        MYASSERT(m_header != 0);
+        return (const RECORD*)(m_data + m_header->sections[index].offset);
+    }
+
+    static inline double toDegrees(qint32 value) { return value / 1000000.0; }
+
+    //! Returns true when all string offsets of the records are inside the
+    //! string table and all detail ranges (runways, airway points) are
+    //! inside their sections.
+    bool checkRecords() const;
+
+    //! builds the ident hash indexes over the record tables
+    void buildIdentIndexes();
+
+    static NavdataIdentIndex::RecordType identIndexType(const NavdataImageNavaid& record);
+
+protected:
+
+    QFile m_file;
+    const uchar* m_data;
+    qint64 m_size;
+    const NavdataImageHeader* m_header;
+    const char* m_strings;
+
+    //! ident to record index maps
+    NavdataIdentIndex m_intersection_index;
+    NavdataIdentIndex m_navaid_index;
+    NavdataIdentIndex m_airport_index;
+    NavdataIdentIndex m_airway_index;
+
+private:
+    //! Hidden copy-constructor
+    NavdataImage(const NavdataImage&);
+    //! Hidden assignment operator
+    const NavdataImage& operator = (const NavdataImage&);
+};
+
+#endif
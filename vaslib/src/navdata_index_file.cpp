@@ -0,0 +1,185 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2005-2006 Alexander Wemmer
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <QCryptographicHash>
+#include <QDataStream>
+#include <QDateTime>
+#include <QFileInfo>
+
+#include "logger.h"
+
+#include "navdata_index_file.h"
+
+/////////////////////////////////////////////////////////////////////////////
+
+NavdataIndexFile::NavdataIndexFile() : m_modified(false)
+{
+    for(int source = 0; source < SOURCE_COUNT; ++source)
+    {
+        m_sections[source].size = -1;
+        m_sections[source].modified = 0;
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+bool NavdataIndexFile::load(const QString& filename, const QString& airac_cycle_title, const QString& airac_cycle_dates)
+{
+    m_modified = false;
+
+    QFile file(filename);
+    if (!file.open(QIODevice::ReadOnly)) return false;
+
+    QDataStream in(&file);
+    in.setVersion(QDataStream::Qt_4_0);
+
+    quint32 magic = 0, version = 0;
+    in >> magic >> version;
+    if (magic != NAVDATA_INDEX_FILE_MAGIC || version != NAVDATA_INDEX_FILE_VERSION)
+    {
+        Logger::log(QString("NavdataIndexFile:load: wrong format of %1").arg(filename));
+        return false;
+    }
+
+    QString title, dates;
+    in >> title >> dates;
+    if (title != airac_cycle_title || dates != airac_cycle_dates)
+    {
+        Logger::log(QString("NavdataIndexFile:load: %1 belongs to another AIRAC cycle").arg(filename));
+        return false;
+    }
+
+    Section sections[SOURCE_COUNT];
+    for(int source = 0; source < SOURCE_COUNT; ++source)
+    {
+        Section& section = sections[source];
+        in >> section.size >> section.modified >> section.hash >> section.payload;
+    }
+
+    if (in.status() != QDataStream::Ok)
+    {
+        Logger::log(QString("NavdataIndexFile:load: %1 is truncated").arg(filename));
+        return false;
+    }
+
+    for(int source = 0; source < SOURCE_COUNT; ++source) m_sections[source] = sections[source];
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+bool NavdataIndexFile::save(const QString& filename, const QString& airac_cycle_title, const QString& airac_cycle_dates)
+{
+    // write to a temporary file first, so a crash never leaves a
+    // half written index behind
+    QString temp_filename = filename + ".tmp";
+
+    QFile file(temp_filename);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate))
+    {
+        Logger::log(QString("NavdataIndexFile:save: could not open %1").arg(temp_filename));
+        return false;
+    }
+
+    QDataStream out(&file);
+    out.setVersion(QDataStream::Qt_4_0);
+
+    out << (quint32)NAVDATA_INDEX_FILE_MAGIC << (quint32)NAVDATA_INDEX_FILE_VERSION;
+    out << airac_cycle_title << airac_cycle_dates;
+
+    for(int source = 0; source < SOURCE_COUNT; ++source)
+    {
+        const Section& section = m_sections[source];
+        out << section.size << section.modified << section.hash << section.payload;
+    }
+
+    file.close();
+    if (out.status() != QDataStream::Ok || file.error() != QFile::NoError)
+    {
+        Logger::log(QString("NavdataIndexFile:save: could not write %1").arg(temp_filename));
+        QFile::remove(temp_filename);
+        return false;
+    }
+
+    QFile::remove(filename);
+    if (!QFile::rename(temp_filename, filename))
+    {
+        Logger::log(QString("NavdataIndexFile:save: could not rename %1").arg(temp_filename));
+        return false;
+    }
+
+    m_modified = false;
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+bool NavdataIndexFile::isValid(Source source, QFile& file)
+{
+    MYASSERT(source < SOURCE_COUNT);
+    Section& section = m_sections[source];
+
+    if (section.payload.isEmpty() || section.size != file.size()) return false;
+
+    uint modified = modificationTime(file);
+    if (section.modified == modified) return true;
+
+    // the file was touched, but maybe not changed
+    if (hashFile(file) != section.hash) return false;
+
+    section.modified = modified;
+    m_modified = true;
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void NavdataIndexFile::setSection(Source source, const QFile& file, const QByteArray& hash, const QByteArray& payload)
+{
+    MYASSERT(source < SOURCE_COUNT);
+    Section& section = m_sections[source];
+
+    section.size = file.size();
+    section.modified = modificationTime(file);
+    section.hash = hash;
+    section.payload = payload;
+    m_modified = true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+QByteArray NavdataIndexFile::hashFile(QFile& file)
+{
+    QCryptographicHash hash(QCryptographicHash::Md5);
+
+    MYASSERT(file.reset());
+    while(!file.atEnd()) hash.addData(file.readLine());
+
+    return hash.result();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+uint NavdataIndexFile::modificationTime(const QFile& file)
+{
+    return QFileInfo(file).lastModified().toTime_t();
+}
+
+// End of file
@@ -0,0 +1,102 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2005-2006 Alexander Wemmer
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef NAVDATA_INDEX_FILE_H
+#define NAVDATA_INDEX_FILE_H
+
+#include <QByteArray>
+#include <QFile>
+#include <QString>
+
+#include "assert.h"
+
+/////////////////////////////////////////////////////////////////////////////
+
+#define NAVDATA_INDEX_FILE_MAGIC 0x5844494e  // "NIDX"
+#define NAVDATA_INDEX_FILE_VERSION 3
+
+//! Persistent binary copy of the indexes built over the AIRAC text files.
+//! Every text file has its own section, which stays valid as long as the
+//! size and modification time of the file match. When only the
+//! modification time changed, the content hash decides. So only the
+//! sections of changed files have to be rebuilt at startup.
+class NavdataIndexFile
+{
+public:
+
+    enum Source { SOURCE_WAYPOINTS = 0,
+                  SOURCE_AIRWAYS,
+                  SOURCE_AIRPORTS,
+                  SOURCE_NAVAIDS,
+                  SOURCE_COUNT
+    };
+
+    NavdataIndexFile();
+    virtual ~NavdataIndexFile() {};
+
+    //! Reads the given index file, all sections are dropped when the file
+    //! belongs to another AIRAC cycle. Returns true when successfull.
+    bool load(const QString& filename, const QString& airac_cycle_title, const QString& airac_cycle_dates);
+
+    //! returns true when successfull, false otherwise
+    bool save(const QString& filename, const QString& airac_cycle_title, const QString& airac_cycle_dates);
+
+    //! Returns true if the section of the given source is up to date with
+    //! the given (open) text file. The file position is undefined afterwards.
+    bool isValid(Source source, QFile& file);
+
+    inline const QByteArray& payload(Source source) const
+    { MYASSERT(source < SOURCE_COUNT); return m_sections[source].payload; }
+
+    //! replaces the section of the given source
+    void setSection(Source source, const QFile& file, const QByteArray& hash, const QByteArray& payload);
+
+    //! returns true if a section was changed after the last load() or save()
+    inline bool isModified() const { return m_modified; }
+
+    //! Reads the given (open) text file line by line and returns the MD5
+    //! hash of its content. The indexing passes hash the lines the same way.
+    static QByteArray hashFile(QFile& file);
+
+protected:
+
+    struct Section
+    {
+        qint64 size;
+        uint modified;
+        QByteArray hash;
+        QByteArray payload;
+    };
+
+    static uint modificationTime(const QFile& file);
+
+protected:
+
+    Section m_sections[SOURCE_COUNT];
+    bool m_modified;
+
+private:
+    //! Hidden copy-constructor
+    NavdataIndexFile(const NavdataIndexFile&);
+    //! Hidden assignment operator
+    const NavdataIndexFile& operator = (const NavdataIndexFile&);
+};
+
+#endif
@@ -0,0 +1,183 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2005-2006 Alexander Wemmer
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <QMetaType>
+#include <QMutexLocker>
+#include <QRunnable>
+
+#include "logger.h"
+
+#include "navdata_query_service.h"
+
+/////////////////////////////////////////////////////////////////////////////
+
+//! the query threads do not need more, the queries mostly wait for the disk
+#define MAX_QUERY_THREAD_COUNT 2
+
+/////////////////////////////////////////////////////////////////////////////
+
+NavdataQuery::NavdataQuery(Type type, const QString& text, QObject* parent) :
+    QObject(parent), m_type(type), m_text(text), m_finished(false), m_ref_count(0)
+{
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+bool NavdataQuery::isFinished() const
+{
+    QMutexLocker locker(&m_finished_mutex);
+    return m_finished;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void NavdataQuery::waitForFinished() const
+{
+    QMutexLocker locker(&m_finished_mutex);
+    while(!m_finished) m_finished_condition.wait(&m_finished_mutex);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+//! Runs one query in the thread pool of the navdata query service.
+class NavdataQueryTask : public QRunnable
+{
+public:
+
+    NavdataQueryTask(NavdataQueryService& service, NavdataQuery* query) : m_service(service), m_query(query)
+    {
+        MYASSERT(m_query != 0);
+    }
+
+    virtual ~NavdataQueryTask() {};
+
+    virtual void run() { m_service.run(m_query); }
+
+protected:
+
+    NavdataQueryService& m_service;
+    NavdataQuery* m_query;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+
+NavdataQueryService::NavdataQueryService(const Navdata& navdata, const QRegExp& lat_lon_regexp) :
+    m_navdata(navdata), m_lat_lon_regexp(lat_lon_regexp), m_started_query_count(0)
+{
+    // the queries are passed by queued connections
+    qRegisterMetaType<NavdataQuery*>("NavdataQuery*");
+
+    m_thread_pool.setMaxThreadCount(MAX_QUERY_THREAD_COUNT);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+NavdataQueryService::~NavdataQueryService()
+{
+    // the remaining queries are deleted as children afterwards
+    m_thread_pool.waitForDone();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+NavdataQuery* NavdataQueryService::queryICAORoute(const QString& route)
+{
+    return query(NavdataQuery::TYPE_ICAO_ROUTE, route.trimmed().toUpper().simplified());
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+NavdataQuery* NavdataQueryService::query(NavdataQuery::Type type, const QString& text)
+{
+    QString key = NavdataQuery::key(type, text);
+
+    QMutexLocker locker(&m_mutex);
+
+    // coalesce with an identical pending query
+
+    NavdataQuery* query = m_pending_query_map.value(key);
+    if (query != 0)
+    {
+        ++query->m_ref_count;
+        return query;
+    }
+
+    query = new NavdataQuery(type, text, this);
+    MYASSERT(query != 0);
+
+    // one reference for the caller and one for the task
+    query->m_ref_count = 2;
+    m_pending_query_map.insert(key, query);
+    ++m_started_query_count;
+
+    m_thread_pool.start(new NavdataQueryTask(*this, query));
+    return query;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void NavdataQueryService::release(NavdataQuery* query)
+{
+    if (query == 0) return;
+
+    QMutexLocker locker(&m_mutex);
+    MYASSERT(query->m_ref_count > 0);
+    if (--query->m_ref_count > 0) return;
+
+    // the task holds a reference until the query is finished, so the
+    // query is not pending anymore
+    query->deleteLater();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void NavdataQueryService::run(NavdataQuery* query)
+{
+    MYASSERT(query != 0);
+
+    switch(query->m_type)
+    {
+        case(NavdataQuery::TYPE_ICAO_ROUTE): {
+            m_navdata.resolveICAORoute(query->m_text, m_lat_lon_regexp, query->m_route);
+            break;
+        }
+        default: {
+            MYASSERT(false);
+            break;
+        }
+    }
+
+    // later identical queries start a new query
+    m_mutex.lock();
+    m_pending_query_map.remove(NavdataQuery::key(query->m_type, query->m_text));
+    m_mutex.unlock();
+
+    query->m_finished_mutex.lock();
+    query->m_finished = true;
+    query->m_finished_condition.wakeAll();
+    query->m_finished_mutex.unlock();
+
+    emit query->signalFinished(query);
+
+    // drop the reference of the task
+    release(query);
+}
+
+// End of file
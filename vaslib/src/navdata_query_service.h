@@ -0,0 +1,156 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2005-2006 Alexander Wemmer
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef NAVDATA_QUERY_SERVICE_H
+#define NAVDATA_QUERY_SERVICE_H
+
+#include <QHash>
+#include <QMutex>
+#include <QObject>
+#include <QRegExp>
+#include <QString>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+#include "assert.h"
+#include "navdata.h"
+
+class NavdataQueryTask;
+
+/////////////////////////////////////////////////////////////////////////////
+
+//! A query of the navdata query service, acts as the future of the result.
+//! The result is valid when the query is finished. The signalFinished()
+//! signal is emitted from the query thread, so receivers living in the
+//! GUI thread are called via a queued connection.
+//! ATTENTION: Queries are owned by the service, release them with
+//! NavdataQueryService::release() when done. Identical queries may return
+//! the same query object, so it must not be changed by the receivers.
+class NavdataQuery : public QObject
+{
+    Q_OBJECT
+
+public:
+
+    enum Type { TYPE_ICAO_ROUTE = 0
+    };
+
+    inline Type type() const { return m_type; }
+    inline const QString& text() const { return m_text; }
+
+    bool isFinished() const;
+
+    //! blocks until the query is finished
+    void waitForFinished() const;
+
+    //! the resolved route of a TYPE_ICAO_ROUTE query
+    inline const NavdataResolvedRoute& route() const { MYASSERT(isFinished()); return m_route; }
+
+signals:
+
+    void signalFinished(NavdataQuery* query);
+
+protected:
+
+    friend class NavdataQueryService;
+    friend class NavdataQueryTask;
+
+    NavdataQuery(Type type, const QString& text, QObject* parent);
+    virtual ~NavdataQuery() {};
+
+    //! returns the coalescing key of a query
+    static inline QString key(Type type, const QString& text) { return QString("%1:%2").arg(type).arg(text); }
+
+protected:
+
+    Type m_type;
+    QString m_text;
+
+    //! guarded by the finished mutex
+    bool m_finished;
+    //! guarded by the mutex of the service, the running task holds a reference too
+    int m_ref_count;
+
+    NavdataResolvedRoute m_route;
+
+    mutable QMutex m_finished_mutex;
+    mutable QWaitCondition m_finished_condition;
+
+private:
+    //! Hidden copy-constructor
+    NavdataQuery(const NavdataQuery&);
+    //! Hidden assignment operator
+    const NavdataQuery& operator = (const NavdataQuery&);
+};
+
+/////////////////////////////////////////////////////////////////////////////
+
+//! Runs navdata queries in a thread pool, so the GUI thread is not blocked
+//! by reading the AIRAC files. Identical queries which are pending at the
+//! same time (e.g. from both CDUs) are coalesced and answered only once.
+//! ATTENTION: The service must be deleted before the navdata.
+class NavdataQueryService : public QObject
+{
+    Q_OBJECT
+
+public:
+
+    NavdataQueryService(const Navdata& navdata, const QRegExp& lat_lon_regexp);
+    virtual ~NavdataQueryService();
+
+    //! Resolves the given ICAO route string like Navdata::resolveICAORoute().
+    NavdataQuery* queryICAORoute(const QString& route);
+
+    //! Releases the given query, the receivers of the query should be
+    //! disconnected before.
+    void release(NavdataQuery* query);
+
+    //! returns the number of queries started so far, coalesced ones not counted
+    inline uint startedQueryCount() const { return m_started_query_count; }
+
+protected:
+
+    friend class NavdataQueryTask;
+
+    NavdataQuery* query(NavdataQuery::Type type, const QString& text);
+
+    //! runs the given query, called from the query threads
+    void run(NavdataQuery* query);
+
+protected:
+
+    const Navdata& m_navdata;
+    QRegExp m_lat_lon_regexp;
+
+    QThreadPool m_thread_pool;
+
+    QMutex m_mutex;
+    //! pending queries by key
+    QHash<QString, NavdataQuery*> m_pending_query_map;
+    uint m_started_query_count;
+
+private:
+    //! Hidden copy-constructor
+    NavdataQueryService(const NavdataQueryService&);
+    //! Hidden assignment operator
+    const NavdataQueryService& operator = (const NavdataQueryService&);
+};
+
+#endif
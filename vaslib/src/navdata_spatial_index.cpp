@@ -0,0 +1,186 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2005-2006 Alexander Wemmer
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <QtAlgorithms>
+
+#include "navcalc.h"
+
+#include "navdata_spatial_index.h"
+
+//! half of the earth circumference, no search radius can be bigger
+#define MAX_RADIUS_NM (180.0 * 60.0)
+//! initial search radius for nearest queries
+#define NEAREST_START_RADIUS_NM 50.0
+
+/////////////////////////////////////////////////////////////////////////////
+
+NavdataSpatialIndex::NavdataSpatialIndex()
+{
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void NavdataSpatialIndex::clear()
+{
+    m_pending_points.clear();
+    m_points.clear();
+    m_cell_start.clear();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void NavdataSpatialIndex::insert(double lat, double lon, uint index)
+{
+    double rad_lat = Navcalc::toRad(lat);
+    double rad_lon = Navcalc::toRad(lon);
+
+    Point point;
+    point.x = cos(rad_lat) * cos(rad_lon);
+    point.y = cos(rad_lat) * sin(rad_lon);
+    point.z = sin(rad_lat);
+    point.index = index;
+    point.cell = latCell(lat) * LON_CELLS + lonCell(lon);
+    m_pending_points.append(point);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void NavdataSpatialIndex::finalize()
+{
+    qStableSort(m_pending_points);
+
+    m_points.clear();
+    m_points.reserve(m_pending_points.count());
+    m_cell_start.fill(0, CELL_COUNT + 1);
+
+    QList<Point>::const_iterator iter = m_pending_points.begin();
+    for(; iter != m_pending_points.end(); ++iter)
+    {
+        m_points.append(*iter);
+        ++m_cell_start[iter->cell + 1];
+    }
+
+    for(int cell = 0; cell < CELL_COUNT; ++cell) m_cell_start[cell + 1] += m_cell_start[cell];
+
+    m_pending_points.clear();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void NavdataSpatialIndex::scanCells(int first_row, int last_row, int first_column, int column_count,
+                                    double x, double y, double z, double cos_radius, HitList& hits) const
+{
+    for(int row = first_row; row <= last_row; ++row)
+    {
+        for(int column_offset = 0; column_offset < column_count; ++column_offset)
+        {
+            int cell = row * LON_CELLS + (first_column + column_offset) % LON_CELLS;
+
+            for(uint index = m_cell_start[cell]; index < m_cell_start[cell + 1]; ++index)
+            {
+                const Point& point = m_points[index];
+
+                double dot = point.x * x + point.y * y + point.z * z;
+                if (dot < cos_radius) continue;
+                if (dot > 1.0) dot = 1.0;
+
+                Hit hit;
+                hit.index = point.index;
+                hit.distance_nm = Navcalc::toDeg(acos(dot)) * 60.0;
+                hits.append(hit);
+            }
+        }
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+uint NavdataSpatialIndex::getWithinRadius(double lat, double lon, double radius_nm, HitList& hits) const
+{
+    if (m_points.isEmpty() || radius_nm < 0.0) return 0;
+    if (radius_nm > MAX_RADIUS_NM) radius_nm = MAX_RADIUS_NM;
+
+    double radius_deg = radius_nm / 60.0;
+    double rad_radius = Navcalc::toRad(radius_deg);
+    double rad_lat = Navcalc::toRad(lat);
+    double rad_lon = Navcalc::toRad(lon);
+
+    double x = cos(rad_lat) * cos(rad_lon);
+    double y = cos(rad_lat) * sin(rad_lon);
+    double z = sin(rad_lat);
+
+    // latitude band of the search circle
+
+    double min_lat = lat - radius_deg;
+    double max_lat = lat + radius_deg;
+    int first_row = latCell(min_lat);
+    int last_row = latCell(max_lat);
+
+    // longitude span of the search circle, all longitudes when it
+    // contains a pole
+
+    int first_column = 0;
+    int column_count = LON_CELLS;
+
+    if (min_lat > -90.0 && max_lat < 90.0)
+    {
+        double sin_ratio = sin(rad_radius) / cos(rad_lat);
+        if (sin_ratio < 1.0)
+        {
+            double delta_lon = Navcalc::toDeg(asin(sin_ratio));
+            first_column = lonCell(lon - delta_lon);
+            column_count = (int)floor(lon + delta_lon + 180.0) - (int)floor(lon - delta_lon + 180.0) + 1;
+            if (column_count > LON_CELLS) column_count = LON_CELLS;
+        }
+    }
+
+    int first_hit = hits.count();
+    scanCells(first_row, last_row, first_column, column_count, x, y, z, cos(rad_radius), hits);
+
+    qSort(hits.begin() + first_hit, hits.end());
+    return hits.count() - first_hit;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+uint NavdataSpatialIndex::getNearest(double lat, double lon, uint max_count, HitList& hits) const
+{
+    if (m_points.isEmpty() || max_count == 0) return 0;
+
+    // widen the search circle until it contains enough points, all points
+    // within the circle are found, so the nearest ones are among them
+
+    HitList candidates;
+    double radius_nm = NEAREST_START_RADIUS_NM;
+
+    while(true)
+    {
+        candidates.clear();
+        getWithinRadius(lat, lon, radius_nm, candidates);
+        if ((uint)candidates.count() >= max_count || radius_nm >= MAX_RADIUS_NM) break;
+        radius_nm *= 4.0;
+    }
+
+    uint count = qMin((uint)candidates.count(), max_count);
+    for(uint index = 0; index < count; ++index) hits.append(candidates[index]);
+    return count;
+}
+
+// End of file
@@ -0,0 +1,120 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2005-2006 Alexander Wemmer
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef NAVDATA_SPATIAL_INDEX_H
+#define NAVDATA_SPATIAL_INDEX_H
+
+#include <math.h>
+
+#include <QList>
+#include <QVector>
+
+#include "assert.h"
+
+/////////////////////////////////////////////////////////////////////////////
+
+//! Spatial index over points on the earth with radius and k-nearest
+//! queries. The points are bucketed into 1x1 degree cells with integer keys,
+//! the cells are stored packed in key order. Distances are great circle
+//! distances, searches wrap around the antimeridian and cover all
+//! longitudes when the search circle contains a pole.
+//! Points are collected with insert() and the index is built by finalize().
+class NavdataSpatialIndex
+{
+public:
+
+    //! Lightweight query result, "index" is the value passed to insert(),
+    //! e.g. the index of the point in a list owned by the caller.
+    struct Hit
+    {
+        uint index;
+        double distance_nm;
+        bool operator<(const Hit& other) const { return distance_nm < other.distance_nm; }
+    };
+
+    typedef QVector<Hit> HitList;
+
+    NavdataSpatialIndex();
+    virtual ~NavdataSpatialIndex() {};
+
+    void clear();
+
+    //! adds a point, call finalize() when all points have been added
+    void insert(double lat, double lon, uint index);
+
+    //! builds the cell index from the inserted points
+    void finalize();
+
+    inline uint count() const { return m_points.count(); }
+
+    //! Appends all points within the given distance to "hits", sorted by
+    //! distance, and returns the number of appended hits.
+    uint getWithinRadius(double lat, double lon, double radius_nm, HitList& hits) const;
+
+    //! Appends the "max_count" nearest points to "hits", sorted by distance,
+    //! and returns the number of appended hits.
+    uint getNearest(double lat, double lon, uint max_count, HitList& hits) const;
+
+protected:
+
+    enum { LAT_CELLS = 180,
+           LON_CELLS = 360,
+           CELL_COUNT = LAT_CELLS * LON_CELLS
+    };
+
+    struct Point
+    {
+        //! unit vector of the position
+        double x;
+        double y;
+        double z;
+        uint index;
+        uint cell;
+        bool operator<(const Point& other) const { return cell < other.cell; }
+    };
+
+    static inline int latCell(double lat)
+    {
+        int cell = (int)floor(lat + 90.0);
+        return (cell < 0) ? 0 : ((cell >= LAT_CELLS) ? LAT_CELLS - 1 : cell);
+    }
+
+    static inline int lonCell(double lon)
+    {
+        int cell = ((int)floor(lon + 180.0)) % LON_CELLS;
+        return (cell < 0) ? cell + LON_CELLS : cell;
+    }
+
+    //! appends the hits of all cells of the given row and column range,
+    //! "cos_radius" is the cosine of the angular search radius
+    void scanCells(int first_row, int last_row, int first_column, int column_count,
+                   double x, double y, double z, double cos_radius, HitList& hits) const;
+
+protected:
+
+    QList<Point> m_pending_points;
+
+    //! points sorted by cell
+    QVector<Point> m_points;
+    //! index of the first point of every cell, CELL_COUNT+1 entries
+    QVector<uint> m_cell_start;
+};
+
+#endif
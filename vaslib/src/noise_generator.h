@@ -25,9 +25,9 @@
 #ifndef __NOISE_GENERATOR_H__
 #define __NOISE_GENERATOR_H__
 
-#include <QTime>
 
 #include "smoothing.h"
+#include "sim_clock.h"
 
 /////////////////////////////////////////////////////////////////////////////
 
@@ -65,7 +65,7 @@ public:
 
 protected:
     
-    QTime m_last_noise_update_timer;
+    SimTimer m_last_noise_update_timer;
     uint m_max_noise_update_interval_ms;
     double m_max_noise_inc_per_update;
     double m_max_noise;
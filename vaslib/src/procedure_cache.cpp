@@ -0,0 +1,199 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2005-2006 Alexander Wemmer
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#include <QDataStream>
+#include <QMutexLocker>
+
+#include "logger.h"
+#include "waypoint_serialization.h"
+#include "procedure_serialization.h"
+
+#include "procedure_cache.h"
+
+/////////////////////////////////////////////////////////////////////////////
+
+ProcedureCache::ProcedureCache(uint max_size_bytes) : m_size(0), m_max_size(max_size_bytes)
+{
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void ProcedureCache::clear()
+{
+    QMutexLocker locker(&m_mutex);
+    m_entry_map.clear();
+    m_lru_list.clear();
+    m_size = 0;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void ProcedureCache::setMaxSize(uint max_size_bytes)
+{
+    QMutexLocker locker(&m_mutex);
+    m_max_size = max_size_bytes;
+    evict();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+uint ProcedureCache::maxSize() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_max_size;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+uint ProcedureCache::size() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_size;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+uint ProcedureCache::count() const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_entry_map.count();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+bool ProcedureCache::contains(const QString& airport) const
+{
+    QMutexLocker locker(&m_mutex);
+    return m_entry_map.contains(airport.toUpper());
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void ProcedureCache::insert(const QString& airport,
+                            const ProcedurePtrList& sids,
+                            const ProcedurePtrList& stars,
+                            const ProcedurePtrList& approaches)
+{
+    Entry entry;
+    entry.sids = serialize(sids);
+    entry.stars = serialize(stars);
+    entry.approaches = serialize(approaches);
+
+    QString key = airport.toUpper();
+    QMutexLocker locker(&m_mutex);
+
+    if (m_entry_map.contains(key))
+    {
+        m_size -= m_entry_map[key].size();
+        m_lru_list.removeAll(key);
+    }
+
+    m_entry_map.insert(key, entry);
+    m_lru_list.prepend(key);
+    m_size += entry.size();
+
+    evict();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+bool ProcedureCache::getProcedures(const QString& airport, const QString& type, ProcedurePtrList& procedures)
+{
+    QString key = airport.toUpper();
+    QByteArray data;
+
+    {
+        QMutexLocker locker(&m_mutex);
+
+        QHash<QString, Entry>::const_iterator iter = m_entry_map.find(key);
+        if (iter == m_entry_map.end()) return false;
+
+        if (type == Route::TYPE_SID) data = iter->sids;
+        else if (type == Route::TYPE_STAR) data = iter->stars;
+        else if (type == Route::TYPE_APPROACH) data = iter->approaches;
+
+        if (m_lru_list.first() != key)
+        {
+            m_lru_list.removeAll(key);
+            m_lru_list.prepend(key);
+        }
+    }
+
+    deserialize(data, procedures);
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void ProcedureCache::evict()
+{
+    // always keep the most recently used airport
+    while(m_size > m_max_size && m_lru_list.count() > 1)
+    {
+        QString key = m_lru_list.takeLast();
+        m_size -= m_entry_map[key].size();
+        m_entry_map.remove(key);
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+QByteArray ProcedureCache::serialize(const ProcedurePtrList& procedures)
+{
+    if (procedures.isEmpty()) return QByteArray();
+
+    QByteArray data;
+    QDataStream out(&data, QIODevice::WriteOnly);
+    out << procedures;
+    return data;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void ProcedureCache::deserialize(const QByteArray& data, ProcedurePtrList& procedures)
+{
+    if (data.isEmpty()) return;
+
+    ProcedurePtrList read_procedures;
+    QDataStream in(data);
+    in >> read_procedures;
+
+    // the transitions do not serialize the link to their procedure
+    for(int index = 0; index < read_procedures.count(); ++index)
+    {
+        Procedure* procedure = read_procedures[index];
+
+        ProcedurePtrList* transitions = 0;
+        if (procedure->asSID() != 0) transitions = &procedure->asSID()->transitions();
+        else if (procedure->asApproach() != 0) transitions = &procedure->asApproach()->transitions();
+        if (transitions == 0) continue;
+
+        for(int trans_index = 0; trans_index < transitions->count(); ++trans_index)
+        {
+            Transition* transition = (*transitions)[trans_index]->asTransition();
+            if (transition != 0) transition->setParentProcedure(procedure);
+        }
+    }
+
+    read_procedures.setAutoDelete(false);
+    procedures += read_procedures;
+}
+
+// End of file
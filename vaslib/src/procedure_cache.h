@@ -0,0 +1,106 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2005-2006 Alexander Wemmer
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+///////////////////////////////////////////////////////////////////////////////
+
+#ifndef PROCEDURE_CACHE_H
+#define PROCEDURE_CACHE_H
+
+#include <QByteArray>
+#include <QHash>
+#include <QList>
+#include <QMutex>
+#include <QString>
+
+#include "assert.h"
+#include "procedure.h"
+
+/////////////////////////////////////////////////////////////////////////////
+
+//! Size bounded LRU cache of the parsed procedures of airports. The
+//! procedures are kept serialized, which is compact and makes the memory
+//! accounting exact. When the cache grows above its maximum size, the least
+//! recently used airports are dropped. All methods are thread safe.
+class ProcedureCache
+{
+public:
+
+    ProcedureCache(uint max_size_bytes);
+    virtual ~ProcedureCache() {};
+
+    void clear();
+
+    void setMaxSize(uint max_size_bytes);
+    uint maxSize() const;
+
+    //! returns the number of bytes used by the cached procedures
+    uint size() const;
+    //! returns the number of cached airports
+    uint count() const;
+
+    bool contains(const QString& airport) const;
+
+    //! Stores the procedures of the given airport. Airports without
+    //! procedures are stored too, so their procedure file is not read again.
+    void insert(const QString& airport,
+                const ProcedurePtrList& sids,
+                const ProcedurePtrList& stars,
+                const ProcedurePtrList& approaches);
+
+    //! Appends new copies of the cached procedures of the given type
+    //! (Route::TYPE_SID/STAR/APPROACH) to the given list. Returns false if
+    //! the airport is not cached.
+    bool getProcedures(const QString& airport, const QString& type, ProcedurePtrList& procedures);
+
+protected:
+
+    struct Entry
+    {
+        QByteArray sids;
+        QByteArray stars;
+        QByteArray approaches;
+
+        inline uint size() const { return sids.size() + stars.size() + approaches.size(); }
+    };
+
+    static QByteArray serialize(const ProcedurePtrList& procedures);
+    static void deserialize(const QByteArray& data, ProcedurePtrList& procedures);
+
+    //! drops the least recently used airports until the size fits, the
+    //! mutex must be locked
+    void evict();
+
+protected:
+
+    mutable QMutex m_mutex;
+
+    QHash<QString, Entry> m_entry_map;
+    //! most recently used airport first
+    QList<QString> m_lru_list;
+
+    uint m_size;
+    uint m_max_size;
+
+private:
+    //! Hidden copy-constructor
+    ProcedureCache(const ProcedureCache&);
+    //! Hidden assignment operator
+    const ProcedureCache& operator = (const ProcedureCache&);
+};
+
+#endif
@@ -0,0 +1,226 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2005-2006 Alexander Wemmer 
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+///////////////////////////////////////////////////////////////////////////////
+
+/*! \file    projection.cpp
+    \author  Alexander Wemmer, alex@wemmer.at
+*/
+
+#include <math.h>
+
+#include <QPointF>
+
+#include "assert.h"
+#include "navcalc.h"
+
+#include "projection.h"
+
+/////////////////////////////////////////////////////////////////////////////
+
+//! number of points converted at once by the helpers below
+#define PROJECTION_CHUNK_SIZE 256
+
+//! sample bearings per ring used by calcCenterCorrection()
+#define PROJECTION_CORRECTION_BEARINGS 8
+//! center plus a ring at half and at full range
+#define PROJECTION_CORRECTION_SAMPLES (1 + 2*PROJECTION_CORRECTION_BEARINGS)
+
+/////////////////////////////////////////////////////////////////////////////
+
+QAtomicInt ProjectionBase::m_last_epoch(0);
+
+/////////////////////////////////////////////////////////////////////////////
+
+void ProjectionBase::startNewEpoch()
+{
+    m_epoch = m_last_epoch.fetchAndAddOrdered(1) + 1;
+    m_center_correction.reset();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void ProjectionBase::convertLatLonArraysToXY(const double* lat, const double* lon, int count,
+                                             double* x, double* y) const
+{
+    QPointF xy;
+    for(int index = 0; index < count; ++index)
+    {
+        if (!convertLatLonToXY(QPointF(lat[index], lon[index]), xy)) xy = QPointF();
+        x[index] = xy.x();
+        y[index] = xy.y();
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void ProjectionBase::convertLatLonArraysToXY(const int* lat, const int* lon, int count,
+                                             float* x, float* y) const
+{
+    double lat_chunk[PROJECTION_CHUNK_SIZE];
+    double lon_chunk[PROJECTION_CHUNK_SIZE];
+    double x_chunk[PROJECTION_CHUNK_SIZE];
+    double y_chunk[PROJECTION_CHUNK_SIZE];
+
+    for(int first = 0; first < count; first += PROJECTION_CHUNK_SIZE)
+    {
+        int chunk_count = qMin(count - first, PROJECTION_CHUNK_SIZE);
+
+        for(int index = 0; index < chunk_count; ++index)
+        {
+            lat_chunk[index] = lat[first+index] * 1.0e-6;
+            lon_chunk[index] = lon[first+index] * 1.0e-6;
+        }
+
+        convertLatLonArraysToXY(lat_chunk, lon_chunk, chunk_count, x_chunk, y_chunk);
+
+        for(int index = 0; index < chunk_count; ++index)
+        {
+            x[first+index] = x_chunk[index];
+            y[first+index] = y_chunk[index];
+        }
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void ProjectionBase::convertWaypointsToXY(const QList<Waypoint*>& wpt_list) const
+{
+    double lat_chunk[PROJECTION_CHUNK_SIZE];
+    double lon_chunk[PROJECTION_CHUNK_SIZE];
+    double x_chunk[PROJECTION_CHUNK_SIZE];
+    double y_chunk[PROJECTION_CHUNK_SIZE];
+
+    int count = wpt_list.count();
+
+    for(int first = 0; first < count; first += PROJECTION_CHUNK_SIZE)
+    {
+        int chunk_count = qMin(count - first, PROJECTION_CHUNK_SIZE);
+
+        for(int index = 0; index < chunk_count; ++index)
+        {
+            const Waypoint* wpt = wpt_list[first+index];
+            MYASSERT(wpt != 0);
+            lat_chunk[index] = wpt->lat();
+            lon_chunk[index] = wpt->lon();
+        }
+
+        convertLatLonArraysToXY(lat_chunk, lon_chunk, chunk_count, x_chunk, y_chunk);
+
+        for(int index = 0; index < chunk_count; ++index)
+            wpt_list[first+index]->setPointXY(QPointF(x_chunk[index], y_chunk[index]), m_epoch);
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+bool ProjectionBase::convertLatLonArraysToXYAtCenter(const Waypoint&,
+                                                     const double*, const double*, int,
+                                                     double*, double*) const
+{
+    return false;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+double ProjectionBase::calcCenterCorrection(const Waypoint& center_wpt, double range_nm, QMatrix& correction) const
+{
+    correction.reset();
+
+    double lat[PROJECTION_CORRECTION_SAMPLES];
+    double lon[PROJECTION_CORRECTION_SAMPLES];
+    double x[PROJECTION_CORRECTION_SAMPLES];
+    double y[PROJECTION_CORRECTION_SAMPLES];
+    double new_x[PROJECTION_CORRECTION_SAMPLES];
+    double new_y[PROJECTION_CORRECTION_SAMPLES];
+
+    lat[0] = center_wpt.lat();
+    lon[0] = center_wpt.lon();
+
+    for(int index = 0; index < PROJECTION_CORRECTION_BEARINGS; ++index)
+    {
+        double bearing = index * 360.0 / PROJECTION_CORRECTION_BEARINGS;
+        Waypoint near_wpt = Navcalc::getPBDWaypoint(center_wpt, bearing, range_nm * 0.5, 0);
+        Waypoint far_wpt = Navcalc::getPBDWaypoint(center_wpt, bearing, range_nm, 0);
+        lat[1+2*index] = near_wpt.lat();
+        lon[1+2*index] = near_wpt.lon();
+        lat[2+2*index] = far_wpt.lat();
+        lon[2+2*index] = far_wpt.lon();
+    }
+
+    if (!convertLatLonArraysToXYAtCenter(center_wpt, lat, lon, PROJECTION_CORRECTION_SAMPLES, new_x, new_y))
+        return -1.0;
+
+    convertLatLonArraysToXY(lat, lon, PROJECTION_CORRECTION_SAMPLES, x, y);
+
+    // least squares fit of new = A * old + t, the normal equations of the
+    // x and y rows share the same matrix
+
+    double sxx = 0.0, sxy = 0.0, syy = 0.0, sx = 0.0, sy = 0.0;
+    double bx[3] = { 0.0, 0.0, 0.0 };
+    double by[3] = { 0.0, 0.0, 0.0 };
+
+    for(int index = 0; index < PROJECTION_CORRECTION_SAMPLES; ++index)
+    {
+        sxx += x[index]*x[index];
+        sxy += x[index]*y[index];
+        syy += y[index]*y[index];
+        sx += x[index];
+        sy += y[index];
+
+        bx[0] += x[index]*new_x[index];
+        bx[1] += y[index]*new_x[index];
+        bx[2] += new_x[index];
+        by[0] += x[index]*new_y[index];
+        by[1] += y[index]*new_y[index];
+        by[2] += new_y[index];
+    }
+
+    double n = PROJECTION_CORRECTION_SAMPLES;
+
+    // inverse of the symmetric matrix [sxx sxy sx; sxy syy sy; sx sy n]
+    double i00 = syy*n - sy*sy;
+    double i01 = sx*sy - sxy*n;
+    double i02 = sxy*sy - sx*syy;
+    double i11 = sxx*n - sx*sx;
+    double i12 = sxy*sx - sxx*sy;
+    double i22 = sxx*syy - sxy*sxy;
+    double det = sxx*i00 + sxy*i01 + sx*i02;
+    if (fabs(det) < 1e-12) return -1.0;
+
+    double m11 = (i00*bx[0] + i01*bx[1] + i02*bx[2]) / det;
+    double m21 = (i01*bx[0] + i11*bx[1] + i12*bx[2]) / det;
+    double dx  = (i02*bx[0] + i12*bx[1] + i22*bx[2]) / det;
+    double m12 = (i00*by[0] + i01*by[1] + i02*by[2]) / det;
+    double m22 = (i01*by[0] + i11*by[1] + i12*by[2]) / det;
+    double dy  = (i02*by[0] + i12*by[1] + i22*by[2]) / det;
+
+    correction.setMatrix(m11, m12, m21, m22, dx, dy);
+
+    double max_error = 0.0;
+    for(int index = 0; index < PROJECTION_CORRECTION_SAMPLES; ++index)
+    {
+        double error_x = m11*x[index] + m21*y[index] + dx - new_x[index];
+        double error_y = m12*x[index] + m22*y[index] + dy - new_y[index];
+        max_error = qMax(max_error, sqrt(error_x*error_x + error_y*error_y));
+    }
+
+    return max_error;
+}
+
+// End of file
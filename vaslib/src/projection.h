@@ -25,8 +25,10 @@
 #ifndef PROJECTION_H
 #define PROJECTION_H
 
+#include <QAtomicInt>
 #include <QObject>
 #include <QPointF>
+#include <QMatrix>
 
 #include "waypoint.h"
 
@@ -43,7 +45,7 @@ signals:
 
 public:
     //! Standard Constructor
-    ProjectionBase(unsigned int range_nm = 100) : m_range_nm(range_nm) {};
+    ProjectionBase(unsigned int range_nm = 100) : m_range_nm(range_nm), m_epoch(0) {};
 
     //! Destructor
     virtual ~ProjectionBase() {};
@@ -78,16 +80,31 @@ public:
     //! returns the drawing dist at max range
     virtual unsigned int getDrawingDistAtMaxRange() const { return m_drawing_dist_at_max_range; }
 
+    //! Returns the epoch of the projection, which changes with every
+    //! setScaleAndCenter() call. Epochs are unique over all projections,
+    //! x/y values calculated with an other epoch are stale.
+    inline uint epoch() const { return m_epoch; }
+
     //! Converts the given point's lat/lon values to x/y.
     //! (QPointF: x = lat , y=lon)
     inline bool convertLatLonToXY(Waypoint& waypoint) const
     {
         QPointF wpt_xy;
         bool ret = convertLatLonToXY(waypoint.pointLatLon(), wpt_xy);
-        waypoint.setPointXY(wpt_xy);
+        waypoint.setPointXY(wpt_xy, m_epoch);
         return ret;
     }
 
+    //! Returns the x/y values of the given waypoint, they are calculated
+    //! again when the waypoint was projected with an other epoch.
+    inline QPointF pointXY(const Waypoint& waypoint) const
+    {
+        if (waypoint.projectionEpoch() == m_epoch) return waypoint.pointXY();
+        QPointF wpt_xy;
+        convertLatLonToXY(waypoint.pointLatLon(), wpt_xy);
+        return wpt_xy;
+    }
+
     //! Converts the given point's lat/lon values to x/y.
     //! (QPointF: x = lat , y=lon)
     virtual bool convertLatLonToXY(const QPointF& latlon_point, QPointF& xy_point) const = 0;
@@ -97,6 +114,47 @@ public:
     //! (QPointF: x = lat , y=lon)
 	virtual bool convertXYToLatLon(const QPointF& xy_point, QPointF& latlon_point) const = 0;
 
+    //! Converts "count" points given as separate lat/lon arrays in degrees
+    //! to x/y. Points which can not be converted result in 0/0. The default
+    //! implementation converts the points one by one.
+    virtual void convertLatLonArraysToXY(const double* lat, const double* lon, int count,
+                                         double* x, double* y) const;
+
+    //! Same as above for points in micro-degrees, like in the GeoPolygonStore.
+    void convertLatLonArraysToXY(const int* lat, const int* lon, int count,
+                                 float* x, float* y) const;
+
+    //! converts the lat/lon values of all given waypoints to x/y at once
+    void convertWaypointsToXY(const QList<Waypoint*>& wpt_list) const;
+
+    //----- center correction
+
+    //! Fits an affine transformation, which maps the x/y values of this
+    //! projection to the ones of the same projection centered at
+    //! "center_wpt", to sample points up to "range_nm" around
+    //! "center_wpt". When the returned max. deviation of the samples (in
+    //! x/y units) is small enough, the transformation may be used instead
+    //! of recalculating all x/y values. Returns a negative value when the
+    //! projection does not support this.
+    double calcCenterCorrection(const Waypoint& center_wpt, double range_nm, QMatrix& correction) const;
+
+    //! Sets the correction to use with the current x/y values, it is reset
+    //! to the identity by setScaleAndCenter().
+    inline void setCenterCorrection(const QMatrix& correction) { m_center_correction = correction; }
+    inline const QMatrix& centerCorrection() const { return m_center_correction; }
+
+protected:
+
+    //! Converts lat/lon arrays like convertLatLonArraysToXY(), but for a
+    //! projection centered at "center_wpt" with the current scale. Returns
+    //! false when not supported by the projection.
+    virtual bool convertLatLonArraysToXYAtCenter(const Waypoint& center_wpt,
+                                                 const double* lat, const double* lon, int count,
+                                                 double* x, double* y) const;
+
+    //! starts a new epoch, to be called by setScaleAndCenter()
+    void startNewEpoch();
+
 protected:
 
     //! lat/lon center of the projection
@@ -106,6 +164,13 @@ protected:
     unsigned int m_range_nm;
     unsigned int m_drawing_dist_at_max_range;
 
+    uint m_epoch;
+    QMatrix m_center_correction;
+
+    //! the last epoch given to any projection, projections may be set up
+    //! in different threads
+    static QAtomicInt m_last_epoch;
+
 private:
     //! Hidden copy-constructor
     ProjectionBase(const ProjectionBase&);
@@ -43,6 +43,11 @@ void ProjectionGreatCircle::setScaleAndCenter(const Waypoint& center_wpt,
     m_center_latlon = center_wpt;
     m_xy_scale_factor = 1.0;
 
+    // calculate the cached unit vector of the center here, so the
+    // conversions below only read it
+    m_center_latlon.unitVector();
+
+    startNewEpoch();
     emit signalChanged();
 }
 
@@ -71,25 +76,57 @@ bool ProjectionGreatCircle::convertLatLonToXY(const QPointF& latlon_point, QPoin
     MYASSERT(mypoint.y() >= -180.0);
     MYASSERT(mypoint.y() <= 180.0);
 
-    // calc projection
+    // calc projection, the track is taken as the direction of the point
+    // in the tangent plane at the center, which is spanned by the east
+    // and north vectors (both scaled by cos(center lat))
 
-    double distance = 0.0;
-    double track = 0.0;
-    
-    Waypoint wpt;
-    wpt.setPointLatLon(mypoint);
+    const GeoVector& center = m_center_latlon.unitVector();
+    GeoVector point = GeoVector::fromLatLon(mypoint.x(), mypoint.y());
+
+    double east = center.x*point.y - center.y*point.x;
+    double north = point.z*(center.x*center.x + center.y*center.y) - center.z*(center.x*point.x + center.y*point.y);
+    double length = sqrt(east*east + north*north);
 
-    MYASSERT(Navcalc::getDistAndTrackBetweenWaypoints(m_center_latlon, wpt, distance, track));
+    if (length == 0.0)
+    {
+        xy_point = QPointF();
+        return true;
+    }
 
-    double track_rad = Navcalc::toRad(track);
-    xy_point.setX(distance * sin(track_rad) * m_xy_scale_factor);
-    xy_point.setY(-distance * cos(track_rad) * m_xy_scale_factor);
+    double factor = Navcalc::getDistBetweenWaypoints(center, point) / length * m_xy_scale_factor;
+    xy_point.setX(east * factor);
+    xy_point.setY(-north * factor);
     
     return true;
 }
 
 /////////////////////////////////////////////////////////////////////////////
 
+void ProjectionGreatCircle::convertLatLonArraysToXY(const double* lat, const double* lon, int count,
+                                                    double* x, double* y) const
+{
+    convertLatLonArraysToXYAtCenter(m_center_latlon, lat, lon, count, x, y);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+bool ProjectionGreatCircle::convertLatLonArraysToXYAtCenter(const Waypoint& center_wpt,
+                                                            const double* lat, const double* lon, int count,
+                                                            double* x, double* y) const
+{
+    Navcalc::getDistVectorsFromWaypoint(center_wpt, lat, lon, count, x, y);
+
+    for(int index = 0; index < count; ++index)
+    {
+        x[index] *= m_xy_scale_factor;
+        y[index] *= -m_xy_scale_factor;
+    }
+
+    return true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
 bool ProjectionGreatCircle::convertXYToLatLon(const QPointF&, QPointF&) const
 {
     MYASSERT(0);
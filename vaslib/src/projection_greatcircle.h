@@ -57,6 +57,19 @@ public:
     //! (QPointF: x = lat , y=lon)
 	bool convertXYToLatLon(const QPointF& xy_point, QPointF& latlon_point) const;
 
+    //! Converts "count" points given as separate lat/lon arrays in degrees
+    //! to x/y, see ProjectionBase.
+    void convertLatLonArraysToXY(const double* lat, const double* lon, int count,
+                                 double* x, double* y) const;
+
+    using ProjectionBase::convertLatLonArraysToXY;
+
+protected:
+
+    bool convertLatLonArraysToXYAtCenter(const Waypoint& center_wpt,
+                                         const double* lat, const double* lon, int count,
+                                         double* x, double* y) const;
+
 protected:
     
     double m_xy_scale_factor;
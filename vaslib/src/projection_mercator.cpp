@@ -70,6 +70,7 @@ void ProjectionMercator::setScaleAndCenter(const Waypoint& center_wpt,
     MYASSERT(qMax(scale_xy_test_wpt.x(), scale_xy_test_wpt.y()) <= 
              drawing_dist_at_max_range + 0.001);
 
+    startNewEpoch();
     emit signalChanged();
 }
 
@@ -95,6 +96,23 @@ bool ProjectionMercator::convertLatLonToXY(const QPointF& latlon_point, QPointF&
 
 /////////////////////////////////////////////////////////////////////////////
 
+void ProjectionMercator::convertLatLonArraysToXY(const double* lat, const double* lon, int count,
+                                                 double* x, double* y) const
+{
+    double center_x = m_center_xy.x();
+    double center_y = m_center_xy.y();
+    double scale_factor = m_xy_scale_factor;
+
+    for(int index = 0; index < count; ++index)
+    {
+        double sin_lat = sin(Navcalc::toRad(lat[index]));
+        x[index] = (lon[index] - center_x) * scale_factor;
+        y[index] = (Navcalc::toDeg(-0.5 * log((1.0 + sin_lat) / (1.0 - sin_lat))) - center_y) * scale_factor;
+    }
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
 bool ProjectionMercator::convertXYToLatLon(const QPointF& xy_point, QPointF& latlon_point) const
 {
     // translate and scale
@@ -57,6 +57,13 @@ public:
     //! (QPointF: x = lat , y=lon)
 	bool convertXYToLatLon(const QPointF& xy_point, QPointF& latlon_point) const;
 
+    //! Converts "count" points given as separate lat/lon arrays in degrees
+    //! to x/y, see ProjectionBase.
+    void convertLatLonArraysToXY(const double* lat, const double* lon, int count,
+                                 double* x, double* y) const;
+
+    using ProjectionBase::convertLatLonArraysToXY;
+
 protected:
 
     QPointF m_center_xy;
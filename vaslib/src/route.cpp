@@ -227,8 +227,9 @@ void Route::recalcWaypointData(int pos)
 
     if (prev_wpt != 0)
     {
-        MYASSERT(Navcalc::getDistAndTrackBetweenWaypoints(
-                     *prev_wpt, *wpt, route_data.m_dist_from_prev_wpt_nm, route_data.m_true_track_from_prev_wpt));
+        Navcalc::getDistAndTrackBetweenWaypoints(
+            prev_wpt->unitVector(), wpt->unitVector(),
+            route_data.m_dist_from_prev_wpt_nm, route_data.m_true_track_from_prev_wpt);
     }
     else
     {
@@ -238,8 +239,9 @@ void Route::recalcWaypointData(int pos)
 
     if (next_wpt != 0)
     {
-        MYASSERT(Navcalc::getDistAndTrackBetweenWaypoints(
-                     *wpt, *next_wpt, route_data.m_dist_to_next_wpt_nm, route_data.m_true_track_to_next_wpt));
+        Navcalc::getDistAndTrackBetweenWaypoints(
+            wpt->unitVector(), next_wpt->unitVector(),
+            route_data.m_dist_to_next_wpt_nm, route_data.m_true_track_to_next_wpt);
     }
     else
     {
@@ -260,36 +262,56 @@ void Route::scanForWaypointInformation(const Navdata& navdata)
     QTime start_time;
     start_time.start();
 
+    // look up the navdata of all waypoints at once
+
+    QStringList wanted_id_list;
+    for(int index=0; index < count(); ++index)
+    {
+        const Waypoint* route_wpt = waypoint(index);
+		MYASSERT(route_wpt != 0);
+        if (route_wpt->type() == Waypoint::TYPE_WAYPOINT && route_wpt->id().length() <= 4)
+            wanted_id_list.append(route_wpt->id());
+    }
+
+    WaypointCandidateMap candidate_map;
+    navdata.getWaypointCandidates(wanted_id_list, candidate_map);
+
     for(int index=0; index < count(); ++index)
     {
         Waypoint* route_wpt = waypoint(index);
 		MYASSERT(route_wpt != 0);
 		
 		if (route_wpt->type() != Waypoint::TYPE_WAYPOINT || route_wpt->id().length() > 4) continue;
+
+        const WaypointPtrList* candidate_list = candidate_map.value(route_wpt->id().toUpper());
+        if (candidate_list == 0) continue;
 		
         bool found = false;
 
         for(int count=0; count < 2; ++count)
         {
+            // the candidates are owned by the map
             WaypointPtrList possible_navdata_wpt_list;
-            possible_navdata_wpt_list.clear();
+            possible_navdata_wpt_list.setAutoDelete(false);
 
-            switch(count) {
-                case(0): {
-                    navdata.getNavaids(route_wpt->id(), possible_navdata_wpt_list);
-                    break;
-                }
-                case(1): {
-                    navdata.getAirports(route_wpt->id(), possible_navdata_wpt_list);
-                    break;
-                }
-                case(2): {
-                    navdata.getIntersections(route_wpt->id(), possible_navdata_wpt_list);
-                    break;
-                }
-                default: {
-                    MYASSERT(false);
-                    break;
+            WaypointPtrListIterator candidate_iter(*candidate_list);
+            while(candidate_iter.hasNext())
+            {
+                Waypoint* candidate = candidate_iter.next();
+
+                switch(count) {
+                    case(0): {
+                        if (candidate->asNdb() != 0) possible_navdata_wpt_list.append(candidate);
+                        break;
+                    }
+                    case(1): {
+                        if (candidate->asAirport() != 0) possible_navdata_wpt_list.append(candidate);
+                        break;
+                    }
+                    default: {
+                        MYASSERT(false);
+                        break;
+                    }
                 }
             }
 
@@ -377,6 +399,8 @@ void Route::scanForWaypointInformation(const Navdata& navdata)
         }
     }
 
+    qDeleteAll(candidate_map);
+
     Logger::log(QString("Route:scanForWaypointInformation: scanned route in %1ms").arg(start_time.elapsed()));
 }
 
@@ -389,29 +413,45 @@ bool Route::calcProjection(const ProjectionBase& projection, int start_index, in
     if (end_index < 0) end_index = count() - 1;
     else if (end_index >= count()) end_index = count() - 1;
     
+    // collect the waypoints and runways and project them at once
+
+    QList<Waypoint*> projection_wpt_list;
+
     for(int index = start_index; index <= end_index; ++index)
     {
         Waypoint* wpt = waypoint(index);
         
         checkAndSetSpecialWaypoint(index, false);
-        projection.convertLatLonToXY(*wpt);
+        projection_wpt_list.append(wpt);
 
         if (wpt->asAirport() != 0)
         {
-            QMapIterator<QString, Runway> rwy_iter(wpt->asAirport()->runwayMap());
-            while(rwy_iter.hasNext())
-            {
-                rwy_iter.next();
-                projection.convertLatLonToXY(wpt->asAirport()->runwayMap()[rwy_iter.key()]);
-            }
+            RunwayMap::iterator rwy_iter = wpt->asAirport()->runwayMap().begin();
+            for(; rwy_iter != wpt->asAirport()->runwayMap().end(); ++rwy_iter)
+                projection_wpt_list.append(&rwy_iter.value());
         }
     }
 
+    projection.convertWaypointsToXY(projection_wpt_list);
     return true;
 }
 
 /////////////////////////////////////////////////////////////////////////////
 
+void Route::calcDeclinations(QVector<double>& declination_list) const
+{
+    const Declination* declination = Declination::globalDeclination();
+    if (declination == 0)
+    {
+        declination_list.fill(0.0, count());
+        return;
+    }
+
+    declination->declinations(m_wpt_list, declination_list);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
 void Route::resetAndRecalcSpecialWaypoints()
 {
     int index;
@@ -23,6 +23,7 @@
 
 #include <QObject>
 #include <QList>
+#include <QVector>
 #include <QStringList>
 #include <QDateTime>
 
@@ -162,6 +163,10 @@ public:
     //! returns false if the given start index is behind the last waypoint
     virtual bool calcProjection(const ProjectionBase& projection, int start_index = 0, int end_index = -1);
 
+    //! Calculates the declination at every waypoint of the route from the
+    //! declination grid. All values are zero when no declination is loaded.
+    void calcDeclinations(QVector<double>& declination_list) const;
+
     //-----
 
     virtual void appendWaypoint(const Waypoint& wpt);
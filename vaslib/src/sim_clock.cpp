@@ -0,0 +1,93 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2005-2007 Alexander Wemmer 
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+///////////////////////////////////////////////////////////////////////////////
+
+/*! \file    sim_clock.cpp
+    \author  Alexander Wemmer, alex@wemmer.at
+*/
+
+#include <QList>
+
+#include "assert.h"
+#include "sim_clock.h"
+
+#define MS_PER_DAY 86400000
+
+/////////////////////////////////////////////////////////////////////////////
+
+QAtomicPointer<SimClock> SimClock::m_instance(0);
+
+/////////////////////////////////////////////////////////////////////////////
+
+//! owns the clocks given to SimClock::setInstance()
+class SimClockList : public QList<SimClock*>
+{
+public:
+    SimClockList() {};
+    ~SimClockList() { qDeleteAll(*this); }
+};
+
+/////////////////////////////////////////////////////////////////////////////
+
+SimClock* SimClock::instance()
+{
+    static RealTimeClock real_time_clock;
+    SimClock* clock = m_instance;
+    return (clock != 0) ? clock : &real_time_clock;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void SimClock::setInstance(SimClock* clock)
+{
+    static QMutex mutex;
+    static SimClockList clock_list;
+
+    QMutexLocker locker(&mutex);
+
+    qint64 now_ms = nowMs();
+    if (clock == 0) clock = new RealTimeClock(now_ms);
+    MYASSERT(clock != 0);
+    MYASSERT(clock->currentMs() >= now_ms);
+
+    if (!clock_list.contains(clock)) clock_list.append(clock);
+    m_instance.fetchAndStoreOrdered(clock);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+qint64 RealTimeClock::currentMs()
+{
+    QMutexLocker locker(&m_mutex);
+
+    qint64 current_ms = m_wrapped_ms + m_time_base.elapsed();
+
+    // a drop of more than half a day is the daily wrap around of the time
+    // base, smaller ones are clock adjustments and are not passed on
+    if (current_ms < m_last_ms - MS_PER_DAY/2)
+    {
+        m_wrapped_ms += MS_PER_DAY;
+        current_ms += MS_PER_DAY;
+    }
+
+    m_last_ms = qMax(m_last_ms, current_ms);
+    return m_last_ms;
+}
+
+// End of file
@@ -0,0 +1,184 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2005-2007 Alexander Wemmer 
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+///////////////////////////////////////////////////////////////////////////////
+
+/*! \file    sim_clock.h
+    \author  Alexander Wemmer, alex@wemmer.at
+*/
+
+#ifndef SIM_CLOCK_H
+#define SIM_CLOCK_H
+
+#include <limits.h>
+
+#include <QAtomicPointer>
+#include <QMutex>
+#include <QTime>
+
+#include "assert.h"
+
+/////////////////////////////////////////////////////////////////////////////
+
+//! Time base of the avionics (smoothing, refresh gates, mode timers). By
+//! default this is the real time, a SteppedClock may be set to run the
+//! avionics deterministically or faster than real time. The clock may be
+//! changed while timers are running, so a new clock must continue from
+//! the time of the current one.
+class SimClock
+{
+public:
+
+    SimClock() {};
+    virtual ~SimClock() {};
+
+    //! Returns the time in milliseconds since an arbitrary start, the
+    //! value never decreases.
+    virtual qint64 currentMs() = 0;
+
+    //! returns the clock in use, the real time clock when none was set
+    static SimClock* instance();
+
+    //! Sets the clock to use and takes the ownership of it, the time of
+    //! the given clock must not be behind the current one. A null pointer
+    //! hands over to the real time continuing from the current time.
+    //! Replaced clocks are kept until the program ends, because other
+    //! threads may still be reading them.
+    static void setInstance(SimClock* clock);
+
+    static inline qint64 nowMs() { return instance()->currentMs(); }
+
+protected:
+
+    static QAtomicPointer<SimClock> m_instance;
+
+private:
+    //! Hidden copy-constructor
+    SimClock(const SimClock&);
+    //! Hidden assignment operator
+    const SimClock& operator = (const SimClock&);
+};
+
+/////////////////////////////////////////////////////////////////////////////
+
+//! Real time clock based on QTime, starting at the given time.
+//! QTime::elapsed() wraps around after a day, this is compensated.
+class RealTimeClock : public SimClock
+{
+public:
+
+    RealTimeClock(qint64 start_ms = 0) : m_wrapped_ms(start_ms), m_last_ms(start_ms) { m_time_base.start(); }
+    virtual ~RealTimeClock() {};
+
+    virtual qint64 currentMs();
+
+protected:
+
+    QMutex m_mutex;
+    QTime m_time_base;
+    qint64 m_wrapped_ms;
+    qint64 m_last_ms;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+
+//! Clock which only advances when told to, e.g. by a replay driver.
+class SteppedClock : public SimClock
+{
+public:
+
+    SteppedClock(qint64 start_ms = 0) : m_current_ms(start_ms) {};
+    virtual ~SteppedClock() {};
+
+    virtual qint64 currentMs()
+    {
+        QMutexLocker locker(&m_mutex);
+        return m_current_ms;
+    }
+
+    inline void advanceMs(qint64 delta_ms)
+    {
+        MYASSERT(delta_ms >= 0);
+        QMutexLocker locker(&m_mutex);
+        m_current_ms += delta_ms;
+    }
+
+    inline void setMs(qint64 current_ms)
+    {
+        QMutexLocker locker(&m_mutex);
+        MYASSERT(current_ms >= m_current_ms);
+        m_current_ms = current_ms;
+    }
+
+protected:
+
+    QMutex m_mutex;
+    qint64 m_current_ms;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+
+//! Elapsed time measurement on the SimClock with the QTime interface used
+//! for timers. A timer which was not started yet reports a day as elapsed
+//! time, so checks waiting for it pass.
+class SimTimer
+{
+public:
+
+    SimTimer() : m_start_ms(0), m_started(false) {};
+
+    inline bool isNull() const { return !m_started; }
+
+    inline void start() 
+    {
+        m_start_ms = SimClock::nowMs();
+        m_started = true;
+    }
+
+    //! starts the timer as if it was started the given time ago
+    inline void startMsAgo(int elapsed_ms)
+    {
+        start();
+        m_start_ms -= elapsed_ms;
+    }
+
+    //! restarts the timer and returns the elapsed time before the restart
+    inline int restart()
+    {
+        int elapsed_ms = elapsed();
+        start();
+        return elapsed_ms;
+    }
+
+    inline int elapsed() const
+    {
+        if (!m_started) return SIM_TIMER_NULL_ELAPSED_MS;
+        return (int)qMin(SimClock::nowMs() - m_start_ms, (qint64)INT_MAX);
+    }
+
+    enum { SIM_TIMER_NULL_ELAPSED_MS = 86400000 };
+
+protected:
+
+    qint64 m_start_ms;
+    bool m_started;
+};
+
+#endif /* SIM_CLOCK_H */
+
+// End of file
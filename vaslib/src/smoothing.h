@@ -31,7 +31,7 @@
 #include "median.h"
 #include "navcalc.h"
 #include "meanvalue.h"
-#include "median.h"
+#include "sim_clock.h"
 
 /////////////////////////////////////////////////////////////////////////////
 
@@ -75,46 +75,32 @@ protected:
     
     bool m_first_update;
     TYPE m_time_constant;
-    QTime m_update_dt;
+    SimTimer m_update_dt;
     TYPE m_init_value;
     TYPE m_current_value;
 };
 
 /////////////////////////////////////////////////////////////////////////////
 
-template <class TYPE> class ValueWithTimeStamp
-{
-public:
-
-    ValueWithTimeStamp(const TYPE& value)
-    {
-        m_value = value;
-        m_dt = QTime::currentTime();
-    }
-
-    inline const TYPE& value() const { return m_value; }
-    inline const QTime& dt() const { return m_dt; }
-
-protected:
-
-    TYPE m_value;
-    QTime m_dt;
-};
-
-/////////////////////////////////////////////////////////////////////////////
-
-//! smoothed value with delay
+//! Smoothed value with delay. The last "length" values are kept with their
+//! time stamps in a ring buffer, value() interpolates the value at the
+//! current time minus the delay.
 template <class TYPE> class SmoothedValueWithDelay
 {
 public:
 
     SmoothedValueWithDelay(bool is_heading, bool is_coordinate, uint length, uint delay_ms, bool calc_trend = false) : 
         m_is_heading(is_heading), m_is_coordinate(is_coordinate), m_calc_trend(calc_trend), 
-        m_length(length), m_delay_ms(delay_ms), m_trend_median(2*length, 0.0), m_trend_median_mean(2*length, 0.0),
+        m_length(length), m_delay_ms(delay_ms), m_count(0), m_newest_slot(-1),
+        m_trend_median(2*length, 0.0), m_trend_median_mean(2*length, 0.0),
         m_do_smoothing_mean(false), m_smoothing_mean(length, 0.0), 
         m_do_low_pass(false), m_low_pass(0.0, 0.0), m_do_trend_low_pass(false), m_trend_low_pass(0.0, 0.0),
-        m_verbose(false)
-    {}
+        m_verbose(false), m_frozen(false), m_frozen_value(0), m_frozen_trend(0)
+    {
+        MYASSERT(length > 0);
+        m_value_list.resize(m_length);
+        m_time_ms_list.resize(m_length);
+    }
     
     virtual ~SmoothedValueWithDelay() {}
 
@@ -144,7 +130,9 @@ public:
         if (!m_name.isEmpty())
             Logger::log(QString("SmoothedValueWithDelay:clear(%1)").arg(m_name));
 
-        m_value_list.clear();
+        m_count = 0;
+        m_newest_slot = -1;
+        m_frozen = false;
         m_trend_median.clear();
         m_trend_median_mean.clear();
         m_smoothing_mean.clear();
@@ -152,63 +140,86 @@ public:
         m_trend_low_pass.clear();
     }
 
+    //! Calculates the current value and trend once, value() returns these
+    //! afterwards without updating any filter, so concurrent readers do not
+    //! interfere. A new value or clear() unfreezes the value.
+    void freeze()
+    {
+        m_frozen = false;
+        m_frozen_trend = 0;
+        m_frozen_value = m_calc_trend ? value(&m_frozen_trend) : value();
+        m_frozen = true;
+    }
+
     TYPE value(TYPE* trend_per_second = 0) const
     {
-        if (m_value_list.count() < 1) 
+        if (m_frozen)
+        {
+            if (trend_per_second != 0) *trend_per_second = m_frozen_trend;
+            return m_frozen_value;
+        }
+
+        if (m_count < 1) 
         {
             if (!m_name.isEmpty())
                 Logger::logToFileOnly(QString("SmoothedValueWithDelay:value(%1): count < 1").arg(m_name));
             return 0;
         }
 
-        const ValueWithTimeStamp<TYPE>& newest_value = m_value_list.last();
-        if (m_value_list.count() < 2) 
+        const TYPE& newest_value = m_value_list[m_newest_slot];
+        qint64 newest_time_ms = m_time_ms_list[m_newest_slot];
+
+        if (m_count < 2) 
         {
             if (!m_name.isEmpty())
                 Logger::logToFileOnly(QString("SmoothedValueWithDelay:value(%1): count < 2 -> newest value").arg(m_name));
-            return newest_value.value();
+            return newest_value;
         }
 
-        QTime wanted_dt = QTime::currentTime().addMSecs(-m_delay_ms);
-        if (newest_value.dt() < wanted_dt) 
+        qint64 current_time_ms = SimClock::nowMs();
+        qint64 wanted_time_ms = current_time_ms - m_delay_ms;
+        if (newest_time_ms < wanted_time_ms) 
         {
             if (!m_name.isEmpty())
                 Logger::logToFileOnly(QString("SmoothedValueWithDelay:value(%1): " 
                                               "newest value (%2) < wanted_dt (%3) (cur=%4, del=%5) -> newest value").
-                                      arg(m_name).arg(newest_value.dt().toString("hh:mm:ss:zzz")).
-                                      arg(wanted_dt.toString("hh:mm:ss:zzz")).
-                                      arg(QTime::currentTime().toString("hh:mm:ss:zzz")).
-                                      arg(m_delay_ms));
-            return newest_value.value();
+                                      arg(m_name).arg(newest_time_ms).arg(wanted_time_ms).
+                                      arg(current_time_ms).arg(m_delay_ms));
+            return newest_value;
         }
 
-        // get value older than the reference time
+        // get the newest value not younger than the reference time, the
+        // time stamps are ascending from the oldest to the newest value
 
-        int index = m_value_list.count() - 1;
-        MYASSERT(index > 0);
+        if (wanted_time_ms < m_time_ms_list[slot(0)])
+        {
+            if (!m_name.isEmpty())
+                Logger::logToFileOnly(QString("SmoothedValueWithDelay:value(%1): "
+                                              "wanted_dt (%2) < oldest value (%3) -> newest value").
+                                      arg(m_name).arg(wanted_time_ms).arg(m_time_ms_list[slot(0)]));
+            return newest_value;
+        }
 
-        while(wanted_dt < m_value_list[index].dt())
+        int lower_index = 0;
+        int upper_index = m_count - 1;
+        while(lower_index < upper_index)
         {
-            if (index == 0)
-            {
-                if (!m_name.isEmpty())
-                    Logger::logToFileOnly(QString("SmoothedValueWithDelay:value(%1): "
-                                        "wanted_dt (%2) < oldest value (%3) -> newest value").
-                                arg(m_name).arg(wanted_dt.toString("hh:mm:ss:zzz")).
-                                arg(m_value_list[index].dt().toString("hh:mm:ss:zzz")));
-                return newest_value.value();
-            }
-            --index;
+            int middle_index = (lower_index + upper_index + 1) / 2;
+            if (wanted_time_ms < m_time_ms_list[slot(middle_index)]) upper_index = middle_index - 1;
+            else                                                     lower_index = middle_index;
         }
 
+        const TYPE& ref_value = m_value_list[slot(lower_index)];
+        qint64 ref_time_ms = m_time_ms_list[slot(lower_index)];
+
         // interpolate value
 
-        int timediff = m_value_list[index].dt().msecsTo(newest_value.dt());
+        int timediff = (int)(newest_time_ms - ref_time_ms);
         TYPE per_time_change = 0;
 
         if (timediff > 0) 
         {
-            TYPE absolut_change = newest_value.value() - m_value_list[index].value();
+            TYPE absolut_change = newest_value - ref_value;
 
             if (m_is_heading || m_is_coordinate)
             {
@@ -220,7 +231,7 @@ public:
             
             if (m_verbose)
                 Logger::log(QString("new=%1 old=%2 abs=%3 timediff=%4 pertime=%5").
-                            arg(newest_value.value()).arg(m_value_list[index].value()).
+                            arg(newest_value).arg(ref_value).
                             arg(absolut_change).arg(timediff).arg(per_time_change));
         }
 
@@ -241,15 +252,15 @@ public:
             MYASSERT(trend_per_second == 0);
         }
         
-        double correction_value = per_time_change * m_value_list[index].dt().msecsTo(wanted_dt);
+        double correction_value = per_time_change * (wanted_time_ms - ref_time_ms);
 
         if (m_verbose)
             Logger::log(QString("refdtdiff=%1 correction=%2").
-                        arg(m_value_list[index].dt().msecsTo(wanted_dt)).arg(correction_value));
+                        arg(wanted_time_ms - ref_time_ms).arg(correction_value));
 
         TYPE ret;
-        if (m_is_heading) ret= Navcalc::trimHeading(m_value_list[index].value() + correction_value);
-        ret = m_value_list[index].value() + correction_value;
+        if (m_is_heading) ret= Navcalc::trimHeading(ref_value + correction_value);
+        ret = ref_value + correction_value;
 
         if (m_do_smoothing_mean) 
         {
@@ -265,15 +276,27 @@ public:
 
     void operator=(const TYPE& value)
     {
-        m_value_list.append(ValueWithTimeStamp<TYPE>(value));
-        if (m_value_list.count() > (int)m_length) m_value_list.removeFirst();
+        m_frozen = false;
+        if (++m_newest_slot >= (int)m_length) m_newest_slot = 0;
+        if (m_count < (int)m_length) ++m_count;
 
+        m_value_list[m_newest_slot] = value;
+        m_time_ms_list[m_newest_slot] = SimClock::nowMs();
     }
 
     const TYPE lastValue() const 
     {
-        if (m_value_list.isEmpty()) return 0;
-        return m_value_list.last().value(); 
+        if (m_count < 1) return 0;
+        return m_value_list[m_newest_slot]; 
+    }
+
+protected:
+
+    //! returns the ring slot of the given index, 0 is the oldest value
+    inline int slot(int index) const
+    {
+        int slot = m_newest_slot - m_count + 1 + index;
+        return (slot < 0) ? slot + m_length : slot;
     }
 
 protected:
@@ -283,7 +306,13 @@ protected:
     bool m_calc_trend;
     uint m_length;
     uint m_delay_ms;
-    QList< ValueWithTimeStamp<TYPE> > m_value_list;
+
+    //! ring buffer of the values and their time stamps
+    QVector<TYPE> m_value_list;
+    QVector<qint64> m_time_ms_list;
+    int m_count;
+    int m_newest_slot;
+
     mutable Median<TYPE> m_trend_median;
     mutable MeanValue<TYPE> m_trend_median_mean;
 
@@ -298,6 +327,10 @@ protected:
 
     bool m_verbose;
     QString m_name;
+
+    bool m_frozen;
+    TYPE m_frozen_value;
+    TYPE m_frozen_trend;
 };
 
 /////////////////////////////////////////////////////////////////////////////
@@ -0,0 +1,425 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2005-2007 Alexander Wemmer 
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+///////////////////////////////////////////////////////////////////////////////
+
+/*! \file    task_scheduler.cpp
+    \author  Alexander Wemmer, alex@wemmer.at
+*/
+
+#include <QMutexLocker>
+#include <QRunnable>
+
+#include "logger.h"
+
+#include "task_scheduler.h"
+
+/////////////////////////////////////////////////////////////////////////////
+
+//! limits the tasks run per dispatch, so the event loop is served in between
+#define MAX_RUNS_PER_DISPATCH 8
+//! max. time between two dispatches when no task is released
+#define MAX_DISPATCH_INTERVAL_MS 1000
+//! interval of the estimation of the SimClock speed
+#define SIM_RATE_INTERVAL_MS 500
+//! below this speed the SimClock is regarded as stopped
+#define MIN_SIM_RATE 0.01
+
+/////////////////////////////////////////////////////////////////////////////
+
+//! Runs one release of a task of the worker lane in the thread pool.
+class ScheduledWorkerTask : public QRunnable
+{
+public:
+
+    ScheduledWorkerTask(TaskScheduler& scheduler, int index, int task_id, qint64 release_ms) : 
+        m_scheduler(scheduler), m_index(index), m_task_id(task_id), m_release_ms(release_ms)
+    {}
+
+    virtual ~ScheduledWorkerTask() {};
+
+    virtual void run()
+    {
+        qint64 late_ms = SimClock::nowMs() - m_release_ms;
+        qint64 start_ms = m_scheduler.m_wall_clock.currentMs();
+        m_scheduler.m_runner->runScheduledTask(m_task_id);
+        m_scheduler.finishWorkerTask(m_index, late_ms, m_scheduler.m_wall_clock.currentMs() - start_ms);
+    }
+
+protected:
+
+    TaskScheduler& m_scheduler;
+    int m_index;
+    int m_task_id;
+    qint64 m_release_ms;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+
+TaskScheduler::TaskScheduler(TaskRunner* runner, int worker_thread_count) : 
+    m_runner(runner), m_started(false), m_report_interval_ms(0), m_last_report_ms(0),
+    m_sim_rate(1.0), m_sim_rate_sim_ms(0), m_sim_rate_wall_ms(0)
+{
+    MYASSERT(m_runner != 0);
+    MYASSERT(worker_thread_count > 0);
+    m_thread_pool.setMaxThreadCount(worker_thread_count);
+
+    m_dispatch_timer.setSingleShot(true);
+    MYASSERT(connect(&m_dispatch_timer, SIGNAL(timeout()), this, SLOT(slotDispatch())));
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+TaskScheduler::~TaskScheduler()
+{
+    stop();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void TaskScheduler::addTask(int task_id, const QString& name, Lane lane, int period_ms, int deadline_ms, int phase_ms)
+{
+    // running worker tasks reference their entry of the task list
+    MYASSERT(!m_started);
+    MYASSERT(taskIndex(task_id) < 0);
+    MYASSERT(period_ms > 0);
+
+    Task task;
+    task.id = task_id;
+    task.name = name;
+    task.lane = lane;
+    task.period_ms = period_ms;
+    task.deadline_ms = deadline_ms;
+    task.enabled = true;
+    task.release_ms = phase_ms;
+    task.running = false;
+    task.reported_overrun_count = 0;
+    task.reported_skipped_count = 0;
+    m_task_list.append(task);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+int TaskScheduler::taskIndex(int task_id) const
+{
+    for(int index = 0; index < m_task_list.count(); ++index)
+        if (m_task_list[index].id == task_id) return index;
+    return -1;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void TaskScheduler::setTaskPeriod(int task_id, int period_ms)
+{
+    int index = taskIndex(task_id);
+    MYASSERT(index >= 0);
+    MYASSERT(period_ms > 0);
+    m_task_list[index].period_ms = period_ms;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void TaskScheduler::setTaskEnabled(int task_id, bool enabled)
+{
+    int index = taskIndex(task_id);
+    MYASSERT(index >= 0);
+
+    Task& task = m_task_list[index];
+    if (enabled && !task.enabled && m_started) task.release_ms = SimClock::nowMs();
+    task.enabled = enabled;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void TaskScheduler::start()
+{
+    if (m_started) return;
+    m_started = true;
+
+    // the phases were stored as release times
+    qint64 now_ms = SimClock::nowMs();
+    for(int index = 0; index < m_task_list.count(); ++index) m_task_list[index].release_ms += now_ms;
+
+    m_last_report_ms = m_sim_rate_wall_ms = m_wall_clock.currentMs();
+    m_sim_rate_sim_ms = now_ms;
+    m_sim_rate = 1.0;
+
+    m_dispatch_timer.start(0);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void TaskScheduler::stop()
+{
+    if (!m_started) return;
+    m_started = false;
+
+    m_dispatch_timer.stop();
+    m_thread_pool.waitForDone();
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+int TaskScheduler::nextTask(qint64 now_ms) const
+{
+    int next_index = -1;
+    qint64 next_deadline_ms = 0;
+
+    for(int index = 0; index < m_task_list.count(); ++index)
+    {
+        const Task& task = m_task_list[index];
+        if (!task.enabled || task.lane == LANE_WORKER || task.release_ms > now_ms) continue;
+
+        qint64 deadline_ms = task.release_ms + deadlineMs(task);
+
+        if (next_index < 0 || 
+            task.lane < m_task_list[next_index].lane ||
+            (task.lane == m_task_list[next_index].lane && deadline_ms < next_deadline_ms))
+        {
+            next_index = index;
+            next_deadline_ms = deadline_ms;
+        }
+    }
+
+    return next_index;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void TaskScheduler::advanceRelease(Task& task, qint64 now_ms)
+{
+    qint64 next_release_ms = task.release_ms + task.period_ms;
+
+    // a release already late by a whole period is dropped, the task runs
+    // once for the latest one instead of catching up
+    if (next_release_ms + task.period_ms <= now_ms)
+    {
+        qint64 missed = (now_ms - next_release_ms) / task.period_ms;
+        next_release_ms += missed * task.period_ms;
+
+        QMutexLocker locker(&m_mutex);
+        task.statistics.skipped_count += (uint)missed;
+    }
+
+    task.release_ms = next_release_ms;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void TaskScheduler::addRun(Task& task, qint64 late_ms, qint64 run_ms)
+{
+    TaskStatistics& statistics = task.statistics;
+
+    qint64 jitter_ms = qMax((qint64)0, simToWallMs(late_ms));
+
+    ++statistics.run_count;
+    if (jitter_ms + run_ms > simToWallMs(deadlineMs(task))) ++statistics.overrun_count;
+    statistics.total_jitter_ms += jitter_ms;
+    statistics.max_jitter_ms = qMax(statistics.max_jitter_ms, jitter_ms);
+    statistics.total_run_ms += run_ms;
+    statistics.max_run_ms = qMax(statistics.max_run_ms, run_ms);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void TaskScheduler::updateSimRate(qint64 sim_now_ms)
+{
+    qint64 wall_now_ms = m_wall_clock.currentMs();
+    qint64 wall_elapsed_ms = wall_now_ms - m_sim_rate_wall_ms;
+    if (wall_elapsed_ms < SIM_RATE_INTERVAL_MS) return;
+
+    QMutexLocker locker(&m_mutex);
+    m_sim_rate = (sim_now_ms - m_sim_rate_sim_ms) / (double)wall_elapsed_ms;
+    m_sim_rate_sim_ms = sim_now_ms;
+    m_sim_rate_wall_ms = wall_now_ms;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+qint64 TaskScheduler::simToWallMs(qint64 sim_ms) const
+{
+    // a stopped clock is treated as real time, so the scheduler keeps
+    // polling with the task periods until it runs again
+    if (m_sim_rate < MIN_SIM_RATE) return sim_ms;
+    return (qint64)(sim_ms / m_sim_rate);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void TaskScheduler::runTask(Task& task)
+{
+    qint64 late_ms = SimClock::nowMs() - task.release_ms;
+    qint64 start_ms = m_wall_clock.currentMs();
+    m_runner->runScheduledTask(task.id);
+    qint64 run_ms = m_wall_clock.currentMs() - start_ms;
+
+    {
+        QMutexLocker locker(&m_mutex);
+        addRun(task, late_ms, run_ms);
+    }
+
+    advanceRelease(task, SimClock::nowMs());
+    emit signalTimeUsed(task.name, (uint)run_ms);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void TaskScheduler::startWorkerTask(Task& task, qint64 now_ms)
+{
+    int index = &task - m_task_list.data();
+
+    {
+        QMutexLocker locker(&m_mutex);
+
+        if (task.running)
+        {
+            ++task.statistics.skipped_count;
+        }
+        else
+        {
+            task.running = true;
+            m_thread_pool.start(new ScheduledWorkerTask(*this, index, task.id, task.release_ms));
+        }
+    }
+
+    advanceRelease(task, now_ms);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void TaskScheduler::finishWorkerTask(int index, qint64 late_ms, qint64 run_ms)
+{
+    QString name;
+
+    {
+        QMutexLocker locker(&m_mutex);
+        Task& task = m_task_list[index];
+        addRun(task, late_ms, run_ms);
+        task.running = false;
+        name = task.name;
+    }
+
+    emit signalTimeUsed(name, (uint)run_ms);
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void TaskScheduler::slotDispatch()
+{
+    if (!m_started) return;
+
+    qint64 now_ms = SimClock::nowMs();
+    updateSimRate(now_ms);
+
+    // handing a task to the pool is cheap, so the worker lane does not
+    // count against the runs per dispatch
+
+    for(int index = 0; index < m_task_list.count(); ++index)
+    {
+        Task& task = m_task_list[index];
+        if (task.enabled && task.lane == LANE_WORKER && task.release_ms <= now_ms) startWorkerTask(task, now_ms);
+    }
+
+    for(int count = 0; count < MAX_RUNS_PER_DISPATCH; ++count)
+    {
+        int index = nextTask(now_ms);
+        if (index < 0) break;
+
+        runTask(m_task_list[index]);
+        now_ms = SimClock::nowMs();
+    }
+
+    qint64 wall_now_ms = m_wall_clock.currentMs();
+    if (m_report_interval_ms > 0 && wall_now_ms - m_last_report_ms >= m_report_interval_ms)
+    {
+        logReport();
+        m_last_report_ms = wall_now_ms;
+    }
+
+    // sleep until the next release, converted to wall clock time
+
+    qint64 delay_ms = MAX_DISPATCH_INTERVAL_MS;
+    for(int index = 0; index < m_task_list.count(); ++index)
+        if (m_task_list[index].enabled)
+            delay_ms = qMin(delay_ms, simToWallMs(m_task_list[index].release_ms - now_ms));
+
+    m_dispatch_timer.start((int)qMax((qint64)0, delay_ms));
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+TaskStatistics TaskScheduler::statistics(int task_id) const
+{
+    int index = taskIndex(task_id);
+    MYASSERT(index >= 0);
+
+    QMutexLocker locker(&m_mutex);
+    return m_task_list[index].statistics;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+QString TaskScheduler::statisticsText() const
+{
+    QMutexLocker locker(&m_mutex);
+
+    QString text;
+    for(int index = 0; index < m_task_list.count(); ++index)
+    {
+        const Task& task = m_task_list[index];
+        const TaskStatistics& statistics = task.statistics;
+        uint runs = qMax(statistics.run_count, (uint)1);
+
+        text += QString("%1: period %2ms, %3 runs, %4 overruns, %5 skipped, "
+                        "jitter avg %6ms max %7ms, run avg %8ms max %9ms\n").
+                arg(task.name).arg(task.period_ms).arg(statistics.run_count).
+                arg(statistics.overrun_count).arg(statistics.skipped_count).
+                arg(statistics.total_jitter_ms / (double)runs, 0, 'f', 1).arg(statistics.max_jitter_ms).
+                arg(statistics.total_run_ms / (double)runs, 0, 'f', 1).arg(statistics.max_run_ms);
+    }
+
+    return text;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+void TaskScheduler::logReport()
+{
+    QMutexLocker locker(&m_mutex);
+
+    for(int index = 0; index < m_task_list.count(); ++index)
+    {
+        Task& task = m_task_list[index];
+        const TaskStatistics& statistics = task.statistics;
+
+        if (statistics.overrun_count == task.reported_overrun_count &&
+            statistics.skipped_count == task.reported_skipped_count) continue;
+
+        Logger::log(QString("TaskScheduler:logReport: %1: %2 new overruns, %3 new skipped, "
+                            "max jitter %4ms, max run %5ms (period %6ms)").
+                    arg(task.name).
+                    arg(statistics.overrun_count - task.reported_overrun_count).
+                    arg(statistics.skipped_count - task.reported_skipped_count).
+                    arg(statistics.max_jitter_ms).arg(statistics.max_run_ms).arg(task.period_ms));
+
+        task.reported_overrun_count = statistics.overrun_count;
+        task.reported_skipped_count = statistics.skipped_count;
+    }
+}
+
+// End of file
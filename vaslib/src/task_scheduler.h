@@ -0,0 +1,219 @@
+///////////////////////////////////////////////////////////////////////////////
+//
+// Copyright (C) 2005-2007 Alexander Wemmer 
+//
+// This program is free software; you can redistribute it and/or modify
+// it under the terms of the GNU General Public License as published by
+// the Free Software Foundation; either version 2 of the License, or
+// (at your option) any later version.
+//
+// This program is distributed in the hope that it will be useful,
+// but WITHOUT ANY WARRANTY; without even the implied warranty of
+// MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+// GNU General Public License for more details.
+//
+// You should have received a copy of the GNU General Public License
+// along with this program; if not, write to the Free Software
+// Foundation, Inc., 59 Temple Place, Suite 330, Boston, MA  02111-1307  USA
+//
+///////////////////////////////////////////////////////////////////////////////
+
+/*! \file    task_scheduler.h
+    \author  Alexander Wemmer, alex@wemmer.at
+*/
+
+#ifndef TASK_SCHEDULER_H
+#define TASK_SCHEDULER_H
+
+#include <QMutex>
+#include <QObject>
+#include <QString>
+#include <QThreadPool>
+#include <QTimer>
+#include <QVector>
+
+#include "assert.h"
+#include "sim_clock.h"
+
+/////////////////////////////////////////////////////////////////////////////
+
+//! Executes the tasks of a TaskScheduler
+class TaskRunner
+{
+public:
+    TaskRunner() {};
+    virtual ~TaskRunner() {};
+
+    //! Runs the task with the given ID. Tasks of the worker lane are run in
+    //! a thread of the scheduler's pool, all others in the thread of the
+    //! scheduler.
+    virtual void runScheduledTask(int task_id) = 0;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+
+//! Statistics of a scheduled task, wall clock times in milliseconds
+struct TaskStatistics
+{
+    TaskStatistics() : 
+        run_count(0), overrun_count(0), skipped_count(0), 
+        max_jitter_ms(0), total_jitter_ms(0), max_run_ms(0), total_run_ms(0)
+    {}
+
+    uint run_count;
+    //! runs finished after their deadline
+    uint overrun_count;
+    //! releases dropped because the task was late by more than a period or
+    //! still running
+    uint skipped_count;
+    //! delay between the release and the start of a run
+    qint64 max_jitter_ms;
+    qint64 total_jitter_ms;
+    qint64 max_run_ms;
+    qint64 total_run_ms;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+
+//! Runs periodic tasks by their deadlines. Every task is released once per
+//! period and has to finish within its deadline after the release. The
+//! tasks of the guidance, processing and display lanes run in the thread
+//! of the scheduler; of the released ones, the task of the highest lane
+//! runs first and within a lane the one with the earliest deadline. Tasks
+//! of the worker lane run in a thread pool, a task never runs twice at the
+//! same time. The scheduler only wakes up when the next task is released.
+//! The releases follow the SimClock, so the periods scale with e.g. a
+//! faster replay. Run times, jitter, overruns and the sleeps of the
+//! scheduler are wall clock times.
+class TaskScheduler : public QObject
+{
+    Q_OBJECT
+
+public:
+
+    enum Lane { LANE_GUIDANCE = 0,
+                LANE_PROCESSING,
+                LANE_DISPLAY,
+                LANE_WORKER
+    };
+
+    TaskScheduler(TaskRunner* runner, int worker_thread_count = 1);
+    virtual ~TaskScheduler();
+
+    //! Adds a task, tasks can only be added before start(). A deadline of
+    //! 0 equals the period. The first release is "phase_ms" after start().
+    void addTask(int task_id, const QString& name, Lane lane, int period_ms, int deadline_ms = 0, int phase_ms = 0);
+
+    //! changes the period, the next release stays unchanged
+    void setTaskPeriod(int task_id, int period_ms);
+
+    void setTaskEnabled(int task_id, bool enabled);
+
+    void start();
+
+    //! stops dispatching and waits until all running worker tasks finished
+    void stop();
+
+    inline bool isStarted() const { return m_started; }
+
+    //! Logs the tasks with new overruns or skipped releases every given
+    //! interval, 0 disables it.
+    inline void setReportInterval(int report_interval_ms) { m_report_interval_ms = report_interval_ms; }
+
+    TaskStatistics statistics(int task_id) const;
+
+    //! returns one line with the statistics per task
+    QString statisticsText() const;
+
+signals:
+
+    //! emitted after every run of a task with its name
+    void signalTimeUsed(const QString& name, uint millisecs);
+
+protected slots:
+
+    void slotDispatch();
+
+protected:
+
+    friend class ScheduledWorkerTask;
+
+    struct Task
+    {
+        int id;
+        QString name;
+        Lane lane;
+        int period_ms;
+        //! 0 equals the period
+        int deadline_ms;
+        bool enabled;
+        qint64 release_ms;
+        //! set while a worker task runs
+        bool running;
+        TaskStatistics statistics;
+        uint reported_overrun_count;
+        uint reported_skipped_count;
+    };
+
+    int taskIndex(int task_id) const;
+
+    inline int deadlineMs(const Task& task) const { return (task.deadline_ms > 0) ? task.deadline_ms : task.period_ms; }
+
+    //! returns the index of the released task outside the worker lane to
+    //! run next, -1 if none
+    int nextTask(qint64 now_ms) const;
+
+    //! moves the release to the next period, dropping missed periods
+    void advanceRelease(Task& task, qint64 now_ms);
+
+    void runTask(Task& task);
+    void startWorkerTask(Task& task, qint64 now_ms);
+    //! "late_ms" is the SimClock time from the release to the start of the
+    //! run, "run_ms" the wall clock time of the run
+    void finishWorkerTask(int index, qint64 late_ms, qint64 run_ms);
+
+    //! updates the statistics, m_mutex must be locked
+    void addRun(Task& task, qint64 late_ms, qint64 run_ms);
+
+    //! Estimates the speed of the SimClock against the wall clock, the
+    //! estimate is updated every SIM_RATE_INTERVAL_MS.
+    void updateSimRate(qint64 sim_now_ms);
+
+    //! converts a SimClock duration to wall clock time
+    qint64 simToWallMs(qint64 sim_ms) const;
+
+    void logReport();
+
+protected:
+
+    TaskRunner* m_runner;
+    QVector<Task> m_task_list;
+    bool m_started;
+
+    QTimer m_dispatch_timer;
+    QThreadPool m_thread_pool;
+
+    //! protects the running flags and the statistics
+    mutable QMutex m_mutex;
+
+    int m_report_interval_ms;
+    qint64 m_last_report_ms;
+
+    RealTimeClock m_wall_clock;
+
+    //! SimClock ms per wall clock ms, only written by the dispatching thread
+    //! with m_mutex locked
+    double m_sim_rate;
+    qint64 m_sim_rate_sim_ms;
+    qint64 m_sim_rate_wall_ms;
+
+private:
+    //! Hidden copy-constructor
+    TaskScheduler(const TaskScheduler&);
+    //! Hidden assignment operator
+    const TaskScheduler& operator = (const TaskScheduler&);
+};
+
+#endif /* TASK_SCHEDULER_H */
+
+// End of file
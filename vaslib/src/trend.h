@@ -25,9 +25,9 @@
 #ifndef TREND_H
 #define TREND_H
 
-#include <QTime>
 
 #include "logger.h"
+#include "sim_clock.h"
 
 /////////////////////////////////////////////////////////////////////////////
 
@@ -66,7 +66,7 @@ protected:
 
     bool m_init;
     TYPE m_last_value;
-    QTime m_last_value_dt;
+    SimTimer m_last_value_dt;
     TYPE m_last_trend;
 };
 
@@ -198,6 +198,8 @@ HEADERS += \
     pushbutton.h \
     mouse_input_area.h \
     smoothing.h \
+    sim_clock.h \
+    task_scheduler.h \
     waypoint.h \
     waypoint_hdg_to_alt.h \
     waypoint_hdg_to_intercept.h \
@@ -210,19 +212,31 @@ HEADERS += \
     holding.h \
     route.h \
     airway.h \
+    airway_graph.h \
     procedure.h \
     procedure_serialization.h \
     sid.h \
     star.h \
     transition.h \
     approach.h \
+    procedure_cache.h \
     flightroute.h \
     flightstatus.h \
+    flightstatus_publisher.h \
+    flight_recorder.h \
     fsaccess.h \
+    fsaccess_replay.h \
     navcalc.h \
     navdata.h \
+    navdata_image.h \
+    navdata_ident_index.h \
+    navdata_ident_search.h \
+    navdata_index_file.h \
+    navdata_query_service.h \
+    navdata_spatial_index.h \
     gshhs.h \
     geodata.h \
+    geo_polygon_store.h \
     weather.h \
     projection.h \
     projection_mercator.h \
@@ -237,7 +251,7 @@ HEADERS += \
     containerbase.h \
     infodlgimpl.h \
     declination.h \
-    declination_geomag.h \
+    declination_model.h \
     vroute.h \
     vas_path.h \
     #fsaccess_xplane_defines.h \
@@ -272,6 +286,8 @@ SOURCES += \
     pushbutton.cpp \
     mouse_input_area.cpp \
     smoothing.cpp \
+    sim_clock.cpp \
+    task_scheduler.cpp \
     waypoint.cpp \
     airport.cpp \
     runway.cpp \
@@ -282,19 +298,32 @@ SOURCES += \
     holding.cpp \
     route.cpp \
     airway.cpp \
+    airway_graph.cpp \
     procedure.cpp \
     procedure_serialization.cpp \
     sid.cpp \
     star.cpp \
     transition.cpp \
     approach.cpp \
+    procedure_cache.cpp \
     flightroute.cpp \
     flightstatus.cpp \
+    flightstatus_publisher.cpp \
+    flight_recorder.cpp \
     fsaccess.cpp \
+    fsaccess_replay.cpp \
     navcalc.cpp \
     navdata.cpp \
+    navdata_image.cpp \
+    navdata_ident_index.cpp \
+    navdata_ident_search.cpp \
+    navdata_index_file.cpp \
+    navdata_query_service.cpp \
+    navdata_spatial_index.cpp \
     geodata.cpp \
+    geo_polygon_store.cpp \
     weather.cpp \
+    projection.cpp \
     projection_mercator.cpp \
     projection_greatcircle.cpp \
     transport_layer_iface.cpp \
@@ -307,7 +336,7 @@ SOURCES += \
     containerbase.cpp \
     infodlgimpl.cpp \
     declination.cpp \
-    declination_geomag.cpp \
+    declination_model.cpp \
     vroute.cpp \
     vas_path.cpp \
     #fsaccess_xplane.cpp \
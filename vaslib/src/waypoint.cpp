@@ -18,6 +18,10 @@
 //
 ///////////////////////////////////////////////////////////////////////////////
 
+#include <QPair>
+#include <QVector>
+#include <QtAlgorithms>
+
 #include "logger.h"
 #include "navcalc.h"
 
@@ -132,6 +136,31 @@ void WaypointMetaData::operator<<(QDataStream& in)
 /////////////////////////////////////////////////////////////////////////////
 /////////////////////////////////////////////////////////////////////////////
 
+GeoVector GeoVector::fromLatLon(double lat, double lon)
+{
+    double rad_lat = Navcalc::toRad(lat);
+    double rad_lon = Navcalc::toRad(lon);
+    double cos_lat = cos(rad_lat);
+    return GeoVector(cos_lat * cos(rad_lon), cos_lat * sin(rad_lon), sin(rad_lat));
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+double GeoVector::lat() const
+{
+    return Navcalc::toDeg(atan2(z, sqrt(x*x + y*y)));
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
+double GeoVector::lon() const
+{
+    return Navcalc::toDeg(atan2(y, x));
+}
+
+/////////////////////////////////////////////////////////////////////////////
+/////////////////////////////////////////////////////////////////////////////
+
 const double Waypoint::LAT_LON_COMPARE_EPSILON = 0.00001;
 
 QString Waypoint::TYPE_WAYPOINT = "WAYPOINT";
@@ -162,7 +191,7 @@ QString Waypoint::FLAG_DISCONTINUITY = "DISC";
 /////////////////////////////////////////////////////////////////////////////
 
 Waypoint::Waypoint() :
-    m_is_valid(false), m_type(TYPE_WAYPOINT)
+    m_is_valid(false), m_type(TYPE_WAYPOINT), m_projection_epoch(0), m_unit_vector_valid(false)
 {
 }
   
@@ -170,7 +199,7 @@ Waypoint::Waypoint() :
     
 Waypoint::Waypoint(const QString& id, const QString& name, const double &lat, const double& lon) :
     m_is_valid(true), m_type(TYPE_WAYPOINT), m_id(id.trimmed()), m_name(name.trimmed()), 
-    m_polar_coordinates(QPointF(lat, lon))
+    m_polar_coordinates(QPointF(lat, lon)), m_projection_epoch(0), m_unit_vector_valid(false)
 {
 }
 
@@ -251,6 +280,9 @@ const Waypoint& Waypoint::operator=(const Waypoint& other)
     
     m_polar_coordinates = other.m_polar_coordinates;
     m_cartesian_coordinates = other.m_cartesian_coordinates;
+    m_projection_epoch = other.m_projection_epoch;
+    m_unit_vector = other.m_unit_vector;
+    m_unit_vector_valid = other.m_unit_vector_valid;
     
     m_restrictions = other.m_restrictions;
     m_estimated_data = other.m_estimated_data;
@@ -289,6 +321,9 @@ void Waypoint::operator<<(QDataStream& in)
        >> m_polar_coordinates
        >> m_cartesian_coordinates;
 
+    m_projection_epoch = 0;
+    m_unit_vector_valid = false;
+
     m_restrictions << in;
     m_estimated_data << in;
     m_overflown_data << in;
@@ -297,6 +332,14 @@ void Waypoint::operator<<(QDataStream& in)
 
 /////////////////////////////////////////////////////////////////////////////
 
+void Waypoint::calcUnitVector() const
+{
+    m_unit_vector = GeoVector::fromLatLon(lat(), lon());
+    m_unit_vector_valid = true;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
 bool Waypoint::isDependendWaypoint() const
 {
     return 
@@ -307,19 +350,37 @@ bool Waypoint::isDependendWaypoint() const
 /////////////////////////////////////////////////////////////////////////////
 /////////////////////////////////////////////////////////////////////////////
 
+static bool isNearer(const QPair<double, Waypoint*>& entry1, const QPair<double, Waypoint*>& entry2)
+{
+    return entry1.first < entry2.first;
+}
+
+/////////////////////////////////////////////////////////////////////////////
+
 void WaypointPtrList::sortByDistance(const Waypoint& reference_wpt)
 {
-    for (int loop_index=0; loop_index < count() ; ++loop_index)
+    if (count() < 2) return;
+
+    // calculate all distances at once instead of twice per comparison
+
+    QVector<double> lat(count());
+    QVector<double> lon(count());
+    QVector<double> distance_nm(count());
+
+    for(int index = 0; index < count(); ++index)
     {
-        for (int compare_index=0; compare_index < count() - 1 - loop_index; ++compare_index)
-        {
-            if (Navcalc::getDistBetweenWaypoints(reference_wpt, *at(compare_index)) >
-                Navcalc::getDistBetweenWaypoints(reference_wpt, *at(compare_index+1)))
-            {
-                Waypoint* wpt = takeAt(compare_index);
-                insert(compare_index+1, wpt);
-            }        
-        }
+        lat[index] = at(index)->lat();
+        lon[index] = at(index)->lon();
     }
+
+    Navcalc::getDistsFromWaypoint(reference_wpt, lat.constData(), lon.constData(), count(), distance_nm.data());
+
+    QVector< QPair<double, Waypoint*> > sorted_list(count());
+    for(int index = 0; index < count(); ++index) sorted_list[index] = qMakePair(distance_nm[index], at(index));
+
+    // stable, so waypoints with equal distances keep their order
+    qStableSort(sorted_list.begin(), sorted_list.end(), isNearer);
+
+    for(int index = 0; index < count(); ++index) (*this)[index] = sorted_list[index].second;
 }
 
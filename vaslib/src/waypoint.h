@@ -21,6 +21,8 @@
 #ifndef WAYPOINT_H
 #define WAYPOINT_H
 
+#include <math.h>
+
 #include <QString>
 #include <QList>
 #include <QListIterator>
@@ -161,6 +163,43 @@ protected:
 
 /////////////////////////////////////////////////////////////////////////////
 
+//! Earth centered unit vector of a lat/lon position. Great circle math on
+//! these vectors only needs dot and cross products (see Navcalc), so the
+//! sines and cosines of a position are calculated only once.
+class GeoVector
+{
+public:
+
+    GeoVector() : x(0.0), y(0.0), z(0.0) {};
+    GeoVector(double vx, double vy, double vz) : x(vx), y(vy), z(vz) {};
+
+    //! returns the unit vector of the given position in degrees
+    static GeoVector fromLatLon(double lat, double lon);
+
+    //! returns the latitude in degrees, the vector may be unnormalized
+    double lat() const;
+    //! returns the longitude in degrees
+    double lon() const;
+
+    inline double dot(const GeoVector& other) const { return x*other.x + y*other.y + z*other.z; }
+
+    inline GeoVector cross(const GeoVector& other) const
+    {
+        return GeoVector(y*other.z - z*other.y, z*other.x - x*other.z, x*other.y - y*other.x);
+    }
+
+    inline double length() const { return sqrt(dot(*this)); }
+
+    inline GeoVector operator*(double factor) const { return GeoVector(x*factor, y*factor, z*factor); }
+    inline GeoVector operator+(const GeoVector& other) const { return GeoVector(x+other.x, y+other.y, z+other.z); }
+
+    double x;
+    double y;
+    double z;
+};
+
+/////////////////////////////////////////////////////////////////////////////
+
 class Waypoint : public SerializationIface
 {
 public:
@@ -272,19 +311,35 @@ public:
     void setParent(const QString& parent) { m_parent = parent.trimmed(); }
 
     inline double lat() const { return m_polar_coordinates.x(); }
-    inline void setLat(const double& lat) { m_polar_coordinates.setX(lat); }
+    inline void setLat(const double& lat) { m_polar_coordinates.setX(lat); m_unit_vector_valid = false; }
 
     inline double lon() const { return m_polar_coordinates.y(); }
-    inline void setLon(const double& lon) { m_polar_coordinates.setY(lon); }
+    inline void setLon(const double& lon) { m_polar_coordinates.setY(lon); m_unit_vector_valid = false; }
 
     inline QPointF pointLatLon() const { return m_polar_coordinates; }
-    inline void setPointLatLon(const QPointF& point) { m_polar_coordinates = point; }
+    inline void setPointLatLon(const QPointF& point) { m_polar_coordinates = point; m_unit_vector_valid = false; }
+
+    //! Returns the earth centered unit vector of the position. It is
+    //! calculated on first use and kept until the position changes.
+    inline const GeoVector& unitVector() const
+    {
+        if (!m_unit_vector_valid) calcUnitVector();
+        return m_unit_vector;
+    }
 
     inline double x() const { return m_cartesian_coordinates.x(); }
     inline double y() const { return m_cartesian_coordinates.y(); }
 
     inline QPointF pointXY() const { return m_cartesian_coordinates; }
-    inline void setPointXY(const QPointF& point) { m_cartesian_coordinates = point; }
+    inline void setPointXY(const QPointF& point, uint projection_epoch = 0)
+    {
+        m_cartesian_coordinates = point;
+        m_projection_epoch = projection_epoch;
+    }
+
+    //! returns the epoch of the projection the x/y values were calculated
+    //! with (see ProjectionBase::epoch()), 0 if unknown
+    inline uint projectionEpoch() const { return m_projection_epoch; }
 
     QString latString() const;
     QString latStringDegMinSec() const;
@@ -312,7 +367,11 @@ public:
     bool isDependendWaypoint() const;
 
     //! resets the waypoint coordinates if the waypoint is a dependend waypoint (see isDependendWaypoint())
-    inline void resetIfDependendWaypoint() { if (isDependendWaypoint()) m_polar_coordinates = QPointF(); }
+    inline void resetIfDependendWaypoint() { if (isDependendWaypoint()) setPointLatLon(QPointF()); }
+
+protected:
+
+    void calcUnitVector() const;
 
 protected:
 
@@ -326,6 +385,11 @@ protected:
 
     QPointF m_polar_coordinates;
     QPointF m_cartesian_coordinates;
+    uint m_projection_epoch;
+
+    //! cache of unitVector(), only valid when m_unit_vector_valid is set
+    mutable GeoVector m_unit_vector;
+    mutable bool m_unit_vector_valid;
 
     WaypointRestrictions m_restrictions;
     WaypointMetaData m_estimated_data;